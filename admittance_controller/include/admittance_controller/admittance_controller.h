@@ -0,0 +1,124 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef ADMITTANCE_CONTROLLER_ADMITTANCE_CONTROLLER_H
+#define ADMITTANCE_CONTROLLER_ADMITTANCE_CONTROLLER_H
+
+#include <string>
+#include <vector>
+
+#include <controller_interface/multi_interface_controller.h>
+#include <geometry_msgs/Pose.h>
+#include <hardware_interface/force_torque_sensor_interface.h>
+#include <hardware_interface/joint_command_interface.h>
+#include <realtime_tools/realtime_buffer.h>
+#include <ros/node_handle.h>
+
+#include <admittance_controller/admittance_model.h>
+#include <cartesian_trajectory_controller/differential_ik.h>
+#include <joint_trajectory_controller/rigid_body_chain.h>
+
+namespace admittance_controller
+{
+
+/**
+ * \brief Admittance controller closing a force loop around a position-controlled serial chain.
+ *
+ * Each cycle, the wrench measured by a force-torque sensor drives an \ref AdmittanceModel, whose displacement moves the
+ * sensor frame away from a reference pose. The joint positions placing the sensor frame at the displaced pose are
+ * resolved through the chain Jacobian by \ref cartesian_trajectory_controller::DifferentialIk, and sent as position
+ * commands. Sensor reading, admittance integration and command update all happen in the same \ref update call.
+ *
+ * The sensor frame must be a URDF link rigidly attached to the child link of the last joint of the chain. Its wrench is
+ * taken as the one the environment exerts on the sensor, and is rotated to the URDF root frame, where the admittance
+ * parameters are expressed. The sensor offset, including the weight of any tool it carries, is removed on startup.
+ *
+ * The reference pose, the equilibrium of the admittance model, is the startup pose of the sensor frame until a new one
+ * is received in the \p command topic, as a \p geometry_msgs::Pose in the URDF root frame.
+ *
+ * The \p admittance/damping parameter is required, and must be positive on every axis. The \p mass defaults to one
+ * and the \p stiffness to zero. Near singularities a small displacement can map to a large change of joint positions,
+ * so the change of every position command is limited to \p max_joint_step per cycle, 0.01 by default.
+ *
+ * The following is an example configuration:
+ * \code
+ * admittance_controller:
+ *   type: "admittance_controller/AdmittanceController"
+ *   joints: [joint1, joint2, joint3, joint4, joint5, joint6]
+ *   sensor: wrist_ft_sensor  # Optional if the robot has a single force-torque sensor
+ *   admittance:
+ *     mass:      [5.0, 5.0, 5.0, 0.5, 0.5, 0.5]
+ *     damping:   [200.0, 200.0, 200.0, 10.0, 10.0, 10.0]
+ *     stiffness: [500.0, 500.0, 0.0, 20.0, 20.0, 20.0]
+ *   ik: {max_iterations: 5, damping: 0.01}
+ *   max_joint_step: 0.005  # Optional, in radians or meters per cycle
+ * \endcode
+ */
+class AdmittanceController
+  : public controller_interface::MultiInterfaceController<hardware_interface::PositionJointInterface,
+                                                          hardware_interface::ForceTorqueSensorInterface>
+{
+public:
+  AdmittanceController();
+
+  virtual bool init(hardware_interface::RobotHW* robot_hw, ros::NodeHandle& root_nh, ros::NodeHandle& controller_nh);
+  virtual void starting(const ros::Time& time);
+  virtual void update(const ros::Time& time, const ros::Duration& period);
+
+private:
+  typedef joint_trajectory_controller::RigidBodyChain::Transform Transform;
+  typedef joint_trajectory_controller::RigidBodyChain::Vector3   Vector3;
+
+  std::vector<hardware_interface::JointHandle> joints_;
+  hardware_interface::ForceTorqueSensorHandle  sensor_;
+
+  joint_trajectory_controller::RigidBodyChain     chain_;  ///< Kinematic model, with the sensor frame as its tip.
+  cartesian_trajectory_controller::DifferentialIk ik_;
+  AdmittanceModel                                 admittance_;
+
+  std::vector<double>                 position_command_; ///< Preallocated, seeds the inverse kinematics.
+  std::vector<double>                 previous_command_; ///< Preallocated, position command of the previous cycle.
+  double                              max_joint_step_;   ///< Largest position command change per cycle.
+  AdmittanceModel::Vector6            sensor_offset_;    ///< Sensor reading on startup.
+  realtime_tools::RealtimeBuffer<Transform> reference_;  ///< Equilibrium pose of the sensor frame.
+
+  ros::Subscriber reference_sub_;
+  std::string     name_;
+
+  void referenceCB(const geometry_msgs::PoseConstPtr& msg);
+};
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,126 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef ADMITTANCE_CONTROLLER_ADMITTANCE_MODEL_H
+#define ADMITTANCE_CONTROLLER_ADMITTANCE_MODEL_H
+
+#include <array>
+
+namespace admittance_controller
+{
+
+/**
+ * \brief Six-dimensional mass-spring-damper, \f$ M \ddot{x} + D \dot{x} + K x = w \f$, with diagonal matrices.
+ *
+ * The coordinates \f$ x \f$ are the displacement of a frame from its equilibrium: three translations followed by the
+ * three components of a rotation vector, and \f$ w \f$ is the external wrench (force, then torque) acting on it.
+ * Treating the rotation vector as independent coordinates is accurate for the moderate angular displacements
+ * admittance control is meant for.
+ *
+ * The model is integrated with an implicit Euler step on the damping and stiffness terms, which is stable for any
+ * positive mass and time step, so that stiff or lightly damped settings cannot make the control loop diverge.
+ */
+class AdmittanceModel
+{
+public:
+  typedef std::array<double, 6> Vector6;
+
+  struct Parameters
+  {
+    Parameters()
+    {
+      mass.fill(1.0);
+      damping.fill(0.0);
+      stiffness.fill(0.0);
+    }
+
+    Vector6 mass;      ///< Must be positive.
+    Vector6 damping;   ///< Must be non-negative.
+    Vector6 stiffness; ///< Must be non-negative. Zero lets the frame drift under a constant wrench.
+  };
+
+  AdmittanceModel() {reset();}
+
+  /** \return False if the parameters are invalid, leaving the model unchanged. */
+  bool init(const Parameters& params)
+  {
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+      if (!(params.mass[i] > 0.0) || !(params.damping[i] >= 0.0) || !(params.stiffness[i] >= 0.0)) {return false;}
+    }
+    params_ = params;
+    reset();
+    return true;
+  }
+
+  /** \brief Bring the frame to rest at its equilibrium. */
+  void reset()
+  {
+    displacement_.fill(0.0);
+    velocity_.fill(0.0);
+  }
+
+  /**
+   * \brief Advance the model by \p dt under the external \p wrench.
+   * \note This method is realtime-safe.
+   */
+  void update(const Vector6& wrench, double dt)
+  {
+    if (!(dt > 0.0)) {return;}
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+      // m (v' - v) / dt = w - d v' - k (x + dt v')
+      const double m = params_.mass[i];
+      const double d = params_.damping[i];
+      const double k = params_.stiffness[i];
+      velocity_[i] = (m * velocity_[i] + dt * (wrench[i] - k * displacement_[i])) / (m + dt * (d + dt * k));
+      displacement_[i] += dt * velocity_[i];
+    }
+  }
+
+  /** \return Displacement from the equilibrium: translation, then rotation vector. */
+  const Vector6& displacement() const {return displacement_;}
+
+  /** \return Rate of change of the displacement. */
+  const Vector6& velocity() const {return velocity_;}
+
+private:
+  Parameters params_;
+  Vector6    displacement_;
+  Vector6    velocity_;
+};
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,296 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <algorithm>
+#include <algorithm>
+#include <cmath>
+
+#include <pluginlib/class_list_macros.hpp>
+#include <urdf/model.h>
+
+#include <admittance_controller/admittance_controller.h>
+
+namespace admittance_controller
+{
+
+namespace
+{
+
+/**
+ * \brief Read a six-element parameter into \p out, leaving it untouched if the parameter is missing.
+ * \param required Whether a missing parameter is an error.
+ * \return False if the parameter is present but does not have six elements, or is missing and \p required.
+ */
+bool getVector6(const ros::NodeHandle&    nh,
+                const std::string&        param_name,
+                AdmittanceModel::Vector6& out,
+                bool                      required = false)
+{
+  std::vector<double> values;
+  if (!nh.getParam(param_name, values))
+  {
+    if (required)
+    {
+      ROS_ERROR_STREAM("Could not find the '" << param_name << "' parameter (namespace: " << nh.getNamespace() <<
+                       ").");
+    }
+    return !required;
+  }
+  if (values.size() != out.size())
+  {
+    ROS_ERROR_STREAM("The '" << param_name << "' parameter must have " << out.size() << " elements, " <<
+                     values.size() << " found (namespace: " << nh.getNamespace() << ").");
+    return false;
+  }
+  std::copy(values.begin(), values.end(), out.begin());
+  return true;
+}
+
+} // namespace
+
+AdmittanceController::AdmittanceController()
+  : max_joint_step_(0.0)
+{
+  sensor_offset_.fill(0.0);
+}
+
+bool AdmittanceController::init(hardware_interface::RobotHW* robot_hw,
+                                ros::NodeHandle&             root_nh,
+                                ros::NodeHandle&             controller_nh)
+{
+  typedef hardware_interface::PositionJointInterface     PosIface;
+  typedef hardware_interface::ForceTorqueSensorInterface FtIface;
+
+  // Controller name
+  const std::string complete_ns = controller_nh.getNamespace();
+  name_ = complete_ns.substr(complete_ns.find_last_of("/") + 1);
+
+  // Force-torque sensor, which may be omitted if there is only one
+  FtIface* ft_if = robot_hw->get<FtIface>();
+  std::string sensor_name;
+  if (!controller_nh.getParam("sensor", sensor_name))
+  {
+    const std::vector<std::string> sensor_names = ft_if->getNames();
+    if (sensor_names.size() != 1)
+    {
+      ROS_ERROR_STREAM_NAMED(name_, "The 'sensor' parameter is required when the robot has " << sensor_names.size() <<
+                             " force-torque sensors.");
+      return false;
+    }
+    sensor_name = sensor_names.front();
+  }
+  try {sensor_ = ft_if->getHandle(sensor_name);}
+  catch (const hardware_interface::HardwareInterfaceException&)
+  {
+    ROS_ERROR_STREAM_NAMED(name_, "Could not find force-torque sensor '" << sensor_name << "'.");
+    return false;
+  }
+
+  // Joints
+  std::vector<std::string> joint_names;
+  if (!controller_nh.getParam("joints", joint_names) || joint_names.empty())
+  {
+    ROS_ERROR_STREAM_NAMED(name_, "Could not find a non-empty 'joints' parameter (namespace: " <<
+                           controller_nh.getNamespace() << ").");
+    return false;
+  }
+  PosIface* pos_if = robot_hw->get<PosIface>();
+  joints_.clear();
+  for (const auto& joint_name : joint_names)
+  {
+    try {joints_.push_back(pos_if->getHandle(joint_name));}
+    catch (const hardware_interface::HardwareInterfaceException&)
+    {
+      ROS_ERROR_STREAM_NAMED(name_, "Could not find joint '" << joint_name << "'.");
+      return false;
+    }
+  }
+
+  // Kinematic chain, from the URDF root to the sensor frame
+  urdf::Model urdf;
+  if (!urdf.initParamWithNodeHandle("robot_description", root_nh))
+  {
+    ROS_ERROR_STREAM_NAMED(name_, "Failed to parse URDF contained in 'robot_description' parameter.");
+    return false;
+  }
+  if (!chain_.init(urdf, joint_names) || !chain_.setTip(urdf, sensor_.getFrameId()))
+  {
+    ROS_ERROR_STREAM_NAMED(name_, "Failed to build the kinematic chain from the URDF root to the sensor frame '" <<
+                           sensor_.getFrameId() << "'.");
+    return false;
+  }
+
+  // Admittance model. Damping has no sensible default: without it, and without stiffness, the sensor frame keeps
+  // accelerating under any uncompensated wrench, so it must be given and be positive
+  ros::NodeHandle admittance_nh(controller_nh, "admittance");
+  AdmittanceModel::Parameters admittance_params;
+  if (!getVector6(admittance_nh, "mass",      admittance_params.mass)          ||
+      !getVector6(admittance_nh, "damping",   admittance_params.damping, true) ||
+      !getVector6(admittance_nh, "stiffness", admittance_params.stiffness))
+  {
+    return false;
+  }
+  const bool damped = std::all_of(admittance_params.damping.begin(), admittance_params.damping.end(),
+                                  [](double d) {return d > 0.0;});
+  if (!damped || !admittance_.init(admittance_params))
+  {
+    ROS_ERROR_STREAM_NAMED(name_, "Invalid admittance parameters: 'mass' and 'damping' must be positive, " <<
+                           "'stiffness' non-negative.");
+    return false;
+  }
+
+  // Largest joint position change commanded in a single cycle
+  controller_nh.param("max_joint_step", max_joint_step_, 0.01);
+  if (!(max_joint_step_ > 0.0))
+  {
+    ROS_ERROR_STREAM_NAMED(name_, "The 'max_joint_step' parameter must be positive, " << max_joint_step_ <<
+                           " found.");
+    return false;
+  }
+
+  // Inverse kinematics
+  ros::NodeHandle ik_nh(controller_nh, "ik");
+  cartesian_trajectory_controller::DifferentialIk::Parameters ik_params;
+  int max_iterations = ik_params.max_iterations;
+  ik_nh.param("max_iterations",        max_iterations,                 max_iterations);
+  ik_nh.param("damping",               ik_params.damping,               ik_params.damping);
+  ik_nh.param("position_tolerance",    ik_params.position_tolerance,    ik_params.position_tolerance);
+  ik_nh.param("orientation_tolerance", ik_params.orientation_tolerance, ik_params.orientation_tolerance);
+  ik_nh.param("max_step",              ik_params.max_step,              ik_params.max_step);
+  ik_params.max_iterations = std::max(max_iterations, 0);
+  if (!ik_.init(chain_, ik_params))
+  {
+    ROS_ERROR_STREAM_NAMED(name_, "Invalid inverse kinematics parameters: 'damping', 'position_tolerance', " <<
+                           "'orientation_tolerance' and 'max_step' must be positive.");
+    return false;
+  }
+
+  // Preallocate resources
+  position_command_.assign(joints_.size(), 0.0);
+  previous_command_.assign(joints_.size(), 0.0);
+
+  // ROS API: Subscribed topics
+  reference_sub_ = controller_nh.subscribe("command", 1, &AdmittanceController::referenceCB, this);
+
+  return true;
+}
+
+void AdmittanceController::starting(const ros::Time& /*time*/)
+{
+  // Start at rest, at the current pose, with the current wrench as the sensor offset
+  for (unsigned int i = 0; i < joints_.size(); ++i) {position_command_[i] = joints_[i].getPosition();}
+  reference_.initRT(chain_.tipPose(position_command_));
+  admittance_.reset();
+
+  const double* force  = sensor_.getForce();
+  const double* torque = sensor_.getTorque();
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    sensor_offset_[i]     = force[i];
+    sensor_offset_[3 + i] = torque[i];
+  }
+}
+
+void AdmittanceController::update(const ros::Time& /*time*/, const ros::Duration& period)
+{
+  using namespace joint_trajectory_controller::internal;
+
+  // Wrench in the root frame, from the orientation of the sensor at the previous command
+  const Transform sensor_pose = chain_.tipPose(position_command_);
+  const double* force  = sensor_.getForce();
+  const double* torque = sensor_.getTorque();
+  const Vector3 root_force  = sensor_pose.rotation * Vector3{force[0] - sensor_offset_[0],
+                                                             force[1] - sensor_offset_[1],
+                                                             force[2] - sensor_offset_[2]};
+  const Vector3 root_torque = sensor_pose.rotation * Vector3{torque[0] - sensor_offset_[3],
+                                                             torque[1] - sensor_offset_[4],
+                                                             torque[2] - sensor_offset_[5]};
+  const AdmittanceModel::Vector6 wrench = {root_force.x,  root_force.y,  root_force.z,
+                                           root_torque.x, root_torque.y, root_torque.z};
+
+  // Displaced pose of the sensor frame
+  admittance_.update(wrench, period.toSec());
+  const AdmittanceModel::Vector6& displacement = admittance_.displacement();
+  const Transform& reference = *reference_.readFromRT();
+  const Transform target = {rotationMatrix({displacement[3], displacement[4], displacement[5]}) * reference.rotation,
+                            reference.translation + Vector3{displacement[0], displacement[1], displacement[2]}};
+
+  // Joint positions reaching it, resolved from the previous ones. Vectors have the same size, so copying does not
+  // allocate
+  previous_command_ = position_command_;
+  if (!ik_.solve(target, position_command_))
+  {
+    ROS_WARN_STREAM_THROTTLE_NAMED(1.0, name_, "Inverse kinematics did not converge, with a position error of " <<
+                                   ik_.positionError() << " and an orientation error of " << ik_.orientationError() <<
+                                   ". The displaced pose may be out of reach or near a singularity.");
+  }
+
+  // Near singularities a small Cartesian displacement can map to a large joint jump, which is never commanded at once
+  bool clamped = false;
+  for (unsigned int i = 0; i < joints_.size(); ++i)
+  {
+    const double step = position_command_[i] - previous_command_[i];
+    if (std::abs(step) > max_joint_step_)
+    {
+      position_command_[i] = previous_command_[i] + std::copysign(max_joint_step_, step);
+      clamped = true;
+    }
+    joints_[i].setCommand(position_command_[i]);
+  }
+  if (clamped)
+  {
+    ROS_WARN_STREAM_THROTTLE_NAMED(1.0, name_, "Joint position commands were limited to a change of " <<
+                                   max_joint_step_ << " per cycle.");
+  }
+}
+
+void AdmittanceController::referenceCB(const geometry_msgs::PoseConstPtr& msg)
+{
+  using joint_trajectory_controller::internal::quaternionMatrix;
+
+  const geometry_msgs::Quaternion& q = msg->orientation;
+  const double norm = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+  if (!(norm > 0.0))
+  {
+    ROS_WARN_STREAM_NAMED(name_, "Ignoring reference pose with an invalid orientation quaternion.");
+    return;
+  }
+
+  reference_.writeFromNonRT({quaternionMatrix(q.x / norm, q.y / norm, q.z / norm, q.w / norm),
+                             {msg->position.x, msg->position.y, msg->position.z}});
+}
+
+} // namespace
+
+PLUGINLIB_EXPORT_CLASS(admittance_controller::AdmittanceController, controller_interface::ControllerBase)
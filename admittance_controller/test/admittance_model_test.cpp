@@ -0,0 +1,122 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+#include <admittance_controller/admittance_model.h>
+
+using admittance_controller::AdmittanceModel;
+
+// Floating-point value comparison threshold
+const double EPS = 1e-6;
+
+TEST(AdmittanceModelTest, SpringSettlesAtWrenchOverStiffness)
+{
+  AdmittanceModel::Parameters params;
+  params.mass.fill(2.0);
+  params.damping.fill(40.0);
+  params.stiffness = {100.0, 200.0, 400.0, 10.0, 20.0, 40.0};
+
+  AdmittanceModel model;
+  ASSERT_TRUE(model.init(params));
+
+  const AdmittanceModel::Vector6 wrench = {5.0, -4.0, 8.0, 0.5, -0.2, 0.0};
+  for (unsigned int i = 0; i < 100000; ++i) {model.update(wrench, 1e-3);}
+  for (unsigned int i = 0; i < 6; ++i)
+  {
+    EXPECT_NEAR(wrench[i] / params.stiffness[i], model.displacement()[i], EPS);
+    EXPECT_NEAR(0.0, model.velocity()[i], EPS);
+  }
+
+  model.reset();
+  for (unsigned int i = 0; i < 6; ++i) {EXPECT_EQ(0.0, model.displacement()[i]);}
+}
+
+TEST(AdmittanceModelTest, DamperMovesAtWrenchOverDamping)
+{
+  AdmittanceModel::Parameters params;
+  params.damping.fill(50.0);
+
+  AdmittanceModel model;
+  ASSERT_TRUE(model.init(params));
+
+  // Without stiffness the frame drifts, at a velocity set by the damping once the mass has been accelerated
+  const AdmittanceModel::Vector6 wrench = {10.0, 0.0, 0.0, 0.0, 0.0, -5.0};
+  for (unsigned int i = 0; i < 2000; ++i) {model.update(wrench, 1e-3);}
+  EXPECT_NEAR(0.2, model.velocity()[0], EPS);
+  EXPECT_NEAR(-0.1, model.velocity()[5], EPS);
+  EXPECT_GT(model.displacement()[0], 0.0);
+  EXPECT_EQ(0.0, model.displacement()[1]);
+}
+
+TEST(AdmittanceModelTest, StableForLargeSteps)
+{
+  // The explicit Euler step would diverge for this stiffness and step
+  AdmittanceModel::Parameters params;
+  params.mass.fill(0.1);
+  params.stiffness.fill(1e4);
+
+  AdmittanceModel model;
+  ASSERT_TRUE(model.init(params));
+
+  const AdmittanceModel::Vector6 wrench = {1.0, 1.0, 1.0, 1.0, 1.0, 1.0};
+  for (unsigned int i = 0; i < 1000; ++i)
+  {
+    model.update(wrench, 1e-2);
+    EXPECT_LT(std::abs(model.displacement()[0]), 2.0 * wrench[0] / params.stiffness[0]);
+  }
+}
+
+TEST(AdmittanceModelTest, InvalidParameters)
+{
+  AdmittanceModel model;
+  AdmittanceModel::Parameters params;
+  params.mass[2] = 0.0;
+  EXPECT_FALSE(model.init(params));
+
+  params = AdmittanceModel::Parameters();
+  params.damping[4] = -1.0;
+  EXPECT_FALSE(model.init(params));
+
+  params = AdmittanceModel::Parameters();
+  params.stiffness[0] = std::nan("");
+  EXPECT_FALSE(model.init(params));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
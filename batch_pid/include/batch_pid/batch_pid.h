@@ -0,0 +1,420 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef BATCH_PID_BATCH_PID_H
+#define BATCH_PID_BATCH_PID_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <ros/node_handle.h>
+#include <realtime_tools/realtime_buffer.h>
+
+#include <batch_pid/SetGains.h>
+
+namespace batch_pid
+{
+
+/**
+ * \brief PID controller for a group of joints.
+ *
+ * Computes the commands of all the PID loops of a group in a single pass. Gains and internal state are kept in
+ * structure-of-arrays form, and the per-loop computation is branch-free, so that the compiler can vectorize it.
+ * Each loop behaves like a \p control_toolbox::Pid, with an optional first-order low-pass filter on the error
+ * derivative.
+ *
+ * Gains are shared with the realtime thread through a single realtime buffer for the whole group, so that it is read
+ * once per control cycle instead of once per joint.
+ *
+ * \section ROS interface
+ *
+ * The gains of each loop are read from the \p <loop_name>/pid namespace, using the same parameters as
+ * \p control_toolbox::Pid plus the derivative filter time constant:
+ * \code
+ * joint1:
+ *   pid: {p: 100.0, i: 0.01, d: 10.0, i_clamp: 1.0, antiwindup: false, d_filter_time_constant: 0.005}
+ * \endcode
+ *
+ * Provides:
+ * - \b set_gains (batch_pid::SetGains) : Updates the gains of all loops at once.
+ */
+class BatchPid
+{
+public:
+  /**
+   * \brief Gains of a group of PID loops, one entry per loop.
+   */
+  struct Gains
+  {
+    Gains(const std::vector<double>::size_type size = 0)
+      : p(size, 0.0),
+        i(size, 0.0),
+        d(size, 0.0),
+        i_max(size, 0.0),
+        i_min(size, 0.0),
+        antiwindup(size, false),
+        d_filter_time_constant(size, 0.0)
+    {}
+
+    std::vector<double> p;                      ///< Proportional gains.
+    std::vector<double> i;                      ///< Integral gains.
+    std::vector<double> d;                      ///< Derivative gains.
+    std::vector<double> i_max;                  ///< Upper integral clamps.
+    std::vector<double> i_min;                  ///< Lower integral clamps.
+    std::vector<bool>   antiwindup;             ///< If true, clamp the integral state instead of the integral term.
+    std::vector<double> d_filter_time_constant; ///< Derivative low-pass filter time constants. Zero disables it.
+
+    /** \return Number of loops, or zero if the gain vectors have inconsistent sizes. */
+    std::vector<double>::size_type size() const
+    {
+      const std::vector<double>::size_type n = p.size();
+      const bool consistent = i.size() == n && d.size() == n && i_max.size() == n && i_min.size() == n &&
+                              antiwindup.size() == n && d_filter_time_constant.size() == n;
+      return consistent ? n : 0;
+    }
+  };
+
+  BatchPid() : size_(0) {}
+
+  /**
+   * \brief Initialize from gains stored in the ROS parameter server, and start the \p set_gains service.
+   *
+   * \param nh Node handle the \p <loop_name>/pid namespaces and the service are relative to.
+   * \param loop_names Names of the loops, typically joint names.
+   *
+   * \returns True if the gains of all loops were found.
+   */
+  bool init(const ros::NodeHandle& nh, const std::vector<std::string>& loop_names)
+  {
+    Gains gains(loop_names.size());
+    for (unsigned int k = 0; k < loop_names.size(); ++k)
+    {
+      const ros::NodeHandle pid_nh(nh, loop_names[k] + "/pid");
+      if (!pid_nh.getParam("p", gains.p[k]))
+      {
+        ROS_ERROR_STREAM("No p gain specified for pid. Namespace: " << pid_nh.getNamespace());
+        return false;
+      }
+      pid_nh.param("i", gains.i[k], 0.0);
+      pid_nh.param("d", gains.d[k], 0.0);
+
+      // Same convention as control_toolbox::Pid: the sign of the clamps is not taken into account
+      double i_clamp;
+      pid_nh.param("i_clamp", i_clamp, 0.0);
+      gains.i_max[k] =  std::abs(i_clamp);
+      gains.i_min[k] = -std::abs(i_clamp);
+      if (pid_nh.hasParam("i_clamp_min"))
+      {
+        pid_nh.param("i_clamp_min", gains.i_min[k], gains.i_min[k]);
+        gains.i_min[k] = -std::abs(gains.i_min[k]);
+      }
+      if (pid_nh.hasParam("i_clamp_max"))
+      {
+        pid_nh.param("i_clamp_max", gains.i_max[k], gains.i_max[k]);
+        gains.i_max[k] = std::abs(gains.i_max[k]);
+      }
+
+      bool antiwindup;
+      pid_nh.param("antiwindup", antiwindup, false);
+      gains.antiwindup[k] = antiwindup;
+
+      pid_nh.param("d_filter_time_constant", gains.d_filter_time_constant[k], 0.0);
+    }
+
+    if (!init(gains)) {return false;}
+
+    set_gains_service_ = ros::NodeHandle(nh).advertiseService("set_gains", &BatchPid::setGainsService, this);
+    return true;
+  }
+
+  /**
+   * \brief Initialize from the specified gains. The number of loops is that of \p gains.
+   * \note Does not start the \p set_gains service.
+   */
+  bool init(const Gains& gains)
+  {
+    std::string error_string;
+    if (gains.size() == 0 || !isValid(gains, gains.size(), &error_string))
+    {
+      ROS_ERROR_STREAM("Can't initialize PID loops. " << error_string);
+      return false;
+    }
+
+    size_ = gains.size();
+    RtGains rt_gains;
+    setRtGains(gains, rt_gains);
+    gains_buffer_.writeFromNonRT(rt_gains);
+
+    p_error_last_.assign(size_, 0.0);
+    i_error_.assign(size_, 0.0);
+    d_error_.assign(size_, 0.0);
+    error_dot_.assign(size_, 0.0);
+    return true;
+  }
+
+  /**
+   * \brief Set the gains of all loops. This method is \e not realtime-safe.
+   * \return False if \p gains doesn't contain one valid entry per loop, in which case gains remain unchanged.
+   */
+  bool setGains(const Gains& gains, std::string* error_string = 0)
+  {
+    if (!isValid(gains, size_, error_string)) {return false;}
+
+    RtGains rt_gains;
+    setRtGains(gains, rt_gains);
+    gains_buffer_.writeFromNonRT(rt_gains);
+    return true;
+  }
+
+  /** \return Gains of all loops. This method is \e not realtime-safe. */
+  Gains getGains() const {return gains_buffer_.readFromNonRT()->gains;}
+
+  /** \return Number of loops. */
+  unsigned int size() const {return size_;}
+
+  /** \brief Reset the internal state of all loops. This method is realtime-safe. */
+  void reset()
+  {
+    std::fill(p_error_last_.begin(), p_error_last_.end(), 0.0);
+    std::fill(i_error_.begin(),      i_error_.end(),      0.0);
+    std::fill(d_error_.begin(),      d_error_.end(),      0.0);
+  }
+
+  /**
+   * \brief Compute the commands of all loops, with the error derivatives computed from the change in error since the
+   * last call. This method is realtime-safe.
+   *
+   * \param error Error of each loop, \ref size entries.
+   * \param dt Time elapsed since the last call, in seconds.
+   * \param[out] command Command of each loop, \ref size entries.
+   */
+  void computeCommand(const double* error, double dt, double* command)
+  {
+    if (!(dt > 0.0 && dt < std::numeric_limits<double>::infinity()))
+    {
+      std::fill(command, command + size_, 0.0);
+      return;
+    }
+
+    double* p_error_last = p_error_last_.data();
+    double* error_dot    = error_dot_.data();
+    const double dt_inv  = 1.0 / dt;
+    for (unsigned int k = 0; k < size_; ++k)
+    {
+      error_dot[k] = (error[k] - p_error_last[k]) * dt_inv;
+    }
+    computeCommand(error, error_dot, dt, command);
+  }
+
+  /**
+   * \brief Compute the commands of all loops using precomputed error derivatives. This method is realtime-safe.
+   *
+   * \param error Error of each loop, \ref size entries.
+   * \param error_dot Error derivative of each loop, \ref size entries.
+   * \param dt Time elapsed since the last call, in seconds.
+   * \param[out] command Command of each loop, \ref size entries.
+   *
+   * Loops with a non-finite error or error derivative output a zero command and keep their internal state, as does
+   * the whole batch when \p dt is not positive. Errors are still recorded for the numerically differentiated overload,
+   * so that both overloads can be used alternately without a derivative kick.
+   */
+  void computeCommand(const double* error, const double* error_dot, double dt, double* command)
+  {
+    if (!(dt > 0.0 && dt < std::numeric_limits<double>::infinity()))
+    {
+      std::fill(command, command + size_, 0.0);
+      return;
+    }
+
+    double* p_error_last = p_error_last_.data();
+    for (unsigned int k = 0; k < size_; ++k)
+    {
+      p_error_last[k] = isFinite(error[k]) ? error[k] : p_error_last[k];
+    }
+
+    // Loops are evaluated in runs of consecutive loops with finite inputs, which in the nominal case is the whole batch
+    const RtGains& rt_gains = *gains_buffer_.readFromRT();
+    unsigned int begin = 0;
+    for (unsigned int k = 0; k < size_; ++k)
+    {
+      if (isFinite(error[k]) && isFinite(error_dot[k])) {continue;}
+      computeCommands(rt_gains, begin, k, dt, error, error_dot, command, i_error_.data(), d_error_.data());
+      command[k] = 0.0;
+      begin = k + 1;
+    }
+    computeCommands(rt_gains, begin, size_, dt, error, error_dot, command, i_error_.data(), d_error_.data());
+  }
+
+private:
+  /**
+   * \brief Gains as consumed by the realtime loop. Integral clamps are expressed as bounds on both the integral state
+   * and the integral term, set to infinity when not applicable, so that both antiwindup modes share the same code path.
+   */
+  struct RtGains
+  {
+    Gains gains;
+    std::vector<double> i_state_min;
+    std::vector<double> i_state_max;
+    std::vector<double> i_term_min;
+    std::vector<double> i_term_max;
+  };
+
+  unsigned int size_;
+
+  realtime_tools::RealtimeBuffer<RtGains> gains_buffer_;
+
+  std::vector<double> p_error_last_; ///< Errors of the previous cycle.
+  std::vector<double> i_error_;      ///< Integral states.
+  std::vector<double> d_error_;      ///< Filtered error derivatives.
+  std::vector<double> error_dot_;    ///< Preallocated workspace variable.
+
+  ros::ServiceServer set_gains_service_;
+
+  static bool isFinite(double value) {return std::abs(value) <= std::numeric_limits<double>::max();}
+
+  /**
+   * \brief Compute the commands of loops <tt>[begin, end)</tt>, all of which must have finite inputs.
+   *
+   * The loop body is branch-free, and the restrict-qualified arguments tell the compiler that inputs, outputs and
+   * internal state don't overlap, so that it can be vectorized without runtime alias checks.
+   */
+  static void computeCommands(const RtGains& rt_gains,
+                              unsigned int begin,
+                              unsigned int end,
+                              double dt,
+                              const double* __restrict error,
+                              const double* __restrict error_dot,
+                              double* __restrict command,
+                              double* __restrict i_error,
+                              double* __restrict d_error)
+  {
+    const double* p           = rt_gains.gains.p.data();
+    const double* i           = rt_gains.gains.i.data();
+    const double* d           = rt_gains.gains.d.data();
+    const double* d_filter_tc = rt_gains.gains.d_filter_time_constant.data();
+    const double* i_state_min = rt_gains.i_state_min.data();
+    const double* i_state_max = rt_gains.i_state_max.data();
+    const double* i_term_min  = rt_gains.i_term_min.data();
+    const double* i_term_max  = rt_gains.i_term_max.data();
+
+    for (unsigned int k = begin; k < end; ++k)
+    {
+      const double alpha  = dt / (d_filter_tc[k] + dt);
+      d_error[k]         += alpha * (error_dot[k] - d_error[k]);
+      i_error[k]          = std::min(std::max(i_error[k] + dt * error[k], i_state_min[k]), i_state_max[k]);
+      const double i_term = std::min(std::max(i[k] * i_error[k], i_term_min[k]), i_term_max[k]);
+      command[k]          = p[k] * error[k] + i_term + d[k] * d_error[k];
+    }
+  }
+
+  static bool isValid(const Gains& gains, unsigned int size, std::string* error_string)
+  {
+    std::string msg;
+    if (gains.size() != size)
+    {
+      msg = "Expected gains for " + std::to_string(size) + " loops.";
+    }
+    for (unsigned int k = 0; k < gains.size() && msg.empty(); ++k)
+    {
+      if (gains.i_min[k] > gains.i_max[k])
+      {
+        msg = "Integral clamps of loop " + std::to_string(k) + " are inconsistent: i_clamp_min > i_clamp_max.";
+      }
+      else if (gains.d_filter_time_constant[k] < 0.0)
+      {
+        msg = "Derivative filter time constant of loop " + std::to_string(k) + " is negative.";
+      }
+    }
+
+    if (!msg.empty() && error_string) {*error_string = msg;}
+    return msg.empty();
+  }
+
+  static void setRtGains(const Gains& gains, RtGains& rt_gains)
+  {
+    const double inf = std::numeric_limits<double>::infinity();
+    const unsigned int n = gains.size();
+
+    rt_gains.gains = gains;
+    rt_gains.i_state_min.assign(n, -inf);
+    rt_gains.i_state_max.assign(n,  inf);
+    rt_gains.i_term_min.assign(n,  -inf);
+    rt_gains.i_term_max.assign(n,   inf);
+    for (unsigned int k = 0; k < n; ++k)
+    {
+      if (!gains.antiwindup[k])
+      {
+        rt_gains.i_term_min[k] = gains.i_min[k];
+        rt_gains.i_term_max[k] = gains.i_max[k];
+      }
+      else if (gains.i[k] != 0.0)
+      {
+        rt_gains.i_state_min[k] = gains.i_min[k] / std::abs(gains.i[k]);
+        rt_gains.i_state_max[k] = gains.i_max[k] / std::abs(gains.i[k]);
+      }
+      else
+      {
+        // No integral action, keep the integral state from growing unbounded
+        rt_gains.i_state_min[k] = 0.0;
+        rt_gains.i_state_max[k] = 0.0;
+      }
+    }
+  }
+
+  bool setGainsService(SetGains::Request& req, SetGains::Response& resp)
+  {
+    Gains gains = getGains();
+
+    // Empty fields leave the corresponding gains unchanged
+    if (!req.p.empty())           {gains.p     = req.p;}
+    if (!req.i.empty())           {gains.i     = req.i;}
+    if (!req.d.empty())           {gains.d     = req.d;}
+    if (!req.i_clamp_max.empty()) {gains.i_max = req.i_clamp_max;}
+    if (!req.i_clamp_min.empty()) {gains.i_min = req.i_clamp_min;}
+    if (!req.antiwindup.empty())  {gains.antiwindup.assign(req.antiwindup.begin(), req.antiwindup.end());}
+    if (!req.d_filter_time_constant.empty()) {gains.d_filter_time_constant = req.d_filter_time_constant;}
+
+    resp.success = setGains(gains, &resp.message);
+    if (resp.success) {resp.message = "Gains updated.";}
+    else              {ROS_ERROR_STREAM("Can't set PID gains. " << resp.message);}
+    return true;
+  }
+};
+
+} // namespace
+
+#endif // header guard
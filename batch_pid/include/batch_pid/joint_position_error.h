@@ -0,0 +1,171 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef BATCH_PID_JOINT_POSITION_ERROR_H
+#define BATCH_PID_JOINT_POSITION_ERROR_H
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <angles/angles.h>
+#include <ros/console.h>
+#include <urdf/model.h>
+
+namespace batch_pid
+{
+
+/**
+ * \brief Position error of a group of joints, taking joint limits and angle wraparound into account.
+ *
+ * Joint types and limits are extracted from the URDF at initialization, so that \ref compute does not need to look
+ * into the URDF model. Commands are clamped to the joint limits, and the error of revolute and continuous joints is the
+ * shortest angular distance to the clamped command.
+ */
+class JointPositionError
+{
+public:
+  /**
+   * \brief Cache the types and limits of a group of joints.
+   *
+   * \param urdf Robot model.
+   * \param joint_names Names of the joints, in the order used by \ref compute.
+   *
+   * \returns True if all joints were found in \p urdf, and limited joints have limits specified.
+   */
+  bool init(const urdf::Model& urdf, const std::vector<std::string>& joint_names)
+  {
+    const std::vector<std::string>::size_type n_joints = joint_names.size();
+    joint_descriptors_.type.assign(n_joints, JointDescriptors::PRISMATIC);
+    joint_descriptors_.lower.assign(n_joints, -std::numeric_limits<double>::infinity());
+    joint_descriptors_.upper.assign(n_joints,  std::numeric_limits<double>::infinity());
+    angular_joint_ids_.clear();
+    command_positions_.assign(n_joints, 0.0);
+
+    for (unsigned int i = 0; i < n_joints; ++i)
+    {
+      const std::string& joint_name = joint_names[i];
+      urdf::JointConstSharedPtr joint_urdf = urdf.getJoint(joint_name);
+      if (!joint_urdf)
+      {
+        ROS_ERROR("Could not find joint '%s' in urdf", joint_name.c_str());
+        return false;
+      }
+
+      if (joint_urdf->type == urdf::Joint::REVOLUTE || joint_urdf->type == urdf::Joint::PRISMATIC)
+      {
+        if (!joint_urdf->limits)
+        {
+          ROS_ERROR("Joint '%s' has no limits specified in urdf", joint_name.c_str());
+          return false;
+        }
+        joint_descriptors_.lower[i] = joint_urdf->limits->lower;
+        joint_descriptors_.upper[i] = joint_urdf->limits->upper;
+      }
+
+      if (joint_urdf->type == urdf::Joint::REVOLUTE)
+      {
+        joint_descriptors_.type[i] = JointDescriptors::REVOLUTE;
+        angular_joint_ids_.push_back(i);
+      }
+      else if (joint_urdf->type == urdf::Joint::CONTINUOUS)
+      {
+        joint_descriptors_.type[i] = JointDescriptors::CONTINUOUS;
+        angular_joint_ids_.push_back(i);
+      }
+    }
+    return true;
+  }
+
+  /**
+   * \brief Compute the position errors of all joints. Realtime-safe.
+   *
+   * \param command Commanded positions, one per joint. Values out of the joint limits are clamped.
+   * \param current Current positions, one per joint.
+   * \param error Output position errors, one per joint.
+   */
+  void compute(const double* command, const double* current, double* error)
+  {
+    // Joints without applicable limits have infinite bounds, so this loop is branch-free
+    const double* lower            = joint_descriptors_.lower.data();
+    const double* upper            = joint_descriptors_.upper.data();
+    double*       command_position = command_positions_.data();
+    const unsigned int n_joints    = command_positions_.size();
+    for (unsigned int i = 0; i < n_joints; ++i)
+    {
+      command_position[i] = std::min(std::max(command[i], lower[i]), upper[i]);
+      error[i] = command_position[i] - current[i];
+    }
+
+    // Compute position error of angular joints
+    for (const auto i : angular_joint_ids_)
+    {
+      if (joint_descriptors_.type[i] == JointDescriptors::REVOLUTE)
+      {
+        angles::shortest_angular_distance_with_limits(
+          current[i],
+          command_position[i],
+          lower[i],
+          upper[i],
+          error[i]);
+      }
+      else // continuous
+      {
+        error[i] = angles::normalize_angle(error[i]);
+      }
+    }
+  }
+
+private:
+  /**
+   * \brief Joint types and limits, stored per field in contiguous arrays, one entry per joint.
+   */
+  struct JointDescriptors
+  {
+    enum Type {PRISMATIC, REVOLUTE, CONTINUOUS};
+
+    std::vector<Type>   type;  ///< Determines how the position error is computed.
+    std::vector<double> lower; ///< Lower position limits, -inf if the joint has no applicable limits.
+    std::vector<double> upper; ///< Upper position limits, +inf if the joint has no applicable limits.
+  };
+
+  JointDescriptors          joint_descriptors_;
+  std::vector<unsigned int> angular_joint_ids_; ///< Indices of revolute and continuous joints.
+  std::vector<double>       command_positions_; ///< Preallocated workspace variable.
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,338 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef BATCH_PID_PID_STATE_PUBLISHER_H
+#define BATCH_PID_PID_STATE_PUBLISHER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <boost/lockfree/spsc_queue.hpp>
+
+#include <control_msgs/JointControllerState.h>
+#include <control_toolbox/pid.h>
+#include <dynamic_reconfigure/Config.h>
+#include <realtime_tools/realtime_publisher.h>
+#include <ros/node_handle.h>
+
+namespace batch_pid
+{
+
+/**
+ * \brief Realtime-safe publisher of the state of a single-joint PID controller.
+ *
+ * State is published at a configurable rate, or on every tenth control cycle if no rate is given. By default only the
+ * most recent sample is published once per publish period, and cycles in between are not sampled at all. When
+ * batching is enabled, every control cycle is sampled into a preallocated lock-free queue, which a non-realtime thread
+ * drains once per publish period, so that no samples are lost.
+ *
+ * Publishers created without their own publisher thread always queue samples, and leave publishing to the owner of
+ * the thread, which calls \ref publishQueued. This allows a group of controllers to share a single thread.
+ *
+ * PID gains are cached, and only read again from the PID controller after it publishes a dynamic reconfigure update,
+ * which it does whenever its gains change.
+ *
+ * \section ROS interface
+ *
+ * \param state_publish_rate Publish rate, in Hz. If not set, the default given to \ref init is used if any. Otherwise,
+ * state is published on every tenth control cycle, and queued samples are published at 100 Hz.
+ * \param state_batch_size Maximum number of samples queued between publishes. Zero disables batching (default).
+ *
+ * Subscribes to:
+ * - \b pid/parameter_updates (dynamic_reconfigure::Config) : Gain updates of the PID controller.
+ *
+ * Publishes:
+ * - \b state (control_msgs::JointControllerState) : Current state of the controller, including pid error and gains.
+ *
+ * Typical usage from the control loop:
+ * \code
+ * if (control_msgs::JointControllerState* state = state_publisher_.sample(time))
+ * {
+ *   state->error = error;
+ *   // ...
+ *   state_publisher_.publish();
+ * }
+ * \endcode
+ */
+class PidStatePublisher
+{
+public:
+  PidStatePublisher()
+    : pid_(nullptr),
+      cycles_per_publish_(0),
+      cycle_count_(0),
+      batching_(false),
+      gains_changed_(false),
+      sample_(nullptr),
+      keep_running_(false),
+      dropped_samples_(0)
+  {}
+
+  ~PidStatePublisher()
+  {
+    gains_sub_.shutdown();
+    stop();
+  }
+
+  /**
+   * \param nh Node handle the publisher parameters and topic are relative to.
+   * \param pid PID controller whose gains are published, initialized from the \p pid namespace of \p nh. Must outlive
+   * this instance.
+   * \param own_thread If false, queued samples are only published by calls to \ref publishQueued.
+   * \param default_state_publish_rate Publish rate used if \p state_publish_rate is not set. Ignored if not positive.
+   * \returns True if initialization was successful.
+   */
+  bool init(const ros::NodeHandle& nh,
+            control_toolbox::Pid&  pid,
+            bool                   own_thread = true,
+            double                 default_state_publish_rate = 0.0)
+  {
+    stop();
+    pid_ = &pid;
+
+    // Without a publish rate, keep publishing on every tenth control cycle, as these controllers always did
+    double state_publish_rate = DEFAULT_QUEUE_PUBLISH_RATE;
+    const bool has_default_rate = default_state_publish_rate > 0.0;
+    if (has_default_rate) {state_publish_rate = default_state_publish_rate;}
+    if (nh.getParam("state_publish_rate", state_publish_rate) || has_default_rate)
+    {
+      if (state_publish_rate <= 0.0)
+      {
+        ROS_ERROR_STREAM("State publish rate must be positive (namespace: " << nh.getNamespace() << ").");
+        return false;
+      }
+      cycles_per_publish_ = 0;
+    }
+    else
+    {
+      cycles_per_publish_ = DEFAULT_CYCLES_PER_PUBLISH;
+    }
+    publish_period_ = ros::Duration(1.0 / state_publish_rate);
+    cycle_count_ = 0;
+
+    int state_batch_size = 0;
+    nh.getParam("state_batch_size", state_batch_size);
+    if (state_batch_size < 0)
+    {
+      ROS_ERROR_STREAM("State batch size can't be negative (namespace: " << nh.getNamespace() << ").");
+      return false;
+    }
+
+    batching_ = state_batch_size > 0;
+
+    ros::NodeHandle state_nh(nh);
+    if (!batching_ && own_thread)
+    {
+      queue_.reset();
+      realtime_publisher_.reset(
+        new realtime_tools::RealtimePublisher<control_msgs::JointControllerState>(state_nh, "state", 1));
+    }
+    else
+    {
+      // Without batching, a single slot holds the sample of the current publish period
+      const unsigned int queue_size = batching_ ? state_batch_size : 1;
+      realtime_publisher_.reset();
+      queue_.reset(new Queue(queue_size));
+      publisher_ = state_nh.advertise<control_msgs::JointControllerState>("state", queue_size);
+      dropped_samples_ = 0;
+      if (own_thread)
+      {
+        keep_running_ = true;
+        publisher_thread_ = std::thread(&PidStatePublisher::publisherLoop, this);
+      }
+    }
+
+    last_publish_time_ = ros::Time();
+
+    // Gains are read on the first sample, and whenever the PID controller reports new ones
+    gains_changed_ = true;
+    ros::NodeHandle pid_nh(nh, "pid");
+    gains_sub_ = pid_nh.subscribe<dynamic_reconfigure::Config>("parameter_updates", 1,
+                                                                &PidStatePublisher::gainsUpdateCB, this);
+    return true;
+  }
+
+  /**
+   * \brief Start a new sample, if one is due. This method is realtime-safe.
+   *
+   * \param time Current time, used as sample stamp.
+   * \returns Message to fill with the controller state, which has its header and gains already set, or null if no
+   * sample is due or the publisher is not initialized. A non-null message must be followed by a call to \ref publish.
+   */
+  control_msgs::JointControllerState* sample(const ros::Time& time)
+  {
+    if (!realtime_publisher_ && !queue_) {return nullptr;}
+
+    bool period_elapsed;
+    if (cycles_per_publish_ > 0)
+    {
+      period_elapsed = cycle_count_ == 0;
+      cycle_count_ = (cycle_count_ + 1) % cycles_per_publish_;
+    }
+    else
+    {
+      // Clock going backwards, e.g. when a simulation is reset, restarts the publish period
+      period_elapsed = time < last_publish_time_ || last_publish_time_ + publish_period_ <= time;
+      if (period_elapsed) {last_publish_time_ = time;}
+    }
+
+    if (realtime_publisher_)
+    {
+      if (!period_elapsed || !realtime_publisher_->trylock()) {return nullptr;}
+      sample_ = &realtime_publisher_->msg_;
+    }
+    else
+    {
+      if (!batching_ && !period_elapsed) {return nullptr;}
+      sample_ = &queue_sample_;
+    }
+
+    if (gains_changed_.exchange(false)) {gains_ = pid_->getGains();}
+    sample_->header.stamp = time;
+    sample_->p            = gains_.p_gain_;
+    sample_->i            = gains_.i_gain_;
+    sample_->d            = gains_.d_gain_;
+    sample_->i_clamp      = gains_.i_max_;
+    sample_->antiwindup   = static_cast<char>(gains_.antiwindup_);
+    return sample_;
+  }
+
+  /**
+   * \brief Publish the sample started by the last successful call to \ref sample. This method is realtime-safe.
+   */
+  void publish()
+  {
+    if (realtime_publisher_)
+    {
+      realtime_publisher_->unlockAndPublish();
+    }
+    else if (!queue_->push(*sample_) && batching_)
+    {
+      // Without batching, samples are only meant to be published if the previous one has already been
+      ++dropped_samples_;
+    }
+  }
+
+  /**
+   * \brief Publish all queued samples. This method is \e not realtime-safe.
+   *
+   * Only needs to be called by owners of publishers initialized without their own publisher thread.
+   */
+  void publishQueued()
+  {
+    if (!queue_) {return;}
+
+    while (queue_->pop(published_sample_)) {publisher_.publish(published_sample_);}
+
+    const unsigned int dropped_samples = dropped_samples_.exchange(0);
+    if (dropped_samples > 0)
+    {
+      ROS_WARN_STREAM("Dropped " << dropped_samples << " controller state samples on topic '" << publisher_.getTopic()
+                      << "'. Consider increasing the state batch size or the publish rate.");
+    }
+  }
+
+private:
+  typedef boost::lockfree::spsc_queue<control_msgs::JointControllerState> Queue;
+
+  static constexpr unsigned int DEFAULT_CYCLES_PER_PUBLISH = 10;
+  static constexpr double DEFAULT_QUEUE_PUBLISH_RATE = 100.0; ///< Hz, ten cycles at the usual 1 kHz control rate.
+
+  control_toolbox::Pid* pid_;
+  control_toolbox::Pid::Gains gains_;      ///< Gains cached for the samples, updated when \ref gains_changed_ is set.
+
+  ros::Duration publish_period_;
+  ros::Time last_publish_time_;
+  unsigned int cycles_per_publish_;        ///< Zero if state is published at \ref publish_period_ instead.
+  unsigned int cycle_count_;
+  bool batching_;
+
+  ros::Subscriber gains_sub_;
+  std::atomic<bool> gains_changed_;
+
+  control_msgs::JointControllerState* sample_;
+
+  // Non-batching mode
+  std::unique_ptr<realtime_tools::RealtimePublisher<control_msgs::JointControllerState> > realtime_publisher_;
+
+  // Batching mode, or no own publisher thread
+  control_msgs::JointControllerState queue_sample_;
+  control_msgs::JointControllerState published_sample_;
+  std::unique_ptr<Queue> queue_;
+  ros::Publisher publisher_;
+  std::thread publisher_thread_;
+  std::mutex mutex_;
+  std::condition_variable stop_cond_;
+  bool keep_running_;                      ///< Protected by \ref mutex_.
+  std::atomic<unsigned int> dropped_samples_;
+
+  void gainsUpdateCB(const dynamic_reconfigure::ConfigConstPtr& /*config*/)
+  {
+    gains_changed_ = true;
+  }
+
+  void publisherLoop()
+  {
+    const std::chrono::duration<double> period(publish_period_.toSec());
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (keep_running_)
+    {
+      stop_cond_.wait_for(lock, period, [this] {return !keep_running_;});
+
+      lock.unlock();
+      publishQueued();
+      lock.lock();
+    }
+  }
+
+  void stop()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      keep_running_ = false;
+    }
+    stop_cond_.notify_all();
+    if (publisher_thread_.joinable()) {publisher_thread_.join();}
+  }
+};
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,126 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/// \file Compares the per-cycle cost of BatchPid against one control_toolbox::Pid per joint.
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <control_toolbox/pid.h>
+#include <batch_pid/batch_pid.h>
+
+namespace
+{
+
+const unsigned int CYCLES = 100000;
+const double DT = 0.001;
+
+// Keeps the optimizer from discarding the computed commands
+volatile double sink;
+
+double error(unsigned int joint, unsigned int cycle)
+{
+  return std::sin(1e-3 * cycle + joint);
+}
+
+template <class F>
+double nsPerCycle(F compute)
+{
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (unsigned int cycle = 0; cycle < CYCLES; ++cycle) {compute(cycle);}
+  const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / CYCLES;
+}
+
+void benchmark(unsigned int n_joints)
+{
+  batch_pid::BatchPid::Gains gains(n_joints);
+  std::vector<control_toolbox::Pid> pids(n_joints);
+  for (unsigned int k = 0; k < n_joints; ++k)
+  {
+    gains.p[k]     =  100.0;
+    gains.i[k]     =  1.0;
+    gains.d[k]     =  10.0;
+    gains.i_max[k] =  5.0;
+    gains.i_min[k] = -5.0;
+    pids[k].initPid(gains.p[k], gains.i[k], gains.d[k], gains.i_max[k], gains.i_min[k]);
+  }
+
+  batch_pid::BatchPid batch_pid;
+  batch_pid.init(gains);
+
+  // Errors are precomputed so that only the PID evaluation is measured
+  std::vector<std::vector<double> > errors(64, std::vector<double>(n_joints));
+  for (unsigned int cycle = 0; cycle < errors.size(); ++cycle)
+  {
+    for (unsigned int k = 0; k < n_joints; ++k) {errors[cycle][k] = error(k, cycle);}
+  }
+  std::vector<double> commands(n_joints);
+
+  const ros::Duration period(DT);
+  const double pid_ns = nsPerCycle([&](unsigned int cycle)
+  {
+    const std::vector<double>& e = errors[cycle % errors.size()];
+    for (unsigned int k = 0; k < n_joints; ++k) {commands[k] = pids[k].computeCommand(e[k], period);}
+    sink = commands[0];
+  });
+
+  const double batch_ns = nsPerCycle([&](unsigned int cycle)
+  {
+    batch_pid.computeCommand(errors[cycle % errors.size()].data(), DT, commands.data());
+    sink = commands[0];
+  });
+
+  std::cout << std::setw(8)  << n_joints
+            << std::setw(16) << std::fixed << std::setprecision(1) << pid_ns
+            << std::setw(16) << batch_ns
+            << std::setw(10) << std::setprecision(2) << pid_ns / batch_ns << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  std::cout << std::setw(8)  << "joints"
+            << std::setw(16) << "Pid [ns/cycle]"
+            << std::setw(16) << "Batch [ns/cycle]"
+            << std::setw(10) << "speedup" << std::endl;
+
+  const unsigned int n_joints[] = {7, 14, 28, 40, 64};
+  for (unsigned int n : n_joints) {benchmark(n);}
+  return 0;
+}
@@ -0,0 +1,240 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <control_toolbox/pid.h>
+#include <batch_pid/batch_pid.h>
+
+using batch_pid::BatchPid;
+
+// Floating-point value comparison threshold
+const double EPS = 1e-9;
+
+// Gains exercising all combinations of integral clamping modes
+BatchPid::Gains makeGains()
+{
+  BatchPid::Gains gains(4);
+  const double p[]     = {10.0,  5.0,  2.0, 1.0};
+  const double i[]     = { 0.0,  2.0, -3.0, 4.0};
+  const double d[]     = { 1.0,  0.5,  0.2, 0.0};
+  const double i_max[] = { 1.0,  0.5,  2.0, 0.3};
+  const bool   aw[]    = {false, false, true, true};
+  for (unsigned int k = 0; k < gains.size(); ++k)
+  {
+    gains.p[k]          =  p[k];
+    gains.i[k]          =  i[k];
+    gains.d[k]          =  d[k];
+    gains.i_max[k]      =  i_max[k];
+    gains.i_min[k]      = -i_max[k];
+    gains.antiwindup[k] =  aw[k];
+  }
+  return gains;
+}
+
+double errorAt(unsigned int k, unsigned int cycle)
+{
+  return std::sin(0.05 * cycle + k) * (1.0 + k);
+}
+
+TEST(BatchPidTest, InitFromGains)
+{
+  BatchPid pid;
+  EXPECT_FALSE(pid.init(BatchPid::Gains()));
+
+  // Inconsistent sizes
+  BatchPid::Gains gains = makeGains();
+  gains.d.pop_back();
+  EXPECT_FALSE(pid.init(gains));
+
+  // Inconsistent clamps
+  gains = makeGains();
+  gains.i_min[1] = 1.0;
+  EXPECT_FALSE(pid.init(gains));
+
+  // Negative filter time constant
+  gains = makeGains();
+  gains.d_filter_time_constant[0] = -0.1;
+  EXPECT_FALSE(pid.init(gains));
+
+  EXPECT_TRUE(pid.init(makeGains()));
+  EXPECT_EQ(4, pid.size());
+}
+
+TEST(BatchPidTest, SetGains)
+{
+  BatchPid pid;
+  ASSERT_TRUE(pid.init(makeGains()));
+
+  BatchPid::Gains gains = makeGains();
+  gains.p[2] = 42.0;
+  EXPECT_TRUE(pid.setGains(gains));
+  EXPECT_EQ(42.0, pid.getGains().p[2]);
+
+  // Wrong number of loops leaves gains unchanged
+  BatchPid::Gains bad_gains(3);
+  std::string error_string;
+  EXPECT_FALSE(pid.setGains(bad_gains, &error_string));
+  EXPECT_FALSE(error_string.empty());
+  EXPECT_EQ(42.0, pid.getGains().p[2]);
+}
+
+TEST(BatchPidTest, MatchesControlToolboxPid)
+{
+  const BatchPid::Gains gains = makeGains();
+  const unsigned int n = gains.size();
+
+  BatchPid batch_pid;
+  ASSERT_TRUE(batch_pid.init(gains));
+
+  std::vector<control_toolbox::Pid> pids(n);
+  for (unsigned int k = 0; k < n; ++k)
+  {
+    pids[k].initPid(gains.p[k], gains.i[k], gains.d[k], gains.i_max[k], gains.i_min[k], gains.antiwindup[k]);
+  }
+
+  const double dt = 0.01;
+  std::vector<double> error(n), error_dot(n), command(n);
+
+  // Error derivative computed internally
+  for (unsigned int cycle = 0; cycle < 500; ++cycle)
+  {
+    for (unsigned int k = 0; k < n; ++k) {error[k] = errorAt(k, cycle);}
+    batch_pid.computeCommand(error.data(), dt, command.data());
+    for (unsigned int k = 0; k < n; ++k)
+    {
+      EXPECT_NEAR(pids[k].computeCommand(error[k], ros::Duration(dt)), command[k], EPS);
+    }
+  }
+
+  // Error derivative supplied by the caller
+  batch_pid.reset();
+  for (unsigned int k = 0; k < n; ++k) {pids[k].reset();}
+  for (unsigned int cycle = 0; cycle < 500; ++cycle)
+  {
+    for (unsigned int k = 0; k < n; ++k)
+    {
+      error[k]     = errorAt(k, cycle);
+      error_dot[k] = -errorAt(k, cycle + 10);
+    }
+    batch_pid.computeCommand(error.data(), error_dot.data(), dt, command.data());
+    for (unsigned int k = 0; k < n; ++k)
+    {
+      EXPECT_NEAR(pids[k].computeCommand(error[k], error_dot[k], ros::Duration(dt)), command[k], EPS);
+    }
+  }
+}
+
+TEST(BatchPidTest, DerivativeFilter)
+{
+  BatchPid::Gains gains(1);
+  gains.d[0] = 1.0;
+  gains.d_filter_time_constant[0] = 0.09;
+
+  BatchPid pid;
+  ASSERT_TRUE(pid.init(gains));
+
+  // First-order response to a step in the error derivative: alpha = dt / (tau + dt) = 0.1
+  const double dt = 0.01;
+  const double error = 0.0;
+  const double error_dot = 1.0;
+  double command;
+  pid.computeCommand(&error, &error_dot, dt, &command);
+  EXPECT_NEAR(0.1, command, EPS);
+  pid.computeCommand(&error, &error_dot, dt, &command);
+  EXPECT_NEAR(0.19, command, EPS);
+}
+
+TEST(BatchPidTest, InvalidInput)
+{
+  BatchPid pid;
+  ASSERT_TRUE(pid.init(makeGains()));
+
+  const double dt = 0.01;
+  std::vector<double> error(pid.size(), 1.0);
+  std::vector<double> command(pid.size());
+  std::vector<double> ref_command(pid.size());
+
+  // Non-positive time step yields zero commands
+  pid.computeCommand(error.data(), 0.0, command.data());
+  for (unsigned int k = 0; k < pid.size(); ++k) {EXPECT_EQ(0.0, command[k]);}
+
+  // Non-finite errors yield zero commands for the affected loops only, and don't corrupt their state
+  BatchPid ref_pid;
+  ASSERT_TRUE(ref_pid.init(makeGains()));
+  ref_pid.computeCommand(error.data(), error.data(), dt, ref_command.data());
+  pid.reset();
+  pid.computeCommand(error.data(), error.data(), dt, command.data());
+
+  std::vector<double> bad_error = error;
+  bad_error[1] = std::numeric_limits<double>::quiet_NaN();
+  bad_error[3] = std::numeric_limits<double>::infinity();
+  pid.computeCommand(bad_error.data(), error.data(), dt, command.data());
+  EXPECT_EQ(0.0, command[1]);
+  EXPECT_EQ(0.0, command[3]);
+
+  ref_pid.computeCommand(error.data(), error.data(), dt, ref_command.data());
+  pid.computeCommand(error.data(), error.data(), dt, command.data());
+  EXPECT_NEAR(ref_command[1], command[1], EPS);
+  EXPECT_NEAR(ref_command[3], command[3], EPS);
+}
+
+TEST(BatchPidTest, AlternateOverloads)
+{
+  // Pure derivative loop, so that the command is the error derivative
+  BatchPid::Gains gains(1);
+  gains.d[0] = 1.0;
+  BatchPid pid;
+  ASSERT_TRUE(pid.init(gains));
+
+  const double dt = 0.01;
+  const double error = 1.0;
+  const double error_dot = 0.5;
+  double command;
+  pid.computeCommand(&error, &error_dot, dt, &command);
+  EXPECT_NEAR(error_dot, command, EPS);
+
+  // The error recorded by the precomputed derivative overload is the reference of the differentiated one
+  pid.computeCommand(&error, dt, &command);
+  EXPECT_NEAR(0.0, command, EPS);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
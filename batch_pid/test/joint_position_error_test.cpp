@@ -0,0 +1,116 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <urdf/model.h>
+#include <batch_pid/joint_position_error.h>
+
+using batch_pid::JointPositionError;
+
+// Floating-point value comparison threshold
+const double EPS = 1e-9;
+
+const std::string URDF =
+  "<robot name=\"robot\">"
+  "  <link name=\"base\"/>"
+  "  <link name=\"link1\"/>"
+  "  <link name=\"link2\"/>"
+  "  <link name=\"link3\"/>"
+  "  <joint name=\"prismatic\" type=\"prismatic\">"
+  "    <parent link=\"base\"/><child link=\"link1\"/>"
+  "    <limit lower=\"-0.5\" upper=\"0.5\" effort=\"10\" velocity=\"1\"/>"
+  "  </joint>"
+  "  <joint name=\"revolute\" type=\"revolute\">"
+  "    <parent link=\"link1\"/><child link=\"link2\"/>"
+  "    <limit lower=\"-1.0\" upper=\"1.5\" effort=\"10\" velocity=\"1\"/>"
+  "  </joint>"
+  "  <joint name=\"continuous\" type=\"continuous\">"
+  "    <parent link=\"link2\"/><child link=\"link3\"/>"
+  "  </joint>"
+  "</robot>";
+
+TEST(JointPositionErrorTest, Init)
+{
+  urdf::Model urdf;
+  ASSERT_TRUE(urdf.initString(URDF));
+
+  JointPositionError position_error;
+  EXPECT_TRUE(position_error.init(urdf, {"continuous", "prismatic", "revolute"}));
+  EXPECT_FALSE(position_error.init(urdf, {"prismatic", "unknown"}));
+
+  // Limited joints must have limits
+  const std::string no_limits = "<limit lower=\"-0.5\" upper=\"0.5\" effort=\"10\" velocity=\"1\"/>";
+  std::string urdf_string = URDF;
+  urdf_string.erase(urdf_string.find(no_limits), no_limits.size());
+  urdf::Model urdf_no_limits;
+  ASSERT_TRUE(urdf_no_limits.initString(urdf_string));
+  EXPECT_FALSE(position_error.init(urdf_no_limits, {"prismatic"}));
+  EXPECT_TRUE(position_error.init(urdf_no_limits, {"revolute", "continuous"}));
+}
+
+TEST(JointPositionErrorTest, Compute)
+{
+  urdf::Model urdf;
+  ASSERT_TRUE(urdf.initString(URDF));
+
+  JointPositionError position_error;
+  ASSERT_TRUE(position_error.init(urdf, {"prismatic", "revolute", "continuous"}));
+
+  std::vector<double> error(3);
+  const std::vector<double> current = {0.1, 0.5, 3.0};
+
+  // Within limits
+  std::vector<double> command = {0.2, 1.0, 3.1};
+  position_error.compute(command.data(), current.data(), error.data());
+  EXPECT_NEAR(0.1, error[0], EPS);
+  EXPECT_NEAR(0.5, error[1], EPS);
+  EXPECT_NEAR(0.1, error[2], EPS);
+
+  // Commands out of the limits are clamped, and continuous joints take the shortest path
+  command = {2.0, 3.0, -3.0};
+  position_error.compute(command.data(), current.data(), error.data());
+  EXPECT_NEAR(0.4, error[0], EPS);
+  EXPECT_NEAR(1.0, error[1], EPS);
+  EXPECT_NEAR(2.0 * M_PI - 6.0, error[2], EPS);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
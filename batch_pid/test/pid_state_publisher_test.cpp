@@ -0,0 +1,128 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <ros/ros.h>
+#include <control_toolbox/pid.h>
+#include <dynamic_reconfigure/Config.h>
+
+#include <batch_pid/pid_state_publisher.h>
+
+using batch_pid::PidStatePublisher;
+
+// Sample the publisher on \p cycles control cycles of \p period, starting at \p start, and return the number of samples
+unsigned int countSamples(PidStatePublisher& publisher, const ros::Time& start, double period, unsigned int cycles)
+{
+  unsigned int samples = 0;
+  for (unsigned int k = 0; k < cycles; ++k)
+  {
+    if (publisher.sample(start + ros::Duration(k * period)))
+    {
+      publisher.publish();
+      ++samples;
+    }
+    publisher.publishQueued();
+  }
+  return samples;
+}
+
+TEST(PidStatePublisherTest, DefaultsToEveryTenthCycle)
+{
+  control_toolbox::Pid pid;
+  PidStatePublisher publisher;
+  ASSERT_TRUE(publisher.init(ros::NodeHandle("default_rate"), pid, false));
+
+  EXPECT_EQ(3u, countSamples(publisher, ros::Time(1.0), 0.001, 30));
+
+  // Independent of the control rate
+  EXPECT_EQ(3u, countSamples(publisher, ros::Time(2.0), 0.1, 30));
+}
+
+TEST(PidStatePublisherTest, PublishRate)
+{
+  control_toolbox::Pid pid;
+  PidStatePublisher publisher;
+  ASSERT_TRUE(publisher.init(ros::NodeHandle("publish_rate"), pid, false));
+
+  // 10 Hz over one second of 100 Hz control cycles
+  EXPECT_NEAR(10, countSamples(publisher, ros::Time(1.0), 0.01, 100), 1);
+
+  ros::NodeHandle bad_rate_nh("bad_publish_rate");
+  EXPECT_FALSE(publisher.init(bad_rate_nh, pid, false));
+}
+
+TEST(PidStatePublisherTest, GainsUpdatedOnChange)
+{
+  ros::NodeHandle nh("default_rate");
+  ros::Publisher gains_pub = nh.advertise<dynamic_reconfigure::Config>("pid/parameter_updates", 1);
+
+  control_toolbox::Pid pid;
+  pid.initPid(1.0, 0.0, 0.0, 0.0, 0.0);
+  PidStatePublisher publisher;
+  ASSERT_TRUE(publisher.init(nh, pid, false));
+
+  control_msgs::JointControllerState* state = publisher.sample(ros::Time(1.0));
+  ASSERT_TRUE(state != nullptr);
+  EXPECT_EQ(1.0, state->p);
+  publisher.publish();
+  publisher.publishQueued();
+
+  // Gains are cached until the PID controller reports an update
+  pid.setGains(2.0, 0.0, 0.0, 0.0, 0.0);
+  const ros::Time timeout = ros::Time::now() + ros::Duration(5.0);
+  while (gains_pub.getNumSubscribers() == 0 && ros::Time::now() < timeout) {ros::Duration(0.01).sleep();}
+  gains_pub.publish(dynamic_reconfigure::Config());
+
+  double p = 1.0;
+  for (unsigned int k = 1; p != 2.0 && ros::Time::now() < timeout; ++k)
+  {
+    ros::spinOnce();
+    if ((state = publisher.sample(ros::Time(1.0 + 0.001 * k))))
+    {
+      p = state->p;
+      publisher.publish();
+      publisher.publishQueued();
+    }
+    ros::Duration(0.001).sleep();
+  }
+  EXPECT_EQ(2.0, p);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "pid_state_publisher_test");
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,216 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef CARTESIAN_TRAJECTORY_CONTROLLER_CARTESIAN_TRAJECTORY_CONTROLLER_H
+#define CARTESIAN_TRAJECTORY_CONTROLLER_CARTESIAN_TRAJECTORY_CONTROLLER_H
+
+// C++ standard
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Boost
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+// ROS
+#include <ros/node_handle.h>
+
+// URDF
+#include <urdf/model.h>
+
+// ROS messages
+#include <control_msgs/JointTrajectoryControllerState.h>
+#include <trajectory_msgs/MultiDOFJointTrajectory.h>
+
+// realtime_tools
+#include <realtime_tools/realtime_box.h>
+#include <realtime_tools/realtime_publisher.h>
+
+// ros_controls
+#include <controller_interface/controller.h>
+#include <hardware_interface/joint_command_interface.h>
+
+// Project
+#include <trajectory_interface/quintic_spline_segment.h>
+#include <trajectory_interface/trajectory_interface.h>
+#include <joint_trajectory_controller/hardware_interface_adapter.h>
+#include <joint_trajectory_controller/joint_trajectory_segment.h>
+#include <joint_trajectory_controller/rigid_body_chain.h>
+
+#include <cartesian_trajectory_controller/cartesian_trajectory_segment.h>
+#include <cartesian_trajectory_controller/differential_ik.h>
+
+namespace cartesian_trajectory_controller
+{
+
+/**
+ * \brief Controller for executing Cartesian trajectories of the tip of a serial chain of joints.
+ *
+ * Each control cycle, the Cartesian trajectory is sampled and the desired joint positions are resolved by
+ * \ref DifferentialIk, seeded with those of the previous cycle. Desired joint velocities map the sampled tip twist
+ * through the chain Jacobian, and desired joint accelerations are their finite differences. The resulting joint-space
+ * desired state is sent to the hardware through the same adapters used by the joint trajectory controller, so the
+ * position, velocity and effort variants take the same \p gains, \p velocity_ff and \p inverse_dynamics parameters.
+ *
+ * Trajectories are received in the \p command topic as \p trajectory_msgs::MultiDOFJointTrajectory messages with one
+ * transform per point: the desired tip pose in the URDF root frame. Point velocities and accelerations are optional,
+ * and default to zero. A new trajectory replaces the current one from its start time on, bridged from the state
+ * the current trajectory has at that time. An empty trajectory holds the current pose.
+ *
+ * The following is an example configuration of a controller using an effort interface:
+ * \code
+ * arm_controller:
+ *   type: "effort_controllers/CartesianTrajectoryController"
+ *   joints: [joint1, joint2, joint3, joint4, joint5, joint6]
+ *   tip_link: tool0     # Optional, defaults to the child link of the last joint of the chain
+ *   ik:
+ *     max_iterations: 10
+ *     damping: 0.01
+ *     position_tolerance: 1.0e-5
+ *     orientation_tolerance: 1.0e-4
+ *     max_step: 0.2
+ *   gains:
+ *     joint1: {p: 200, d: 1, i: 5, i_clamp: 1}
+ *     ...
+ *   state_publish_rate: 25
+ * \endcode
+ *
+ * \tparam HardwareInterface Controller hardware interface. Currently \p hardware_interface::PositionJointInterface,
+ * \p hardware_interface::VelocityJointInterface, and \p hardware_interface::EffortJointInterface are supported
+ * out-of-the-box.
+ */
+template <class HardwareInterface>
+class CartesianTrajectoryController : public controller_interface::Controller<HardwareInterface>
+{
+public:
+
+  CartesianTrajectoryController();
+
+  /** \name Non Real-Time Safe Functions
+   *\{*/
+  bool init(HardwareInterface* hw, ros::NodeHandle& root_nh, ros::NodeHandle& controller_nh);
+  /*\}*/
+
+  /** \name Real-Time Safe Functions
+   *\{*/
+  /** \brief Holds the current pose. */
+  void starting(const ros::Time& time);
+
+  /** \brief Cancels the active trajectory. */
+  void stopping(const ros::Time& time);
+
+  void update(const ros::Time& time, const ros::Duration& period);
+  /*\}*/
+
+protected:
+
+  struct TimeData
+  {
+    TimeData() : time(0.0), period(0.0), uptime(0.0) {}
+
+    ros::Time     time;   ///< Time of last update cycle
+    ros::Duration period; ///< Period of last update cycle
+    ros::Time     uptime; ///< Controller uptime. Set to zero at every restart.
+  };
+
+  typedef CartesianTrajectorySegment                                   Segment;
+  typedef std::vector<Segment>                                         Trajectory;
+  typedef boost::shared_ptr<Trajectory>                                TrajectoryPtr;
+  typedef realtime_tools::RealtimeBox<TrajectoryPtr>                   TrajectoryBox;
+  typedef trajectory_msgs::MultiDOFJointTrajectory::ConstPtr           MultiDOFJointTrajectoryConstPtr;
+  typedef realtime_tools::RealtimePublisher<control_msgs::JointTrajectoryControllerState> StatePublisher;
+  typedef boost::scoped_ptr<StatePublisher>                            StatePublisherPtr;
+
+  typedef joint_trajectory_controller::JointTrajectorySegment<trajectory_interface::QuinticSplineSegment<double> >
+          JointSegment;
+  typedef JointSegment::State                                          JointState;
+  typedef HardwareInterfaceAdapter<HardwareInterface, JointState>      HwIfaceAdapter;
+  typedef typename HardwareInterface::ResourceHandleType               JointHandle;
+
+  std::vector<JointHandle>                    joints_;               ///< Handles to controlled joints.
+  std::vector<bool>                           angle_wraparound_;     ///< Whether controlled joints wrap around or not.
+  std::vector<std::string>                    joint_names_;          ///< Controlled joint names.
+  joint_trajectory_controller::RigidBodyChain chain_;                ///< Kinematic model of the controlled joints.
+  DifferentialIk                              ik_;
+  HwIfaceAdapter                              hw_iface_adapter_;     ///< Adapts desired joint state to HW interface.
+
+  TrajectoryBox curr_trajectory_box_;
+  TrajectoryPtr hold_trajectory_ptr_; ///< Last hold trajectory values.
+
+  TimeData                              time_data_;     ///< Time data of the last update. Realtime loop only.
+  realtime_tools::RealtimeBox<TimeData> time_data_box_; ///< Copy of \p time_data_ for non-realtime callbacks.
+
+  /** \brief Copy of the desired joint positions of the last update, from which non-realtime callbacks hold the pose. */
+  realtime_tools::RealtimeBox<std::vector<double> > desired_position_box_;
+
+  Segment::State desired_pose_;        ///< Preallocated workspace variable.
+  JointState     current_state_;       ///< Preallocated workspace variable.
+  JointState     desired_state_;       ///< Preallocated workspace variable.
+  JointState     state_error_;         ///< Preallocated workspace variable.
+  JointState     previous_state_;      ///< Desired joint state of the previous cycle.
+
+  ros::Duration state_publisher_period_;
+  ros::Time     last_state_publish_time_;
+
+  ros::NodeHandle    controller_nh_;
+  ros::Subscriber    trajectory_command_sub_;
+  StatePublisherPtr  state_publisher_;
+  std::string        name_;              ///< Controller name.
+
+  /**
+   * \brief Replace the current trajectory with the one in \p msg, from the start time of the latter.
+   * \param error_string Output error description when returning false, unused if null.
+   * \return True if the trajectory was accepted.
+   */
+  bool updateTrajectoryCommand(const MultiDOFJointTrajectoryConstPtr& msg, std::string* error_string = 0);
+
+  void trajectoryCommandCB(const MultiDOFJointTrajectoryConstPtr& msg);
+
+  /**
+   * \brief Hold the pose of the chain tip at the desired joint positions.
+   * \note This method is realtime-safe, but reuses the realtime loop workspace, so it must only be called from it.
+   */
+  void setHoldPose(const ros::Time& time);
+
+  void publishState(const ros::Time& time);
+};
+
+} // namespace
+
+#include <cartesian_trajectory_controller/cartesian_trajectory_controller_impl.h>
+
+#endif // header guard
@@ -0,0 +1,469 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef CARTESIAN_TRAJECTORY_CONTROLLER_CARTESIAN_TRAJECTORY_CONTROLLER_IMPL_H
+#define CARTESIAN_TRAJECTORY_CONTROLLER_CARTESIAN_TRAJECTORY_CONTROLLER_IMPL_H
+
+#include <angles/angles.h>
+
+namespace cartesian_trajectory_controller
+{
+
+namespace internal
+{
+
+inline std::string getLeafNamespace(const ros::NodeHandle& nh)
+{
+  const std::string complete_ns = nh.getNamespace();
+  std::size_t id   = complete_ns.find_last_of("/");
+  return complete_ns.substr(id + 1);
+}
+
+inline Vector3 toVector3(const geometry_msgs::Vector3& v) {return {v.x, v.y, v.z};}
+
+/**
+ * \brief Convert a trajectory point to the Cartesian state of its first (and only) transform.
+ * \throw std::invalid_argument If the point does not have exactly one transform, or its rotation is not a quaternion.
+ */
+inline CartesianTrajectorySegment::State toState(const trajectory_msgs::MultiDOFJointTrajectoryPoint& point)
+{
+  using joint_trajectory_controller::internal::quaternionMatrix;
+
+  if (point.transforms.size() != 1 || point.velocities.size() > 1 || point.accelerations.size() > 1)
+  {
+    throw(std::invalid_argument("Trajectory points must specify exactly one transform, the desired pose of the "
+                                "chain tip, and at most one velocity and acceleration."));
+  }
+
+  const geometry_msgs::Quaternion& q = point.transforms.front().rotation;
+  const double norm = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+  if (!(norm > 0.0))
+  {
+    throw(std::invalid_argument("Trajectory point rotation is not a valid quaternion."));
+  }
+
+  CartesianTrajectorySegment::State state;
+  state.pose.translation = toVector3(point.transforms.front().translation);
+  state.pose.rotation    = quaternionMatrix(q.x / norm, q.y / norm, q.z / norm, q.w / norm);
+  if (!point.velocities.empty())
+  {
+    state.linear_velocity  = toVector3(point.velocities.front().linear);
+    state.angular_velocity = toVector3(point.velocities.front().angular);
+  }
+  if (!point.accelerations.empty())
+  {
+    state.linear_acceleration  = toVector3(point.accelerations.front().linear);
+    state.angular_acceleration = toVector3(point.accelerations.front().angular);
+  }
+  return state;
+}
+
+} // namespace
+
+template <class HardwareInterface>
+CartesianTrajectoryController<HardwareInterface>::CartesianTrajectoryController()
+  : hold_trajectory_ptr_(new Trajectory(1))
+{}
+
+template <class HardwareInterface>
+bool CartesianTrajectoryController<HardwareInterface>::init(HardwareInterface* hw,
+                                                           ros::NodeHandle&   root_nh,
+                                                           ros::NodeHandle&   controller_nh)
+{
+  using namespace internal;
+
+  // Cache controller node handle
+  controller_nh_ = controller_nh;
+
+  // Controller name
+  name_ = getLeafNamespace(controller_nh_);
+
+  // State publish rate
+  double state_publish_rate = 50.0;
+  controller_nh_.getParam("state_publish_rate", state_publish_rate);
+  ROS_DEBUG_STREAM_NAMED(name_, "Controller state will be published at " << state_publish_rate << "Hz.");
+  state_publisher_period_ = ros::Duration(1.0 / state_publish_rate);
+
+  // List of controlled joints
+  if (!controller_nh_.getParam("joints", joint_names_) || joint_names_.empty())
+  {
+    ROS_ERROR_STREAM_NAMED(name_, "Could not find a non-empty 'joints' parameter (namespace: " <<
+                           controller_nh_.getNamespace() << ").");
+    return false;
+  }
+  const unsigned int n_joints = joint_names_.size();
+
+  // Kinematic model
+  urdf::Model urdf;
+  if (!urdf.initParamWithNodeHandle("robot_description", root_nh))
+  {
+    ROS_ERROR_STREAM_NAMED(name_, "Failed to parse URDF contained in 'robot_description' parameter.");
+    return false;
+  }
+  if (!chain_.init(urdf, joint_names_))
+  {
+    ROS_ERROR_STREAM_NAMED(name_, "Failed to build the kinematic chain of the controlled joints.");
+    return false;
+  }
+  std::string tip_link;
+  if (controller_nh_.getParam("tip_link", tip_link) && !chain_.setTip(urdf, tip_link))
+  {
+    ROS_ERROR_STREAM_NAMED(name_, "Failed to set the chain tip to link '" << tip_link << "'.");
+    return false;
+  }
+
+  // Inverse kinematics
+  ros::NodeHandle ik_nh(controller_nh_, "ik");
+  DifferentialIk::Parameters ik_params;
+  int max_iterations = ik_params.max_iterations;
+  ik_nh.param("max_iterations",        max_iterations,                 max_iterations);
+  ik_nh.param("damping",               ik_params.damping,               ik_params.damping);
+  ik_nh.param("position_tolerance",    ik_params.position_tolerance,    ik_params.position_tolerance);
+  ik_nh.param("orientation_tolerance", ik_params.orientation_tolerance, ik_params.orientation_tolerance);
+  ik_nh.param("max_step",              ik_params.max_step,              ik_params.max_step);
+  ik_params.max_iterations = std::max(max_iterations, 0);
+  if (!ik_.init(chain_, ik_params))
+  {
+    ROS_ERROR_STREAM_NAMED(name_, "Invalid inverse kinematics parameters: 'damping', 'position_tolerance', " <<
+                           "'orientation_tolerance' and 'max_step' must be positive.");
+    return false;
+  }
+
+  // Initialize members
+  joints_.resize(n_joints);
+  angle_wraparound_.resize(n_joints);
+  for (unsigned int i = 0; i < n_joints; ++i)
+  {
+    // Joint handle
+    try {joints_[i] = hw->getHandle(joint_names_[i]);}
+    catch (...)
+    {
+      ROS_ERROR_STREAM_NAMED(name_, "Could not find joint '" << joint_names_[i] << "' in '" <<
+                                    this->getHardwareInterfaceType() << "'.");
+      return false;
+    }
+
+    // Whether a joint is continuous (ie. has angle wraparound). The chain checked that it is in the URDF
+    angle_wraparound_[i] = urdf.getJoint(joint_names_[i])->type == urdf::Joint::CONTINUOUS;
+  }
+
+  ROS_DEBUG_STREAM_NAMED(name_, "Initialized controller '" << name_ << "' with:" <<
+                         "\n- Number of joints: " << joints_.size() <<
+                         "\n- Hardware interface type: '" << this->getHardwareInterfaceType() << "'" <<
+                         "\n- Inverse kinematics iterations: " << ik_params.max_iterations);
+
+  // Hardware interface adapter
+  if (!hw_iface_adapter_.init(joints_, controller_nh_)) {return false;}
+
+  // ROS API: Subscribed topics
+  trajectory_command_sub_ = controller_nh_.subscribe("command", 1,
+                                                     &CartesianTrajectoryController::trajectoryCommandCB, this);
+
+  // ROS API: Published topics
+  state_publisher_.reset(new StatePublisher(controller_nh_, "state", 1));
+
+  // Preeallocate resources
+  current_state_  = JointState(n_joints);
+  desired_state_  = JointState(n_joints);
+  state_error_    = JointState(n_joints);
+  previous_state_ = JointState(n_joints);
+  desired_position_box_.set(std::vector<double>(n_joints, 0.0));
+
+  {
+    state_publisher_->lock();
+    state_publisher_->msg_.joint_names = joint_names_;
+    state_publisher_->msg_.desired.positions.resize(n_joints);
+    state_publisher_->msg_.desired.velocities.resize(n_joints);
+    state_publisher_->msg_.desired.accelerations.resize(n_joints);
+    state_publisher_->msg_.actual.positions.resize(n_joints);
+    state_publisher_->msg_.actual.velocities.resize(n_joints);
+    state_publisher_->msg_.error.positions.resize(n_joints);
+    state_publisher_->msg_.error.velocities.resize(n_joints);
+    state_publisher_->unlock();
+  }
+
+  return true;
+}
+
+template <class HardwareInterface>
+void CartesianTrajectoryController<HardwareInterface>::starting(const ros::Time& time)
+{
+  // Update time data
+  TimeData time_data;
+  time_data.time   = time;
+  time_data.uptime = ros::Time(0.0);
+  time_data_ = time_data;
+  time_data_box_.set(time_data);
+
+  // Initialize the desired state with the current state on startup, at rest
+  for (unsigned int i = 0; i < joints_.size(); ++i)
+  {
+    desired_state_.position[i]      = joints_[i].getPosition();
+    desired_state_.velocity[i]      = 0.0;
+    desired_state_.acceleration[i]  = 0.0;
+    previous_state_.velocity[i]     = 0.0;
+  }
+  desired_position_box_.set(desired_state_.position);
+
+  // Hold current pose
+  setHoldPose(time_data.uptime);
+
+  // Initialize last state update time
+  last_state_publish_time_ = time_data.uptime;
+
+  // Hardware interface adapter
+  hw_iface_adapter_.starting(time_data.uptime);
+}
+
+template <class HardwareInterface>
+void CartesianTrajectoryController<HardwareInterface>::stopping(const ros::Time& time)
+{
+  hw_iface_adapter_.stopping(time);
+}
+
+template <class HardwareInterface>
+void CartesianTrajectoryController<HardwareInterface>::update(const ros::Time& time, const ros::Duration& period)
+{
+  // Get currently followed trajectory. As in the joint trajectory controller, this must precede the time data update
+  TrajectoryPtr curr_traj_ptr;
+  curr_trajectory_box_.get(curr_traj_ptr);
+  const Trajectory& curr_traj = *curr_traj_ptr;
+
+  // Update time data
+  TimeData time_data;
+  time_data.time   = time;                                     // Cache current time
+  time_data.period = period;                                   // Cache current control period
+  time_data.uptime = time_data_.uptime + period;               // Update controller uptime
+  time_data_ = time_data;
+  time_data_box_.set(time_data);
+
+  // Desired Cartesian state
+  if (curr_traj.end() == trajectory_interface::sample(curr_traj, time_data.uptime.toSec(), desired_pose_))
+  {
+    // Non-realtime safe, but should never happen under normal operation
+    ROS_ERROR_NAMED(name_,
+                    "Unexpected error: No trajectory defined at current time. Please contact the package maintainer.");
+    return;
+  }
+
+  // Desired joint state, resolved from the previous one. Vectors have the same size, so copying does not allocate
+  previous_state_.velocity = desired_state_.velocity;
+  if (!ik_.solve(desired_pose_.pose, desired_state_.position))
+  {
+    ROS_WARN_STREAM_THROTTLE_NAMED(1.0, name_, "Inverse kinematics did not converge, with a position error of " <<
+                                   ik_.positionError() << " and an orientation error of " << ik_.orientationError() <<
+                                   ". The desired pose may be out of reach or near a singularity.");
+  }
+  ik_.velocity(desired_pose_.linear_velocity, desired_pose_.angular_velocity, desired_state_.velocity);
+  desired_position_box_.set(desired_state_.position); // Same size, so copying does not allocate
+
+  const double dt = period.toSec();
+  for (unsigned int i = 0; i < joints_.size(); ++i)
+  {
+    desired_state_.acceleration[i] = dt > 0.0 ? (desired_state_.velocity[i] - previous_state_.velocity[i]) / dt : 0.0;
+
+    // Current state and state error
+    current_state_.position[i] = joints_[i].getPosition();
+    current_state_.velocity[i] = joints_[i].getVelocity();
+
+    state_error_.position[i] = angle_wraparound_[i] ?
+      angles::shortest_angular_distance(current_state_.position[i], desired_state_.position[i]) :
+      desired_state_.position[i] - current_state_.position[i];
+    state_error_.velocity[i] = desired_state_.velocity[i] - current_state_.velocity[i];
+    state_error_.acceleration[i] = 0.0;
+  }
+
+  // Hardware interface adapter: Generate and send commands
+  hw_iface_adapter_.updateCommand(time_data.uptime, time_data.period, desired_state_, state_error_);
+
+  // Publish state
+  publishState(time_data.uptime);
+}
+
+template <class HardwareInterface>
+bool CartesianTrajectoryController<HardwareInterface>::
+updateTrajectoryCommand(const MultiDOFJointTrajectoryConstPtr& msg, std::string* error_string)
+{
+  std::string error_string_tmp;
+
+  // Preconditions
+  if (!this->isRunning())
+  {
+    error_string_tmp = "Can't accept new commands. Controller is not running.";
+  }
+  else if (!msg)
+  {
+    error_string_tmp = "Received null-pointer trajectory message, skipping.";
+  }
+  if (!error_string_tmp.empty())
+  {
+    ROS_WARN_STREAM_NAMED(name_, error_string_tmp);
+    if (error_string) {*error_string = error_string_tmp;}
+    return false;
+  }
+
+  // Time data
+  TimeData time_data;
+  time_data_box_.get(time_data);
+
+  // Uptime of the next update
+  const ros::Time next_update_uptime = time_data.uptime + time_data.period;
+
+  // Hold current pose if trajectory is empty. The realtime loop workspace and hold trajectory are not touched here, so
+  // the pose is computed from a copy of the last desired joint positions, into a trajectory of its own
+  if (msg->points.empty())
+  {
+    std::vector<double> desired_position;
+    desired_position_box_.get(desired_position);
+
+    Segment::State hold_state;
+    hold_state.pose = chain_.tipPose(desired_position);
+
+    const Segment::Time hold_time = time_data.uptime.toSec();
+    TrajectoryPtr hold_traj_ptr(new Trajectory(1, Segment(hold_time, hold_state, hold_time, hold_state)));
+    curr_trajectory_box_.set(hold_traj_ptr);
+    ROS_DEBUG_NAMED(name_, "Empty trajectory command, stopping.");
+    return true;
+  }
+
+  try
+  {
+    // Trajectory start time, in the controller uptime. A zero stamp starts the trajectory now
+    const Segment::Time msg_start_time = msg->header.stamp.isZero() ?
+      next_update_uptime.toSec() : (time_data.uptime + (msg->header.stamp - time_data.time)).toSec();
+    const Segment::Time bridge_start_time = std::max(msg_start_time, next_update_uptime.toSec());
+
+    // Points must be in chronological order. Those not later than the bridge start are skipped
+    std::vector<Segment::State> states;
+    std::vector<Segment::Time>  times;
+    for (unsigned int i = 0; i < msg->points.size(); ++i)
+    {
+      const Segment::Time point_time = msg_start_time + msg->points[i].time_from_start.toSec();
+      if (i > 0 && msg->points[i].time_from_start <= msg->points[i - 1].time_from_start)
+      {
+        throw(std::invalid_argument("Trajectory point times are not strictly increasing."));
+      }
+      const Segment::State state = internal::toState(msg->points[i]);
+      if (point_time > bridge_start_time)
+      {
+        states.push_back(state);
+        times.push_back(point_time);
+      }
+    }
+    if (states.empty())
+    {
+      throw(std::invalid_argument("Dropping all trajectory points, as they occur before the current time."));
+    }
+
+    // Segments of the current trajectory that are followed until the new one starts
+    TrajectoryPtr curr_traj_ptr;
+    curr_trajectory_box_.get(curr_traj_ptr);
+    const Trajectory& curr_traj = *curr_traj_ptr;
+
+    TrajectoryPtr traj_ptr(new Trajectory);
+    Trajectory& traj = *traj_ptr;
+    traj.reserve(curr_traj.size() + states.size());
+    typename Trajectory::const_iterator it = trajectory_interface::findSegment(curr_traj, next_update_uptime.toSec());
+    if (it == curr_traj.end()) {it = curr_traj.begin();}
+    for (; it != curr_traj.end() && it->startTime() < bridge_start_time; ++it) {traj.push_back(*it);}
+
+    // Bridge from the current trajectory to the first point, then through the remaining ones
+    Segment::State bridge_state;
+    trajectory_interface::sample(curr_traj, bridge_start_time, bridge_state);
+    traj.push_back(Segment(bridge_start_time, bridge_state, times.front(), states.front()));
+    for (unsigned int i = 1; i < states.size(); ++i)
+    {
+      traj.push_back(Segment(times[i - 1], states[i - 1], times[i], states[i]));
+    }
+
+    curr_trajectory_box_.set(traj_ptr);
+  }
+  catch(const std::exception& ex)
+  {
+    ROS_ERROR_STREAM_NAMED(name_, ex.what());
+    if (error_string) {*error_string = ex.what();}
+    return false;
+  }
+
+  return true;
+}
+
+template <class HardwareInterface>
+void CartesianTrajectoryController<HardwareInterface>::
+trajectoryCommandCB(const MultiDOFJointTrajectoryConstPtr& msg)
+{
+  updateTrajectoryCommand(msg);
+}
+
+template <class HardwareInterface>
+void CartesianTrajectoryController<HardwareInterface>::setHoldPose(const ros::Time& time)
+{
+  assert(1 == hold_trajectory_ptr_->size());
+
+  // Pose of the desired joint positions, which on startup are the current ones
+  Segment::State hold_state;
+  hold_state.pose = chain_.tipPose(desired_state_.position);
+
+  const Segment::Time hold_time = time.toSec();
+  hold_trajectory_ptr_->front().init(hold_time, hold_state, hold_time, hold_state);
+  curr_trajectory_box_.set(hold_trajectory_ptr_);
+}
+
+template <class HardwareInterface>
+void CartesianTrajectoryController<HardwareInterface>::publishState(const ros::Time& time)
+{
+  // Check if it's time to publish
+  if (!state_publisher_period_.isZero() && last_state_publish_time_ + state_publisher_period_ < time)
+  {
+    if (state_publisher_ && state_publisher_->trylock())
+    {
+      last_state_publish_time_ += state_publisher_period_;
+
+      state_publisher_->msg_.header.stamp          = time_data_.time;
+      state_publisher_->msg_.desired.positions     = desired_state_.position;
+      state_publisher_->msg_.desired.velocities    = desired_state_.velocity;
+      state_publisher_->msg_.desired.accelerations = desired_state_.acceleration;
+      state_publisher_->msg_.actual.positions      = current_state_.position;
+      state_publisher_->msg_.actual.velocities     = current_state_.velocity;
+      state_publisher_->msg_.error.positions       = state_error_.position;
+      state_publisher_->msg_.error.velocities      = state_error_.velocity;
+
+      state_publisher_->unlockAndPublish();
+    }
+  }
+}
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,254 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef CARTESIAN_TRAJECTORY_CONTROLLER_CARTESIAN_TRAJECTORY_SEGMENT_H
+#define CARTESIAN_TRAJECTORY_CONTROLLER_CARTESIAN_TRAJECTORY_SEGMENT_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+#include <joint_trajectory_controller/rigid_body_chain.h>
+#include <trajectory_interface/quintic_spline_segment.h>
+
+namespace cartesian_trajectory_controller
+{
+
+namespace internal
+{
+
+using joint_trajectory_controller::internal::Vector3;
+using joint_trajectory_controller::internal::cross;
+using joint_trajectory_controller::internal::dot;
+
+inline double component(const Vector3& v, unsigned int axis) {return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);}
+
+/**
+ * \return Product of the left Jacobian of the rotation group evaluated at the rotation vector \p r, and \p v.
+ * It maps the rate of change of \p r to the angular velocity of the rotation it represents.
+ */
+inline Vector3 leftJacobianTimes(const Vector3& r, const Vector3& v)
+{
+  const double angle2 = dot(r, r);
+  const double angle  = std::sqrt(angle2);
+  const double a = angle < 1e-6 ? 0.5 - angle2 / 24.0        : (1.0 - std::cos(angle)) / angle2;
+  const double b = angle < 1e-6 ? 1.0 / 6.0 - angle2 / 120.0 : (angle - std::sin(angle)) / (angle2 * angle);
+  const Vector3 rv = cross(r, v);
+  return v + a * rv + b * cross(r, rv);
+}
+
+/** \return Product of the inverse of the left Jacobian evaluated at the rotation vector \p r, and \p v. */
+inline Vector3 leftJacobianInverseTimes(const Vector3& r, const Vector3& v)
+{
+  const double angle2 = dot(r, r);
+  const double angle  = std::sqrt(angle2);
+  const double c = angle < 1e-6 ? 1.0 / 12.0 + angle2 / 720.0
+                                : 1.0 / angle2 - std::cos(0.5 * angle) / (2.0 * angle * std::sin(0.5 * angle));
+  const Vector3 rv = cross(r, v);
+  return v - 0.5 * rv + c * cross(r, rv);
+}
+
+} // namespace
+
+/**
+ * \brief Trajectory segment joining two Cartesian states of a frame, usually the tip of a kinematic chain.
+ *
+ * Position and orientation are interpolated with quintic splines: the position directly, the orientation as the
+ * rotation vector relative to the segment start orientation, which takes the shortest rotation to the end orientation.
+ * Velocities and accelerations are expressed in the same (root) frame as the poses.
+ *
+ * Outside the <tt>[start_time, end_time]</tt> interval, sampling yields the start/end poses with zero velocity and
+ * acceleration, as joint trajectory segments do.
+ */
+class CartesianTrajectorySegment
+{
+public:
+  typedef double                                                Scalar;
+  typedef Scalar                                                Time;
+  typedef joint_trajectory_controller::RigidBodyChain::Vector3   Vector3;
+  typedef joint_trajectory_controller::RigidBodyChain::Matrix3   Matrix3;
+  typedef joint_trajectory_controller::RigidBodyChain::Transform Transform;
+
+  struct State
+  {
+    State()
+      : pose(Transform::identity()),
+        linear_velocity{0.0, 0.0, 0.0},
+        angular_velocity{0.0, 0.0, 0.0},
+        linear_acceleration{0.0, 0.0, 0.0},
+        angular_acceleration{0.0, 0.0, 0.0}
+    {}
+
+    Transform pose;
+    Vector3   linear_velocity;
+    Vector3   angular_velocity;
+    Vector3   linear_acceleration;
+    Vector3   angular_acceleration;
+  };
+
+  /** \brief Creates a segment holding the identity pose at time zero. */
+  CartesianTrajectorySegment()
+    : start_time_(0.0),
+      duration_(0.0),
+      start_rotation_(Matrix3::identity()),
+      coefs_()
+  {}
+
+  /** \brief Construct segment from start and end states. \sa init */
+  CartesianTrajectorySegment(const Time&  start_time,
+                             const State& start_state,
+                             const Time&  end_time,
+                             const State& end_state)
+  {
+    init(start_time, start_state, end_time, end_state);
+  }
+
+  /**
+   * \brief Initialize segment from start and end states (boundary conditions).
+   *
+   * \note Angular accelerations are mapped to the orientation spline neglecting the rate of change of the rotation
+   * group Jacobian, which vanishes when the angular velocity is parallel to the rotation axis.
+   *
+   * \throw std::invalid_argument If \p end_time is earlier than \p start_time.
+   */
+  void init(const Time&  start_time,
+            const State& start_state,
+            const Time&  end_time,
+            const State& end_state);
+
+  /**
+   * \brief Sample the segment at a specified time.
+   * \note This method is realtime-safe.
+   */
+  void sample(const Time& time, State& state) const;
+
+  /** \return Segment start time. */
+  Time startTime() const {return start_time_;}
+
+  /** \return Segment end time. */
+  Time endTime() const {return start_time_ + duration_;}
+
+  /** \return Segment size (dimension): three positions and three rotation vector components. */
+  unsigned int size() const {return 6;}
+
+private:
+  typedef trajectory_interface::QuinticSplineSegment<Scalar> Spline;
+
+  Time    start_time_;
+  Time    duration_;
+  Matrix3 start_rotation_;
+
+  /** Coefficients of the x, y, z position and rotation vector splines, in this order. */
+  std::array<Spline::SplineCoefficients, 6> coefs_;
+};
+
+inline void CartesianTrajectorySegment::init(const Time&  start_time,
+                                             const State& start_state,
+                                             const Time&  end_time,
+                                             const State& end_state)
+{
+  using namespace joint_trajectory_controller::internal;
+  using internal::leftJacobianInverseTimes;
+
+  if (end_time < start_time)
+  {
+    throw(std::invalid_argument("Cartesian trajectory segment end time precedes its start time."));
+  }
+
+  start_time_     = start_time;
+  duration_       = end_time - start_time;
+  start_rotation_ = start_state.pose.rotation;
+
+  // Orientation boundary conditions, in the frame of the start orientation
+  const Vector3 end_rotation = rotationVector(transpose(start_rotation_) * end_state.pose.rotation);
+  const Vector3 start_rates[2] = {transposeTimes(start_rotation_, start_state.angular_velocity),
+                                  transposeTimes(start_rotation_, start_state.angular_acceleration)};
+  const Vector3 end_rates[2] = {
+    leftJacobianInverseTimes(end_rotation, transposeTimes(start_rotation_, end_state.angular_velocity)),
+    leftJacobianInverseTimes(end_rotation, transposeTimes(start_rotation_, end_state.angular_acceleration))};
+
+  const Vector3 knots[4][3] = {
+    {start_state.pose.translation, start_state.linear_velocity, start_state.linear_acceleration},
+    {end_state.pose.translation,   end_state.linear_velocity,   end_state.linear_acceleration},
+    {{0.0, 0.0, 0.0},              start_rates[0],              start_rates[1]},
+    {end_rotation,                 end_rates[0],                end_rates[1]}};
+
+  const Spline::DurationPowers powers = Spline::durationPowers(duration_);
+  for (unsigned int i = 0; i < 6; ++i)
+  {
+    const unsigned int first_knot = i < 3 ? 0 : 2; // Position or orientation spline
+    const unsigned int axis       = i % 3;
+    Scalar positions[2], velocities[2], accelerations[2];
+    for (unsigned int k = 0; k < 2; ++k)
+    {
+      const Vector3* knot = knots[first_knot + k];
+      positions[k]     = internal::component(knot[0], axis);
+      velocities[k]    = internal::component(knot[1], axis);
+      accelerations[k] = internal::component(knot[2], axis);
+    }
+    Spline::computeCoefficients(1, &powers, positions, velocities, accelerations, &coefs_[i]);
+  }
+}
+
+inline void CartesianTrajectorySegment::sample(const Time& time, State& state) const
+{
+  using namespace joint_trajectory_controller::internal;
+  using internal::leftJacobianTimes;
+
+  // Outside the segment, hold the boundary position with zero velocity and acceleration
+  const bool inside = time >= start_time_ && time <= start_time_ + duration_;
+  const Scalar t = std::min(std::max(time - start_time_, 0.0), duration_);
+
+  Scalar pos[6], vel[6], acc[6];
+  for (unsigned int i = 0; i < 6; ++i)
+  {
+    const Spline::SplineCoefficients& c = coefs_[i];
+    pos[i] = c[0] + t * (c[1] + t * (c[2] + t * (c[3] + t * (c[4] + t * c[5]))));
+    vel[i] = inside ? c[1] + t * (2.0 * c[2] + t * (3.0 * c[3] + t * (4.0 * c[4] + t * 5.0 * c[5]))) : 0.0;
+    acc[i] = inside ? 2.0 * c[2] + t * (6.0 * c[3] + t * (12.0 * c[4] + t * 20.0 * c[5])) : 0.0;
+  }
+
+  const Vector3 rotation = {pos[3], pos[4], pos[5]};
+  state.pose.translation     = {pos[0], pos[1], pos[2]};
+  state.pose.rotation        = start_rotation_ * rotationMatrix(rotation);
+  state.linear_velocity      = {vel[0], vel[1], vel[2]};
+  state.linear_acceleration  = {acc[0], acc[1], acc[2]};
+  state.angular_velocity     = start_rotation_ * leftJacobianTimes(rotation, {vel[3], vel[4], vel[5]});
+  state.angular_acceleration = start_rotation_ * leftJacobianTimes(rotation, {acc[3], acc[4], acc[5]});
+}
+
+} // namespace
+
+#endif // header guard
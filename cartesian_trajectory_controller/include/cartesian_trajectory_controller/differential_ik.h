@@ -0,0 +1,244 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef CARTESIAN_TRAJECTORY_CONTROLLER_DIFFERENTIAL_IK_H
+#define CARTESIAN_TRAJECTORY_CONTROLLER_DIFFERENTIAL_IK_H
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include <joint_trajectory_controller/rigid_body_chain.h>
+
+namespace cartesian_trajectory_controller
+{
+
+/**
+ * \brief Iterative inverse kinematics of a RigidBodyChain tip, by damped least squares.
+ *
+ * Each iteration linearizes the chain at the current joint positions and takes the step
+ * \f$ \Delta q = J^T (J J^T + \lambda^2 I)^{-1} e \f$ towards the target pose, where \f$ e \f$ stacks the position
+ * and orientation (rotation vector) errors. The damping \f$ \lambda \f$ keeps steps bounded near singularities, at the
+ * expense of accuracy there. The \f$ 6 \times 6 \f$ system is solved by a Cholesky factorization whose cost does not
+ * depend on the number of joints.
+ *
+ * All working memory is allocated by \ref init, and the number of iterations is bounded, so that \ref solve and
+ * \ref velocity are realtime-safe.
+ */
+class DifferentialIk
+{
+public:
+  typedef joint_trajectory_controller::RigidBodyChain            RigidBodyChain;
+  typedef joint_trajectory_controller::RigidBodyChain::Vector3   Vector3;
+  typedef joint_trajectory_controller::RigidBodyChain::Transform Transform;
+
+  struct Parameters
+  {
+    Parameters()
+      : max_iterations(10),
+        damping(1e-2),
+        position_tolerance(1e-5),
+        orientation_tolerance(1e-4),
+        max_step(0.2)
+    {}
+
+    unsigned int max_iterations;        ///< Maximum number of steps taken by one call to \ref solve.
+    double       damping;               ///< Damping factor \f$ \lambda \f$.
+    double       position_tolerance;    ///< Tip position error below which the solution is accepted.
+    double       orientation_tolerance; ///< Tip orientation error (angle) below which the solution is accepted.
+    double       max_step;              ///< Largest change of a joint position in one step. Larger steps are scaled.
+  };
+
+  DifferentialIk() : chain_(0) {}
+
+  /**
+   * \param chain Kinematic chain, which must outlive this object.
+   * \return False if the parameters are invalid: tolerances, damping and step bound must be positive.
+   */
+  bool init(const RigidBodyChain& chain, const Parameters& params = Parameters());
+
+  /**
+   * \brief Move \p position towards joint positions placing the chain tip at \p target.
+   * \param[in,out] position Initial guess, usually the previous solution, overwritten with the solution found.
+   * \return True if the solution is within tolerances. Otherwise \p position holds the result of the last step.
+   */
+  bool solve(const Transform& target, std::vector<double>& position);
+
+  /**
+   * \brief Compute joint velocities realizing a tip twist, in the damped least squares sense.
+   *
+   * The Jacobian used is that of the joint positions returned by the last call to \ref solve.
+   * \param linear Linear velocity of the tip, in the chain root frame.
+   * \param angular Angular velocity of the tip, in the chain root frame.
+   * \param[out] velocity Joint velocities. Must be sized to the number of joints.
+   */
+  void velocity(const Vector3& linear, const Vector3& angular, std::vector<double>& velocity);
+
+  /** \return Number of steps taken by the last call to \ref solve. */
+  unsigned int iterations() const {return iterations_;}
+
+  /** \return Tip position error norm left by the last call to \ref solve. */
+  double positionError() const {return position_error_;}
+
+  /** \return Tip orientation error (angle) left by the last call to \ref solve. */
+  double orientationError() const {return orientation_error_;}
+
+private:
+  const RigidBodyChain* chain_;
+  Parameters            params_;
+  std::vector<double>   jacobian_; ///< Row-major, 6 x n.
+  std::vector<double>   step_;
+  unsigned int          iterations_;
+  double                position_error_;
+  double                orientation_error_;
+
+  /** \brief Compute \f$ J^T (J J^T + \lambda^2 I)^{-1} v \f$, with \f$ v \f$ stacking \p linear and \p angular. */
+  void dampedLeastSquares(const Vector3& linear, const Vector3& angular, std::vector<double>& result) const;
+};
+
+inline bool DifferentialIk::init(const RigidBodyChain& chain, const Parameters& params)
+{
+  if (params.damping <= 0.0 || params.position_tolerance <= 0.0 || params.orientation_tolerance <= 0.0 ||
+      params.max_step <= 0.0)
+  {
+    return false;
+  }
+
+  chain_  = &chain;
+  params_ = params;
+  jacobian_.assign(6 * chain.size(), 0.0);
+  step_.assign(chain.size(), 0.0);
+  iterations_        = 0;
+  position_error_    = 0.0;
+  orientation_error_ = 0.0;
+  return true;
+}
+
+inline bool DifferentialIk::solve(const Transform& target, std::vector<double>& position)
+{
+  using namespace joint_trajectory_controller::internal;
+  assert(chain_);
+
+  for (iterations_ = 0; ; ++iterations_)
+  {
+    // The Jacobian is evaluated before checking convergence, so that it always matches the returned positions
+    const Transform pose = chain_->jacobian(position, jacobian_);
+    const Vector3 position_error    = target.translation - pose.translation;
+    const Vector3 orientation_error = rotationVector(target.rotation * transpose(pose.rotation));
+    position_error_    = std::sqrt(dot(position_error, position_error));
+    orientation_error_ = std::sqrt(dot(orientation_error, orientation_error));
+
+    if (position_error_ <= params_.position_tolerance && orientation_error_ <= params_.orientation_tolerance)
+    {
+      return true;
+    }
+    if (iterations_ == params_.max_iterations) {return false;}
+
+    dampedLeastSquares(position_error, orientation_error, step_);
+
+    // Scale the whole step, preserving its direction, if a joint would move too far
+    double largest = 0.0;
+    for (double s : step_) {largest = std::max(largest, std::abs(s));}
+    const double scale = largest > params_.max_step ? params_.max_step / largest : 1.0;
+    for (unsigned int i = 0; i < step_.size(); ++i) {position[i] += scale * step_[i];}
+  }
+}
+
+inline void DifferentialIk::velocity(const Vector3& linear, const Vector3& angular, std::vector<double>& velocity)
+{
+  assert(chain_);
+  dampedLeastSquares(linear, angular, velocity);
+}
+
+inline void DifferentialIk::dampedLeastSquares(const Vector3&       linear,
+                                               const Vector3&       angular,
+                                               std::vector<double>& result) const
+{
+  const unsigned int n = result.size();
+  assert(jacobian_.size() == 6 * n);
+
+  // A = J J^T + lambda^2 I, lower triangle only
+  std::array<double, 36> a;
+  const double damping2 = params_.damping * params_.damping;
+  for (unsigned int r = 0; r < 6; ++r)
+  {
+    for (unsigned int c = 0; c <= r; ++c)
+    {
+      double sum = r == c ? damping2 : 0.0;
+      for (unsigned int k = 0; k < n; ++k) {sum += jacobian_[r * n + k] * jacobian_[c * n + k];}
+      a[r * 6 + c] = sum;
+    }
+  }
+
+  // In-place Cholesky factorization A = L L^T. A is positive definite thanks to the damping
+  for (unsigned int c = 0; c < 6; ++c)
+  {
+    double diagonal = a[c * 6 + c];
+    for (unsigned int k = 0; k < c; ++k) {diagonal -= a[c * 6 + k] * a[c * 6 + k];}
+    a[c * 6 + c] = std::sqrt(diagonal);
+    for (unsigned int r = c + 1; r < 6; ++r)
+    {
+      double sum = a[r * 6 + c];
+      for (unsigned int k = 0; k < c; ++k) {sum -= a[r * 6 + k] * a[c * 6 + k];}
+      a[r * 6 + c] = sum / a[c * 6 + c];
+    }
+  }
+
+  // Forward and backward substitution
+  std::array<double, 6> y = {linear.x, linear.y, linear.z, angular.x, angular.y, angular.z};
+  for (unsigned int r = 0; r < 6; ++r)
+  {
+    for (unsigned int k = 0; k < r; ++k) {y[r] -= a[r * 6 + k] * y[k];}
+    y[r] /= a[r * 6 + r];
+  }
+  for (unsigned int r = 6; r-- > 0;)
+  {
+    for (unsigned int k = r + 1; k < 6; ++k) {y[r] -= a[k * 6 + r] * y[k];}
+    y[r] /= a[r * 6 + r];
+  }
+
+  // result = J^T y
+  for (unsigned int k = 0; k < n; ++k)
+  {
+    double sum = 0.0;
+    for (unsigned int r = 0; r < 6; ++r) {sum += jacobian_[r * n + k] * y[r];}
+    result[k] = sum;
+  }
+}
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,70 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+// Pluginlib
+#include <pluginlib/class_list_macros.hpp>
+
+// Project
+#include <cartesian_trajectory_controller/cartesian_trajectory_controller.h>
+
+namespace position_controllers
+{
+  /**
+   * \brief Cartesian trajectory controller that sends commands to a \b position interface.
+   */
+  typedef cartesian_trajectory_controller::CartesianTrajectoryController<hardware_interface::PositionJointInterface>
+          CartesianTrajectoryController;
+}
+
+namespace velocity_controllers
+{
+  /**
+   * \brief Cartesian trajectory controller that sends commands to a \b velocity interface.
+   */
+  typedef cartesian_trajectory_controller::CartesianTrajectoryController<hardware_interface::VelocityJointInterface>
+          CartesianTrajectoryController;
+}
+
+namespace effort_controllers
+{
+  /**
+   * \brief Cartesian trajectory controller that sends commands to an \b effort interface.
+   */
+  typedef cartesian_trajectory_controller::CartesianTrajectoryController<hardware_interface::EffortJointInterface>
+          CartesianTrajectoryController;
+}
+
+PLUGINLIB_EXPORT_CLASS(position_controllers::CartesianTrajectoryController, controller_interface::ControllerBase)
+PLUGINLIB_EXPORT_CLASS(velocity_controllers::CartesianTrajectoryController, controller_interface::ControllerBase)
+PLUGINLIB_EXPORT_CLASS(effort_controllers::CartesianTrajectoryController,   controller_interface::ControllerBase)
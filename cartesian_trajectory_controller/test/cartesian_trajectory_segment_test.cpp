@@ -0,0 +1,167 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+#include <cartesian_trajectory_controller/cartesian_trajectory_segment.h>
+
+using namespace joint_trajectory_controller::internal;
+using cartesian_trajectory_controller::CartesianTrajectorySegment;
+typedef CartesianTrajectorySegment::State State;
+
+// Floating-point value comparison threshold
+const double EPS = 1e-9;
+
+void expectNear(const Vector3& expected, const Vector3& actual, double tolerance = EPS)
+{
+  EXPECT_NEAR(expected.x, actual.x, tolerance);
+  EXPECT_NEAR(expected.y, actual.y, tolerance);
+  EXPECT_NEAR(expected.z, actual.z, tolerance);
+}
+
+void expectNear(const Matrix3& expected, const Matrix3& actual, double tolerance = EPS)
+{
+  for (unsigned int i = 0; i < 9; ++i) {EXPECT_NEAR(expected.m[i], actual.m[i], tolerance);}
+}
+
+class CartesianTrajectorySegmentTest : public ::testing::Test
+{
+public:
+  CartesianTrajectorySegmentTest()
+    : start_time(1.0),
+      end_time(3.0)
+  {
+    start_state.pose                 = {rotationMatrix({0.3, -0.5, 0.2}), {0.4, 0.1, 0.8}};
+    start_state.linear_velocity      = {0.1, 0.0, -0.2};
+    start_state.angular_velocity     = {0.0, 0.3, 0.1};
+    start_state.linear_acceleration  = {0.0, 0.5, 0.0};
+    start_state.angular_acceleration = {0.2, 0.0, 0.0};
+
+    end_state.pose                 = {rotationMatrix({-1.2, 0.9, 1.6}), {0.2, -0.3, 0.6}};
+    end_state.linear_velocity      = {0.0, 0.2, 0.1};
+    end_state.angular_velocity     = {-0.4, 0.0, 0.2};
+  }
+
+protected:
+  double start_time, end_time;
+  State  start_state, end_state;
+};
+
+TEST_F(CartesianTrajectorySegmentTest, BoundaryStates)
+{
+  const CartesianTrajectorySegment segment(start_time, start_state, end_time, end_state);
+  EXPECT_EQ(start_time, segment.startTime());
+  EXPECT_EQ(end_time, segment.endTime());
+  EXPECT_EQ(6, segment.size());
+
+  State state;
+  segment.sample(start_time, state);
+  expectNear(start_state.pose.translation, state.pose.translation);
+  expectNear(start_state.pose.rotation, state.pose.rotation);
+  expectNear(start_state.linear_velocity, state.linear_velocity);
+  expectNear(start_state.angular_velocity, state.angular_velocity);
+  expectNear(start_state.linear_acceleration, state.linear_acceleration);
+  expectNear(start_state.angular_acceleration, state.angular_acceleration);
+
+  segment.sample(end_time, state);
+  expectNear(end_state.pose.translation, state.pose.translation);
+  expectNear(end_state.pose.rotation, state.pose.rotation);
+  expectNear(end_state.linear_velocity, state.linear_velocity);
+  expectNear(end_state.angular_velocity, state.angular_velocity);
+
+  // Outside the segment, boundary poses are held at rest
+  segment.sample(end_time + 1.0, state);
+  expectNear(end_state.pose.translation, state.pose.translation);
+  expectNear(end_state.pose.rotation, state.pose.rotation);
+  expectNear({0.0, 0.0, 0.0}, state.linear_velocity);
+  expectNear({0.0, 0.0, 0.0}, state.angular_velocity);
+
+  segment.sample(start_time - 1.0, state);
+  expectNear(start_state.pose.rotation, state.pose.rotation);
+  expectNear({0.0, 0.0, 0.0}, state.angular_acceleration);
+}
+
+TEST_F(CartesianTrajectorySegmentTest, VelocityIsPoseDerivative)
+{
+  const CartesianTrajectorySegment segment(start_time, start_state, end_time, end_state);
+
+  // Central differences of the sampled poses
+  const double h = 1e-5;
+  for (double time = start_time + 0.1; time < end_time; time += 0.3)
+  {
+    State state, before, after;
+    segment.sample(time, state);
+    segment.sample(time - h, before);
+    segment.sample(time + h, after);
+
+    expectNear((0.5 / h) * (after.pose.translation - before.pose.translation), state.linear_velocity, 1e-6);
+    expectNear((0.5 / h) * rotationVector(after.pose.rotation * transpose(before.pose.rotation)),
+               state.angular_velocity, 1e-6);
+  }
+}
+
+TEST_F(CartesianTrajectorySegmentTest, HoldSegment)
+{
+  // Zero duration segments are allowed, and hold their pose
+  State state;
+  const CartesianTrajectorySegment segment(start_time, start_state, start_time, start_state);
+  segment.sample(start_time + 1.0, state);
+  expectNear(start_state.pose.translation, state.pose.translation);
+  expectNear(start_state.pose.rotation, state.pose.rotation);
+  expectNear({0.0, 0.0, 0.0}, state.linear_velocity);
+
+  EXPECT_THROW(CartesianTrajectorySegment(end_time, start_state, start_time, end_state), std::invalid_argument);
+}
+
+TEST_F(CartesianTrajectorySegmentTest, ShortestRotation)
+{
+  // Orientations 300 degrees apart about z are joined by a 60 degree rotation the other way
+  start_state.angular_velocity     = {0.0, 0.0, 0.0};
+  start_state.angular_acceleration = {0.0, 0.0, 0.0};
+  end_state = start_state;
+  end_state.pose.rotation = start_state.pose.rotation * rotationMatrix({0.0, 0.0, 5.0 * M_PI / 3.0});
+
+  const CartesianTrajectorySegment segment(start_time, start_state, end_time, end_state);
+  State state;
+  segment.sample(0.5 * (start_time + end_time), state);
+  const Vector3 halfway = rotationVector(transpose(start_state.pose.rotation) * state.pose.rotation);
+  expectNear({0.0, 0.0, -M_PI / 6.0}, halfway);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
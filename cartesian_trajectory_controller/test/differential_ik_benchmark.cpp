@@ -0,0 +1,140 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/// \file Measures the per-cycle cost of the Cartesian trajectory controller kinematics (segment sampling, inverse
+/// kinematics and joint velocity resolution) on serial arms of 6 and 7 joints.
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <cartesian_trajectory_controller/cartesian_trajectory_segment.h>
+#include <cartesian_trajectory_controller/differential_ik.h>
+
+using cartesian_trajectory_controller::CartesianTrajectorySegment;
+using cartesian_trajectory_controller::DifferentialIk;
+using joint_trajectory_controller::RigidBodyChain;
+
+namespace
+{
+
+const unsigned int CYCLES = 100000;
+const double       PERIOD = 1e-3;
+
+// Keeps the optimizer from discarding the computed velocities
+volatile double sink;
+
+/// Arm whose consecutive joint axes are perpendicular, as in most industrial and collaborative arms
+std::string armUrdf(unsigned int n_joints)
+{
+  std::stringstream ss;
+  ss << "<robot name=\"arm\"><link name=\"link0\"/>";
+  for (unsigned int k = 1; k <= n_joints; ++k)
+  {
+    ss << "<link name=\"link" << k << "\"/>";
+    ss << "<joint name=\"joint" << k << "\" type=\"revolute\"><parent link=\"link" << k - 1 << "\"/>"
+       << "<child link=\"link" << k << "\"/><origin xyz=\"0 0.05 0.2\" rpy=\"" << (k % 2 ? 1.5708 : -1.5708) << " 0 0\"/>"
+       << "<axis xyz=\"0 0 1\"/><limit lower=\"-3\" upper=\"3\" effort=\"100\" velocity=\"10\"/></joint>";
+  }
+  ss << "</robot>";
+  return ss.str();
+}
+
+void benchmark(unsigned int n_joints)
+{
+  urdf::Model urdf;
+  std::vector<std::string> joint_names;
+  for (unsigned int k = 1; k <= n_joints; ++k) {joint_names.push_back("joint" + std::to_string(k));}
+
+  RigidBodyChain chain;
+  DifferentialIk ik;
+  if (!urdf.initString(armUrdf(n_joints)) || !chain.init(urdf, joint_names) || !ik.init(chain))
+  {
+    std::cerr << "Failed to build a " << n_joints << "-joint chain." << std::endl;
+    return;
+  }
+
+  // Reachable waypoints, the tip poses of a smooth joint-space path, one segment per second
+  std::vector<double> position(n_joints);
+  std::vector<CartesianTrajectorySegment> trajectory;
+  CartesianTrajectorySegment::State start_state, end_state;
+  for (unsigned int k = 0; k <= CYCLES * PERIOD; ++k)
+  {
+    for (unsigned int i = 0; i < n_joints; ++i) {position[i] = 0.4 + 0.3 * std::sin(0.7 * k + i);}
+    end_state.pose = chain.tipPose(position);
+    if (k > 0) {trajectory.push_back(CartesianTrajectorySegment(k - 1.0, start_state, k, end_state));}
+    start_state = end_state;
+  }
+
+  // Seed with the joint positions of the first waypoint
+  for (unsigned int i = 0; i < n_joints; ++i) {position[i] = 0.4 + 0.3 * std::sin(i);}
+  std::vector<double> velocity(n_joints);
+  CartesianTrajectorySegment::State state;
+  unsigned long iterations = 0;
+  unsigned int failures = 0; // Cycles out of tolerance after the maximum iterations, usually near singularities
+
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (unsigned int cycle = 0; cycle < CYCLES; ++cycle)
+  {
+    const double time = cycle * PERIOD;
+    trajectory[static_cast<unsigned int>(time)].sample(time, state);
+    if (!ik.solve(state.pose, position)) {++failures;}
+    ik.velocity(state.linear_velocity, state.angular_velocity, velocity);
+    iterations += ik.iterations();
+    sink = velocity[0];
+  }
+  const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+  std::cout << std::setw(8)  << n_joints
+            << std::setw(16) << std::fixed << std::setprecision(1)
+            << std::chrono::duration<double, std::nano>(end - start).count() / CYCLES
+            << std::setw(20) << std::setprecision(2) << static_cast<double>(iterations) / CYCLES
+            << std::setw(14) << failures << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  std::cout << std::setw(8) << "joints" << std::setw(16) << "ns/cycle" << std::setw(20) << "iterations/cycle"
+            << std::setw(14) << "unconverged" << std::endl;
+
+  const unsigned int n_joints[] = {6, 7};
+  for (unsigned int n : n_joints) {benchmark(n);}
+  return 0;
+}
@@ -0,0 +1,158 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <cartesian_trajectory_controller/differential_ik.h>
+
+using cartesian_trajectory_controller::DifferentialIk;
+using joint_trajectory_controller::RigidBodyChain;
+using std::string;
+using std::vector;
+
+// Six-joint arm whose consecutive joint axes are perpendicular
+string armUrdf()
+{
+  std::stringstream ss;
+  ss << "<robot name=\"arm\"><link name=\"link0\"/>";
+  for (unsigned int k = 1; k <= 6; ++k)
+  {
+    ss << "<link name=\"link" << k << "\"/>";
+    ss << "<joint name=\"joint" << k << "\" type=\"revolute\"><parent link=\"link" << k - 1 << "\"/>"
+       << "<child link=\"link" << k << "\"/><origin xyz=\"0 0.05 0.2\" rpy=\"" << (k % 2 ? 1.5708 : -1.5708) << " 0 0\"/>"
+       << "<axis xyz=\"0 0 1\"/><limit lower=\"-3\" upper=\"3\" effort=\"100\" velocity=\"10\"/></joint>";
+  }
+  ss << "</robot>";
+  return ss.str();
+}
+
+class DifferentialIkTest : public ::testing::Test
+{
+public:
+  DifferentialIkTest()
+    : joint_names({"joint1", "joint2", "joint3", "joint4", "joint5", "joint6"}),
+      reference({0.3, -0.8, 0.5, 1.1, -0.6, 0.4})
+  {
+    urdf::Model urdf;
+    urdf.initString(armUrdf());
+    chain.init(urdf, joint_names);
+  }
+
+protected:
+  vector<string> joint_names;
+  vector<double> reference;
+  RigidBodyChain chain;
+};
+
+TEST_F(DifferentialIkTest, Solve)
+{
+  DifferentialIk ik;
+  ASSERT_TRUE(ik.init(chain));
+
+  // Starting close to the reference positions, the solver converges to them
+  const RigidBodyChain::Transform target = chain.tipPose(reference);
+  vector<double> position = reference;
+  for (unsigned int i = 0; i < position.size(); ++i) {position[i] += 0.05 * (i % 2 ? 1.0 : -1.0);}
+
+  EXPECT_TRUE(ik.solve(target, position));
+  EXPECT_GT(ik.iterations(), 0);
+  EXPECT_LT(ik.positionError(), 1e-5);
+  EXPECT_LT(ik.orientationError(), 1e-4);
+  for (unsigned int i = 0; i < position.size(); ++i) {EXPECT_NEAR(reference[i], position[i], 1e-3);}
+
+  // Already at the target, no steps are taken
+  EXPECT_TRUE(ik.solve(target, position));
+  EXPECT_EQ(0, ik.iterations());
+}
+
+TEST_F(DifferentialIkTest, BoundedIterations)
+{
+  DifferentialIk::Parameters params;
+  params.max_iterations = 2;
+  params.max_step       = 0.01;
+
+  DifferentialIk ik;
+  ASSERT_TRUE(ik.init(chain, params));
+
+  // Far targets are not reached within the iteration budget, and steps are bounded
+  const RigidBodyChain::Transform target = chain.tipPose(reference);
+  vector<double> position(6, 0.0);
+  EXPECT_FALSE(ik.solve(target, position));
+  EXPECT_EQ(2, ik.iterations());
+  for (double q : position) {EXPECT_LE(std::abs(q), 2.0 * params.max_step + 1e-12);}
+}
+
+TEST_F(DifferentialIkTest, Velocity)
+{
+  DifferentialIk ik;
+  ASSERT_TRUE(ik.init(chain));
+
+  // Twist produced by known joint velocities, away from singularities
+  const vector<double> ref_velocity = {0.2, -0.1, 0.4, 0.3, -0.5, 0.1};
+  vector<double> jacobian(36);
+  chain.jacobian(reference, jacobian);
+  double twist[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  for (unsigned int r = 0; r < 6; ++r)
+  {
+    for (unsigned int k = 0; k < 6; ++k) {twist[r] += jacobian[r * 6 + k] * ref_velocity[k];}
+  }
+
+  vector<double> position = reference;
+  ASSERT_TRUE(ik.solve(chain.tipPose(reference), position));
+  vector<double> velocity(6);
+  ik.velocity({twist[0], twist[1], twist[2]}, {twist[3], twist[4], twist[5]}, velocity);
+  for (unsigned int i = 0; i < velocity.size(); ++i) {EXPECT_NEAR(ref_velocity[i], velocity[i], 1e-2);}
+}
+
+TEST_F(DifferentialIkTest, InvalidParameters)
+{
+  DifferentialIk ik;
+  DifferentialIk::Parameters params;
+  params.damping = 0.0;
+  EXPECT_FALSE(ik.init(chain, params));
+
+  params = DifferentialIk::Parameters();
+  params.max_step = -1.0;
+  EXPECT_FALSE(ik.init(chain, params));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
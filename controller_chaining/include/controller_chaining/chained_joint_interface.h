@@ -0,0 +1,192 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef CONTROLLER_CHAINING_CHAINED_JOINT_INTERFACE_H
+#define CONTROLLER_CHAINING_CHAINED_JOINT_INTERFACE_H
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <hardware_interface/joint_state_interface.h>
+
+namespace controller_chaining
+{
+
+/**
+ * \brief Joint output of a controller, written by the exporting controller from its realtime update.
+ */
+struct ChainedJointData
+{
+  ChainedJointData() : position(0.0), velocity(0.0), effort(0.0), valid(false) {}
+
+  double position;
+  double velocity;
+  double effort;
+
+  /**
+   * Whether the values above are current. Set by the exporting controller along with them, and cleared when it stops.
+   * Also cleared when the exporting controller releases the output, ie. when it is unloaded.
+   */
+  std::atomic<bool> valid;
+};
+
+/**
+ * \brief Joint state handle reading the output of an upstream controller.
+ *
+ * The handle shares ownership of the data it points to, so it stays readable when the exporting controller is unloaded.
+ * It then reports the output as no longer valid, and downstream controllers must stop using its values.
+ */
+class ChainedJointHandle : public hardware_interface::JointStateHandle
+{
+public:
+  ChainedJointHandle() {}
+
+  /**
+   * \param name Output name.
+   * \param data Output data.
+   * \param claim Token shared by all copies of the handle. The output remains claimed as long as it is alive.
+   */
+  ChainedJointHandle(const std::string&                             name,
+                     const std::shared_ptr<const ChainedJointData>& data,
+                     const std::shared_ptr<void>&                   claim = std::shared_ptr<void>())
+    : hardware_interface::JointStateHandle(name, &data->position, &data->velocity, &data->effort),
+      data_(data),
+      claim_(claim)
+  {}
+
+  /** \return Whether the exporting controller is running and writing this output. */
+  bool isValid() const {return data_ && data_->valid.load(std::memory_order_relaxed);}
+
+private:
+  std::shared_ptr<const ChainedJointData> data_;
+  std::shared_ptr<void>                   claim_;
+};
+
+/**
+ * \brief Name under which the controller in namespace \p controller_ns exports its output for joint \p joint_name.
+ *
+ * \param controller_ns Fully resolved controller namespace, as returned by \p getNamespace on its node handle. Names
+ * are thus unique across controller managers sharing a process, such as those of several simulated robots.
+ */
+inline std::string chainedJointName(const std::string& controller_ns, const std::string& joint_name)
+{
+  return controller_ns + "/" + joint_name;
+}
+
+/**
+ * \brief Namespace of controller \p controller_name, loaded by the same controller manager as the controller in
+ * namespace \p controller_ns.
+ *
+ * \param controller_ns Fully resolved namespace of the calling controller.
+ * \param controller_name Name of the other controller. Absolute namespaces are returned unchanged.
+ */
+inline std::string chainedControllerNamespace(const std::string& controller_ns, const std::string& controller_name)
+{
+  if (!controller_name.empty() && controller_name[0] == '/') {return controller_name;}
+  const std::string::size_type id = controller_ns.find_last_of('/');
+  const std::string parent_ns = (id == std::string::npos) ? std::string() : controller_ns.substr(0, id);
+  return parent_ns + "/" + controller_name;
+}
+
+/**
+ * \brief Virtual hardware interface holding the joint outputs exported by the controllers of a process.
+ *
+ * ROS control hardware interfaces are owned by the robot and fixed before controllers are loaded, so controllers can't
+ * add resources to them. This process-wide interface fills that gap: an upstream controller exports its outputs from
+ * \p init, and a downstream controller gets handles to them from its own \p init. Data then passes through memory
+ * shared by both controllers, without serialization nor topic latency. Outputs are keyed by controller namespace (see
+ * \ref chainedJointName), so the controller managers of different robots don't collide.
+ *
+ * A downstream controller reads the values written in the same control cycle if the upstream controller is updated
+ * first, which is the case when it is loaded first. Otherwise values lag one cycle behind.
+ *
+ * Exporting and getting handles is thread-safe, but is meant to be done from \p init only. Reading and writing values
+ * is done from the realtime thread of the controller manager, which serializes all controller updates.
+ */
+class ChainedJointInterface
+{
+public:
+  /**
+   * \return The interface shared by all controllers of the process.
+   */
+  static ChainedJointInterface& instance();
+
+  /**
+   * \brief Export a joint output.
+   *
+   * \param name Output name, usually built with \ref chainedJointName.
+   *
+   * \return Data the exporting controller writes to, or a null pointer if \p name is already exported. The output is
+   * unexported, and marked as no longer valid, when the exporting controller releases the returned pointer.
+   */
+  std::shared_ptr<ChainedJointData> exportJoint(const std::string& name);
+
+  /**
+   * \brief Get a handle reading an exported joint output, and claim the output.
+   *
+   * Like joint commands, an output is claimed by a single downstream controller at a time. The claim is released when
+   * all copies of the returned handle are destroyed.
+   *
+   * \throw hardware_interface::HardwareInterfaceException if \p name is not exported, or is already claimed.
+   */
+  ChainedJointHandle getHandle(const std::string& name);
+
+  /**
+   * \return Names of the currently exported joint outputs.
+   */
+  std::vector<std::string> getNames() const;
+
+private:
+  ChainedJointInterface() {}
+  ChainedJointInterface(const ChainedJointInterface&) = delete;
+  ChainedJointInterface& operator=(const ChainedJointInterface&) = delete;
+
+  struct Output
+  {
+    std::weak_ptr<ChainedJointData> exported; ///< Pointer held by the exporting controller.
+    std::weak_ptr<ChainedJointData> data;     ///< Pointer shared by handles.
+    std::weak_ptr<void>             claim;    ///< Token of the handles claiming the output.
+  };
+
+  mutable std::mutex mutex_;
+  std::map<std::string, Output> outputs_; ///< Protected by \ref mutex_.
+};
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,92 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <controller_chaining/chained_joint_interface.h>
+
+namespace controller_chaining
+{
+
+ChainedJointInterface& ChainedJointInterface::instance()
+{
+  static ChainedJointInterface interface;
+  return interface;
+}
+
+std::shared_ptr<ChainedJointData> ChainedJointInterface::exportJoint(const std::string& name)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  Output& output = outputs_[name];
+  if (!output.exported.expired()) {return std::shared_ptr<ChainedJointData>();}
+
+  // Handles share the data, while the exporting controller gets a pointer that invalidates it once released
+  std::shared_ptr<ChainedJointData> data = std::make_shared<ChainedJointData>();
+  std::shared_ptr<ChainedJointData> exported(data.get(), [data](ChainedJointData* d) {d->valid = false;});
+  output.exported = exported;
+  output.data     = data;
+  output.claim.reset();
+  return exported;
+}
+
+ChainedJointHandle ChainedJointInterface::getHandle(const std::string& name)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<std::string, Output>::iterator it = outputs_.find(name);
+  if (it == outputs_.end() || it->second.exported.expired())
+  {
+    throw hardware_interface::HardwareInterfaceException("Could not find chained joint output '" + name + "'.");
+  }
+  Output& output = it->second;
+  if (!output.claim.expired())
+  {
+    throw hardware_interface::HardwareInterfaceException("Chained joint output '" + name +
+                                                         "' is already claimed by another controller.");
+  }
+
+  std::shared_ptr<void> claim = std::make_shared<char>();
+  output.claim = claim;
+  return ChainedJointHandle(name, output.data.lock(), claim);
+}
+
+std::vector<std::string> ChainedJointInterface::getNames() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<std::string> names;
+  for (const auto& output : outputs_)
+  {
+    if (!output.second.exported.expired()) {names.push_back(output.first);}
+  }
+  return names;
+}
+
+} // namespace
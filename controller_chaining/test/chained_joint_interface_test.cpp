@@ -0,0 +1,167 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <controller_chaining/chained_joint_interface.h>
+
+using namespace controller_chaining;
+
+TEST(ChainedJointInterfaceTest, HandleReadsExportedValues)
+{
+  ChainedJointInterface& interface = ChainedJointInterface::instance();
+  const std::string name = chainedJointName("/upstream_controller", "joint1");
+  EXPECT_EQ("/upstream_controller/joint1", name);
+
+  std::shared_ptr<ChainedJointData> output = interface.exportJoint(name);
+  ASSERT_TRUE(output.get());
+
+  ChainedJointHandle handle = interface.getHandle(name);
+  EXPECT_EQ(name, handle.getName());
+  EXPECT_FALSE(handle.isValid()); // Nothing written yet
+
+  // Values written by the upstream controller are read without copies nor delay
+  output->valid    = true;
+  output->position = 1.0;
+  output->velocity = 2.0;
+  output->effort   = 3.0;
+  EXPECT_EQ(1.0, handle.getPosition());
+  EXPECT_EQ(2.0, handle.getVelocity());
+  EXPECT_EQ(3.0, handle.getEffort());
+  EXPECT_TRUE(handle.isValid());
+
+  output->position = -1.0;
+  EXPECT_EQ(-1.0, handle.getPosition());
+}
+
+TEST(ChainedJointInterfaceTest, NamesAreExportedOnce)
+{
+  ChainedJointInterface& interface = ChainedJointInterface::instance();
+  const std::string name = chainedJointName("/first_controller", "joint1");
+
+  std::shared_ptr<ChainedJointData> output = interface.exportJoint(name);
+  ASSERT_TRUE(output.get());
+  EXPECT_FALSE(interface.exportJoint(name).get());
+
+  const std::vector<std::string> names = interface.getNames();
+  EXPECT_NE(names.end(), std::find(names.begin(), names.end(), name));
+
+  // Releasing the output unexports it, so that a reloaded controller can export it again
+  output.reset();
+  const std::vector<std::string> new_names = interface.getNames();
+  EXPECT_EQ(new_names.end(), std::find(new_names.begin(), new_names.end(), name));
+  EXPECT_TRUE(interface.exportJoint(name).get());
+}
+
+TEST(ChainedJointInterfaceTest, ControllerManagersDontCollide)
+{
+  // Namespace of an upstream controller, resolved from that of a downstream controller of the same manager
+  EXPECT_EQ("/robot1/arm_controller", chainedControllerNamespace("/robot1/group_controller", "arm_controller"));
+  EXPECT_EQ("/arm_controller",        chainedControllerNamespace("/group_controller",        "arm_controller"));
+  EXPECT_EQ("/robot2/arm_controller", chainedControllerNamespace("/robot1/group_controller", "/robot2/arm_controller"));
+
+  // Two robots in a process loading controllers with the same name
+  ChainedJointInterface& interface = ChainedJointInterface::instance();
+  std::shared_ptr<ChainedJointData> output1 = interface.exportJoint("/robot1/arm_controller/joint1");
+  std::shared_ptr<ChainedJointData> output2 = interface.exportJoint("/robot2/arm_controller/joint1");
+  ASSERT_TRUE(output1.get());
+  ASSERT_TRUE(output2.get());
+
+  output1->position = 1.0;
+  output2->position = 2.0;
+  const std::string upstream_ns = chainedControllerNamespace("/robot2/group_controller", "arm_controller");
+  EXPECT_EQ(2.0, interface.getHandle(chainedJointName(upstream_ns, "joint1")).getPosition());
+}
+
+TEST(ChainedJointInterfaceTest, MissingOutputThrows)
+{
+  ChainedJointInterface& interface = ChainedJointInterface::instance();
+  EXPECT_THROW(interface.getHandle("/missing_controller/joint1"), hardware_interface::HardwareInterfaceException);
+
+  std::shared_ptr<ChainedJointData> output = interface.exportJoint("/unloaded_controller/joint1");
+  ASSERT_TRUE(output.get());
+  output.reset();
+  EXPECT_THROW(interface.getHandle("/unloaded_controller/joint1"), hardware_interface::HardwareInterfaceException);
+}
+
+TEST(ChainedJointInterfaceTest, HandleOutlivesExporter)
+{
+  ChainedJointInterface& interface = ChainedJointInterface::instance();
+  const std::string name = chainedJointName("/short_lived_controller", "joint1");
+
+  std::shared_ptr<ChainedJointData> output = interface.exportJoint(name);
+  ASSERT_TRUE(output.get());
+  output->position = 4.0;
+  ChainedJointHandle handle = interface.getHandle(name);
+
+  // The handle keeps the last values readable after the upstream controller is unloaded, but they are stale
+  output->valid = true;
+  EXPECT_TRUE(handle.isValid());
+  output.reset();
+  EXPECT_EQ(4.0, handle.getPosition());
+  EXPECT_FALSE(handle.isValid());
+
+  // A reloaded upstream controller exports a new output, that can be claimed again
+  output = interface.exportJoint(name);
+  ASSERT_TRUE(output.get());
+  EXPECT_NO_THROW(interface.getHandle(name));
+}
+
+TEST(ChainedJointInterfaceTest, OutputsAreClaimedOnce)
+{
+  ChainedJointInterface& interface = ChainedJointInterface::instance();
+  const std::string name = chainedJointName("/claimed_controller", "joint1");
+
+  std::shared_ptr<ChainedJointData> output = interface.exportJoint(name);
+  ASSERT_TRUE(output.get());
+
+  {
+    ChainedJointHandle handle = interface.getHandle(name);
+    ChainedJointHandle handle_copy = handle; // Copies share the claim
+    EXPECT_THROW(interface.getHandle(name), hardware_interface::HardwareInterfaceException);
+  }
+
+  // Released with the last copy of the handle
+  EXPECT_NO_THROW(interface.getHandle(name));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
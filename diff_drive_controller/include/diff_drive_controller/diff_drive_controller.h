@@ -37,6 +37,7 @@
  */
 
 #include <control_msgs/JointTrajectoryControllerState.h>
+#include <controller_chaining/chained_joint_interface.h>
 #include <controller_interface/controller.h>
 #include <diff_drive_controller/DiffDriveControllerConfig.h>
 #include <diff_drive_controller/odometry.h>
@@ -109,6 +110,13 @@ namespace diff_drive_controller{
     std::vector<hardware_interface::JointHandle> left_wheel_joints_;
     std::vector<hardware_interface::JointHandle> right_wheel_joints_;
 
+    /// Wheel velocity commands exported to downstream controllers, empty if not exported:
+    std::vector<std::shared_ptr<controller_chaining::ChainedJointData> > left_wheel_outputs_;
+    std::vector<std::shared_ptr<controller_chaining::ChainedJointData> > right_wheel_outputs_;
+
+    /// Whether wheel commands are only exported, leaving the wheels unclaimed for downstream controllers:
+    bool export_only_;
+
     // Previous time
     ros::Time time_previous_;
 
@@ -240,6 +248,13 @@ namespace diff_drive_controller{
      */
     void brake();
 
+    /**
+     * \brief Writes the wheel velocity commands to the exported outputs, if any
+     * \param vel_left  Velocity command of the left wheels
+     * \param vel_right Velocity command of the right wheels
+     */
+    void exportWheelCommands(double vel_left, double vel_right);
+
     /**
      * \brief Velocity command callback
      * \param command Velocity command message (twist)
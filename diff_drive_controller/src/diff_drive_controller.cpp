@@ -159,6 +159,7 @@ namespace diff_drive_controller{
     , wheel_joints_size_(0)
     , publish_cmd_(false)
     , publish_wheel_joint_controller_state_(false)
+    , export_only_(false)
   {
   }
 
@@ -342,14 +343,59 @@ namespace diff_drive_controller{
       vel_right_previous_.resize(wheel_joints_size_, 0.0);
     }
 
+    // Export-only controllers leave the wheels to the downstream controllers of their commands:
+    controller_nh.param("export_only", export_only_, false);
+
     // Get the joint object to use in the realtime loop
+    typedef hardware_interface::ResourceManager<hardware_interface::JointHandle> JointResourceManager;
     for (size_t i = 0; i < wheel_joints_size_; ++i)
     {
       ROS_INFO_STREAM_NAMED(name_,
                             "Adding left wheel with joint name: " << left_wheel_names[i]
                             << " and right wheel with joint name: " << right_wheel_names[i]);
-      left_wheel_joints_[i] = hw->getHandle(left_wheel_names[i]);  // throws on failure
-      right_wheel_joints_[i] = hw->getHandle(right_wheel_names[i]);  // throws on failure
+      if (export_only_)
+      {
+        // Neither claimed nor commanded, only read for odometry
+        left_wheel_joints_[i] = static_cast<JointResourceManager*>(hw)->getHandle(left_wheel_names[i]);
+        right_wheel_joints_[i] = static_cast<JointResourceManager*>(hw)->getHandle(right_wheel_names[i]);
+      }
+      else
+      {
+        left_wheel_joints_[i] = hw->getHandle(left_wheel_names[i]);  // throws on failure
+        right_wheel_joints_[i] = hw->getHandle(right_wheel_names[i]);  // throws on failure
+      }
+    }
+
+    // Wheel commands exported to downstream controllers:
+    bool export_wheel_commands = false;
+    controller_nh.param("export_wheel_commands", export_wheel_commands, export_wheel_commands);
+    left_wheel_outputs_.clear();
+    right_wheel_outputs_.clear();
+    if (export_only_ && !export_wheel_commands)
+    {
+      ROS_ERROR_NAMED(name_, "The 'export_only' parameter requires 'export_wheel_commands' to be set.");
+      return false;
+    }
+    if (export_wheel_commands)
+    {
+      controller_chaining::ChainedJointInterface& chained_iface = controller_chaining::ChainedJointInterface::instance();
+      for (size_t i = 0; i < wheel_joints_size_; ++i)
+      {
+        left_wheel_outputs_.push_back(chained_iface.exportJoint(
+            controller_chaining::chainedJointName(controller_nh.getNamespace(), left_wheel_names[i])));
+        right_wheel_outputs_.push_back(chained_iface.exportJoint(
+            controller_chaining::chainedJointName(controller_nh.getNamespace(), right_wheel_names[i])));
+        if (!left_wheel_outputs_.back() || !right_wheel_outputs_.back())
+        {
+          ROS_ERROR_STREAM_NAMED(name_,
+              "Commands of wheels " << left_wheel_names[i] << " and " << right_wheel_names[i]
+              << " are already exported.");
+          left_wheel_outputs_.clear();
+          right_wheel_outputs_.clear();
+          return false;
+        }
+      }
+      ROS_INFO_STREAM_NAMED(name_, "Wheel commands are exported to downstream controllers.");
     }
 
     sub_command_ = controller_nh.subscribe("cmd_vel", 1, &DiffDriveController::cmdVelCallback, this);
@@ -486,11 +532,12 @@ namespace diff_drive_controller{
     const double vel_right = (curr_cmd.lin + curr_cmd.ang * ws / 2.0)/rwr;
 
     // Set wheels velocities:
-    for (size_t i = 0; i < wheel_joints_size_; ++i)
+    for (size_t i = 0; i < wheel_joints_size_ && !export_only_; ++i)
     {
       left_wheel_joints_[i].setCommand(vel_left);
       right_wheel_joints_[i].setCommand(vel_right);
     }
+    exportWheelCommands(vel_left, vel_right);
 
     publishWheelData(time, period, curr_cmd, ws, lwr, rwr);
     time_previous_ = time;
@@ -510,16 +557,35 @@ namespace diff_drive_controller{
   void DiffDriveController::stopping(const ros::Time& /*time*/)
   {
     brake();
+
+    // Downstream controllers must not keep following the last wheel commands
+    for (size_t i = 0; i < left_wheel_outputs_.size(); ++i)
+    {
+      left_wheel_outputs_[i]->valid  = false;
+      right_wheel_outputs_[i]->valid = false;
+    }
   }
 
   void DiffDriveController::brake()
   {
     const double vel = 0.0;
-    for (size_t i = 0; i < wheel_joints_size_; ++i)
+    for (size_t i = 0; i < wheel_joints_size_ && !export_only_; ++i)
     {
       left_wheel_joints_[i].setCommand(vel);
       right_wheel_joints_[i].setCommand(vel);
     }
+    exportWheelCommands(vel, vel);
+  }
+
+  void DiffDriveController::exportWheelCommands(double vel_left, double vel_right)
+  {
+    for (size_t i = 0; i < left_wheel_outputs_.size(); ++i)
+    {
+      left_wheel_outputs_[i]->velocity  = vel_left;
+      right_wheel_outputs_[i]->velocity = vel_right;
+      left_wheel_outputs_[i]->valid     = true;
+      right_wheel_outputs_[i]->valid    = true;
+    }
   }
 
   void DiffDriveController::cmdVelCallback(const geometry_msgs::Twist& command)
@@ -39,13 +39,15 @@
 #define EFFORT_CONTROLLERS_JOINT_GROUP_POSITION_CONTROLLER_H
 
 #include <control_msgs/JointControllerState.h>
-#include <control_toolbox/pid.h>
+#include <batch_pid/batch_pid.h>
+#include <batch_pid/joint_position_error.h>
 #include <controller_interface/controller.h>
 #include <hardware_interface/joint_command_interface.h>
 #include <realtime_tools/realtime_buffer.h>
 #include <realtime_tools/realtime_publisher.h>
 #include <ros/node_handle.h>
 #include <std_msgs/Float64MultiArray.h>
+#include <trajectory_msgs/JointTrajectoryPoint.h>
 #include <urdf/model.h>
 
 namespace effort_controllers
@@ -60,9 +62,18 @@ namespace effort_controllers
  *
  * \param type Must be "JointGroupEffortController".
  * \param joints List of names of the joints to control.
+ * \param <joint_name>/inertia Optional inertia seen by each joint, used for acceleration feedforward. Defaults to zero.
  *
  * Subscribes to:
  * - \b command (std_msgs::Float64MultiArray) : The joint efforts to apply
+ * - \b command_point (trajectory_msgs::JointTrajectoryPoint) : The joint positions to achieve, with optional
+ *   velocities and accelerations. Velocities replace the numerically differentiated position error in the derivative
+ *   term by the velocity error, and accelerations are fed forward through the joint inertias
+ *
+ * The current positions are held until the first command is received.
+ *
+ * Provides:
+ * - \b set_gains (batch_pid::SetGains) : Update the PID gains of all joints at once
  */
 class JointGroupPositionController : public controller_interface::Controller<hardware_interface::EffortJointInterface>
 {  
@@ -71,22 +82,41 @@ public:
   ~JointGroupPositionController();
 
   bool init(hardware_interface::EffortJointInterface* hw, ros::NodeHandle &n);
+  void starting(const ros::Time& /*time*/);
   void update(const ros::Time& /*time*/, const ros::Duration& /*period*/);
 
   std::vector< std::string > joint_names_;
   std::vector< hardware_interface::JointHandle > joints_;
-  realtime_tools::RealtimeBuffer<std::vector<double> > commands_buffer_;
+
+  /**
+   * \brief Joint setpoints, one entry per joint in each field.
+   */
+  struct Commands
+  {
+    std::vector<double> position;
+    std::vector<double> velocity;     ///< Empty if velocities are not commanded.
+    std::vector<double> acceleration; ///< Empty if accelerations are not commanded.
+  };
+
+  realtime_tools::RealtimeBuffer<Commands> commands_buffer_;
   unsigned int n_joints_;
 
 private:
   ros::Subscriber sub_command_;
+  ros::Subscriber sub_command_point_;
+
+  batch_pid::BatchPid pid_controller_;                      /**< Internal PID controller for all joints. */
 
-  std::vector<control_toolbox::Pid> pid_controllers_;       /**< Internal PID controllers. */
+  batch_pid::JointPositionError position_error_;            /**< Joint limits aware position error computation. */
+  std::vector<double>           inertias_;                  /**< Acceleration feedforward gains. */
 
-  std::vector<urdf::JointConstSharedPtr> joint_urdfs_;
+  std::vector<double> current_positions_;                   /**< Preallocated workspace variable. */
+  std::vector<double> velocity_errors_;                     /**< Preallocated workspace variable. */
+  std::vector<double> position_errors_;                     /**< Preallocated workspace variable. */
+  std::vector<double> commanded_efforts_;                   /**< Preallocated workspace variable. */
 
   void commandCB(const std_msgs::Float64MultiArrayConstPtr& msg);
-  void enforceJointLimits(double &command, unsigned int index);
+  void commandPointCB(const trajectory_msgs::JointTrajectoryPointConstPtr& msg);
 }; // class
 
 } // namespace
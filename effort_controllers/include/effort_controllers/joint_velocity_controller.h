@@ -56,15 +56,16 @@
 
    - @b state (control_msgs::JointControllerState) :
      Current state of the controller, including pid error and gains.
+     Publish rate and sample batching are set by the @b state_publish_rate and
+     @b state_batch_size parameters. See: batch_pid::PidStatePublisher
 
 */
 
-#include <control_msgs/JointControllerState.h>
+#include <batch_pid/pid_state_publisher.h>
 #include <control_toolbox/pid.h>
 #include <controller_interface/controller.h>
 #include <hardware_interface/joint_command_interface.h>
 #include <memory>
-#include <realtime_tools/realtime_publisher.h>
 #include <ros/node_handle.h>
 #include <std_msgs/Float64.h>
 
@@ -95,6 +96,25 @@ public:
    */  
   bool init(hardware_interface::EffortJointInterface *robot, ros::NodeHandle &n);
 
+  /**
+   * \brief Initialize the controller to be hosted by a joint_controller_group::JointControllerGroup.
+   *
+   * Same as \ref init, except that no command subscriber is started, and state samples are only published by calls
+   * to \ref publishState, so that the hosting controller can serve all its joints with a single topic and thread.
+   *
+   * \param default_joint_name Joint controlled if the \p joint parameter is not set.
+   * \param default_state_publish_rate State publish rate if the \p state_publish_rate parameter is not set. Ignored
+   * if not positive.
+   */
+  bool initHosted(hardware_interface::EffortJointInterface *robot, ros::NodeHandle &n,
+                  const std::string &default_joint_name, double default_state_publish_rate);
+
+  /**
+   * \brief Publish the state samples recorded since the last call. Only needed by hosted controllers.
+   *        This method is \e not realtime-safe.
+   */
+  void publishState();
+
   /*!
    * \brief Give set velocity of the joint for next update: revolute (angle) and prismatic (velocity)
    *
@@ -148,12 +168,9 @@ public:
   double command_;                                /**< Last commanded velocity. */
 
 private:
-  int loop_count_;
   control_toolbox::Pid pid_controller_;           /**< Internal PID controller. */
 
-  std::unique_ptr<
-    realtime_tools::RealtimePublisher<
-      control_msgs::JointControllerState> > controller_state_publisher_ ;
+  batch_pid::PidStatePublisher controller_state_publisher_;
 
   ros::Subscriber sub_command_;
 
@@ -161,6 +178,9 @@ private:
    * \brief Callback from /command subscriber for setpoint
    */
   void setCommandCB(const std_msgs::Float64ConstPtr& msg);
+
+  bool initImpl(hardware_interface::EffortJointInterface *robot, ros::NodeHandle &n, bool hosted,
+                const std::string &default_joint_name, double default_state_publish_rate);
 };
 
 } // namespace
@@ -37,7 +37,6 @@
 
 #include <effort_controllers/joint_group_position_controller.h>
 #include <pluginlib/class_list_macros.hpp>
-#include <angles/angles.h>
 
 namespace effort_controllers
 {
@@ -56,7 +55,11 @@ namespace effort_controllers
  * - \b command (std_msgs::Float64MultiArray) : The joint efforts to apply
  */
   JointGroupPositionController::JointGroupPositionController() {}
-  JointGroupPositionController::~JointGroupPositionController() {sub_command_.shutdown();}
+  JointGroupPositionController::~JointGroupPositionController()
+  {
+    sub_command_.shutdown();
+    sub_command_point_.shutdown();
+  }
 
   bool JointGroupPositionController::init(hardware_interface::EffortJointInterface* hw, ros::NodeHandle &n)
   {
@@ -82,7 +85,7 @@ namespace effort_controllers
       return false;
     }
 
-    pid_controllers_.resize(n_joints_);
+    inertias_.resize(n_joints_, 0.0);
 
     for(unsigned int i=0; i<n_joints_; i++)
     {
@@ -98,68 +101,95 @@ namespace effort_controllers
         return false;
       }
 
-      urdf::JointConstSharedPtr joint_urdf = urdf.getJoint(joint_name);
-      if (!joint_urdf)
-      {
-        ROS_ERROR("Could not find joint '%s' in urdf", joint_name.c_str());
-        return false;
-      }
-      joint_urdfs_.push_back(joint_urdf);
+      // Optional acceleration feedforward
+      n.param(joint_name + "/inertia", inertias_[i], 0.0);
+    }
 
-      // Load PID Controller using gains set on parameter server
-      if (!pid_controllers_[i].init(ros::NodeHandle(n, joint_name + "/pid")))
-      {
-        ROS_ERROR_STREAM("Failed to load PID parameters from " << joint_name + "/pid");
-        return false;
-      }
+    // Cache joint types and limits, so that the control loop doesn't need to access the URDF model
+    if (!position_error_.init(urdf, joint_names_))
+    {
+      return false;
     }
 
-    commands_buffer_.writeFromNonRT(std::vector<double>(n_joints_, 0.0));
+    // Load PID Controller using gains set on parameter server
+    if (!pid_controller_.init(n, joint_names_))
+    {
+      ROS_ERROR_STREAM("Failed to load PID parameters (namespace: " << n.getNamespace() << ").");
+      return false;
+    }
+
+    // Preallocate workspace used by the control loop
+    current_positions_.resize(n_joints_, 0.0);
+    velocity_errors_.resize(n_joints_, 0.0);
+    position_errors_.resize(n_joints_, 0.0);
+    commanded_efforts_.resize(n_joints_, 0.0);
+
+    Commands commands;
+    commands.position.resize(n_joints_, 0.0);
+    commands_buffer_.writeFromNonRT(commands);
 
     sub_command_ = n.subscribe<std_msgs::Float64MultiArray>("command", 1, &JointGroupPositionController::commandCB, this);
+    sub_command_point_ = n.subscribe<trajectory_msgs::JointTrajectoryPoint>("command_point", 1,
+                                                                            &JointGroupPositionController::commandPointCB,
+                                                                            this);
     return true;
   }
 
   void JointGroupPositionController::update(const ros::Time& time, const ros::Duration& period)
   {
-    std::vector<double> & commands = *commands_buffer_.readFromRT();
+    const Commands& commands = *commands_buffer_.readFromRT();
+
+    for(unsigned int i=0; i<n_joints_; i++)
+    {
+      current_positions_[i] = joints_[i].getPosition();
+    }
+
+    // Make sure joints are within limits if applicable, and compute the position error
+    position_error_.compute(commands.position.data(), current_positions_.data(), position_errors_.data());
+
+    // Set the PID errors and compute the PID commands of all joints at once with nonuniform
+    // time step size.
+    if (commands.velocity.empty())
+    {
+      pid_controller_.computeCommand(position_errors_.data(), period.toSec(), commanded_efforts_.data());
+    }
+    else
+    {
+      // Use the velocity error instead of differentiating the position error
+      for(unsigned int i=0; i<n_joints_; i++)
+      {
+        velocity_errors_[i] = commands.velocity[i] - joints_[i].getVelocity();
+      }
+      pid_controller_.computeCommand(position_errors_.data(), velocity_errors_.data(), period.toSec(), commanded_efforts_.data());
+    }
+
+    // Acceleration feedforward
+    if (!commands.acceleration.empty())
+    {
+      for(unsigned int i=0; i<n_joints_; i++)
+      {
+        commanded_efforts_[i] += inertias_[i] * commands.acceleration[i];
+      }
+    }
+
+    for(unsigned int i=0; i<n_joints_; i++)
+    {
+      joints_[i].setCommand(commanded_efforts_[i]);
+    }
+  }
+
+  void JointGroupPositionController::starting(const ros::Time& time)
+  {
+    // Hold the current positions until a command is received
     for(unsigned int i=0; i<n_joints_; i++)
     {
-        double command_position = commands[i];
-
-        double error; //, vel_error;
-        double commanded_effort;
-
-        double current_position = joints_[i].getPosition();
-
-        // Make sure joint is within limits if applicable
-        enforceJointLimits(command_position, i);
-
-        // Compute position error
-        if (joint_urdfs_[i]->type == urdf::Joint::REVOLUTE)
-        {
-         angles::shortest_angular_distance_with_limits(
-            current_position,
-            command_position,
-            joint_urdfs_[i]->limits->lower,
-            joint_urdfs_[i]->limits->upper,
-            error);
-        }
-        else if (joint_urdfs_[i]->type == urdf::Joint::CONTINUOUS)
-        {
-          error = angles::shortest_angular_distance(current_position, command_position);
-        }
-        else //prismatic
-        {
-          error = command_position - current_position;
-        }
-
-        // Set the PID error and compute the PID command with nonuniform
-        // time step size.
-        commanded_effort = pid_controllers_[i].computeCommand(error, period);
-
-        joints_[i].setCommand(commanded_effort);
+      current_positions_[i] = joints_[i].getPosition();
     }
+    Commands commands;
+    commands.position = current_positions_;
+    commands_buffer_.initRT(commands);
+
+    pid_controller_.reset();
   }
 
   void JointGroupPositionController::commandCB(const std_msgs::Float64MultiArrayConstPtr& msg)
@@ -169,23 +199,34 @@ namespace effort_controllers
       ROS_ERROR_STREAM("Dimension of command (" << msg->data.size() << ") does not match number of joints (" << n_joints_ << ")! Not executing!");
       return; 
     }
-    commands_buffer_.writeFromNonRT(msg->data);
+    Commands commands;
+    commands.position = msg->data;
+    commands_buffer_.writeFromNonRT(commands);
   }
 
-  void JointGroupPositionController::enforceJointLimits(double &command, unsigned int index)
+  void JointGroupPositionController::commandPointCB(const trajectory_msgs::JointTrajectoryPointConstPtr& msg)
   {
-    // Check that this joint has applicable limits
-    if (joint_urdfs_[index]->type == urdf::Joint::REVOLUTE || joint_urdfs_[index]->type == urdf::Joint::PRISMATIC)
+    if(msg->positions.size()!=n_joints_)
     {
-      if( command > joint_urdfs_[index]->limits->upper ) // above upper limnit
-      {
-        command = joint_urdfs_[index]->limits->upper;
-      }
-      else if( command < joint_urdfs_[index]->limits->lower ) // below lower limit
-      {
-        command = joint_urdfs_[index]->limits->lower;
-      }
+      ROS_ERROR_STREAM("Dimension of command positions (" << msg->positions.size() << ") does not match number of joints (" << n_joints_ << ")! Not executing!");
+      return;
+    }
+    if(!msg->velocities.empty() && msg->velocities.size()!=n_joints_)
+    {
+      ROS_ERROR_STREAM("Dimension of command velocities (" << msg->velocities.size() << ") does not match number of joints (" << n_joints_ << ")! Not executing!");
+      return;
     }
+    if(!msg->accelerations.empty() && msg->accelerations.size()!=n_joints_)
+    {
+      ROS_ERROR_STREAM("Dimension of command accelerations (" << msg->accelerations.size() << ") does not match number of joints (" << n_joints_ << ")! Not executing!");
+      return;
+    }
+
+    Commands commands;
+    commands.position     = msg->positions;
+    commands.velocity     = msg->velocities;
+    commands.acceleration = msg->accelerations;
+    commands_buffer_.writeFromNonRT(commands);
   }
 
 } // namespace
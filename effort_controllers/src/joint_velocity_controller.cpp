@@ -40,7 +40,7 @@
 namespace effort_controllers {
 
 JointVelocityController::JointVelocityController()
-: command_(0), loop_count_(0)
+: command_(0)
 {}
 
 JointVelocityController::~JointVelocityController()
@@ -60,10 +60,28 @@ bool JointVelocityController::init(hardware_interface::EffortJointInterface *rob
 }
 
 bool JointVelocityController::init(hardware_interface::EffortJointInterface *robot, ros::NodeHandle &n)
+{
+  return initImpl(robot, n, false, std::string(), 0.0);
+}
+
+bool JointVelocityController::initHosted(hardware_interface::EffortJointInterface *robot, ros::NodeHandle &n,
+                                         const std::string &default_joint_name, double default_state_publish_rate)
+{
+  return initImpl(robot, n, true, default_joint_name, default_state_publish_rate);
+}
+
+void JointVelocityController::publishState()
+{
+  controller_state_publisher_.publishQueued();
+}
+
+bool JointVelocityController::initImpl(hardware_interface::EffortJointInterface *robot, ros::NodeHandle &n,
+                                       bool hosted, const std::string &default_joint_name,
+                                       double default_state_publish_rate)
 {
   // Get joint name from parameter server
-  std::string joint_name;
-  if (!n.getParam("joint", joint_name)) {
+  std::string joint_name = default_joint_name;
+  if (!n.getParam("joint", joint_name) && joint_name.empty()) {
     ROS_ERROR("No joint given (namespace: %s)", n.getNamespace().c_str());
     return false;
   }
@@ -76,12 +94,12 @@ bool JointVelocityController::init(hardware_interface::EffortJointInterface *rob
     return false;
 
   // Start realtime state publisher
-  controller_state_publisher_.reset(
-    new realtime_tools::RealtimePublisher<control_msgs::JointControllerState>
-    (n, "state", 1));
+  if (!controller_state_publisher_.init(n, pid_controller_, !hosted, default_state_publish_rate))
+    return false;
 
-  // Start command subscriber
-  sub_command_ = n.subscribe<std_msgs::Float64>("command", 1, &JointVelocityController::setCommandCB, this);
+  // Start command subscriber, hosted controllers are commanded by their host
+  if (!hosted)
+    sub_command_ = n.subscribe<std_msgs::Float64>("command", 1, &JointVelocityController::setCommandCB, this);
 
   return true;
 }
@@ -141,30 +159,16 @@ void JointVelocityController::update(const ros::Time& time, const ros::Duration&
 
   joint_.setCommand(commanded_effort);
 
-  if(loop_count_ % 10 == 0)
+  // publish state
+  if (control_msgs::JointControllerState* state = controller_state_publisher_.sample(time))
   {
-    if(controller_state_publisher_ && controller_state_publisher_->trylock())
-    {
-      controller_state_publisher_->msg_.header.stamp = time;
-      controller_state_publisher_->msg_.set_point = command_;
-      controller_state_publisher_->msg_.process_value = joint_.getVelocity();
-      controller_state_publisher_->msg_.error = error;
-      controller_state_publisher_->msg_.time_step = period.toSec();
-      controller_state_publisher_->msg_.command = commanded_effort;
-
-      double dummy;
-      bool antiwindup;
-      getGains(controller_state_publisher_->msg_.p,
-        controller_state_publisher_->msg_.i,
-        controller_state_publisher_->msg_.d,
-        controller_state_publisher_->msg_.i_clamp,
-        dummy,
-        antiwindup);
-      controller_state_publisher_->msg_.antiwindup = static_cast<char>(antiwindup);
-      controller_state_publisher_->unlockAndPublish();
-    }
+    state->set_point = command_;
+    state->process_value = joint_.getVelocity();
+    state->error = error;
+    state->time_step = period.toSec();
+    state->command = commanded_effort;
+    controller_state_publisher_.publish();
   }
-  loop_count_++;
 }
 
 void JointVelocityController::setCommandCB(const std_msgs::Float64ConstPtr& msg)
@@ -0,0 +1,200 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <ros/ros.h>
+#include <std_msgs/Float64MultiArray.h>
+#include <trajectory_msgs/JointTrajectoryPoint.h>
+
+#include <hardware_interface/joint_command_interface.h>
+#include <effort_controllers/joint_group_position_controller.h>
+
+using effort_controllers::JointGroupPositionController;
+
+// Floating-point value comparison threshold
+const double EPS = 1e-9;
+
+class JointGroupPositionControllerTest : public ::testing::Test
+{
+public:
+  JointGroupPositionControllerTest()
+    : controller_nh_("effort_group_position_controller"),
+      period_(0.01)
+  {
+    const std::string names[] = {"joint1", "joint2"};
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+      pos_[i] = 0.0; vel_[i] = 0.0; eff_[i] = 0.0; cmd_[i] = 0.0;
+      hardware_interface::JointStateHandle state_handle(names[i], &pos_[i], &vel_[i], &eff_[i]);
+      hw_.registerHandle(hardware_interface::JointHandle(state_handle, &cmd_[i]));
+    }
+
+    command_pub_       = controller_nh_.advertise<std_msgs::Float64MultiArray>("command", 1);
+    command_point_pub_ = controller_nh_.advertise<trajectory_msgs::JointTrajectoryPoint>("command_point", 1);
+  }
+
+protected:
+  ros::NodeHandle controller_nh_;
+  ros::Publisher command_pub_;
+  ros::Publisher command_point_pub_;
+  hardware_interface::EffortJointInterface hw_;
+  ros::Duration period_;
+
+  // Raw joint data
+  double pos_[2];
+  double vel_[2];
+  double eff_[2];
+  double cmd_[2];
+
+  /**
+   * \brief Publish \p msg once \p pub has a subscriber, and wait for the controller to receive a command with the
+   * given positions and number of velocities.
+   */
+  template <class Msg>
+  bool publish(const ros::Publisher& pub,
+               const Msg& msg,
+               const JointGroupPositionController& controller,
+               const std::vector<double>& positions,
+               unsigned int n_velocities)
+  {
+    const ros::Time timeout = ros::Time::now() + ros::Duration(5.0);
+    while (pub.getNumSubscribers() == 0 && ros::Time::now() < timeout) {ros::Duration(0.01).sleep();}
+    pub.publish(msg);
+
+    while (ros::ok() && ros::Time::now() < timeout)
+    {
+      ros::spinOnce();
+      const JointGroupPositionController::Commands& commands = *controller.commands_buffer_.readFromNonRT();
+      if (commands.position == positions && commands.velocity.size() == n_velocities) {return true;}
+      ros::Duration(0.01).sleep();
+    }
+    return false;
+  }
+
+  bool publishCommand(const JointGroupPositionController& controller, const std::vector<double>& positions)
+  {
+    std_msgs::Float64MultiArray msg;
+    msg.data = positions;
+    return publish(command_pub_, msg, controller, positions, 0);
+  }
+
+  bool publishCommandPoint(const JointGroupPositionController& controller,
+                           const trajectory_msgs::JointTrajectoryPoint& msg)
+  {
+    return publish(command_point_pub_, msg, controller, msg.positions, msg.velocities.size());
+  }
+};
+
+TEST_F(JointGroupPositionControllerTest, HoldPositionOnStart)
+{
+  JointGroupPositionController controller;
+  ASSERT_TRUE(controller.init(&hw_, controller_nh_));
+
+  pos_[0] = 0.5; pos_[1] = -0.3;
+  controller.starting(ros::Time::now());
+  controller.update(ros::Time::now(), period_);
+  EXPECT_NEAR(0.0, cmd_[0], EPS);
+  EXPECT_NEAR(0.0, cmd_[1], EPS);
+}
+
+TEST_F(JointGroupPositionControllerTest, CommandPoint)
+{
+  JointGroupPositionController controller;
+  ASSERT_TRUE(controller.init(&hw_, controller_nh_));
+
+  pos_[0] = 0.5; pos_[1] = 0.0;
+  vel_[0] = 0.2; vel_[1] = 0.0;
+  controller.starting(ros::Time::now());
+
+  // Velocity errors are used in the derivative term, and accelerations are fed forward through the joint inertias
+  trajectory_msgs::JointTrajectoryPoint msg;
+  msg.positions     = {1.0, 0.1};
+  msg.velocities    = {1.0, 0.5};
+  msg.accelerations = {3.0, 3.0};
+  ASSERT_TRUE(publishCommandPoint(controller, msg));
+
+  controller.update(ros::Time::now(), period_);
+  EXPECT_NEAR(10.0 * 0.5 + 1.0 * 0.8 + 2.0 * 3.0, cmd_[0], EPS);
+  EXPECT_NEAR(20.0 * 0.1 + 4.0 * 0.5,             cmd_[1], EPS);
+
+  // Velocities and accelerations are optional
+  msg.velocities.clear();
+  msg.accelerations.clear();
+  msg.positions = {1.5, 0.1};
+  ASSERT_TRUE(publishCommandPoint(controller, msg));
+
+  controller.update(ros::Time::now(), period_);
+  EXPECT_NEAR(10.0 * 1.0 + 1.0 * 0.5 / period_.toSec(), cmd_[0], EPS);
+  EXPECT_NEAR(20.0 * 0.1,                               cmd_[1], EPS);
+
+  // Mismatching sizes are rejected
+  msg.positions     = {2.0, 0.2};
+  msg.velocities    = {1.0};
+  msg.accelerations = {};
+  command_point_pub_.publish(msg);
+  ros::Duration(0.1).sleep();
+  ros::spinOnce();
+  EXPECT_EQ(std::vector<double>({1.5, 0.1}), controller.commands_buffer_.readFromNonRT()->position);
+}
+
+TEST_F(JointGroupPositionControllerTest, NoDerivativeKickOnTopicSwitch)
+{
+  JointGroupPositionController controller;
+  ASSERT_TRUE(controller.init(&hw_, controller_nh_));
+
+  controller.starting(ros::Time::now());
+
+  trajectory_msgs::JointTrajectoryPoint msg;
+  msg.positions  = {1.0, 0.1};
+  msg.velocities = {0.0, 0.0};
+  ASSERT_TRUE(publishCommandPoint(controller, msg));
+  controller.update(ros::Time::now(), period_);
+
+  // Same setpoint without velocities: the position error didn't change, so there is no derivative contribution
+  ASSERT_TRUE(publishCommand(controller, msg.positions));
+  controller.update(ros::Time::now(), period_);
+  EXPECT_NEAR(10.0 * 1.0, cmd_[0], EPS);
+  EXPECT_NEAR(20.0 * 0.1, cmd_[1], EPS);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "joint_group_position_controller_test");
+  return RUN_ALL_TESTS();
+}
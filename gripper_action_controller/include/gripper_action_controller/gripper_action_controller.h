@@ -31,10 +31,20 @@
 #define GRIPPER_ACTION_CONTROLLER_GRIPPER_ACTION_CONTROLLER_H
 
 // C++ standard
+#include <atomic>
 #include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <ctime>
 #include <stdexcept>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// POSIX
+#include <semaphore.h>
 
 // ROS
 #include <ros/node_handle.h>
@@ -82,6 +92,9 @@ public:
   };
   
   GripperActionController();
+
+  /** \brief Stops the goal status notifier thread. */
+  ~GripperActionController();
   
   /** \name Non Real-Time Safe Functions
    *\{*/
@@ -130,13 +143,30 @@ private:
   ros::NodeHandle    controller_nh_;
   ActionServerPtr    action_server_;
 
-  ros::Timer         goal_handle_timer_;
+  // Goal status notification: results set from update() are forwarded to actionlib by a persistent non-realtime
+  // thread, woken up through a semaphore as soon as a goal finishes and otherwise running at the action monitor rate.
+  // Only this thread calls into the goal handles, and never with goal_notifier_mutex_ locked, as actionlib holds its
+  // own lock while running goalCB, which takes goal_notifier_mutex_
+  std::thread             goal_notifier_thread_;
+  std::mutex              goal_notifier_mutex_;
+  sem_t                   goal_notifier_sem_;   ///< Posted to wake up the notifier thread.
+  std::atomic<bool>       goal_notifier_stopped_;
+  RealtimeGoalHandlePtr   notifier_goal_;       ///< Last accepted goal. Protected by goal_notifier_mutex_.
+  std::vector<RealtimeGoalHandlePtr> replaced_goals_; ///< Goals replaced before their status was forwarded.
+                                                      ///< Protected by goal_notifier_mutex_.
 
   void goalCB(GoalHandle gh);
   void cancelCB(GoalHandle gh);
   void preemptActiveGoal();
   void setHoldPosition(const ros::Time& time);
 
+  /**
+   * \brief Wake up the goal status notifier thread after a goal has been marked as succeeded or aborted.
+   * \note This method is realtime-safe: it only posts a semaphore, which neither allocates nor takes a lock.
+   */
+  void notifyGoalStatus();
+  void goalNotifierLoop();
+
   ros::Time last_movement_time_;                                    ///< Store stall time
   double computed_command_;                                         ///< Computed command
 
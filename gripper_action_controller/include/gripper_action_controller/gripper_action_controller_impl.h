@@ -125,8 +125,21 @@ preemptActiveGoal()
 template <class HardwareInterface>
 GripperActionController<HardwareInterface>::
 GripperActionController()
-: verbose_(false) // Set to true during debugging
-{}
+: verbose_(false), // Set to true during debugging
+  goal_notifier_stopped_(false)
+{
+  sem_init(&goal_notifier_sem_, 0, 0);
+}
+
+template <class HardwareInterface>
+GripperActionController<HardwareInterface>::
+~GripperActionController()
+{
+  goal_notifier_stopped_.store(true, std::memory_order_release);
+  sem_post(&goal_notifier_sem_);
+  if (goal_notifier_thread_.joinable()) {goal_notifier_thread_.join();}
+  sem_destroy(&goal_notifier_sem_);
+}
 
 template <class HardwareInterface>
 bool GripperActionController<HardwareInterface>::init(HardwareInterface* hw,
@@ -145,7 +158,7 @@ bool GripperActionController<HardwareInterface>::init(HardwareInterface* hw,
   double action_monitor_rate = 20.0;
   controller_nh_.getParam("action_monitor_rate", action_monitor_rate);
   action_monitor_period_ = ros::Duration(1.0 / action_monitor_rate);
-  ROS_DEBUG_STREAM_NAMED(name_, "Action status changes will be monitored at " << action_monitor_rate << "Hz.");
+  ROS_DEBUG_STREAM_NAMED(name_, "Action feedback will be published at " << action_monitor_rate << "Hz.");
   
   // Controlled joint
   controller_nh_.getParam("joint", joint_name_);
@@ -198,7 +211,11 @@ bool GripperActionController<HardwareInterface>::init(HardwareInterface* hw,
   controller_nh_.param<double>("stall_timeout", stall_timeout_, 1.0);
   
   // Hardware interface adapter
-  hw_iface_adapter_.init(joint_, controller_nh_);
+  if (!hw_iface_adapter_.init(joint_, controller_nh_))
+  {
+    ROS_ERROR_STREAM_NAMED(name_, "Failed to initialize the hardware interface adapter.");
+    return false;
+  }
 
   // Command - non RT version
   command_struct_.position_ = joint_.getPosition();
@@ -211,6 +228,7 @@ bool GripperActionController<HardwareInterface>::init(HardwareInterface* hw,
   pre_alloc_result_->stalled = false;
 
   // ROS API: Action interface
+  goal_notifier_thread_ = std::thread(&GripperActionController::goalNotifierLoop, this);
   action_server_.reset(new ActionServer(controller_nh_, "gripper_cmd",
 					boost::bind(&GripperActionController::goalCB,   this, _1),
 					boost::bind(&GripperActionController::cancelCB, this, _1),
@@ -272,11 +290,13 @@ goalCB(GoalHandle gh)
 
   last_movement_time_ = ros::Time::now();
     
-  // Setup goal status checking timer
-  goal_handle_timer_ = controller_nh_.createTimer(action_monitor_period_,
-                                                  &RealtimeGoalHandle::runNonRealtime,
-                                                  rt_goal);
-  goal_handle_timer_.start();
+  // Hand the new goal over to the status notifier, which still forwards any pending status of the previous one
+  {
+    std::lock_guard<std::mutex> lock(goal_notifier_mutex_);
+    if (notifier_goal_) {replaced_goals_.push_back(notifier_goal_);}
+    notifier_goal_ = rt_goal;
+  }
+  notifyGoalStatus();
   rt_active_goal_ = rt_goal;
 }
 
@@ -329,6 +349,7 @@ checkForSuccess(const ros::Time& time, double error_position, double current_pos
     pre_alloc_result_->reached_goal = true;
     pre_alloc_result_->stalled = false;
     current_active_goal->setSucceeded(pre_alloc_result_);
+    notifyGoalStatus();
   }
   else
   {
@@ -343,7 +364,50 @@ checkForSuccess(const ros::Time& time, double error_position, double current_pos
       pre_alloc_result_->reached_goal = false;
       pre_alloc_result_->stalled = true;
       current_active_goal->setAborted(pre_alloc_result_);
+      notifyGoalStatus();
+    }
+  }
+}
+
+template <class HardwareInterface>
+inline void GripperActionController<HardwareInterface>::
+notifyGoalStatus()
+{
+  // Posted even if the notifier thread is busy, so that it runs again as soon as it waits
+  sem_post(&goal_notifier_sem_);
+}
+
+template <class HardwareInterface>
+void GripperActionController<HardwareInterface>::
+goalNotifierLoop()
+{
+  const int64_t period_ns = action_monitor_period_.toNSec();
+  std::vector<RealtimeGoalHandlePtr> goals;
+
+  while (!goal_notifier_stopped_.load(std::memory_order_acquire))
+  {
+    // Wait for a wake-up, or for the next feedback. sem_timedwait only takes deadlines in CLOCK_REALTIME
+    timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    const int64_t deadline_ns = deadline.tv_nsec + period_ns;
+    deadline.tv_sec  += deadline_ns / 1000000000;
+    deadline.tv_nsec  = deadline_ns % 1000000000;
+    while (sem_timedwait(&goal_notifier_sem_, &deadline) != 0 && errno == EINTR) {}
+
+    // Wake-ups posted until now are all served by this iteration
+    while (sem_trywait(&goal_notifier_sem_) == 0) {}
+    if (goal_notifier_stopped_.load(std::memory_order_acquire)) {break;}
+
+    // Take the goals to notify, and call into actionlib only after releasing the lock
+    {
+      std::lock_guard<std::mutex> lock(goal_notifier_mutex_);
+      goals.swap(replaced_goals_);
+      if (notifier_goal_) {goals.push_back(notifier_goal_);}
     }
+
+    // Forwards results requested by the realtime loop to actionlib
+    for (const RealtimeGoalHandlePtr& goal : goals) {goal->runNonRealtime(ros::TimerEvent());}
+    goals.clear();
   }
 }
 
@@ -0,0 +1,343 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef JOINT_CONTROLLER_GROUP_JOINT_CONTROLLER_GROUP_H
+#define JOINT_CONTROLLER_GROUP_JOINT_CONTROLLER_GROUP_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <controller_chaining/chained_joint_interface.h>
+#include <controller_interface/controller.h>
+#include <realtime_tools/realtime_buffer.h>
+#include <ros/node_handle.h>
+#include <std_msgs/Float64MultiArray.h>
+
+namespace joint_controller_group
+{
+
+/**
+ * \brief Controller hosting one single-joint controller per joint of a group.
+ *
+ * Single-joint controllers are stored contiguously and updated through non-virtual calls. The group has a single
+ * command topic and a single thread publishing the state of all hosted controllers, instead of one of each per joint.
+ * Hosted controllers keep their other per-joint ROS interfaces, such as their state topics and the dynamic_reconfigure
+ * servers of their PID controllers.
+ *
+ * \tparam JointController Hosted single-joint controller type. Must be default-constructible, and provide:
+ * - <tt>bool initHosted(HardwareInterface* hw, ros::NodeHandle& n, const std::string& default_joint_name,
+ *   double default_state_publish_rate)</tt> : Initialize without command subscriber, and without publishing state on
+ *   its own. The defaults apply when the \p joint and \p state_publish_rate parameters are not set in \p n. A
+ *   non-positive default rate leaves the controller's own default.
+ * - <tt>void publishState()</tt> : Publish the state samples recorded since the last call.
+ * - <tt>void setCommand(double command)</tt> : Set the command, called from the realtime thread.
+ * - The \p starting, \p update and \p stopping methods of \p controller_interface::Controller.
+ * \tparam HardwareInterface Hardware interface type of the hosted controllers.
+ *
+ * \section ROS interface
+ *
+ * \param joints Names of the joints to control.
+ * \param <joint_name> Configuration of the controller hosted for each joint, with the same parameters as a standalone
+ * single-joint controller. The \p joint parameter defaults to \p <joint_name>. Defaults are passed to the hosted
+ * controllers on initialization, and never written to the parameter server.
+ * \param state_publish_rate Rate at which the state of all hosted controllers is published, in Hz. Also the default of
+ * the hosted controllers. If not set, hosted controllers keep their own default, and their state is published at
+ * 100 Hz.
+ * \param chained_input Name of an upstream controller loaded by the same controller manager (or its absolute
+ * namespace) exporting its outputs for \p joints (see \p controller_chaining::ChainedJointInterface). If set,
+ * commands are read from it every cycle instead of from the \p command topic. Load the upstream controller first for
+ * commands to be read in the cycle they are written. Each output is claimed by a single downstream controller. When the
+ * upstream controller stops or is unloaded, its outputs are no longer valid: hosted controllers then hold the current
+ * joint position if \p chained_input_field is \p position, and get a zero command otherwise. Reload the group after
+ * reloading the upstream controller. An upstream controller that would command the same joints must set its
+ * \p export_only parameter, so that it neither claims nor commands them. Otherwise the controller manager refuses to
+ * run both controllers together.
+ * \param chained_input_field Field of the upstream outputs used as command: \p position (default), \p velocity or
+ * \p effort.
+ *
+ * Subscribes to:
+ * - \b command (std_msgs::Float64MultiArray) : The commands of all joints, in the order of \p joints. Not subscribed
+ *   to when \p chained_input is set.
+ *
+ * Publishes:
+ * - \b <joint_name>/state : State of each hosted controller.
+ */
+template <class JointController, class HardwareInterface>
+class JointControllerGroup : public controller_interface::Controller<HardwareInterface>
+{
+public:
+  JointControllerGroup()
+    : n_joints_(0), last_command_id_(0), chained_input_getter_(nullptr), hold_position_on_stale_input_(false),
+      keep_running_(false)
+  {}
+
+  ~JointControllerGroup()
+  {
+    sub_command_.shutdown();
+    stopStatePublisher();
+  }
+
+  bool init(HardwareInterface* hw, ros::NodeHandle& n)
+  {
+    // List of controlled joints
+    std::string param_name = "joints";
+    if (!n.getParam(param_name, joint_names_))
+    {
+      ROS_ERROR_STREAM("Failed to getParam '" << param_name << "' (namespace: " << n.getNamespace() << ").");
+      return false;
+    }
+    n_joints_ = joint_names_.size();
+
+    if (n_joints_ == 0)
+    {
+      ROS_ERROR_STREAM("List of joint names is empty.");
+      return false;
+    }
+
+    double state_publish_rate = 100.0;
+    const bool has_state_publish_rate = n.getParam("state_publish_rate", state_publish_rate);
+    if (state_publish_rate <= 0.0)
+    {
+      ROS_ERROR_STREAM("State publish rate must be positive (namespace: " << n.getNamespace() << ").");
+      return false;
+    }
+
+    // Hosted controllers can't be copied nor moved, so they are constructed in place
+    const double default_state_publish_rate = has_state_publish_rate ? state_publish_rate : 0.0;
+    controllers_ = std::vector<JointController>(n_joints_);
+    for (unsigned int i = 0; i < n_joints_; ++i)
+    {
+      ros::NodeHandle joint_nh(n, joint_names_[i]);
+      if (!controllers_[i].initHosted(hw, joint_nh, joint_names_[i], default_state_publish_rate))
+      {
+        ROS_ERROR_STREAM("Failed to initialize controller of joint '" << joint_names_[i] << "'.");
+        return false;
+      }
+    }
+
+    Commands commands;
+    commands.values.resize(n_joints_, 0.0);
+    commands.id = 0;
+    commands_buffer_.writeFromNonRT(commands);
+    next_command_id_ = 1;
+
+    chained_inputs_.clear();
+    std::string chained_input;
+    if (n.getParam("chained_input", chained_input))
+    {
+      if (!initChainedInputs(hw, n, chained_input)) {return false;}
+    }
+    else
+    {
+      sub_command_ = n.subscribe<std_msgs::Float64MultiArray>("command", 1, &JointControllerGroup::commandCB, this);
+    }
+
+    stopStatePublisher();
+    state_publish_period_ = std::chrono::duration<double>(1.0 / state_publish_rate);
+    keep_running_ = true;
+    state_publisher_thread_ = std::thread(&JointControllerGroup::statePublisherLoop, this);
+    return true;
+  }
+
+  void starting(const ros::Time& time)
+  {
+    // Commands received before starting don't override what hosted controllers hold on start
+    last_command_id_ = commands_buffer_.readFromRT()->id;
+    std::fill(chained_input_stale_.begin(), chained_input_stale_.end(), false);
+    for (auto& controller : controllers_) {controller.JointController::starting(time);}
+  }
+
+  void update(const ros::Time& time, const ros::Duration& period)
+  {
+    const Commands& commands = *commands_buffer_.readFromRT();
+    if (!chained_inputs_.empty())
+    {
+      // Outputs of the upstream controller, written earlier in this same cycle if it was loaded first
+      for (unsigned int i = 0; i < n_joints_; ++i)
+      {
+        if (chained_inputs_[i].isValid())
+        {
+          controllers_[i].setCommand((chained_inputs_[i].*chained_input_getter_)());
+          chained_input_stale_[i] = false;
+        }
+        else if (!chained_input_stale_[i])
+        {
+          // The upstream controller is not running: don't replay its last output
+          controllers_[i].setCommand(hold_position_on_stale_input_ ? joint_states_[i].getPosition() : 0.0);
+          chained_input_stale_[i] = true;
+        }
+      }
+    }
+    else if (commands.id != last_command_id_)
+    {
+      for (unsigned int i = 0; i < n_joints_; ++i) {controllers_[i].setCommand(commands.values[i]);}
+      last_command_id_ = commands.id;
+    }
+
+    // Qualified calls bypass virtual dispatch
+    for (auto& controller : controllers_) {controller.JointController::update(time, period);}
+  }
+
+  void stopping(const ros::Time& time)
+  {
+    for (auto& controller : controllers_) {controller.JointController::stopping(time);}
+  }
+
+  std::vector<std::string> joint_names_;
+  unsigned int n_joints_;
+
+private:
+  /**
+   * \brief Commands of all joints. Each new command message gets a new identifier, so that the realtime thread only
+   * forwards commands to hosted controllers when they change.
+   */
+  struct Commands
+  {
+    std::vector<double> values;
+    unsigned int id;
+  };
+
+  std::vector<JointController> controllers_;
+
+  realtime_tools::RealtimeBuffer<Commands> commands_buffer_;
+  unsigned int next_command_id_; ///< Only used from the command callback.
+  unsigned int last_command_id_; ///< Only used from the realtime thread.
+  ros::Subscriber sub_command_;
+
+  typedef double (hardware_interface::JointStateHandle::*ChainedInputGetter)() const;
+  std::vector<controller_chaining::ChainedJointHandle> chained_inputs_; ///< Empty if commands come from the topic.
+  ChainedInputGetter chained_input_getter_;
+  std::vector<hardware_interface::JointStateHandle> joint_states_; ///< Read when chained inputs become stale.
+  std::vector<bool> chained_input_stale_;  ///< Whether the stale command was set. Only used from the realtime thread.
+  bool hold_position_on_stale_input_;
+
+  std::chrono::duration<double> state_publish_period_;
+  std::thread state_publisher_thread_;
+  std::mutex mutex_;
+  std::condition_variable stop_cond_;
+  bool keep_running_;            ///< Protected by \ref mutex_.
+
+  void commandCB(const std_msgs::Float64MultiArrayConstPtr& msg)
+  {
+    if (msg->data.size() != n_joints_)
+    {
+      ROS_ERROR_STREAM("Dimension of command (" << msg->data.size() << ") does not match number of joints ("
+                       << n_joints_ << ")! Not executing!");
+      return;
+    }
+    Commands commands;
+    commands.values = msg->data;
+    commands.id = next_command_id_++;
+    commands_buffer_.writeFromNonRT(commands);
+  }
+
+  bool initChainedInputs(HardwareInterface* hw, ros::NodeHandle& n, const std::string& upstream_name)
+  {
+    std::string field = "position";
+    n.getParam("chained_input_field", field);
+    hold_position_on_stale_input_ = field == "position";
+    if      (field == "position") {chained_input_getter_ = &hardware_interface::JointStateHandle::getPosition;}
+    else if (field == "velocity") {chained_input_getter_ = &hardware_interface::JointStateHandle::getVelocity;}
+    else if (field == "effort")   {chained_input_getter_ = &hardware_interface::JointStateHandle::getEffort;}
+    else
+    {
+      ROS_ERROR_STREAM("Unknown chained input field '" << field << "' (namespace: " << n.getNamespace() <<
+                       "). Expected 'position', 'velocity' or 'effort'.");
+      return false;
+    }
+
+    const std::string upstream_ns = controller_chaining::chainedControllerNamespace(n.getNamespace(), upstream_name);
+    controller_chaining::ChainedJointInterface& chained_iface = controller_chaining::ChainedJointInterface::instance();
+    for (const auto& joint_name : joint_names_)
+    {
+      const std::string chained_name = controller_chaining::chainedJointName(upstream_ns, joint_name);
+      try {chained_inputs_.push_back(chained_iface.getHandle(chained_name));}
+      catch (const hardware_interface::HardwareInterfaceException& e)
+      {
+        ROS_ERROR_STREAM(e.what() << " Is controller '" << upstream_ns << "' loaded, and exporting its outputs?");
+        chained_inputs_.clear();
+        return false;
+      }
+    }
+
+    // Joints of the hosted controllers, to hold their position when inputs become stale
+    joint_states_.clear();
+    for (const auto& joint_name : joint_names_)
+    {
+      std::string hosted_joint_name;
+      ros::NodeHandle(n, joint_name).param<std::string>("joint", hosted_joint_name, joint_name);
+      try {joint_states_.push_back(hw->getHandle(hosted_joint_name));}
+      catch (const hardware_interface::HardwareInterfaceException& e)
+      {
+        ROS_ERROR_STREAM(e.what());
+        chained_inputs_.clear();
+        return false;
+      }
+    }
+    chained_input_stale_.assign(n_joints_, false);
+    return true;
+  }
+
+  void statePublisherLoop()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (keep_running_)
+    {
+      stop_cond_.wait_for(lock, state_publish_period_, [this] {return !keep_running_;});
+
+      lock.unlock();
+      for (auto& controller : controllers_) {controller.publishState();}
+      lock.lock();
+    }
+  }
+
+  void stopStatePublisher()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      keep_running_ = false;
+    }
+    stop_cond_.notify_all();
+    if (state_publisher_thread_.joinable()) {state_publisher_thread_.join();}
+  }
+};
+
+} // namespace
+
+#endif // header guard
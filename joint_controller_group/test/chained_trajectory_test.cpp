@@ -0,0 +1,201 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <list>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <ros/ros.h>
+
+#include <hardware_interface/joint_command_interface.h>
+#include <hardware_interface/robot_hw.h>
+#include <joint_controller_group/joint_controller_group.h>
+#include <joint_trajectory_controller/joint_trajectory_controller.h>
+#include <trajectory_interface/quintic_spline_segment.h>
+
+/**
+ * \brief Hosted controller claiming its joint and forwarding its command as effort.
+ */
+class ForwardJointController : public controller_interface::Controller<hardware_interface::EffortJointInterface>
+{
+public:
+  bool initHosted(hardware_interface::EffortJointInterface* hw, ros::NodeHandle& n,
+                  const std::string& default_joint_name, double /*default_state_publish_rate*/)
+  {
+    std::string joint_name;
+    n.param("joint", joint_name, default_joint_name);
+    joint_ = hw->getHandle(joint_name);
+    return true;
+  }
+
+  void publishState() {}
+  void setCommand(double command) {command_ = command;}
+  void update(const ros::Time& /*time*/, const ros::Duration& /*period*/) {joint_.setCommand(command_);}
+
+private:
+  hardware_interface::JointHandle joint_;
+  double command_ = 0.0;
+};
+
+typedef joint_controller_group::JointControllerGroup<ForwardJointController, hardware_interface::EffortJointInterface>
+        ForwardJointControllerGroup;
+typedef joint_trajectory_controller::JointTrajectoryController<trajectory_interface::QuinticSplineSegment<double>,
+                                                               hardware_interface::EffortJointInterface>
+        TrajectoryController;
+
+/**
+ * \brief Effort-controlled robot with two joints.
+ */
+class TwoJointRobot : public hardware_interface::RobotHW
+{
+public:
+  TwoJointRobot()
+  {
+    const char* names[] = {"joint1", "joint2"};
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+      pos[i] = vel[i] = eff[i] = cmd[i] = 0.0;
+      hardware_interface::JointStateHandle state_handle(names[i], &pos[i], &vel[i], &eff[i]);
+      effort_iface_.registerHandle(hardware_interface::JointHandle(state_handle, &cmd[i]));
+    }
+    registerInterface(&effort_iface_);
+  }
+
+  double pos[2];
+  double vel[2];
+  double eff[2];
+  double cmd[2];
+
+private:
+  hardware_interface::EffortJointInterface effort_iface_;
+};
+
+hardware_interface::ControllerInfo controllerInfo(const std::string&                                         name,
+                                                  const controller_interface::ControllerBase::ClaimedResources& claims)
+{
+  hardware_interface::ControllerInfo info;
+  info.name = name;
+  info.claimed_resources = claims;
+  return info;
+}
+
+TEST(ChainedTrajectoryTest, ExportOnlyTrajectoryControllerDrivesGroup)
+{
+  TwoJointRobot robot;
+  robot.pos[0] = 0.3;
+  robot.pos[1] = -0.2;
+  ros::NodeHandle root_nh;
+
+  // Upstream controller first, so that the group reads its outputs in the same cycle
+  TrajectoryController trajectory_controller;
+  ros::NodeHandle trajectory_nh("export_only_trajectory_controller");
+  controller_interface::ControllerBase::ClaimedResources trajectory_claims;
+  ASSERT_TRUE(trajectory_controller.initRequest(&robot, root_nh, trajectory_nh, trajectory_claims));
+
+  ForwardJointControllerGroup group;
+  ros::NodeHandle group_nh("export_only_group");
+  controller_interface::ControllerBase::ClaimedResources group_claims;
+  ASSERT_TRUE(group.initRequest(&robot, root_nh, group_nh, group_claims));
+
+  // Only the group claims the joints, so both controllers can run together
+  std::list<hardware_interface::ControllerInfo> controllers;
+  controllers.push_back(controllerInfo("export_only_trajectory_controller", trajectory_claims));
+  controllers.push_back(controllerInfo("export_only_group", group_claims));
+  EXPECT_FALSE(robot.checkForConflict(controllers));
+
+  const ros::Duration period(0.01);
+  ros::Time time(1.0);
+  trajectory_controller.startRequest(time);
+  group.startRequest(time);
+
+  // The trajectory controller holds the start position, while the joints move away from it
+  robot.pos[0] = 0.5;
+  robot.pos[1] = 0.1;
+  robot.cmd[0] = robot.cmd[1] = -1.0;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    time += period;
+    trajectory_controller.updateRequest(time, period);
+    EXPECT_EQ(-1.0, robot.cmd[0]); // Not commanded by the trajectory controller
+    EXPECT_EQ(-1.0, robot.cmd[1]);
+
+    group.updateRequest(time, period);
+    EXPECT_DOUBLE_EQ(0.3, robot.cmd[0]); // Desired position of the trajectory controller
+    EXPECT_DOUBLE_EQ(-0.2, robot.cmd[1]);
+    robot.cmd[0] = robot.cmd[1] = -1.0;
+  }
+
+  trajectory_controller.stopRequest(time);
+  group.stopRequest(time);
+}
+
+TEST(ChainedTrajectoryTest, ClaimingTrajectoryControllerConflictsWithGroup)
+{
+  TwoJointRobot robot;
+  ros::NodeHandle root_nh;
+
+  TrajectoryController trajectory_controller;
+  ros::NodeHandle trajectory_nh("claiming_trajectory_controller");
+  controller_interface::ControllerBase::ClaimedResources trajectory_claims;
+  ASSERT_TRUE(trajectory_controller.initRequest(&robot, root_nh, trajectory_nh, trajectory_claims));
+
+  ForwardJointControllerGroup group;
+  ros::NodeHandle group_nh("claiming_group");
+  controller_interface::ControllerBase::ClaimedResources group_claims;
+  ASSERT_TRUE(group.initRequest(&robot, root_nh, group_nh, group_claims));
+
+  std::list<hardware_interface::ControllerInfo> controllers;
+  controllers.push_back(controllerInfo("claiming_trajectory_controller", trajectory_claims));
+  controllers.push_back(controllerInfo("claiming_group", group_claims));
+  EXPECT_TRUE(robot.checkForConflict(controllers));
+}
+
+TEST(ChainedTrajectoryTest, ExportOnlyRequiresExportedState)
+{
+  TwoJointRobot robot;
+  ros::NodeHandle root_nh;
+
+  TrajectoryController trajectory_controller;
+  ros::NodeHandle trajectory_nh("unexported_trajectory_controller");
+  controller_interface::ControllerBase::ClaimedResources trajectory_claims;
+  EXPECT_FALSE(trajectory_controller.initRequest(&robot, root_nh, trajectory_nh, trajectory_claims));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "chained_trajectory_test");
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,282 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <ros/ros.h>
+#include <std_msgs/Float64MultiArray.h>
+
+#include <hardware_interface/joint_command_interface.h>
+#include <joint_controller_group/joint_controller_group.h>
+
+/**
+ * \brief Hosted controller recording the calls it gets from its group.
+ */
+class FakeJointController : public controller_interface::Controller<hardware_interface::EffortJointInterface>
+{
+public:
+  static std::vector<FakeJointController*> instances; ///< Hosted controllers, in initialization order.
+
+  bool initHosted(hardware_interface::EffortJointInterface* /*hw*/, ros::NodeHandle& n,
+                  const std::string& default_joint_name, double default_state_publish_rate)
+  {
+    instances.push_back(this);
+    n.param("joint", joint_name, default_joint_name);
+    n.param("state_publish_rate", state_publish_rate, default_state_publish_rate);
+    return !n.hasParam("fail");
+  }
+
+  void publishState() {}
+
+  void setCommand(double command)
+  {
+    last_command = command;
+    ++commands_set;
+  }
+
+  void update(const ros::Time& /*time*/, const ros::Duration& /*period*/) {++updates;}
+
+  std::string joint_name;
+  double state_publish_rate = 0.0;
+  double last_command = 0.0;
+  unsigned int commands_set = 0;
+  unsigned int updates = 0;
+};
+
+std::vector<FakeJointController*> FakeJointController::instances;
+
+typedef joint_controller_group::JointControllerGroup<FakeJointController, hardware_interface::EffortJointInterface>
+        FakeJointControllerGroup;
+
+class JointControllerGroupTest : public ::testing::Test
+{
+public:
+  JointControllerGroupTest()
+    : period_(0.001)
+  {
+    const std::string names[] = {"joint1", "joint2", "joint3"};
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      pos_[i] = 0.1 * (i + 1); vel_[i] = 0.0; eff_[i] = 0.0; cmd_[i] = 0.0;
+      hardware_interface::JointStateHandle state_handle(names[i], &pos_[i], &vel_[i], &eff_[i]);
+      hw_.registerHandle(hardware_interface::JointHandle(state_handle, &cmd_[i]));
+    }
+    FakeJointController::instances.clear();
+  }
+
+protected:
+  hardware_interface::EffortJointInterface hw_;
+  ros::Duration period_;
+
+  // Raw joint data
+  double pos_[3];
+  double vel_[3];
+  double eff_[3];
+  double cmd_[3];
+
+  /** \brief Publish \p data on the command topic of the group in \p nh, and wait until it is received. */
+  bool publishCommand(ros::NodeHandle& nh, const std::vector<double>& data)
+  {
+    ros::Publisher pub = nh.advertise<std_msgs::Float64MultiArray>("command", 1);
+    const ros::Time timeout = ros::Time::now() + ros::Duration(5.0);
+    while (pub.getNumSubscribers() == 0 && ros::Time::now() < timeout) {ros::Duration(0.01).sleep();}
+    if (pub.getNumSubscribers() == 0) {return false;}
+
+    std_msgs::Float64MultiArray msg;
+    msg.data = data;
+    pub.publish(msg);
+
+    // The message is processed by the group callback, which has no observable effect before the next update
+    ros::Duration(0.1).sleep();
+    ros::spinOnce();
+    return true;
+  }
+};
+
+TEST_F(JointControllerGroupTest, CommandFannedOut)
+{
+  ros::NodeHandle nh("group");
+  FakeJointControllerGroup group;
+  ASSERT_TRUE(group.init(&hw_, nh));
+  ASSERT_EQ(3u, FakeJointController::instances.size());
+  EXPECT_EQ("joint1", FakeJointController::instances[0]->joint_name);
+  EXPECT_EQ("joint3", FakeJointController::instances[2]->joint_name);
+
+  group.starting(ros::Time::now());
+  ASSERT_TRUE(publishCommand(nh, {1.0, 2.0, 3.0}));
+  group.update(ros::Time::now(), period_);
+
+  // A single message commands every hosted controller, all of which are updated
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    const FakeJointController& controller = *FakeJointController::instances[i];
+    EXPECT_EQ(1.0 + i, controller.last_command);
+    EXPECT_EQ(1u, controller.commands_set);
+    EXPECT_EQ(1u, controller.updates);
+  }
+}
+
+TEST_F(JointControllerGroupTest, DefaultsPassedToHostedControllers)
+{
+  ros::NodeHandle nh("rate_group");
+  FakeJointControllerGroup group;
+  ASSERT_TRUE(group.init(&hw_, nh));
+  ASSERT_EQ(2u, FakeJointController::instances.size());
+
+  // Parameters of the hosted controllers take precedence over the defaults of the group
+  EXPECT_EQ("joint1", FakeJointController::instances[0]->joint_name);
+  EXPECT_EQ(50.0,     FakeJointController::instances[0]->state_publish_rate);
+  EXPECT_EQ("joint3", FakeJointController::instances[1]->joint_name);
+  EXPECT_EQ(20.0,     FakeJointController::instances[1]->state_publish_rate);
+
+  // Defaults are not written to the parameter server
+  EXPECT_FALSE(nh.hasParam("joint1/joint"));
+  EXPECT_FALSE(nh.hasParam("joint1/state_publish_rate"));
+
+  // Without a group rate, hosted controllers keep their own default
+  ros::NodeHandle default_nh("group");
+  FakeJointControllerGroup default_group;
+  ASSERT_TRUE(default_group.init(&hw_, default_nh));
+  EXPECT_EQ(0.0, FakeJointController::instances.back()->state_publish_rate);
+}
+
+TEST_F(JointControllerGroupTest, UnchangedCommandNotResent)
+{
+  ros::NodeHandle nh("group");
+  FakeJointControllerGroup group;
+  ASSERT_TRUE(group.init(&hw_, nh));
+  group.starting(ros::Time::now());
+
+  ASSERT_TRUE(publishCommand(nh, {1.0, 2.0, 3.0}));
+  for (unsigned int k = 0; k < 10; ++k) {group.update(ros::Time::now(), period_);}
+  for (const auto controller : FakeJointController::instances)
+  {
+    EXPECT_EQ(1u,  controller->commands_set);
+    EXPECT_EQ(10u, controller->updates);
+  }
+
+  // A new message is forwarded, even with the same values
+  ASSERT_TRUE(publishCommand(nh, {1.0, 2.0, 3.0}));
+  group.update(ros::Time::now(), period_);
+  for (const auto controller : FakeJointController::instances) {EXPECT_EQ(2u, controller->commands_set);}
+
+  // Messages of the wrong size are discarded
+  ASSERT_TRUE(publishCommand(nh, {4.0, 5.0}));
+  group.update(ros::Time::now(), period_);
+  for (const auto controller : FakeJointController::instances) {EXPECT_EQ(2u, controller->commands_set);}
+}
+
+TEST_F(JointControllerGroupTest, CommandsBeforeStartingNotForwarded)
+{
+  ros::NodeHandle nh("group");
+  FakeJointControllerGroup group;
+  ASSERT_TRUE(group.init(&hw_, nh));
+
+  ASSERT_TRUE(publishCommand(nh, {1.0, 2.0, 3.0}));
+  group.starting(ros::Time::now());
+  group.update(ros::Time::now(), period_);
+  for (const auto controller : FakeJointController::instances) {EXPECT_EQ(0u, controller->commands_set);}
+}
+
+TEST_F(JointControllerGroupTest, InitFailures)
+{
+  // No joints
+  {
+    ros::NodeHandle nh("empty_group");
+    FakeJointControllerGroup group;
+    EXPECT_FALSE(group.init(&hw_, nh));
+  }
+
+  // A hosted controller fails to initialize
+  {
+    ros::NodeHandle nh("failing_group");
+    FakeJointControllerGroup group;
+    EXPECT_FALSE(group.init(&hw_, nh));
+  }
+
+  // Upstream controller exports fewer joints than the group has
+  {
+    controller_chaining::ChainedJointInterface& chained_iface = controller_chaining::ChainedJointInterface::instance();
+    std::shared_ptr<controller_chaining::ChainedJointData> output =
+      chained_iface.exportJoint(controller_chaining::chainedJointName("/partial_upstream", "joint1"));
+    ASSERT_TRUE(output.get());
+
+    ros::NodeHandle nh("chained_group");
+    FakeJointControllerGroup group;
+    EXPECT_FALSE(group.init(&hw_, nh));
+  }
+}
+
+TEST_F(JointControllerGroupTest, ChainedInput)
+{
+  controller_chaining::ChainedJointInterface& chained_iface = controller_chaining::ChainedJointInterface::instance();
+  std::vector<std::shared_ptr<controller_chaining::ChainedJointData> > outputs;
+  for (const std::string joint_name : {"joint1", "joint2"})
+  {
+    outputs.push_back(chained_iface.exportJoint(controller_chaining::chainedJointName("/full_upstream", joint_name)));
+    ASSERT_TRUE(outputs.back().get());
+  }
+
+  ros::NodeHandle nh("fully_chained_group");
+  FakeJointControllerGroup group;
+  ASSERT_TRUE(group.init(&hw_, nh));
+  group.starting(ros::Time::now());
+
+  // Upstream outputs are forwarded every cycle
+  outputs[0]->position = 1.0; outputs[0]->valid = true;
+  outputs[1]->position = 2.0; outputs[1]->valid = true;
+  group.update(ros::Time::now(), period_);
+  group.update(ros::Time::now(), period_);
+  EXPECT_EQ(1.0, FakeJointController::instances[0]->last_command);
+  EXPECT_EQ(2.0, FakeJointController::instances[1]->last_command);
+  EXPECT_EQ(2u,  FakeJointController::instances[0]->commands_set);
+
+  // Stale outputs are replaced by the current joint position once
+  outputs[1]->valid = false;
+  group.update(ros::Time::now(), period_);
+  group.update(ros::Time::now(), period_);
+  EXPECT_EQ(pos_[1], FakeJointController::instances[1]->last_command);
+  EXPECT_EQ(3u,      FakeJointController::instances[1]->commands_set);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "joint_controller_group_test");
+  return RUN_ALL_TESTS();
+}
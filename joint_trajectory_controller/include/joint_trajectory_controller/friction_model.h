@@ -0,0 +1,146 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER_FRICTION_MODEL_H
+#define JOINT_TRAJECTORY_CONTROLLER_FRICTION_MODEL_H
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace joint_trajectory_controller
+{
+
+/**
+ * \brief Friction model of a group of joints, used to compute friction compensation feedforward.
+ *
+ * The friction of each joint at velocity \f$ v \f$ is the sum of Coulomb, Stribeck and viscous terms:
+ * \f[
+ *   f(v) = \tanh(v / v_\epsilon) \left( F_c + (F_s - F_c) e^{-(v / v_s)^2} \right) + F_v v
+ * \f]
+ * where the hyperbolic tangent smooths the sign change at zero velocity over \f$ v_\epsilon \f$, so that compensation
+ * does not chatter at velocity reversals. With \f$ F_s > F_c \f$, friction peaks near zero velocity and decays to the
+ * Coulomb level over the Stribeck velocity \f$ v_s \f$.
+ *
+ * Parameters are kept in structure-of-arrays form, and the per-joint computation is branch-free, so that the compiler
+ * can vectorize it. All methods except \ref init are realtime-safe.
+ */
+template <class Scalar>
+class FrictionModel
+{
+public:
+  struct Parameters
+  {
+    Parameters()
+      : coulomb(0.0),
+        static_friction(0.0),
+        viscous(0.0),
+        stribeck_velocity(0.1),
+        smoothing_velocity(0.001)
+    {}
+
+    Scalar coulomb;            ///< Coulomb friction \f$ F_c \f$. Non-negative.
+    Scalar static_friction;    ///< Breakaway friction \f$ F_s \f$. Not lower than \p coulomb.
+    Scalar viscous;            ///< Viscous friction coefficient \f$ F_v \f$. Non-negative.
+    Scalar stribeck_velocity;  ///< Stribeck velocity \f$ v_s \f$. Positive.
+    Scalar smoothing_velocity; ///< Sign smoothing velocity \f$ v_\epsilon \f$. Positive.
+  };
+
+  /**
+   * \param parameters Parameters of each joint.
+   * \return True if all parameters are valid, in which case they are used from now on.
+   */
+  bool init(const std::vector<Parameters>& parameters)
+  {
+    for (const auto& p : parameters)
+    {
+      if (!(p.coulomb >= 0.0) || !(p.static_friction >= p.coulomb) || !(p.viscous >= 0.0) ||
+          !(p.stribeck_velocity > 0.0) || !(p.smoothing_velocity > 0.0))
+      {
+        return false;
+      }
+    }
+
+    const std::size_t n = parameters.size();
+    coulomb_.resize(n);
+    stribeck_.resize(n);
+    viscous_.resize(n);
+    inv_stribeck_velocity_.resize(n);
+    inv_smoothing_velocity_.resize(n);
+    for (std::size_t k = 0; k < n; ++k)
+    {
+      coulomb_[k]                = parameters[k].coulomb;
+      stribeck_[k]               = parameters[k].static_friction - parameters[k].coulomb;
+      viscous_[k]                = parameters[k].viscous;
+      inv_stribeck_velocity_[k]  = 1.0 / parameters[k].stribeck_velocity;
+      inv_smoothing_velocity_[k] = 1.0 / parameters[k].smoothing_velocity;
+    }
+    return true;
+  }
+
+  /** \return Number of joints. */
+  std::size_t size() const {return coulomb_.size();}
+
+  /**
+   * \brief Compute the friction of all joints.
+   * \param velocity Velocity of each joint, \ref size entries.
+   * \param[out] friction Friction of each joint, \ref size entries. Must not overlap \p velocity.
+   */
+  void compute(const Scalar* __restrict velocity, Scalar* __restrict friction) const
+  {
+    const Scalar* coulomb   = coulomb_.data();
+    const Scalar* stribeck  = stribeck_.data();
+    const Scalar* viscous   = viscous_.data();
+    const Scalar* inv_v_s   = inv_stribeck_velocity_.data();
+    const Scalar* inv_v_eps = inv_smoothing_velocity_.data();
+    const std::size_t n     = coulomb_.size();
+    for (std::size_t k = 0; k < n; ++k)
+    {
+      const Scalar v_ratio = velocity[k] * inv_v_s[k];
+      friction[k] = std::tanh(velocity[k] * inv_v_eps[k]) * (coulomb[k] + stribeck[k] * std::exp(-v_ratio * v_ratio)) +
+                    viscous[k] * velocity[k];
+    }
+  }
+
+private:
+  std::vector<Scalar> coulomb_;
+  std::vector<Scalar> stribeck_;               ///< Static minus Coulomb friction.
+  std::vector<Scalar> viscous_;
+  std::vector<Scalar> inv_stribeck_velocity_;
+  std::vector<Scalar> inv_smoothing_velocity_;
+};
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,156 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER_GAIN_SCHEDULE_H
+#define JOINT_TRAJECTORY_CONTROLLER_GAIN_SCHEDULE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace joint_trajectory_controller
+{
+
+/**
+ * \brief PID loop of a single joint whose gains are scheduled on a scalar key, such as the desired velocity magnitude.
+ *
+ * Gains are specified at increasing key breakpoints, interpolated linearly in between, and held constant beyond the
+ * first and last breakpoints. The integral term accumulates the product of the integral gain and the error, rather
+ * than the error alone, so that the command does not jump when the integral gain changes. As in
+ * \p control_toolbox::Pid, the integral term is bounded to [\p i_min, \p i_max], and with anti-windup the accumulated
+ * value itself is clamped, instead of only its contribution to the command.
+ *
+ * All methods except \ref init are realtime-safe.
+ */
+template <class Scalar>
+class GainSchedule
+{
+public:
+  struct Gains
+  {
+    Gains() : p(0.0), i(0.0), d(0.0), i_max(0.0), i_min(0.0) {}
+
+    Scalar p;     ///< Proportional gain.
+    Scalar i;     ///< Integral gain.
+    Scalar d;     ///< Derivative gain.
+    Scalar i_max; ///< Upper bound of the integral term.
+    Scalar i_min; ///< Lower bound of the integral term. Not greater than \p i_max.
+  };
+
+  GainSchedule() : segment_(0), antiwindup_(true), i_term_(0.0) {}
+
+  /**
+   * \param keys Key breakpoints, strictly increasing.
+   * \param gains Gains at each breakpoint.
+   * \param antiwindup Whether the accumulated integral term is clamped, or only its contribution to the command.
+   * \return True if the schedule is valid, in which case it is used from now on.
+   */
+  bool init(const std::vector<Scalar>& keys, const std::vector<Gains>& gains, bool antiwindup = true)
+  {
+    if (keys.empty() || keys.size() != gains.size()) {return false;}
+    for (std::size_t k = 0; k < keys.size(); ++k)
+    {
+      if (k > 0 && !(keys[k] > keys[k - 1]))   {return false;}
+      if (!(gains[k].i_min <= gains[k].i_max)) {return false;}
+    }
+    keys_       = keys;
+    gains_      = gains;
+    segment_    = 0;
+    antiwindup_ = antiwindup;
+    reset();
+    return true;
+  }
+
+  /** \return True if no schedule has been set. */
+  bool empty() const {return keys_.empty();}
+
+  /** \brief Reset the integral term. */
+  void reset() {i_term_ = static_cast<Scalar>(0.0);}
+
+  /**
+   * \brief Interpolate the gains at \p key.
+   *
+   * Lookup starts from the breakpoint interval of the previous call, so it takes constant time when the key changes
+   * slowly between calls.
+   */
+  void interpolate(const Scalar& key, Gains& gains)
+  {
+    const std::size_t last = keys_.size() - 1;
+    if (last == 0 || !(key > keys_.front())) {gains = gains_.front(); return;} // Also catches NaN keys
+    if (key >= keys_.back())                  {gains = gains_.back();  return;}
+
+    while (key < keys_[segment_])      {--segment_;}
+    while (key >= keys_[segment_ + 1]) {++segment_;}
+
+    const Gains& g0 = gains_[segment_];
+    const Gains& g1 = gains_[segment_ + 1];
+    const Scalar s  = (key - keys_[segment_]) / (keys_[segment_ + 1] - keys_[segment_]);
+    gains.p     = g0.p     + s * (g1.p     - g0.p);
+    gains.i     = g0.i     + s * (g1.i     - g0.i);
+    gains.d     = g0.d     + s * (g1.d     - g0.d);
+    gains.i_max = g0.i_max + s * (g1.i_max - g0.i_max);
+    gains.i_min = g0.i_min + s * (g1.i_min - g0.i_min);
+  }
+
+  /**
+   * \brief Compute the command of the PID loop, with gains interpolated at \p key.
+   * \return The command, or zero if \p dt is not positive or the inputs are not finite, as \p control_toolbox::Pid.
+   */
+  Scalar computeCommand(const Scalar& key, const Scalar& error, const Scalar& error_dot, const Scalar& dt)
+  {
+    if (!(dt > 0.0) || !isFinite(error) || !isFinite(error_dot)) {return static_cast<Scalar>(0.0);}
+
+    Gains gains;
+    interpolate(key, gains);
+    i_term_ += dt * gains.i * error;
+    const Scalar i_term = std::min(std::max(i_term_, gains.i_min), gains.i_max);
+    if (antiwindup_) {i_term_ = i_term;}
+    return gains.p * error + i_term + gains.d * error_dot;
+  }
+
+private:
+  std::vector<Scalar> keys_;
+  std::vector<Gains>  gains_;
+  std::size_t         segment_; ///< Breakpoint interval of the last lookup.
+  bool                antiwindup_;
+  Scalar              i_term_;  ///< Accumulated integral term, unbounded without anti-windup.
+
+  static bool isFinite(const Scalar& value) {return std::abs(value) <= std::numeric_limits<Scalar>::max();}
+};
+
+} // namespace
+
+#endif // header guard
@@ -30,18 +30,31 @@
 #ifndef JOINT_TRAJECTORY_CONTROLLER_HARDWARE_INTERFACE_ADAPTER_H
 #define JOINT_TRAJECTORY_CONTROLLER_HARDWARE_INTERFACE_ADAPTER_H
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <string>
+#include <type_traits>
 #include <vector>
 #include <memory>
 
 #include <ros/node_handle.h>
 #include <ros/time.h>
 
+#include <urdf/model.h>
+
 #include <control_toolbox/pid.h>
 #include <hardware_interface/joint_command_interface.h>
 #include <hardware_interface/posvel_command_interface.h>
 #include <hardware_interface/posvelacc_command_interface.h>
+#include <realtime_tools/realtime_buffer.h>
+#include <std_msgs/Float64.h>
+
+#include <joint_trajectory_controller/friction_model.h>
+#include <joint_trajectory_controller/gain_schedule.h>
+#include <joint_trajectory_controller/rigid_body_chain.h>
+#include <joint_trajectory_controller/segment_command_interface.h>
+#include <trajectory_interface/trajectory_interface.h>
 
 /**
  * \brief Helper class to simplify integrating the JointTrajectoryController with different hardware interfaces.
@@ -135,7 +148,36 @@ private:
  * \brief Helper base class template for closed loop HardwareInterfaceAdapter implementations.
  *
  * Adapters leveraging (specializing) this class will generate a command given the desired state and state error using a
- * velocity feedforward term plus a corrective PID term.
+ * velocity feedforward term plus a corrective PID term. Specializations can add further feedforward terms through
+ * \p command_ff_.
+ *
+ * The PID gains of a joint can be scheduled, see \ref joint_trajectory_controller::GainSchedule. Gains are specified at
+ * breakpoints of a schedule key, which is either the magnitude of the desired velocity (\p velocity source, default),
+ * or a value received in the \p gain_schedule_key topic (\p external source), e.g. set according to the payload before
+ * sending a goal. Scheduled gains not specified keep their fixed value from \p gains, including \p antiwindup. As in
+ * \p gains, \p i_clamp bounds the integral term symmetrically, and \p i_clamp_min and \p i_clamp_max override either
+ * bound. For example:
+ * \code
+ * gain_schedule:
+ *   wrist_1_joint:
+ *     source: velocity
+ *     keys:    [0.0,   0.2,   1.0]
+ *     p:       [800.0, 500.0, 300.0]
+ *     i:       [40.0,  10.0,  0.0]
+ *     i_clamp: [2.0,   1.0,   0.0]
+ * \endcode
+ * Interpolated gains are computed in the realtime loop without going through the realtime buffer of
+ * \p control_toolbox::Pid, which only holds the fixed gains. The fixed gains are read once on initialization, so
+ * changing the gains of a scheduled joint through \p dynamic_reconfigure has no effect.
+ *
+ * Friction can be compensated by a feedforward computed from the desired velocity, see
+ * \ref joint_trajectory_controller::FrictionModel. Joints without a \p friction entry are not compensated, and
+ * \p static defaults to \p coulomb. Values are in command units, so that the same model serves velocity and effort
+ * commands. For example:
+ * \code
+ * friction:
+ *   wrist_1_joint: {coulomb: 1.2, static: 1.8, viscous: 0.4, stribeck_velocity: 0.02, smoothing_velocity: 0.002}
+ * \endcode
  *
  * Use one of the available template specializations of this class (or create your own) to adapt the
  * JointTrajectoryController to a specific hardware interface.
@@ -144,22 +186,34 @@ template <class State>
 class ClosedLoopHardwareInterfaceAdapter
 {
 public:
-  ClosedLoopHardwareInterfaceAdapter() : joint_handles_ptr_(0) {}
+  ClosedLoopHardwareInterfaceAdapter()
+    : friction_compensation_(false),
+      has_external_key_(false),
+      joint_handles_ptr_(0)
+  {}
 
   bool init(std::vector<hardware_interface::JointHandle>& joint_handles, ros::NodeHandle& controller_nh)
   {
     // Store pointer to joint handles
     joint_handles_ptr_ = &joint_handles;
 
+    // Preallocate workspace, so that it is consistent with the joints even if initialization fails
+    const unsigned int n_joints = joint_handles.size();
+    pids_.resize(n_joints);
+    for (unsigned int i = 0; i < n_joints; ++i) {pids_[i].reset(new control_toolbox::Pid());}
+    velocity_ff_.assign(n_joints, 0.0);
+    command_ff_.assign(n_joints, 0.0);
+    friction_ff_.assign(n_joints, 0.0);
+    gain_schedules_.assign(n_joints, joint_trajectory_controller::GainSchedule<double>());
+    uses_external_key_.assign(n_joints, false);
+
     // Initialize PIDs
-    pids_.resize(joint_handles.size());
-    for (unsigned int i = 0; i < pids_.size(); ++i)
+    for (unsigned int i = 0; i < n_joints; ++i)
     {
       // Node handle to PID gains
       ros::NodeHandle joint_nh(controller_nh, std::string("gains/") + joint_handles[i].getName());
 
       // Init PID gains from ROS parameter server
-      pids_[i].reset(new control_toolbox::Pid());
       if (!pids_[i]->init(joint_nh))
       {
         ROS_WARN_STREAM("Failed to initialize PID gains from ROS parameter server.");
@@ -168,13 +222,12 @@ public:
     }
 
     // Load velocity feedforward gains from parameter server
-    velocity_ff_.resize(joint_handles.size());
-    for (unsigned int i = 0; i < velocity_ff_.size(); ++i)
+    for (unsigned int i = 0; i < n_joints; ++i)
     {
       controller_nh.param(std::string("velocity_ff/") + joint_handles[i].getName(), velocity_ff_[i], 0.0);
     }
 
-    return true;
+    return initFrictionCompensation(joint_handles, controller_nh) && initGainSchedules(joint_handles, controller_nh);
   }
 
   void starting(const ros::Time& /*time*/)
@@ -185,6 +238,7 @@ public:
     for (unsigned int i = 0; i < pids_.size(); ++i)
     {
       pids_[i]->reset();
+      gain_schedules_[i].reset();
       (*joint_handles_ptr_)[i].setCommand(0.0);
     }
   }
@@ -196,29 +250,170 @@ public:
                      const State&         desired_state,
                      const State&         state_error)
   {
-    const unsigned int n_joints = joint_handles_ptr_->size();
-
     // Preconditions
     if (!joint_handles_ptr_)
       return;
+    const unsigned int n_joints = joint_handles_ptr_->size();
     assert(n_joints == state_error.position.size());
     assert(n_joints == state_error.velocity.size());
 
+    // Friction compensation of all joints in a single pass
+    if (friction_compensation_) {friction_model_.compute(desired_state.velocity.data(), friction_ff_.data());}
+
+    // External schedule key, read once for all joints
+    const double external_key = has_external_key_ ? *external_key_buffer_.readFromRT() : 0.0;
+
     // Update PIDs
     for (unsigned int i = 0; i < n_joints; ++i)
     {
-      const double command = (desired_state.velocity[i] * velocity_ff_[i]) + pids_[i]->computeCommand(state_error.position[i], state_error.velocity[i], period);
+      double feedback;
+      if (gain_schedules_[i].empty())
+      {
+        feedback = pids_[i]->computeCommand(state_error.position[i], state_error.velocity[i], period);
+      }
+      else
+      {
+        const double key = uses_external_key_[i] ? external_key : std::abs(desired_state.velocity[i]);
+        feedback = gain_schedules_[i].computeCommand(key, state_error.position[i], state_error.velocity[i],
+                                                     period.toSec());
+      }
+      const double command = (desired_state.velocity[i] * velocity_ff_[i]) + command_ff_[i] + friction_ff_[i] +
+                             feedback;
       (*joint_handles_ptr_)[i].setCommand(command);
     }
   }
 
+protected:
+  std::vector<double> command_ff_; ///< Feedforward added to the commands, zero unless set by a specialization.
+
 private:
   typedef std::shared_ptr<control_toolbox::Pid> PidPtr;
   std::vector<PidPtr> pids_;
 
   std::vector<double> velocity_ff_;
 
+  joint_trajectory_controller::FrictionModel<double> friction_model_;
+  bool                                               friction_compensation_;
+  std::vector<double>                                friction_ff_; ///< Zero unless friction is compensated.
+
+  std::vector<joint_trajectory_controller::GainSchedule<double> > gain_schedules_; ///< Empty for fixed gains.
+  std::vector<bool>                      uses_external_key_;
+  bool                                   has_external_key_;
+  realtime_tools::RealtimeBuffer<double> external_key_buffer_;
+  ros::Subscriber                        external_key_sub_;
+
   std::vector<hardware_interface::JointHandle>* joint_handles_ptr_;
+
+  bool initFrictionCompensation(const std::vector<hardware_interface::JointHandle>& joint_handles,
+                                ros::NodeHandle&                                    controller_nh)
+  {
+    typedef joint_trajectory_controller::FrictionModel<double> FrictionModel;
+
+    // Joints without friction parameters keep the default zero friction
+    std::vector<FrictionModel::Parameters> params(joint_handles.size());
+    friction_compensation_ = false;
+    for (unsigned int i = 0; i < joint_handles.size(); ++i)
+    {
+      const std::string friction_ns = std::string("friction/") + joint_handles[i].getName();
+      if (!controller_nh.hasParam(friction_ns)) {continue;}
+      ros::NodeHandle friction_nh(controller_nh, friction_ns);
+
+      friction_compensation_ = true;
+      friction_nh.param("coulomb",            params[i].coulomb,            params[i].coulomb);
+      friction_nh.param("static",             params[i].static_friction,    params[i].coulomb);
+      friction_nh.param("viscous",            params[i].viscous,            params[i].viscous);
+      friction_nh.param("stribeck_velocity",  params[i].stribeck_velocity,  params[i].stribeck_velocity);
+      friction_nh.param("smoothing_velocity", params[i].smoothing_velocity, params[i].smoothing_velocity);
+    }
+
+    if (friction_compensation_ && !friction_model_.init(params))
+    {
+      ROS_ERROR_STREAM("Invalid friction parameters: 'coulomb' and 'viscous' must be non-negative, 'static' not " <<
+                       "lower than 'coulomb', 'stribeck_velocity' and 'smoothing_velocity' positive.");
+      return false;
+    }
+    return true;
+  }
+
+  bool initGainSchedules(const std::vector<hardware_interface::JointHandle>& joint_handles,
+                         ros::NodeHandle&                                    controller_nh)
+  {
+    typedef joint_trajectory_controller::GainSchedule<double> GainSchedule;
+
+    const unsigned int n_joints = joint_handles.size();
+    has_external_key_ = false;
+    for (unsigned int i = 0; i < n_joints; ++i)
+    {
+      const std::string& joint_name = joint_handles[i].getName();
+      ros::NodeHandle schedule_nh(controller_nh, std::string("gain_schedule/") + joint_name);
+      std::vector<double> keys;
+      if (!schedule_nh.getParam("keys", keys)) {continue;}
+
+      // Gains not scheduled keep their fixed values. A symmetric 'i_clamp' is overridden by either bound, as in
+      // control_toolbox::Pid
+      const control_toolbox::Pid::Gains fixed_gains = pids_[i]->getGains();
+      std::vector<double> p(keys.size(),     fixed_gains.p_gain_);
+      std::vector<double> ig(keys.size(),    fixed_gains.i_gain_);
+      std::vector<double> d(keys.size(),     fixed_gains.d_gain_);
+      std::vector<double> i_max(keys.size(), fixed_gains.i_max_);
+      std::vector<double> i_min(keys.size(), fixed_gains.i_min_);
+      schedule_nh.getParam("p", p);
+      schedule_nh.getParam("i", ig);
+      schedule_nh.getParam("d", d);
+      if (schedule_nh.getParam("i_clamp", i_max))
+      {
+        i_min = i_max;
+        for (double& bound : i_min) {bound = -bound;}
+      }
+      schedule_nh.getParam("i_clamp_max", i_max);
+      schedule_nh.getParam("i_clamp_min", i_min);
+
+      std::vector<GainSchedule::Gains> gains(keys.size());
+      const bool consistent = p.size() == keys.size() && ig.size() == keys.size() && d.size() == keys.size() &&
+                              i_max.size() == keys.size() && i_min.size() == keys.size();
+      for (unsigned int k = 0; consistent && k < keys.size(); ++k)
+      {
+        gains[k].p     = p[k];
+        gains[k].i     = ig[k];
+        gains[k].d     = d[k];
+        gains[k].i_max = i_max[k];
+        gains[k].i_min = i_min[k];
+      }
+      if (!consistent || !gain_schedules_[i].init(keys, gains, fixed_gains.antiwindup_))
+      {
+        ROS_ERROR_STREAM("Invalid gain schedule of joint '" << joint_name << "': 'keys' must be strictly " <<
+                         "increasing, the integral clamp bounds ordered, and all entries must have the same size.");
+        return false;
+      }
+
+      std::string source = "velocity";
+      schedule_nh.param("source", source, source);
+      if (source == "external")
+      {
+        uses_external_key_[i] = true;
+        has_external_key_     = true;
+      }
+      else if (source != "velocity")
+      {
+        ROS_ERROR_STREAM("Unknown gain schedule source '" << source << "' of joint '" << joint_name <<
+                         "'. Expected 'velocity' or 'external'.");
+        return false;
+      }
+    }
+
+    if (has_external_key_)
+    {
+      external_key_buffer_.writeFromNonRT(0.0);
+      external_key_sub_ = controller_nh.subscribe("gain_schedule_key", 1,
+                                                  &ClosedLoopHardwareInterfaceAdapter::externalKeyCB, this);
+    }
+    return true;
+  }
+
+  void externalKeyCB(const std_msgs::Float64ConstPtr& msg)
+  {
+    external_key_buffer_.writeFromNonRT(msg->data);
+  }
 };
 
 /**
@@ -256,8 +451,16 @@ class HardwareInterfaceAdapter<hardware_interface::VelocityJointInterface, State
  * \brief Adapter for an effort-controlled hardware interface. Maps position and velocity errors to effort commands
  * through a position PID loop.
  *
- * The following is an example configuration of a controller that uses this adapter. Notice the \p gains and \p velocity_ff
- * entries:
+ * Optionally, the efforts required to follow the desired trajectory are computed from the robot model (URDF) by inverse
+ * dynamics and added as feedforward, leaving only the residuals to the PID loops. The controlled joints must then
+ * form a serial chain, see \ref joint_trajectory_controller::RigidBodyChain. Gravity is expressed in the URDF root frame.
+ *
+ * Efforts specified in the trajectory points are interpolated along the trajectory and added as feedforward as well, on
+ * top of the inverse dynamics efforts if enabled. Leave inverse dynamics disabled if the trajectory efforts already
+ * account for the full robot dynamics.
+ *
+ * The following is an example configuration of a controller that uses this adapter. Notice the \p gains, \p velocity_ff
+ * and \p inverse_dynamics entries:
  * \code
  * head_controller:
  *   type: "effort_controllers/JointTrajectoryController"
@@ -270,6 +473,9 @@ class HardwareInterfaceAdapter<hardware_interface::VelocityJointInterface, State
  *   velocity_ff:
  *     head_1_joint: 1.0
  *     head_2_joint: 1.0
+ *   inverse_dynamics:
+ *     enabled: true
+ *     gravity: [0.0, 0.0, -9.81]
  *   constraints:
  *     goal_time: 0.6
  *     stopped_velocity_tolerance: 0.02
@@ -281,7 +487,82 @@ class HardwareInterfaceAdapter<hardware_interface::VelocityJointInterface, State
  */
 template <class State>
 class HardwareInterfaceAdapter<hardware_interface::EffortJointInterface, State> : public ClosedLoopHardwareInterfaceAdapter<State>
-{};
+{
+public:
+  HardwareInterfaceAdapter() : inverse_dynamics_(false) {}
+
+  bool init(std::vector<hardware_interface::JointHandle>& joint_handles, ros::NodeHandle& controller_nh)
+  {
+    if (!ClosedLoopHardwareInterfaceAdapter<State>::init(joint_handles, controller_nh)) {return false;}
+
+    // Inverse dynamics feedforward, only enabled once its model is built
+    inverse_dynamics_ = false;
+    ros::NodeHandle id_nh(controller_nh, "inverse_dynamics");
+    bool enabled = false;
+    id_nh.param("enabled", enabled, enabled);
+    if (!enabled) {return true;}
+
+    urdf::Model urdf;
+    if (!urdf.initParamWithNodeHandle("robot_description", controller_nh))
+    {
+      ROS_ERROR_STREAM("Failed to parse URDF, required by the inverse dynamics feedforward.");
+      return false;
+    }
+
+    std::vector<std::string> joint_names;
+    for (const auto& jh : joint_handles) {joint_names.push_back(jh.getName());}
+    if (!chain_.init(urdf, joint_names))
+    {
+      ROS_ERROR_STREAM("Failed to build the dynamic model used by the inverse dynamics feedforward.");
+      return false;
+    }
+
+    std::vector<double> gravity;
+    if (id_nh.getParam("gravity", gravity))
+    {
+      if (gravity.size() != 3)
+      {
+        ROS_ERROR_STREAM("Gravity vector must have 3 elements, " << gravity.size() << " found.");
+        return false;
+      }
+      chain_.setGravity({gravity[0], gravity[1], gravity[2]});
+    }
+
+    inverse_dynamics_ = true;
+    return true;
+  }
+
+  void updateCommand(const ros::Time&     time,
+                     const ros::Duration& period,
+                     const State&         desired_state,
+                     const State&         state_error)
+  {
+    if (inverse_dynamics_)
+    {
+      chain_.inverseDynamics(desired_state.position, desired_state.velocity, desired_state.acceleration,
+                             this->command_ff_);
+    }
+    else
+    {
+      std::fill(this->command_ff_.begin(), this->command_ff_.end(), 0.0);
+    }
+
+    // Trajectory effort feedforward
+    if (desired_state.effort.size() == this->command_ff_.size())
+    {
+      for (unsigned int i = 0; i < this->command_ff_.size(); ++i)
+      {
+        this->command_ff_[i] += desired_state.effort[i];
+      }
+    }
+
+    ClosedLoopHardwareInterfaceAdapter<State>::updateCommand(time, period, desired_state, state_error);
+  }
+
+private:
+  bool inverse_dynamics_;
+  joint_trajectory_controller::RigidBodyChain chain_;
+};
 
 /**
  * \brief Adapter for a pos-vel hardware interface. Forwards desired positions with velcities as commands.
@@ -357,4 +638,296 @@ private:
   std::vector<hardware_interface::PosVelAccJointHandle>* joint_handles_ptr_;
 };
 
+/**
+ * \brief Adapter for joints whose drives interpolate trajectory segments themselves.
+ *
+ * Instead of sampling the trajectory every control cycle, the spline coefficients and time boundaries of the active
+ * segment and of the ones that follow it are pushed to the segment queue of each joint (see
+ * \ref joint_trajectory_controller::SegmentJointInterface "SegmentJointInterface"), so that the drive can interpolate
+ * them on its own clock and is unaffected by jitter in the control loop. At most \p segment_lookahead segments
+ * (default: 2) starting from the active one are sent ahead of time. Segment start times are ROS times, and mapping them
+ * to the drive clock is up to the robot hardware abstraction.
+ *
+ * When the trajectory is replaced, the queue of each joint is cleared and streaming resumes from the segment active in
+ * the new trajectory.
+ *
+ * \note Segments are streamed unaltered, so this adapter cannot be used with time warping.
+ */
+template <class State>
+class HardwareInterfaceAdapter<joint_trajectory_controller::SegmentJointInterface, State>
+{
+public:
+  HardwareInterfaceAdapter() : joint_handles_ptr_(0), lookahead_(2), last_traj_(0) {}
+
+  bool init(std::vector<joint_trajectory_controller::SegmentJointHandle>& joint_handles,
+            ros::NodeHandle&                                              controller_nh)
+  {
+    // Store pointer to joint handles
+    joint_handles_ptr_ = &joint_handles;
+
+    // Preallocate streaming state
+    next_segment_.assign(joint_handles.size(), 0);
+    last_segment_.assign(joint_handles.size(), joint_trajectory_controller::SegmentCommand());
+
+    int lookahead = 2;
+    controller_nh.param("segment_lookahead", lookahead, lookahead);
+    if (lookahead < 1)
+    {
+      ROS_ERROR_STREAM("The 'segment_lookahead' parameter must be positive (namespace: " <<
+                       controller_nh.getNamespace() << ").");
+      return false;
+    }
+    for (unsigned int i = 0; i < joint_handles.size(); ++i)
+    {
+      if (static_cast<std::size_t>(lookahead) > joint_handles[i].getQueue()->capacity())
+      {
+        ROS_ERROR_STREAM("The 'segment_lookahead' parameter exceeds the segment queue capacity of joint '" <<
+                         joint_handles[i].getName() << "' (" << joint_handles[i].getQueue()->capacity() << ").");
+        return false;
+      }
+    }
+    lookahead_ = lookahead;
+
+    return true;
+  }
+
+  void starting(const ros::Time& /*time*/) {reset();}
+  void stopping(const ros::Time& /*time*/) {reset();}
+
+  /** Commands are sent ahead of time by \ref updateSegments. */
+  void updateCommand(const ros::Time&     /*time*/,
+                     const ros::Duration& /*period*/,
+                     const State&         /*desired_state*/,
+                     const State&         /*state_error*/) {}
+
+  /**
+   * \brief Push the active and upcoming segments of \p trajectory to the segment queues.
+   *
+   * \param time Current ROS time.
+   * \param uptime Current controller uptime, which is the time base of \p trajectory.
+   * \param trajectory Multi-joint trajectory currently being executed.
+   */
+  template <class Trajectory>
+  void updateSegments(const ros::Time& time, const ros::Time& uptime, const Trajectory& trajectory)
+  {
+    // Preconditions
+    if (!joint_handles_ptr_) {return;}
+    const unsigned int n_joints = joint_handles_ptr_->size();
+    assert(n_joints == trajectory.size());
+
+    const bool new_trajectory = &trajectory != last_traj_;
+    last_traj_ = &trajectory;
+
+    const double time_offset = (time - uptime).toSec();
+    for (unsigned int i = 0; i < n_joints; ++i)
+    {
+      typedef typename Trajectory::value_type TrajectoryPerJoint;
+      const TrajectoryPerJoint& joint_traj = trajectory[i];
+      joint_trajectory_controller::SegmentQueue& queue = *(*joint_handles_ptr_)[i].getQueue();
+
+      typename TrajectoryPerJoint::const_iterator active_it = trajectory_interface::findSegment(joint_traj,
+                                                                                               uptime.toSec());
+      const std::size_t active = (active_it == joint_traj.end()) ? 0 : active_it - joint_traj.begin();
+
+      // Trajectories can also be modified in place, as when holding position, so check the last streamed segment too
+      std::size_t& next = next_segment_[i];
+      if (new_trajectory || (next > 0 && !isLastSegment(i, joint_traj, next - 1)))
+      {
+        queue.clear();
+        next = active;
+      }
+
+      // Skip segments that elapsed before being streamed, eg. when the queue was full
+      next = std::max(next, active);
+
+      for (; next < joint_traj.size() && next < active + lookahead_ && !queue.full(); ++next)
+      {
+        joint_trajectory_controller::SegmentCommand& segment = last_segment_[i];
+        segment.start_time   = joint_traj[next].startTime();
+        segment.duration     = joint_traj[next].endTime() - joint_traj[next].startTime();
+        segment.coefficients = joint_traj[next].coefficients();
+
+        joint_trajectory_controller::SegmentCommand command = segment;
+        command.start_time += time_offset;
+        queue.push(command);
+      }
+    }
+  }
+
+private:
+  std::vector<joint_trajectory_controller::SegmentJointHandle>* joint_handles_ptr_;
+  std::size_t lookahead_;
+
+  const void*                                              last_traj_;    ///< Last streamed trajectory.
+  std::vector<std::size_t>                                 next_segment_; ///< Index of the next segment to stream.
+  std::vector<joint_trajectory_controller::SegmentCommand> last_segment_; ///< Last streamed segment, in uptime.
+
+  void reset()
+  {
+    last_traj_ = 0;
+    if (!joint_handles_ptr_) {return;}
+    for (unsigned int i = 0; i < joint_handles_ptr_->size(); ++i)
+    {
+      (*joint_handles_ptr_)[i].getQueue()->clear();
+      next_segment_[i] = 0;
+    }
+  }
+
+  template <class TrajectoryPerJoint>
+  bool isLastSegment(unsigned int joint_id, const TrajectoryPerJoint& joint_traj, std::size_t segment_id) const
+  {
+    if (segment_id >= joint_traj.size()) {return false;}
+    const joint_trajectory_controller::SegmentCommand& last = last_segment_[joint_id];
+    return joint_traj[segment_id].startTime() == last.start_time &&
+           joint_traj[segment_id].endTime() - joint_traj[segment_id].startTime() == last.duration &&
+           joint_traj[segment_id].coefficients() == last.coefficients;
+  }
+};
+
+/**
+ * \brief Adapter for an effort-controlled hardware interface implementing a joint impedance law.
+ *
+ * Effort commands are computed as \f$ \tau = K (q_d - q) + D (\dot{q}_d - \dot{q}) + \tau_{ff} \f$, where the
+ * stiffness \f$ K \f$ and damping \f$ D \f$ are those carried by the desired state, and the feedforward
+ * \f$ \tau_{ff} \f$ is the trajectory effort. Joints whose desired state carries no stiffness nor damping (stored
+ * as NaN), such as when holding position or following trajectories without impedance data, use the default values of
+ * the \p impedance parameters. Damping defaults to zero if unspecified.
+ *
+ * The following is an example configuration of a controller that uses this adapter:
+ * \code
+ * arm_controller:
+ *   type: "effort_controllers/JointImpedanceTrajectoryController"
+ *   joints:
+ *     - arm_1_joint
+ *     - arm_2_joint
+ *   impedance:
+ *     arm_1_joint: {stiffness: 500.0, damping: 20.0}
+ *     arm_2_joint: {stiffness: 300.0, damping: 15.0}
+ *   stop_trajectory_duration: 0.5
+ * \endcode
+ */
+template <class State>
+class JointImpedanceHardwareInterfaceAdapter
+{
+public:
+  JointImpedanceHardwareInterfaceAdapter() : joint_handles_ptr_(0) {}
+
+  bool init(std::vector<hardware_interface::JointHandle>& joint_handles, ros::NodeHandle& controller_nh)
+  {
+    // Store pointer to joint handles
+    joint_handles_ptr_ = &joint_handles;
+
+    // Preallocate workspace
+    const unsigned int n_joints = joint_handles.size();
+    stiffness_.assign(n_joints, 0.0);
+    damping_.assign(n_joints, 0.0);
+    commands_.assign(n_joints, 0.0);
+
+    // Load default impedance from parameter server
+    default_stiffness_.assign(n_joints, 0.0);
+    default_damping_.assign(n_joints, 0.0);
+    for (unsigned int i = 0; i < n_joints; ++i)
+    {
+      ros::NodeHandle joint_nh(controller_nh, std::string("impedance/") + joint_handles[i].getName());
+      if (!joint_nh.getParam("stiffness", default_stiffness_[i]))
+      {
+        ROS_ERROR_STREAM("No default stiffness specified for joint '" << joint_handles[i].getName() <<
+                         "' (namespace: " << joint_nh.getNamespace() << ").");
+        return false;
+      }
+      joint_nh.param("damping", default_damping_[i], 0.0);
+      if (default_stiffness_[i] < 0.0 || default_damping_[i] < 0.0)
+      {
+        ROS_ERROR_STREAM("Default stiffness and damping of joint '" << joint_handles[i].getName() <<
+                         "' must be non-negative.");
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  void starting(const ros::Time& /*time*/)
+  {
+    if (!joint_handles_ptr_) {return;}
+
+    // Zero commands
+    for (unsigned int i = 0; i < joint_handles_ptr_->size(); ++i)
+    {
+      (*joint_handles_ptr_)[i].setCommand(0.0);
+    }
+  }
+
+  void stopping(const ros::Time& /*time*/) {}
+
+  void updateCommand(const ros::Time&     /*time*/,
+                     const ros::Duration& /*period*/,
+                     const State&         desired_state,
+                     const State&         state_error)
+  {
+    // Preconditions
+    if (!joint_handles_ptr_) {return;}
+    const unsigned int n_joints = joint_handles_ptr_->size();
+    assert(n_joints == state_error.position.size());
+    assert(n_joints == state_error.velocity.size());
+
+    // Impedance of the desired state, with defaults for the joints that carry none
+    const bool has_impedance = desired_state.stiffness.size() == n_joints && desired_state.damping.size() == n_joints;
+    for (unsigned int i = 0; i < n_joints; ++i)
+    {
+      const bool use_default = !has_impedance || std::isnan(desired_state.stiffness[i]);
+      stiffness_[i] = use_default ? default_stiffness_[i] : desired_state.stiffness[i];
+      damping_[i]   = use_default ? default_damping_[i]   : desired_state.damping[i];
+    }
+
+    // Impedance law. Kept free of branches and calls, so that it can be vectorized
+    const bool has_effort = desired_state.effort.size() == n_joints;
+    for (unsigned int i = 0; i < n_joints; ++i)
+    {
+      commands_[i] = stiffness_[i] * state_error.position[i] + damping_[i] * state_error.velocity[i];
+    }
+    if (has_effort)
+    {
+      for (unsigned int i = 0; i < n_joints; ++i) {commands_[i] += desired_state.effort[i];}
+    }
+
+    for (unsigned int i = 0; i < n_joints; ++i)
+    {
+      (*joint_handles_ptr_)[i].setCommand(commands_[i]);
+    }
+  }
+
+private:
+  std::vector<double> default_stiffness_;
+  std::vector<double> default_damping_;
+  std::vector<double> stiffness_; ///< Preallocated workspace variable.
+  std::vector<double> damping_;   ///< Preallocated workspace variable.
+  std::vector<double> commands_;  ///< Preallocated workspace variable.
+
+  std::vector<hardware_interface::JointHandle>* joint_handles_ptr_;
+};
+
+/**
+ * \brief Whether a hardware interface adapter uses the joint stiffness and damping of the desired state.
+ *
+ * Controllers using such adapters additionally accept trajectories carrying stiffness and damping data.
+ */
+template <class Adapter>
+struct UsesJointImpedance : std::false_type {};
+
+template <class State>
+struct UsesJointImpedance<JointImpedanceHardwareInterfaceAdapter<State> > : std::true_type {};
+
+/**
+ * \brief Whether a hardware interface adapter streams trajectory segments to the hardware ahead of time.
+ *
+ * Controllers using such adapters call its \p updateSegments method with the current trajectory every cycle.
+ */
+template <class Adapter>
+struct StreamsTrajectorySegments : std::false_type {};
+
+template <class State>
+struct StreamsTrajectorySegments<HardwareInterfaceAdapter<joint_trajectory_controller::SegmentJointInterface, State> >
+  : std::true_type {};
+
 #endif // header guard
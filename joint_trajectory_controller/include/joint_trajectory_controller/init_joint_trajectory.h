@@ -32,9 +32,14 @@
 
 // C++ standard
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
 #include <iomanip>
+#include <iterator>
 #include <sstream>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
 // Boost
@@ -48,8 +53,11 @@
 #include <realtime_tools/realtime_server_goal_handle.h>
 
 // Project
+#include <joint_trajectory_controller/JointImpedancePoint.h>
 #include <joint_trajectory_controller/joint_trajectory_msg_utils.h>
 #include <joint_trajectory_controller/joint_trajectory_segment.h>
+#include <joint_trajectory_controller/worker_pool.h>
+#include <trajectory_interface/quintic_spline_segment.h>
 
 namespace joint_trajectory_controller
 {
@@ -84,6 +92,288 @@ inline std::vector<unsigned int> mapping(const T& t1, const T& t2)
   return mapping_vector;
 }
 
+/**
+ * \brief Shortest duration of a segment joining two states that keeps acceleration and jerk within limits.
+ *
+ * Peaks are estimated by sampling candidate segments at evenly spaced instants, jerk by finite differences of the
+ * sampled accelerations, which keeps this function independent of the segment type. Accelerations imposed by the
+ * boundary states are always allowed.
+ *
+ * The search doubles the duration until the limits are met, and then bisects down to a 1% resolution.
+ *
+ * \param start_state Start state of the segment (one-dimensional).
+ * \param end_state End state of the segment (one-dimensional).
+ * \param min_duration Shortest allowed duration. It is returned if it already satisfies the limits.
+ * \param max_acceleration Acceleration limit. Non-positive values disable it.
+ * \param max_jerk Jerk limit. Non-positive values disable it.
+ */
+template <class Segment>
+typename Segment::Time minBridgeDuration(const typename Segment::State&  start_state,
+                                         const typename Segment::State&  end_state,
+                                         const typename Segment::Time&   min_duration,
+                                         const typename Segment::Scalar& max_acceleration,
+                                         const typename Segment::Scalar& max_jerk)
+{
+  typedef typename Segment::Time   Time;
+  typedef typename Segment::Scalar Scalar;
+  using std::abs;
+
+  const bool limit_acceleration = max_acceleration > 0.0;
+  const bool limit_jerk         = max_jerk > 0.0;
+  if (!limit_acceleration && !limit_jerk) {return min_duration;}
+
+  const Scalar acceleration_limit = std::max(max_acceleration, std::max(abs(start_state.acceleration[0]),
+                                                                        abs(end_state.acceleration[0])));
+  const auto within_limits = [&](const Time& duration)
+  {
+    const unsigned int n_samples = 16;
+    const Time dt = duration / n_samples;
+    const Segment segment(static_cast<Time>(0.0), start_state, duration, end_state);
+
+    typename Segment::State state;
+    Scalar prev_acceleration = 0.0;
+    for (unsigned int k = 0; k <= n_samples; ++k)
+    {
+      segment.sample(k * dt, state);
+      const Scalar acceleration = state.acceleration[0];
+      if (limit_acceleration && abs(acceleration) > acceleration_limit)          {return false;}
+      if (limit_jerk && k > 0 && abs(acceleration - prev_acceleration) > max_jerk * dt) {return false;}
+      prev_acceleration = acceleration;
+    }
+    return true;
+  };
+
+  if (min_duration > 0.0 && within_limits(min_duration)) {return min_duration;}
+
+  // Upper bound satisfying the limits
+  const unsigned int max_doublings = 32;
+  Time lower = std::max(min_duration, static_cast<Time>(0.0));
+  Time upper = std::max(static_cast<Time>(2.0) * lower, static_cast<Time>(1e-3));
+  bool feasible = within_limits(upper);
+  for (unsigned int i = 0; !feasible && i < max_doublings; ++i)
+  {
+    lower = upper;
+    upper *= 2.0;
+    feasible = within_limits(upper);
+  }
+  if (!feasible) {return upper;}
+
+  // Shortest duration satisfying the limits
+  while (upper - lower > 0.01 * upper)
+  {
+    const Time middle = 0.5 * (lower + upper);
+    if (within_limits(middle)) {upper = middle;}
+    else                       {lower = middle;}
+  }
+  return upper;
+}
+
+/**
+ * \brief Builds the segments joining consecutive points of a trajectory message, one joint at a time.
+ *
+ * Points are validated once on construction. Segments are constructed one at a time from their boundary states.
+ *
+ * \tparam Segment Segment type.
+ */
+template <class Segment>
+class PerSegmentBuilder
+{
+public:
+  typedef std::vector<trajectory_msgs::JointTrajectoryPoint>::const_iterator PointConstIterator;
+  typedef typename Segment::Scalar                                           Scalar;
+
+  /**
+   * \param first First trajectory point.
+   * \param last One past the last trajectory point.
+   * \param start_time Time the \p time_from_start of the points is relative to.
+   *
+   * \throw std::invalid_argument If the points have inconsistent data sizes.
+   */
+  PerSegmentBuilder(PointConstIterator first, PointConstIterator last, const ros::Time& start_time)
+    : first_(first),
+      last_(last),
+      start_time_(start_time)
+  {
+    for (PointConstIterator it = first_; it != last_; ++it)
+    {
+      if (!isValid(*it, it->positions.size()) || it->positions.size() != first_->positions.size())
+      {
+        throw(std::invalid_argument("Size mismatch in trajectory point position, velocity, acceleration or effort data."));
+      }
+    }
+  }
+
+  /**
+   * \brief Append the segments of a joint to \p result.
+   *
+   * \param index Index of the joint in the trajectory points.
+   * \param position_offset Position offset to apply to the joint positions.
+   * \param result Container the segments are appended to.
+   */
+  template <class SegmentContainer>
+  void build(unsigned int index, const Scalar& position_offset, SegmentContainer& result) const
+  {
+    if (std::distance(first_, last_) < 2) {return;}
+
+    // Boundary states are reused across segments, and the joint data is read directly from the message columns
+    typename Segment::State state, next_state;
+    state.init(*first_, index, position_offset);
+    for (PointConstIterator it = first_, next_it = ++PointConstIterator(first_); next_it != last_; ++it, ++next_it)
+    {
+      next_state.init(*next_it, index, position_offset);
+      result.push_back(Segment((start_time_ + it->time_from_start).toSec(),      state,
+                               (start_time_ + next_it->time_from_start).toSec(), next_state));
+      std::swap(state, next_state); // End state of this segment is the start state of the next one
+    }
+  }
+
+private:
+  PointConstIterator first_;
+  PointConstIterator last_;
+  ros::Time          start_time_;
+};
+
+/**
+ * \brief Segment builder used by \ref initJointTrajectory.
+ *
+ * Builds one segment at a time. Segment types able to compute their coefficients in batches specialize it.
+ */
+template <class Segment>
+class SegmentBuilder : public PerSegmentBuilder<Segment>
+{
+public:
+  typedef typename PerSegmentBuilder<Segment>::PointConstIterator PointConstIterator;
+
+  SegmentBuilder(PointConstIterator first, PointConstIterator last, const ros::Time& start_time)
+    : PerSegmentBuilder<Segment>(first, last, start_time)
+  {}
+};
+
+/**
+ * \brief Segment builder for quintic splines.
+ *
+ * Knot times and the duration powers entering the spline coefficients are computed once and shared by all joints. The
+ * coefficients of the segments of a joint are then computed in batches, see
+ * \ref trajectory_interface::QuinticSplineSegment::computeCoefficients. Messages where only some of the points specify
+ * velocities or accelerations fall back to building one segment at a time.
+ */
+template <class ScalarType>
+class SegmentBuilder<JointTrajectorySegment<trajectory_interface::QuinticSplineSegment<ScalarType> > >
+{
+public:
+  typedef trajectory_interface::QuinticSplineSegment<ScalarType>  Spline;
+  typedef JointTrajectorySegment<Spline>                          Segment;
+  typedef typename PerSegmentBuilder<Segment>::PointConstIterator PointConstIterator;
+  typedef ScalarType                                              Scalar;
+
+  SegmentBuilder(PointConstIterator first, PointConstIterator last, const ros::Time& start_time)
+    : first_(first),
+      last_(last),
+      fallback_(first, last, start_time),
+      batched_(true),
+      has_velocity_(false),
+      has_acceleration_(false),
+      has_effort_(false)
+  {
+    const std::size_t n_points = std::distance(first_, last_);
+    if (n_points < 2) {return;}
+
+    // Interpolation order must be the same for all segments
+    has_velocity_     = !first_->velocities.empty();
+    has_acceleration_ = !first_->accelerations.empty();
+    for (PointConstIterator it = first_; it != last_; ++it)
+    {
+      if (it->velocities.empty() == has_velocity_ || it->accelerations.empty() == has_acceleration_)
+      {
+        batched_ = false;
+        return;
+      }
+      has_effort_ = has_effort_ || !it->effort.empty();
+    }
+
+    knot_times_.resize(n_points);
+    powers_.resize(n_points - 1);
+    for (std::size_t k = 0; k < n_points; ++k)
+    {
+      knot_times_[k] = (start_time + (first_ + k)->time_from_start).toSec();
+    }
+    for (std::size_t k = 0; k + 1 < n_points; ++k)
+    {
+      powers_[k] = Spline::durationPowers(knot_times_[k + 1] - knot_times_[k]);
+    }
+  }
+
+  template <class SegmentContainer>
+  void build(unsigned int index, const Scalar& position_offset, SegmentContainer& result) const
+  {
+    if (!batched_) {fallback_.build(index, position_offset, result); return;}
+    if (powers_.empty()) {return;}
+
+    // Gather joint data into contiguous arrays. Scratch data is local, so that joints can be built concurrently
+    const std::size_t n_points = knot_times_.size();
+    std::vector<Scalar> positions(n_points);
+    std::vector<Scalar> velocities(has_velocity_ ? n_points : 0);
+    std::vector<Scalar> accelerations(has_acceleration_ ? n_points : 0);
+    typename Spline::SplineCoefficients coefficients[BATCH_SIZE];
+    std::vector<Scalar> start_effort, end_effort;
+
+    PointConstIterator it = first_;
+    for (std::size_t k = 0; k < n_points; ++k, ++it)
+    {
+      positions[k] = it->positions[index] + position_offset;
+      if (has_velocity_)     {velocities[k]    = it->velocities[index];}
+      if (has_acceleration_) {accelerations[k] = it->accelerations[index];}
+    }
+
+    // Coefficients are computed in batches small enough to stay in cache until copied to the segments
+    it = first_;
+    const std::size_t n_segments = n_points - 1;
+    for (std::size_t first = 0; first < n_segments; first += BATCH_SIZE)
+    {
+      const std::size_t n = (n_segments - first < BATCH_SIZE) ? n_segments - first : BATCH_SIZE;
+      Spline::computeCoefficients(n, &powers_[first], &positions[first],
+                                  has_velocity_ ? &velocities[first] : 0,
+                                  has_velocity_ && has_acceleration_ ? &accelerations[first] : 0,
+                                  coefficients);
+
+      for (std::size_t k = 0; k < n; ++k, ++it)
+      {
+        result.push_back(Segment());
+        Segment& segment = result.back();
+        segment.Spline::init(knot_times_[first + k], knot_times_[first + k + 1], coefficients[k]);
+        if (has_effort_)
+        {
+          PointConstIterator next_it = it; ++next_it;
+          effortColumn(*it, index, start_effort);
+          effortColumn(*next_it, index, end_effort);
+          segment.setEffort(start_effort, end_effort);
+        }
+      }
+    }
+  }
+
+private:
+  static const std::size_t BATCH_SIZE = 64;
+
+  PointConstIterator                                  first_;
+  PointConstIterator                                  last_;
+  PerSegmentBuilder<Segment>                          fallback_;
+  bool                                                batched_;
+  bool                                                has_velocity_;
+  bool                                                has_acceleration_;
+  bool                                                has_effort_;
+  std::vector<Scalar>                                 knot_times_;
+  std::vector<typename Spline::DurationPowers>        powers_;
+
+  static void effortColumn(const trajectory_msgs::JointTrajectoryPoint& point,
+                           unsigned int                                 index,
+                           std::vector<Scalar>&                         effort)
+  {
+    if (point.effort.empty()) {effort.clear();}
+    else                      {effort.assign(1, point.effort[index]);}
+  }
+};
+
 } // namespace
 
 /**
@@ -99,6 +389,9 @@ struct InitJointTrajectoryOptions
   typedef typename TrajectoryPerJoint::value_type                                             Segment;
   typedef typename Segment::Scalar                                                            Scalar;
 
+  /** Goals with fewer new segments (points times joints) than this are built sequentially. */
+  static const std::size_t DEFAULT_PARALLEL_MIN_SEGMENTS = 100000;
+
   InitJointTrajectoryOptions()
     : current_trajectory(0),
       joint_names(0),
@@ -107,17 +400,27 @@ struct InitJointTrajectoryOptions
       default_tolerances(0),
       other_time_base(0),
       allow_partial_joints_goal(false),
-      error_string(0)
+      error_string(0),
+      worker_pool(0),
+      parallel_min_segments(DEFAULT_PARALLEL_MIN_SEGMENTS),
+      bridge_max_acceleration(0),
+      bridge_max_jerk(0),
+      impedance_points(0)
   {}
 
-  Trajectory*                current_trajectory;
-  std::vector<std::string>*  joint_names;
-  std::vector<bool>*         angle_wraparound;
-  RealtimeGoalHandlePtr      rt_goal_handle;
-  SegmentTolerances<Scalar>* default_tolerances;
-  ros::Time*                 other_time_base;
-  bool                       allow_partial_joints_goal;
-  std::string*               error_string;
+  Trajectory*                             current_trajectory;
+  std::vector<std::string>*               joint_names;
+  std::vector<bool>*                      angle_wraparound;
+  RealtimeGoalHandlePtr                   rt_goal_handle;
+  SegmentTolerances<Scalar>*              default_tolerances;
+  ros::Time*                              other_time_base;
+  bool                                    allow_partial_joints_goal;
+  std::string*                            error_string;
+  WorkerPool*                             worker_pool;
+  std::size_t                             parallel_min_segments;
+  std::vector<Scalar>*                    bridge_max_acceleration;
+  std::vector<Scalar>*                    bridge_max_jerk;
+  const std::vector<JointImpedancePoint>* impedance_points;
 
   void setErrorString(const std::string &msg) const
   {
@@ -179,6 +482,21 @@ bool isNotEmpty(typename Trajectory::value_type trajPerJoint)
  * - \b error_string Error message. If specified, an error message will be written to this string in case of failure to
  * initialize the output trajectory from \p msg.
  *
+ * - \b worker_pool Pool of worker threads. If specified, the segments of different joints are built concurrently when
+ * the number of new segments (points times joints) reaches \b parallel_min_segments. The result is the same as when
+ * built sequentially.
+ *
+ * - \b bridge_max_acceleration, \b bridge_max_jerk Per-joint acceleration and jerk limits of the segments bridging
+ * \p current_trajectory with the new trajectory, ordered like \p joint_names. Non-positive values disable a limit.
+ * If specified, bridge segments are made as long as needed to satisfy the limits of all joints, and the new trajectory
+ * points are delayed accordingly. The bridge segments still start at the same time, and joints stay synchronized.
+ * These parameters \b require \p current_trajectory to also be specified, otherwise they are ignored.
+ *
+ * - \b impedance_points Joint stiffness and damping at each point of \p msg, ordered like \p msg. If specified, new
+ * segments carry them, see \ref JointTrajectorySegment::setImpedance. Segments bridging \p current_trajectory start
+ * with its stiffness and damping, or with those of the first new point if it carries none. If unspecified, new
+ * segments carry no stiffness nor damping.
+ *
  * \return Trajectory container.
  *
  * \tparam Trajectory Trajectory type. Should be a \e sequence container \e sorted by segment start time.
@@ -285,6 +603,54 @@ Trajectory initJointTrajectory(const trajectory_msgs::JointTrajectory&       msg
     }
   }
 
+  const bool has_bridge_limits = has_current_trajectory &&
+                                 (options.bridge_max_acceleration || options.bridge_max_jerk);
+  if ((options.bridge_max_acceleration && options.bridge_max_acceleration->size() != joint_names.size()) ||
+      (options.bridge_max_jerk         && options.bridge_max_jerk->size()         != joint_names.size()))
+  {
+    error_string = "Cannot create trajectory from message. "
+                   "Vectors specifying bridging limits have an invalid size.";
+    ROS_ERROR_STREAM(error_string);
+    options.setErrorString(error_string);
+    return Trajectory();
+  }
+
+  const bool has_impedance = options.impedance_points != 0;
+  if (has_impedance)
+  {
+    bool valid_impedance = options.impedance_points->size() == msg.points.size();
+    for (const JointImpedancePoint& point : *options.impedance_points)
+    {
+      valid_impedance = valid_impedance && point.stiffness.size() == n_joints && point.damping.size() == n_joints;
+    }
+    if (!valid_impedance)
+    {
+      error_string = "Cannot create trajectory from message. "
+                     "Stiffness and damping must be specified for every point and joint.";
+      ROS_ERROR_STREAM(error_string);
+      options.setErrorString(error_string);
+      return Trajectory();
+    }
+
+    // Negative values would turn the impedance law into positive feedback, and NaN selects the default impedance
+    for (const JointImpedancePoint& point : *options.impedance_points)
+    {
+      for (unsigned int i = 0; i < n_joints; ++i)
+      {
+        valid_impedance = valid_impedance && std::isfinite(point.stiffness[i]) && point.stiffness[i] >= 0.0 &&
+                                             std::isfinite(point.damping[i])   && point.damping[i]   >= 0.0;
+      }
+    }
+    if (!valid_impedance)
+    {
+      error_string = "Cannot create trajectory from message. "
+                     "Stiffness and damping must be finite and non-negative.";
+      ROS_ERROR_STREAM(error_string);
+      options.setErrorString(error_string);
+      return Trajectory();
+    }
+  }
+
   // If partial joints goals are not allowed, goal should specify all controller joints
   if (!options.allow_partial_joints_goal)
   {
@@ -388,19 +754,101 @@ Trajectory initJointTrajectory(const trajectory_msgs::JointTrajectory&       msg
   else
     result_traj.resize(joint_names.size());
 
-  //Iterate through the joints that are in the message, in the order of the mapping vector
-  //for (unsigned int joint_id=0; joint_id < joint_names.size();joint_id++)
-  for (unsigned int msg_joint_it=0; msg_joint_it < mapping_vector.size();msg_joint_it++)
+  // Index of the first point that will be executed from the new trajectory
+  const std::size_t first_point_index = std::distance(msg.points.begin(), msg_it);
+
+  // Time and state at which each joint leaves the current trajectory, and state in which it enters the new one
+  const typename Segment::Time last_curr_time = std::max(o_msg_start_time.toSec(), o_time.toSec()); // Important!
+  const auto bridge_states = [&](std::size_t              msg_joint_it,
+                                 typename Segment::State& last_curr_state,
+                                 typename Segment::State& first_new_state)
+  {
+    const unsigned int joint_id = mapping_vector[msg_joint_it];
+    sample((*options.current_trajectory)[joint_id], last_curr_time, last_curr_state);
+
+    // Compute offsets due to wrapping joints
+    Scalar position_offset = 0.0;
+    if (has_angle_wraparound && !msg_it->positions.empty())
+    {
+      position_offset = wraparoundJointOffset(last_curr_state.position[0],
+                                              msg_it->positions[msg_joint_it],
+                                              (*options.angle_wraparound)[joint_id]);
+    }
+
+    // First state that will be executed from the new trajectory, with offsets applied
+    first_new_state.init(*msg_it, msg_joint_it, position_offset);
+
+    // Bridge stiffness and damping to those of the new trajectory, if it has any
+    if (has_impedance)
+    {
+      const JointImpedancePoint& first_new_impedance = (*options.impedance_points)[first_point_index];
+      first_new_state.stiffness.assign(1, first_new_impedance.stiffness[msg_joint_it]);
+      first_new_state.damping.assign(1,   first_new_impedance.damping[msg_joint_it]);
+      if (last_curr_state.stiffness.empty())
+      {
+        last_curr_state.stiffness = first_new_state.stiffness;
+        last_curr_state.damping   = first_new_state.damping;
+      }
+    }
+    else
+    {
+      last_curr_state.stiffness.clear();
+      last_curr_state.damping.clear();
+    }
+    return position_offset;
+  };
+
+  // Delay the new trajectory points if reaching the first one in time would exceed the bridging limits of any joint
+  ros::Duration bridge_delay(0.0);
+  if (has_bridge_limits)
+  {
+    if (!isValid(*msg_it, msg_it->positions.size()))
+      throw(std::invalid_argument("Size mismatch in trajectory point position, velocity, acceleration or effort data."));
+
+    const typename Segment::Time first_new_time = (o_msg_start_time + msg_it->time_from_start).toSec();
+    const typename Segment::Time requested_duration = first_new_time - last_curr_time;
+    typename Segment::Time bridge_duration = requested_duration;
+    for (std::size_t msg_joint_it = 0; msg_joint_it < mapping_vector.size(); ++msg_joint_it)
+    {
+      const unsigned int joint_id = mapping_vector[msg_joint_it];
+      const Scalar max_acceleration = options.bridge_max_acceleration ?
+                                      (*options.bridge_max_acceleration)[joint_id] : 0.0;
+      const Scalar max_jerk         = options.bridge_max_jerk ? (*options.bridge_max_jerk)[joint_id] : 0.0;
+
+      typename Segment::State last_curr_state, first_new_state;
+      bridge_states(msg_joint_it, last_curr_state, first_new_state);
+      bridge_duration = std::max(bridge_duration,
+                                 internal::minBridgeDuration<Segment>(last_curr_state, first_new_state,
+                                                                      requested_duration, max_acceleration, max_jerk));
+    }
+    bridge_delay = ros::Duration(bridge_duration - requested_duration);
+    if (!bridge_delay.isZero())
+    {
+      ROS_DEBUG_STREAM("Delaying new trajectory by " << std::fixed << std::setprecision(3) << bridge_delay.toSec() <<
+                       "s to satisfy the bridging limits.");
+    }
+  }
+  const ros::Time o_points_start_time = o_msg_start_time + bridge_delay; // Time the message points are relative to
+
+  // Builds the segments of the new trajectory. Data shared by all joints, such as knot times, is computed only once
+  internal::SegmentBuilder<Segment> segment_builder(msg_it, msg.points.end(), o_points_start_time);
+
+  // Segments of each joint in the message, in the order of the mapping vector. Joints are independent, so they can be
+  // built concurrently; each task only writes to its own entry
+  std::vector<TrajectoryPerJoint> new_traj(mapping_vector.size());
+  std::vector<std::string>        joint_errors(mapping_vector.size());
+
+  const auto build_joint = [&](std::size_t msg_joint_it)
   {
     std::vector<trajectory_msgs::JointTrajectoryPoint>::const_iterator it = msg_it;
     if (!isValid(*it, it->positions.size()))
-      throw(std::invalid_argument("Size mismatch in trajectory point position, velocity or acceleration data."));
+      throw(std::invalid_argument("Size mismatch in trajectory point position, velocity, acceleration or effort data."));
 
-    TrajectoryPerJoint result_traj_per_joint; // Currently empty
+    TrajectoryPerJoint& result_traj_per_joint = new_traj[msg_joint_it]; // Currently empty
     unsigned int joint_id = mapping_vector[msg_joint_it];
 
-    // Initialize offsets due to wrapping joints to zero
-    std::vector<Scalar> position_offset(1, 0.0);
+    // Initialize offset due to wrapping joints to zero
+    Scalar position_offset = 0.0;
 
     //Initialize segment tolerance per joint
     SegmentTolerancesPerJoint<Scalar> tolerances_per_joint;
@@ -413,31 +861,11 @@ Trajectory initJointTrajectory(const trajectory_msgs::JointTrajectory&       msg
     {
       const TrajectoryPerJoint& curr_joint_traj = (*options.current_trajectory)[joint_id];
 
-      // Get the last time and state that will be executed from the current trajectory
-      const typename Segment::Time last_curr_time = std::max(o_msg_start_time.toSec(), o_time.toSec()); // Important!
-      typename Segment::State last_curr_state;
-      sample(curr_joint_traj, last_curr_time, last_curr_state);
-
-      // Get the first time and state that will be executed from the new trajectory
-      trajectory_msgs::JointTrajectoryPoint point_per_joint;
-      if (!it->positions.empty())     {point_per_joint.positions.resize(1, it->positions[msg_joint_it]);}
-      if (!it->velocities.empty())    {point_per_joint.velocities.resize(1, it->velocities[msg_joint_it]);}
-      if (!it->accelerations.empty()) {point_per_joint.accelerations.resize(1, it->accelerations[msg_joint_it]);}
-      point_per_joint.time_from_start = it->time_from_start;
-
-      const typename Segment::Time first_new_time = o_msg_start_time.toSec() + (it->time_from_start).toSec();
-      typename Segment::State first_new_state(point_per_joint); // Here offsets are not yet applied
-
-      // Compute offsets due to wrapping joints
-      if (has_angle_wraparound)
-      {
-        position_offset[0] = wraparoundJointOffset(last_curr_state.position[0],
-                                                first_new_state.position[0],
-                                                (*options.angle_wraparound)[joint_id]);
-      }
-
-      // Apply offset to first state that will be executed from the new trajectory
-      first_new_state = typename Segment::State(point_per_joint, position_offset); // Now offsets are applied
+      // Get the last state that will be executed from the current trajectory, and the first time and state that will
+      // be executed from the new trajectory
+      typename Segment::State last_curr_state, first_new_state;
+      position_offset = bridge_states(msg_joint_it, last_curr_state, first_new_state);
+      const typename Segment::Time first_new_time = o_points_start_time.toSec() + (it->time_from_start).toSec();
 
       // Add useful segments of current trajectory to result
       {
@@ -445,11 +873,11 @@ Trajectory initJointTrajectory(const trajectory_msgs::JointTrajectory&       msg
         TrajIter last  = findSegment(curr_joint_traj, last_curr_time); // Segment active when new trajectory starts
         if (first == curr_joint_traj.end() || last == curr_joint_traj.end())
         {
-          error_string = "Unexpected error: Could not find segments in current trajectory. Please contact the package maintainer.";
-          ROS_ERROR_STREAM(error_string);
-          options.setErrorString(error_string);
-          return Trajectory();
+          joint_errors[msg_joint_it] = "Unexpected error: Could not find segments in current trajectory. "
+                                       "Please contact the package maintainer.";
+          return;
         }
+        result_traj_per_joint.reserve(std::distance(first, last) + 1 + std::distance(it, msg.points.end()));
         result_traj_per_joint.insert(result_traj_per_joint.begin(), first, ++last); // Range [first,last) will still be executed
       }
 
@@ -460,6 +888,10 @@ Trajectory initJointTrajectory(const trajectory_msgs::JointTrajectory&       msg
       if (has_rt_goal_handle) {bridge_seg.setTolerances(tolerances_per_joint);}
       result_traj_per_joint.push_back(bridge_seg);
     }
+    else
+    {
+      result_traj_per_joint.reserve(std::distance(it, msg.points.end()));
+    }
 
     // Constants used in log statement at the end
     const unsigned int num_old_segments = result_traj_per_joint.size() -1;
@@ -468,31 +900,23 @@ Trajectory initJointTrajectory(const trajectory_msgs::JointTrajectory&       msg
     // Add useful segments of new trajectory to result
     // - Construct all trajectory segments occurring after current time
     // - As long as there remain two trajectory points we can construct the next trajectory segment
-    while (std::distance(it, msg.points.end()) >= 2)
+    const typename TrajectoryPerJoint::size_type first_new_segment = result_traj_per_joint.size();
+    segment_builder.build(msg_joint_it, position_offset, result_traj_per_joint);
+    for (typename TrajectoryPerJoint::size_type k = first_new_segment; k < result_traj_per_joint.size(); ++k)
     {
-      std::vector<trajectory_msgs::JointTrajectoryPoint>::const_iterator next_it = it; ++next_it;
-
-      trajectory_msgs::JointTrajectoryPoint it_point_per_joint, next_it_point_per_joint;
-
-      if (!isValid(*it, it->positions.size()))
-            throw(std::invalid_argument("Size mismatch in trajectory point position, velocity or acceleration data."));
-      if (!it->positions.empty())     {it_point_per_joint.positions.resize(1, it->positions[msg_joint_it]);}
-      if (!it->velocities.empty())    {it_point_per_joint.velocities.resize(1, it->velocities[msg_joint_it]);}
-      if (!it->accelerations.empty()) {it_point_per_joint.accelerations.resize(1, it->accelerations[msg_joint_it]);}
-      it_point_per_joint.time_from_start = it->time_from_start;
-
-      if (!isValid(*next_it, next_it->positions.size()))
-            throw(std::invalid_argument("Size mismatch in trajectory point position, velocity or acceleration data."));
-      if (!next_it->positions.empty()) {next_it_point_per_joint.positions.resize(1, next_it->positions[msg_joint_it]);}
-      if (!next_it->velocities.empty()) {next_it_point_per_joint.velocities.resize(1, next_it->velocities[msg_joint_it]);}
-      if (!next_it->accelerations.empty()) {next_it_point_per_joint.accelerations.resize(1, next_it->accelerations[msg_joint_it]);}
-      next_it_point_per_joint.time_from_start = next_it->time_from_start;
-
-      Segment segment(o_msg_start_time, it_point_per_joint, next_it_point_per_joint, position_offset);
-      segment.setGoalHandle(options.rt_goal_handle);
-      if (has_rt_goal_handle) {segment.setTolerances(tolerances_per_joint);}
-      result_traj_per_joint.push_back(segment);
-      ++it;
+      result_traj_per_joint[k].setGoalHandle(options.rt_goal_handle);
+      if (has_rt_goal_handle) {result_traj_per_joint[k].setTolerances(tolerances_per_joint);}
+      if (has_impedance)
+      {
+        const std::size_t point_index = first_point_index + (k - first_new_segment);
+        const JointImpedancePoint& start_impedance = (*options.impedance_points)[point_index];
+        const JointImpedancePoint& end_impedance   = (*options.impedance_points)[point_index + 1];
+        const std::array<Scalar, 1> start_stiffness = {{start_impedance.stiffness[msg_joint_it]}};
+        const std::array<Scalar, 1> start_damping   = {{start_impedance.damping[msg_joint_it]}};
+        const std::array<Scalar, 1> end_stiffness   = {{end_impedance.stiffness[msg_joint_it]}};
+        const std::array<Scalar, 1> end_damping     = {{end_impedance.damping[msg_joint_it]}};
+        result_traj_per_joint[k].setImpedance(start_stiffness, start_damping, end_stiffness, end_damping);
+      }
     }
 
     // Useful debug info
@@ -508,11 +932,40 @@ Trajectory initJointTrajectory(const trajectory_msgs::JointTrajectory&       msg
     }
     else {log_str << ".";}
     ROS_DEBUG_STREAM(log_str.str());
+  };
 
-    if (result_traj_per_joint.size() > 0)
-      result_traj[joint_id] = result_traj_per_joint;
+  // Build joints in parallel only when the goal is large enough to amortize the synchronization overhead
+  const std::size_t n_new_segments = mapping_vector.size() * std::distance(msg_it, msg.points.end());
+  if (options.worker_pool && n_new_segments >= options.parallel_min_segments)
+  {
+    options.worker_pool->run(mapping_vector.size(), build_joint);
+  }
+  else
+  {
+    for (std::size_t msg_joint_it = 0; msg_joint_it < mapping_vector.size(); ++msg_joint_it)
+    {
+      build_joint(msg_joint_it);
+      if (!joint_errors[msg_joint_it].empty()) {break;}
+    }
   }
 
+  // Assemble result in joint order, so that it does not depend on how joints were scheduled
+  for (unsigned int msg_joint_it = 0; msg_joint_it < mapping_vector.size(); ++msg_joint_it)
+  {
+    if (!joint_errors[msg_joint_it].empty())
+    {
+      error_string = joint_errors[msg_joint_it];
+      ROS_ERROR_STREAM(error_string);
+      options.setErrorString(error_string);
+      return Trajectory();
+    }
+    if (!new_traj[msg_joint_it].empty())
+    {
+      result_traj[mapping_vector[msg_joint_it]].swap(new_traj[msg_joint_it]);
+    }
+  }
+
+
   // If the trajectory for all joints is empty, empty the trajectory vector
   typename Trajectory::const_iterator trajIter = std::find_if (result_traj.begin(), result_traj.end(), isNotEmpty<Trajectory>);
   if (trajIter == result_traj.end())
@@ -523,6 +976,145 @@ Trajectory initJointTrajectory(const trajectory_msgs::JointTrajectory&       msg
   return result_traj;
 }
 
+/**
+ * \brief Resume an interrupted joint trajectory.
+ *
+ * The part of \p interrupted_trajectory following \p interrupt_time is shifted in time, and joined to
+ * \p current_trajectory by bridging segments. Bridging starts at \p time, from the state of \p current_trajectory, and
+ * reaches the state of \p interrupted_trajectory at \p interrupt_time after \p bridge_duration. The remaining
+ * segments are rebuilt from their boundary states, so action goal handles and tolerances of the interrupted trajectory
+ * are not carried over.
+ *
+ * \param interrupted_trajectory Trajectory that was being executed when interrupted.
+ * \param interrupt_time Time at which \p interrupted_trajectory was interrupted, expressed in its own time base.
+ * \param current_trajectory Currently executed trajectory, containing the same joints as \p interrupted_trajectory.
+ * \param time Time at which bridging starts, expressed in the time base of \p current_trajectory.
+ * \param bridge_duration Duration of the bridging segments. It may only be zero when bridging limits are specified.
+ * \param options Options that change how the trajectory gets resumed. Only \b angle_wraparound,
+ * \b bridge_max_acceleration, \b bridge_max_jerk and \b error_string are used, with the same meaning as in
+ * \ref initJointTrajectory. Bridge segments are lengthened, if required, to satisfy the bridging limits.
+ *
+ * \return Trajectory container, expressed in the time base of \p current_trajectory. It is empty if
+ * \p interrupted_trajectory had already finished by \p interrupt_time, or on error.
+ */
+template <class Trajectory>
+Trajectory resumeJointTrajectory(const Trajectory&                             interrupted_trajectory,
+                                 const ros::Time&                              interrupt_time,
+                                 const Trajectory&                             current_trajectory,
+                                 const ros::Time&                              time,
+                                 const ros::Duration&                          bridge_duration,
+                                 const InitJointTrajectoryOptions<Trajectory>& options =
+                                 InitJointTrajectoryOptions<Trajectory>())
+{
+  typedef typename Trajectory::value_type TrajectoryPerJoint;
+  typedef typename TrajectoryPerJoint::value_type Segment;
+  typedef typename Segment::Scalar Scalar;
+  typedef typename Segment::Time Time;
+
+  const unsigned int n_joints = interrupted_trajectory.size();
+  std::string error_string;
+
+  // Preconditions
+  if (current_trajectory.size() != n_joints)
+  {
+    error_string = "Cannot resume trajectory: It does not contain the same joints as the current trajectory.";
+  }
+  else if ((options.angle_wraparound        && options.angle_wraparound->size()        != n_joints) ||
+           (options.bridge_max_acceleration && options.bridge_max_acceleration->size() != n_joints) ||
+           (options.bridge_max_jerk         && options.bridge_max_jerk->size()         != n_joints))
+  {
+    error_string = "Cannot resume trajectory: Size mismatch between joints and wraparound or bridging limit data.";
+  }
+  else if (bridge_duration < ros::Duration(0.0) ||
+           (bridge_duration.isZero() && !options.bridge_max_acceleration && !options.bridge_max_jerk))
+  {
+    error_string = "Cannot resume trajectory: The bridge duration must be positive, unless bridging limits are set.";
+  }
+  if (!error_string.empty())
+  {
+    ROS_ERROR_STREAM(error_string);
+    options.setErrorString(error_string);
+    return Trajectory();
+  }
+
+  // Nothing left to resume
+  const Time o_interrupt_time = interrupt_time.toSec();
+  bool finished = true;
+  for (const TrajectoryPerJoint& joint_traj : interrupted_trajectory)
+  {
+    if (!joint_traj.empty() && joint_traj.back().endTime() > o_interrupt_time) {finished = false;}
+  }
+  if (finished)
+  {
+    error_string = "Cannot resume trajectory: It had already finished when it was interrupted.";
+    ROS_DEBUG_STREAM(error_string);
+    options.setErrorString(error_string);
+    return Trajectory();
+  }
+
+  // State from which each joint bridges, and state of the interrupted trajectory it bridges to
+  const Time bridge_start_time = time.toSec();
+  std::vector<typename Segment::State> start_states(n_joints);
+  std::vector<typename Segment::State> resume_states(n_joints);
+  std::vector<Scalar> position_offsets(n_joints, 0.0);
+  Time duration = bridge_duration.toSec();
+  for (unsigned int i = 0; i < n_joints; ++i)
+  {
+    if (current_trajectory[i].end()     == sample(current_trajectory[i],     bridge_start_time, start_states[i]) ||
+        interrupted_trajectory[i].end() == sample(interrupted_trajectory[i], o_interrupt_time,  resume_states[i]))
+    {
+      error_string = "Cannot resume trajectory: No trajectory defined for joint " + std::to_string(i) + ".";
+      ROS_ERROR_STREAM(error_string);
+      options.setErrorString(error_string);
+      return Trajectory();
+    }
+
+    // Compute offsets due to wrapping joints
+    if (options.angle_wraparound)
+    {
+      position_offsets[i] = wraparoundJointOffset(start_states[i].position[0],
+                                                  resume_states[i].position[0],
+                                                  static_cast<bool>((*options.angle_wraparound)[i]));
+      resume_states[i].position[0] += position_offsets[i];
+    }
+
+    const Scalar max_acceleration = options.bridge_max_acceleration ? (*options.bridge_max_acceleration)[i] : 0.0;
+    const Scalar max_jerk         = options.bridge_max_jerk ? (*options.bridge_max_jerk)[i] : 0.0;
+    duration = std::max(duration, internal::minBridgeDuration<Segment>(start_states[i], resume_states[i],
+                                                                       bridge_duration.toSec(),
+                                                                       max_acceleration, max_jerk));
+  }
+
+  // Bridge, followed by the unexecuted part of the interrupted trajectory, shifted in time and position
+  const Time time_offset = bridge_start_time + duration - o_interrupt_time;
+  Trajectory result_traj(n_joints);
+  for (unsigned int i = 0; i < n_joints; ++i)
+  {
+    TrajectoryPerJoint& result_traj_per_joint = result_traj[i];
+    result_traj_per_joint.push_back(Segment(bridge_start_time, start_states[i],
+                                            bridge_start_time + duration, resume_states[i]));
+
+    typename Segment::State seg_start_state, seg_end_state;
+    for (const Segment& segment : interrupted_trajectory[i])
+    {
+      const Time seg_start = std::max(segment.startTime(), o_interrupt_time);
+      const Time seg_end   = segment.endTime();
+      if (seg_end <= seg_start) {continue;}
+
+      segment.sample(seg_start, seg_start_state);
+      segment.sample(seg_end,   seg_end_state);
+      seg_start_state.position[0] += position_offsets[i];
+      seg_end_state.position[0]   += position_offsets[i];
+      result_traj_per_joint.push_back(Segment(seg_start + time_offset, seg_start_state,
+                                              seg_end   + time_offset, seg_end_state));
+    }
+  }
+
+  ROS_DEBUG_STREAM("Resuming trajectory interrupted at time " << std::fixed << std::setprecision(3) <<
+                   o_interrupt_time << ", after bridging for " << duration << "s.");
+  return result_traj;
+}
+
 } // namespace
 
 #endif // header guard
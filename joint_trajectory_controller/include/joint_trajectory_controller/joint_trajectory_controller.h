@@ -32,10 +32,23 @@
 #define JOINT_TRAJECTORY_CONTROLLER_JOINT_TRAJECTORY_CONTROLLER_H
 
 // C++ standard
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <limits>
 #include <stdexcept>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// POSIX
+#include <semaphore.h>
 
 // Boost
 #include <boost/shared_ptr.hpp>
@@ -63,6 +76,7 @@
 
 // ros_controls
 #include <realtime_tools/realtime_server_goal_handle.h>
+#include <controller_chaining/chained_joint_interface.h>
 #include <controller_interface/controller.h>
 #include <hardware_interface/joint_command_interface.h>
 #include <hardware_interface/internal/demangle_symbol.h>
@@ -71,8 +85,15 @@
 #include <trajectory_interface/trajectory_interface.h>
 
 #include <joint_trajectory_controller/joint_trajectory_segment.h>
+#include <joint_trajectory_controller/worker_pool.h>
 #include <joint_trajectory_controller/init_joint_trajectory.h>
 #include <joint_trajectory_controller/hardware_interface_adapter.h>
+#include <joint_trajectory_controller/time_warping.h>
+#include <joint_trajectory_controller/tracking_statistics.h>
+#include <joint_trajectory_controller/CheckTrajectory.h>
+#include <joint_trajectory_controller/GoalTrackingStatistics.h>
+#include <joint_trajectory_controller/JointImpedanceTrajectory.h>
+#include <joint_trajectory_controller/ResumeTrajectory.h>
 
 namespace joint_trajectory_controller
 {
@@ -82,6 +103,11 @@ namespace joint_trajectory_controller
  *
  * \note Non-developer documentation and usage instructions can be found in the package's ROS wiki page.
  *
+ * When \p time_warping/enabled is set, the trajectory clock is slowed down instead of aborting goals on tracking
+ * errors (see \ref TimeWarping). The error of a joint is measured relative to its path position tolerance, so joints
+ * without one, from the \p constraints parameters or the action goal, never slow the trajectory down. A warning is
+ * logged on initialization if no joint has a default path position tolerance.
+ *
  * \tparam SegmentImpl Trajectory segment representation to use. The type must comply with the following structure:
  * \code
  * class FooSegment
@@ -121,14 +147,24 @@ namespace joint_trajectory_controller
  * \tparam HardwareInterface Controller hardware interface. Currently \p hardware_interface::PositionJointInterface,
  * \p hardware_interface::VelocityJointInterface, and \p hardware_interface::EffortJointInterface are supported 
  * out-of-the-box.
+ *
+ * \tparam HardwareAdapter Maps the desired state and state error to hardware commands. Defaults to the
+ * \ref HardwareInterfaceAdapter specialization of \p HardwareInterface. Controllers whose adapter uses joint stiffness
+ * and damping (see \ref UsesJointImpedance) additionally accept trajectories carrying them on the
+ * \p impedance_command topic.
  */
-template <class SegmentImpl, class HardwareInterface>
+template <class SegmentImpl, class HardwareInterface,
+          class HardwareAdapter = HardwareInterfaceAdapter<HardwareInterface,
+                                                           typename JointTrajectorySegment<SegmentImpl>::State> >
 class JointTrajectoryController : public controller_interface::Controller<HardwareInterface>
 {
 public:
 
   JointTrajectoryController();
 
+  /** \brief Stops the goal status notifier thread. */
+  ~JointTrajectoryController();
+
   /** \name Non Real-Time Safe Functions
    *\{*/
   bool init(HardwareInterface* hw, ros::NodeHandle& root_nh, ros::NodeHandle& controller_nh);
@@ -139,7 +175,7 @@ public:
   /** \brief Holds the current position. */
   void starting(const ros::Time& time);
 
-  /** \brief Cancels the active action goal, if any. */
+  /** \brief Cancels the active action goal, if any, and keeps the interrupted trajectory if resuming is allowed. */
   void stopping(const ros::Time& /*time*/);
 
   void update(const ros::Time& time, const ros::Duration& period);
@@ -153,7 +189,7 @@ protected:
 
     ros::Time     time;   ///< Time of last update cycle
     ros::Duration period; ///< Period of last update cycle
-    ros::Time     uptime; ///< Controller uptime. Set to zero at every restart.
+    ros::Time     uptime; ///< Controller uptime. Set to zero at every restart. Runs slower while time is warped.
   };
 
   typedef actionlib::ActionServer<control_msgs::FollowJointTrajectoryAction>                  ActionServer;
@@ -162,6 +198,7 @@ protected:
   typedef realtime_tools::RealtimeServerGoalHandle<control_msgs::FollowJointTrajectoryAction> RealtimeGoalHandle;
   typedef boost::shared_ptr<RealtimeGoalHandle>                                               RealtimeGoalHandlePtr;
   typedef trajectory_msgs::JointTrajectory::ConstPtr                                          JointTrajectoryConstPtr;
+  typedef JointImpedanceTrajectory::ConstPtr                                                  JointImpedanceTrajectoryConstPtr;
   typedef realtime_tools::RealtimePublisher<control_msgs::JointTrajectoryControllerState>     StatePublisher;
   typedef std::unique_ptr<StatePublisher>                                                     StatePublisherPtr;
 
@@ -173,8 +210,16 @@ protected:
   typedef realtime_tools::RealtimeBox<TrajectoryPtr> TrajectoryBox;
   typedef typename Segment::Scalar Scalar;
 
-  typedef HardwareInterfaceAdapter<HardwareInterface, typename Segment::State> HwIfaceAdapter;
+  /** Trajectory interrupted by \ref stopping, and the uptime at which it was interrupted. */
+  struct InterruptedTrajectory
+  {
+    TrajectoryPtr trajectory; ///< Null if there is nothing to resume.
+    ros::Time     uptime;
+  };
+
+  typedef HardwareAdapter HwIfaceAdapter;
   typedef typename HardwareInterface::ResourceHandleType JointHandle;
+  typedef hardware_interface::ResourceManager<JointHandle> JointResourceManager; ///< Gets handles without claiming.
 
   bool                      verbose_;            ///< Hard coded verbose flag to help in debugging
   std::string               name_;               ///< Controller name.
@@ -211,24 +256,109 @@ protected:
   boost::dynamic_bitset<> successful_joint_traj_;
   bool allow_partial_joints_goal_;
 
+  bool                time_warping_enabled_; ///< Whether to slow down on tracking errors instead of aborting goals.
+  TimeWarping<Scalar> time_warping_;         ///< Trajectory clock scaling. Realtime loop only.
+
+  std::vector<Scalar> bridge_max_acceleration_; ///< Acceleration limits of segments bridging to new trajectories.
+  std::vector<Scalar> bridge_max_jerk_;         ///< Jerk limits of segments bridging to new trajectories.
+  bool                has_bridge_limits_;       ///< Whether any bridging limit is set.
+
+  std::unique_ptr<WorkerPool> worker_pool_;           ///< Builds large trajectories in parallel. Null if disabled.
+  std::size_t                 parallel_min_segments_; ///< Smallest goal (points times joints) built in parallel.
+
+  bool                                               allow_trajectory_resume_;
+  realtime_tools::RealtimeBox<InterruptedTrajectory> interrupted_trajectory_box_;
+
+  /** \brief Desired state exported to downstream controllers, see \p controller_chaining. Empty if not exported. */
+  std::vector<std::shared_ptr<controller_chaining::ChainedJointData> > chained_outputs_;
+
+  /**
+   * \brief Whether the controller only exports its desired state. Its joints are then neither claimed nor commanded,
+   * so that downstream controllers can claim them.
+   */
+  bool export_only_;
+
   // ROS API
   ros::NodeHandle    controller_nh_;
   ros::Subscriber    trajectory_command_sub_;
+  ros::Subscriber    impedance_command_sub_;
   ActionServerPtr    action_server_;
   ros::ServiceServer query_state_service_;
+  ros::ServiceServer check_trajectory_service_;
+  ros::ServiceServer resume_trajectory_service_;
   StatePublisherPtr  state_publisher_;
 
-  ros::Timer         goal_handle_timer_;
   ros::Time          last_state_publish_time_;
 
-  virtual bool updateTrajectoryCommand(const JointTrajectoryConstPtr& msg, RealtimeGoalHandlePtr gh, std::string* error_string = 0);
+  /**
+   * \name Goal status notification
+   * Action results set from \ref update are forwarded to actionlib by a persistent non-realtime thread. The realtime
+   * loop wakes it up through \ref notifyGoalStatus as soon as a goal finishes, while feedback is still forwarded at
+   * the \p action_monitor_rate. Wake-ups post a semaphore, so that they are counted even if the thread is not waiting
+   * yet. Only this thread calls into the goal handles, and never with \p goal_notifier_mutex_ locked: actionlib holds
+   * its own lock while running \ref goalCB, which takes \p goal_notifier_mutex_.
+   *\{*/
+  std::thread             goal_notifier_thread_;
+  std::mutex              goal_notifier_mutex_;
+  sem_t                   goal_notifier_sem_;   ///< Posted to wake up the notifier thread.
+  std::atomic<bool>       goal_notifier_stopped_;
+  RealtimeGoalHandlePtr   notifier_goal_;       ///< Last accepted goal. Protected by \p goal_notifier_mutex_.
+  std::vector<RealtimeGoalHandlePtr> replaced_goals_; ///< Goals replaced before their status was forwarded.
+                                                      ///< Protected by \p goal_notifier_mutex_.
+  /*\}*/
+
+  /**
+   * \name Goal tracking statistics
+   * Accumulated by \ref update while a goal is active. When the goal succeeds or is aborted they are handed over to the
+   * goal status notifier thread, which publishes them on the \p tracking_statistics topic. There is room for the
+   * statistics of a single finished goal: those of a goal finishing before the previous ones have been published are
+   * dropped.
+   *\{*/
+  TrackingStatistics<Scalar> tracking_statistics_;          ///< Statistics of \p tracking_goal_. Realtime loop only.
+  RealtimeGoalHandlePtr      tracking_goal_;                ///< Goal being tracked. Realtime loop only.
+  TrackingStatistics<Scalar> finished_tracking_statistics_; ///< Statistics of the last finished goal.
+  RealtimeGoalHandlePtr      finished_tracking_goal_;       ///< Last finished goal.
+  int                        finished_tracking_error_code_; ///< Result error code of the last finished goal.
+  std::atomic<bool>          tracking_statistics_pending_;  ///< Whether the \p finished_tracking_* members are set.
+  ros::Publisher             tracking_statistics_pub_;
+  /*\}*/
+
+  virtual bool updateTrajectoryCommand(const JointTrajectoryConstPtr&          msg,
+                                       RealtimeGoalHandlePtr                   gh,
+                                       std::string*                            error_string = 0,
+                                       const std::vector<JointImpedancePoint>* impedance_points = 0);
   virtual void trajectoryCommandCB(const JointTrajectoryConstPtr& msg);
+  virtual void impedanceCommandCB(const JointImpedanceTrajectoryConstPtr& msg);
   virtual void goalCB(GoalHandle gh);
   virtual void cancelCB(GoalHandle gh);
   virtual void preemptActiveGoal();
   virtual bool queryStateService(control_msgs::QueryTrajectoryState::Request&  req,
                                  control_msgs::QueryTrajectoryState::Response& resp);
 
+  /**
+   * \brief Dry-run a trajectory command.
+   *
+   * Combines the requested trajectory with a snapshot of the one currently being followed, exactly as
+   * \ref updateTrajectoryCommand would, and reports whether it would be accepted, when it would finish, the state it
+   * would be bridged from, and the peak joint velocities and accelerations it would reach. Nothing is executed, and
+   * the realtime loop is left untouched.
+   * \note Peaks are found by sampling every segment at a fixed number of evenly spaced instants.
+   */
+  virtual bool checkTrajectoryService(CheckTrajectory::Request&  req,
+                                      CheckTrajectory::Response& resp);
+
+  /**
+   * \brief Resume the trajectory interrupted by the last controller stop.
+   *
+   * The unexecuted part of the interrupted trajectory is shifted in time and bridged to from the trajectory currently
+   * being followed, so clients need not resend it. Bridging starts at the next update, and takes the requested
+   * duration, or longer if required by the bridging limits. The interrupted trajectory can only be resumed once, and is
+   * forgotten as soon as a new trajectory command is accepted. Its action goal, if any, was canceled when the controller
+   * stopped, so the resumed trajectory is executed without goal tolerances or feedback.
+   */
+  virtual bool resumeTrajectoryService(ResumeTrajectory::Request&  req,
+                                       ResumeTrajectory::Response& resp);
+
   /**
    * \brief Publish current controller state at a throttled frequency.
    * \note This method is realtime-safe and is meant to be called from \ref update, as it shares data with it without
@@ -246,6 +376,30 @@ protected:
    */
   void setHoldPosition(const ros::Time& time, RealtimeGoalHandlePtr gh=RealtimeGoalHandlePtr());
 
+  /**
+   * \brief Wake up the goal status notifier thread after a goal has been marked as succeeded or aborted.
+   * \note This method is realtime-safe: it only posts a semaphore, which neither allocates nor takes a lock.
+   */
+  void notifyGoalStatus();
+
+  /** \brief Body of the goal status notifier thread. */
+  void goalNotifierLoop();
+
+  /**
+   * \brief Hand the tracking statistics of a goal that just finished over to the goal status notifier thread.
+   *
+   * Must be called before marking the goal as succeeded or aborted. The statistics are dropped if the ones of the
+   * previous goal have not been published yet.
+   * \note This method is realtime-safe.
+   */
+  void finishTrackingStatistics(int error_code);
+
+  /**
+   * \brief Publish the statistics handed over by \ref finishTrackingStatistics, if any.
+   * \note Must be called from the goal status notifier thread, before forwarding the goal status to actionlib.
+   */
+  void publishTrackingStatistics();
+
 };
 
 } // namespace
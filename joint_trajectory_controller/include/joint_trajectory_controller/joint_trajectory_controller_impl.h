@@ -127,10 +127,21 @@ std::string getLeafNamespace(const ros::NodeHandle& nh)
   return complete_ns.substr(id + 1);
 }
 
+template <class Adapter, class Trajectory>
+inline void updateSegments(Adapter& adapter, const ros::Time& time, const ros::Time& uptime,
+                           const Trajectory& trajectory, std::true_type)
+{
+  adapter.updateSegments(time, uptime, trajectory);
+}
+
+template <class Adapter, class Trajectory>
+inline void updateSegments(Adapter& /*adapter*/, const ros::Time& /*time*/, const ros::Time& /*uptime*/,
+                           const Trajectory& /*trajectory*/, std::false_type) {}
+
 } // namespace
 
-template <class SegmentImpl, class HardwareInterface>
-inline void JointTrajectoryController<SegmentImpl, HardwareInterface>::
+template <class SegmentImpl, class HardwareInterface, class HardwareAdapter>
+inline void JointTrajectoryController<SegmentImpl, HardwareInterface, HardwareAdapter>::
 starting(const ros::Time& time)
 {
   // Update time data
@@ -152,27 +163,54 @@ starting(const ros::Time& time)
   // Initialize last state update time
   last_state_publish_time_ = time_data.uptime;
 
+  // Start running at real-time speed
+  time_warping_.reset();
+
   // Hardware interface adapter
-  hw_iface_adapter_.starting(time_data.uptime);
+  if (!export_only_) {hw_iface_adapter_.starting(time_data.uptime);}
 }
 
-template <class SegmentImpl, class HardwareInterface>
-inline void JointTrajectoryController<SegmentImpl, HardwareInterface>::
+template <class SegmentImpl, class HardwareInterface, class HardwareAdapter>
+inline void JointTrajectoryController<SegmentImpl, HardwareInterface, HardwareAdapter>::
 stopping(const ros::Time& /*time*/)
 {
   preemptActiveGoal();
+
+  // Keep the interrupted trajectory, unless the controller was just holding a position
+  if (allow_trajectory_resume_)
+  {
+    InterruptedTrajectory interrupted;
+    curr_trajectory_box_.get(interrupted.trajectory);
+    if (interrupted.trajectory == hold_trajectory_ptr_) {interrupted.trajectory.reset();}
+    interrupted.uptime = time_data_.readFromRT()->uptime;
+    interrupted_trajectory_box_.set(interrupted);
+  }
+
+  // Downstream controllers must not keep following the last desired state
+  for (unsigned int i = 0; i < chained_outputs_.size(); ++i) {chained_outputs_[i]->valid = false;}
 }
 
-template <class SegmentImpl, class HardwareInterface>
-inline void JointTrajectoryController<SegmentImpl, HardwareInterface>::
+template <class SegmentImpl, class HardwareInterface, class HardwareAdapter>
+inline void JointTrajectoryController<SegmentImpl, HardwareInterface, HardwareAdapter>::
 trajectoryCommandCB(const JointTrajectoryConstPtr& msg)
 {
   const bool update_ok = updateTrajectoryCommand(msg, RealtimeGoalHandlePtr());
   if (update_ok) {preemptActiveGoal();}
 }
 
-template <class SegmentImpl, class HardwareInterface>
-inline void JointTrajectoryController<SegmentImpl, HardwareInterface>::
+template <class SegmentImpl, class HardwareInterface, class HardwareAdapter>
+inline void JointTrajectoryController<SegmentImpl, HardwareInterface, HardwareAdapter>::
+impedanceCommandCB(const JointImpedanceTrajectoryConstPtr& msg)
+{
+  const bool update_ok = updateTrajectoryCommand(internal::share_member(msg, msg->trajectory),
+                                                 RealtimeGoalHandlePtr(),
+                                                 0,
+                                                 &msg->impedance);
+  if (update_ok) {preemptActiveGoal();}
+}
+
+template <class SegmentImpl, class HardwareInterface, class HardwareAdapter>
+inline void JointTrajectoryController<SegmentImpl, HardwareInterface, HardwareAdapter>::
 preemptActiveGoal()
 {
   RealtimeGoalHandlePtr current_active_goal(rt_active_goal_);
@@ -186,12 +224,22 @@ preemptActiveGoal()
   }
 }
 
-template <class SegmentImpl, class HardwareInterface>
-JointTrajectoryController<SegmentImpl, HardwareInterface>::
+template <class SegmentImpl, class HardwareInterface, class HardwareAdapter>
+JointTrajectoryController<SegmentImpl, HardwareInterface, HardwareAdapter>::
 JointTrajectoryController()
   : verbose_(false), // Set to true during debugging
-    hold_trajectory_ptr_(new Trajectory)
+    hold_trajectory_ptr_(new Trajectory),
+    time_warping_enabled_(false),
+    has_bridge_limits_(false),
+    parallel_min_segments_(InitJointTrajectoryOptions<Trajectory>::DEFAULT_PARALLEL_MIN_SEGMENTS),
+    allow_trajectory_resume_(false),
+    export_only_(false),
+    goal_notifier_stopped_(false),
+    finished_tracking_error_code_(0),
+    tracking_statistics_pending_(false)
 {
+  sem_init(&goal_notifier_sem_, 0, 0);
+
   // The verbose parameter is for advanced use as it breaks real-time safety
   // by enabling ROS logging services
   if (verbose_)
@@ -203,10 +251,20 @@ JointTrajectoryController()
   }
 }
 
-template <class SegmentImpl, class HardwareInterface>
-bool JointTrajectoryController<SegmentImpl, HardwareInterface>::init(HardwareInterface* hw,
-                                                                     ros::NodeHandle&   root_nh,
-                                                                     ros::NodeHandle&   controller_nh)
+template <class SegmentImpl, class HardwareInterface, class HardwareAdapter>
+JointTrajectoryController<SegmentImpl, HardwareInterface, HardwareAdapter>::
+~JointTrajectoryController()
+{
+  goal_notifier_stopped_.store(true, std::memory_order_release);
+  sem_post(&goal_notifier_sem_);
+  if (goal_notifier_thread_.joinable()) {goal_notifier_thread_.join();}
+  sem_destroy(&goal_notifier_sem_);
+}
+
+template <class SegmentImpl, class HardwareInterface, class HardwareAdapter>
+bool JointTrajectoryController<SegmentImpl, HardwareInterface, HardwareAdapter>::init(HardwareInterface* hw,
+                                                                                      ros::NodeHandle&   root_nh,
+                                                                                      ros::NodeHandle&   controller_nh)
 {
   using namespace internal;
 
@@ -226,7 +284,7 @@ bool JointTrajectoryController<SegmentImpl, HardwareInterface>::init(HardwareInt
   double action_monitor_rate = 20.0;
   controller_nh_.getParam("action_monitor_rate", action_monitor_rate);
   action_monitor_period_ = ros::Duration(1.0 / action_monitor_rate);
-  ROS_DEBUG_STREAM_NAMED(name_, "Action status changes will be monitored at " << action_monitor_rate << "Hz.");
+  ROS_DEBUG_STREAM_NAMED(name_, "Action feedback will be published at " << action_monitor_rate << "Hz.");
 
   // Stop trajectory duration
   stop_trajectory_duration_ = 0.0;
@@ -240,6 +298,53 @@ bool JointTrajectoryController<SegmentImpl, HardwareInterface>::init(HardwareInt
     ROS_DEBUG_NAMED(name_, "Goals with partial set of joints are allowed");
   }
 
+  // Checking if interrupted trajectories can be resumed
+  controller_nh_.param<bool>("allow_trajectory_resume", allow_trajectory_resume_, false);
+  if (allow_trajectory_resume_)
+  {
+    ROS_DEBUG_NAMED(name_, "Trajectories interrupted by a controller stop can be resumed");
+  }
+
+  // Trajectory time warping
+  ros::NodeHandle time_warping_nh(controller_nh_, "time_warping");
+  time_warping_nh.param("enabled", time_warping_enabled_, false);
+  if (time_warping_enabled_)
+  {
+    typename TimeWarping<Scalar>::Parameters params;
+    time_warping_nh.param("min_scale",              params.min_scale,              params.min_scale);
+    time_warping_nh.param("slowdown_error_ratio",   params.slowdown_error_ratio,   params.slowdown_error_ratio);
+    time_warping_nh.param("recovery_rate",          params.recovery_rate,          params.recovery_rate);
+    time_warping_nh.param("max_violation_duration", params.max_violation_duration, params.max_violation_duration);
+    if (!time_warping_.init(params))
+    {
+      ROS_ERROR_STREAM_NAMED(name_, "Invalid time warping parameters: 'min_scale' must be in (0, 1], " <<
+                             "'slowdown_error_ratio' in [0, 1), 'recovery_rate' positive and " <<
+                             "'max_violation_duration' non-negative.");
+      return false;
+    }
+    if (StreamsTrajectorySegments<HwIfaceAdapter>::value)
+    {
+      ROS_ERROR_STREAM_NAMED(name_, "Time warping cannot be enabled when streaming trajectory segments to the " <<
+                             "hardware.");
+      return false;
+    }
+    ROS_DEBUG_STREAM_NAMED(name_, "Trajectory time warping enabled, with a minimum scale of " << params.min_scale <<
+                           ". Path tolerance violations are tolerated for " << params.max_violation_duration << "s.");
+  }
+
+  // Parallel construction of large trajectories
+  int construction_threads = 0;
+  int parallel_min_segments = InitJointTrajectoryOptions<Trajectory>::DEFAULT_PARALLEL_MIN_SEGMENTS;
+  controller_nh_.param("trajectory_construction/threads", construction_threads, 0);
+  controller_nh_.param("trajectory_construction/parallel_min_segments", parallel_min_segments, parallel_min_segments);
+  parallel_min_segments_ = std::max(parallel_min_segments, 0);
+  if (construction_threads > 1)
+  {
+    worker_pool_.reset(new WorkerPool(construction_threads));
+    ROS_DEBUG_STREAM_NAMED(name_, "Trajectories with at least " << parallel_min_segments_ << " segments will be " <<
+                           "built using " << construction_threads << " threads.");
+  }
+
   // List of controlled joints
   joint_names_ = getStrings(controller_nh_, "joints");
   if (joint_names_.empty()) {return false;}
@@ -253,13 +358,20 @@ bool JointTrajectoryController<SegmentImpl, HardwareInterface>::init(HardwareInt
   if (urdf_joints.empty()) {return false;}
   assert(n_joints == urdf_joints.size());
 
+  // Export-only controllers leave the joints to the downstream controllers of their desired state
+  controller_nh_.param("export_only", export_only_, false);
+
   // Initialize members
   joints_.resize(n_joints);
   angle_wraparound_.resize(n_joints);
   for (unsigned int i = 0; i < n_joints; ++i)
   {
-    // Joint handle
-    try {joints_[i] = hw->getHandle(joint_names_[i]);}
+    // Joint handle. Export-only controllers neither claim nor command the joints, so get it without claiming
+    try
+    {
+      joints_[i] = export_only_ ? static_cast<JointResourceManager*>(hw)->getHandle(joint_names_[i])
+                                : hw->getHandle(joint_names_[i]);
+    }
     catch (...)
     {
       ROS_ERROR_STREAM_NAMED(name_, "Could not find joint '" << joint_names_[i] << "' in '" <<
@@ -285,16 +397,83 @@ bool JointTrajectoryController<SegmentImpl, HardwareInterface>::init(HardwareInt
   ros::NodeHandle tol_nh(controller_nh_, "constraints");
   default_tolerances_ = getSegmentTolerances<Scalar>(tol_nh, joint_names_);
 
-  // Hardware interface adapter
-  hw_iface_adapter_.init(joints_, controller_nh_);
+  // Time warping only reacts to the errors of joints with a path position tolerance. Action goals may still set some
+  if (time_warping_enabled_ &&
+      std::none_of(default_tolerances_.state_tolerance.begin(), default_tolerances_.state_tolerance.end(),
+                   [](const StateTolerances<Scalar>& tolerance) {return tolerance.position > 0.0;}))
+  {
+    ROS_WARN_STREAM_NAMED(name_, "Time warping is enabled, but no joint has a path position tolerance " <<
+                          "('constraints/<joint>/trajectory'). Trajectories will only be slowed down for action " <<
+                          "goals that specify path tolerances.");
+  }
+
+  // Limits of the segments bridging the current trajectory to new ones
+  ros::NodeHandle bridging_nh(controller_nh_, "bridging");
+  bridge_max_acceleration_.assign(n_joints, 0.0);
+  bridge_max_jerk_.assign(n_joints, 0.0);
+  for (unsigned int i = 0; i < n_joints; ++i)
+  {
+    ros::NodeHandle joint_nh(bridging_nh, joint_names_[i]);
+    joint_nh.param("max_acceleration", bridge_max_acceleration_[i], bridge_max_acceleration_[i]);
+    joint_nh.param("max_jerk",         bridge_max_jerk_[i],         bridge_max_jerk_[i]);
+    if (bridge_max_acceleration_[i] > 0.0 || bridge_max_jerk_[i] > 0.0)
+    {
+      has_bridge_limits_ = true;
+      ROS_DEBUG_STREAM_NAMED(name_, "Bridging to new trajectories of joint '" << joint_names_[i] << "' is limited to " <<
+                             bridge_max_acceleration_[i] << " acceleration and " << bridge_max_jerk_[i] << " jerk.");
+    }
+  }
+
+  // Desired state exported to downstream controllers
+  bool export_desired_state = false;
+  controller_nh_.param("export_desired_state", export_desired_state, export_desired_state);
+  chained_outputs_.clear();
+  if (export_only_ && !export_desired_state)
+  {
+    ROS_ERROR_STREAM_NAMED(name_, "The 'export_only' parameter requires 'export_desired_state' to be set.");
+    return false;
+  }
+  if (export_desired_state)
+  {
+    controller_chaining::ChainedJointInterface& chained_iface = controller_chaining::ChainedJointInterface::instance();
+    for (unsigned int i = 0; i < n_joints; ++i)
+    {
+      using controller_chaining::chainedJointName;
+      const std::string chained_name = chainedJointName(controller_nh_.getNamespace(), joint_names_[i]);
+      chained_outputs_.push_back(chained_iface.exportJoint(chained_name));
+      if (!chained_outputs_.back())
+      {
+        ROS_ERROR_STREAM_NAMED(name_, "Desired state of joint '" << joint_names_[i] << "' is already exported as '" <<
+                               chained_name << "'.");
+        chained_outputs_.clear();
+        return false;
+      }
+    }
+    ROS_DEBUG_STREAM_NAMED(name_, "Desired state is exported to downstream controllers.");
+  }
+
+  // Hardware interface adapter, unused by export-only controllers
+  if (!export_only_ && !hw_iface_adapter_.init(joints_, controller_nh_))
+  {
+    ROS_ERROR_STREAM_NAMED(name_, "Failed to initialize the hardware interface adapter.");
+    chained_outputs_.clear();
+    return false;
+  }
 
   // ROS API: Subscribed topics
   trajectory_command_sub_ = controller_nh_.subscribe("command", 1, &JointTrajectoryController::trajectoryCommandCB, this);
+  if (UsesJointImpedance<HwIfaceAdapter>::value)
+  {
+    impedance_command_sub_ = controller_nh_.subscribe("impedance_command", 1,
+                                                      &JointTrajectoryController::impedanceCommandCB, this);
+  }
 
   // ROS API: Published topics
   state_publisher_.reset(new StatePublisher(controller_nh_, "state", 1));
+  tracking_statistics_pub_ = controller_nh_.advertise<GoalTrackingStatistics>("tracking_statistics", 1);
 
   // ROS API: Action interface
+  goal_notifier_thread_ = std::thread(&JointTrajectoryController::goalNotifierLoop, this);
   action_server_.reset(new ActionServer(controller_nh_, "follow_joint_trajectory",
                                         boost::bind(&JointTrajectoryController::goalCB,   this, _1),
                                         boost::bind(&JointTrajectoryController::cancelCB, this, _1),
@@ -305,16 +484,30 @@ bool JointTrajectoryController<SegmentImpl, HardwareInterface>::init(HardwareInt
   query_state_service_ = controller_nh_.advertiseService("query_state",
                                                          &JointTrajectoryController::queryStateService,
                                                          this);
+  check_trajectory_service_ = controller_nh_.advertiseService("check_trajectory",
+                                                              &JointTrajectoryController::checkTrajectoryService,
+                                                              this);
+  if (allow_trajectory_resume_)
+  {
+    resume_trajectory_service_ = controller_nh_.advertiseService("resume_trajectory",
+                                                                 &JointTrajectoryController::resumeTrajectoryService,
+                                                                 this);
+  }
 
   // Preeallocate resources
   current_state_       = typename Segment::State(n_joints);
   desired_state_       = typename Segment::State(n_joints);
+  desired_state_.stiffness.assign(n_joints, std::numeric_limits<Scalar>::quiet_NaN()); // Unspecified
+  desired_state_.damping.assign(n_joints, std::numeric_limits<Scalar>::quiet_NaN());
   state_error_         = typename Segment::State(n_joints);
   desired_joint_state_ = typename Segment::State(1);
   state_joint_error_   = typename Segment::State(1);
 
   successful_joint_traj_ = boost::dynamic_bitset<>(joints_.size());
 
+  tracking_statistics_.resize(n_joints);
+  finished_tracking_statistics_.resize(n_joints);
+
   // Initialize trajectory with all joints
   typename Segment::State current_joint_state_ = typename Segment::State(1);
   for (unsigned int i = 0; i < n_joints; ++i)
@@ -334,6 +527,7 @@ bool JointTrajectoryController<SegmentImpl, HardwareInterface>::init(HardwareInt
     state_publisher_->msg_.desired.positions.resize(n_joints);
     state_publisher_->msg_.desired.velocities.resize(n_joints);
     state_publisher_->msg_.desired.accelerations.resize(n_joints);
+    state_publisher_->msg_.desired.effort.resize(n_joints);
     state_publisher_->msg_.actual.positions.resize(n_joints);
     state_publisher_->msg_.actual.velocities.resize(n_joints);
     state_publisher_->msg_.error.positions.resize(n_joints);
@@ -344,8 +538,8 @@ bool JointTrajectoryController<SegmentImpl, HardwareInterface>::init(HardwareInt
   return true;
 }
 
-template <class SegmentImpl, class HardwareInterface>
-void JointTrajectoryController<SegmentImpl, HardwareInterface>::
+template <class SegmentImpl, class HardwareInterface, class HardwareAdapter>
+void JointTrajectoryController<SegmentImpl, HardwareInterface, HardwareAdapter>::
 update(const ros::Time& time, const ros::Duration& period)
 {
   // Get currently followed trajectory
@@ -357,7 +551,9 @@ update(const ros::Time& time, const ros::Duration& period)
   TimeData time_data;
   time_data.time   = time;                                     // Cache current time
   time_data.period = period;                                   // Cache current control period
-  time_data.uptime = time_data_.readFromRT()->uptime + period; // Update controller uptime
+  const ros::Duration uptime_increment = time_warping_enabled_ ? ros::Duration(time_warping_.advance(period.toSec()))
+                                                                : period;
+  time_data.uptime = time_data_.readFromRT()->uptime + uptime_increment; // Update controller uptime
   time_data_.writeFromNonRT(time_data); // TODO: Grrr, we need a lock-free data structure here!
 
   // NOTE: It is very important to execute the two above code blocks in the specified sequence: first get current
@@ -369,6 +565,9 @@ update(const ros::Time& time, const ros::Duration& period)
   // next control cycle, leaving the current cycle without a valid trajectory.
 
   // Update current state and state error
+  const Scalar time_scale = time_warping_.scale();
+  Scalar max_error_ratio = 0.0;         // Largest position error relative to its path tolerance
+  bool path_tolerance_violated = false; // Whether the active goal violates its path tolerances
   for (unsigned int i = 0; i < joints_.size(); ++i)
   {
     current_state_.position[i] = joints_[i].getPosition();
@@ -383,9 +582,28 @@ update(const ros::Time& time, const ros::Duration& period)
                       "Unexpected error: No trajectory defined at current time. Please contact the package maintainer.");
       return;
     }
+
+    // Trajectory derivatives are with respect to the trajectory clock, which may run slower than real time
+    if (time_warping_enabled_)
+    {
+      desired_joint_state_.velocity[0]     *= time_scale;
+      desired_joint_state_.acceleration[0] *= time_scale * time_scale;
+    }
+
     desired_state_.position[i] = desired_joint_state_.position[0];
     desired_state_.velocity[i] = desired_joint_state_.velocity[0];
     desired_state_.acceleration[i] = desired_joint_state_.acceleration[0]; ;
+    desired_state_.effort[i] = desired_joint_state_.effort[0];
+    if (desired_joint_state_.stiffness.empty())
+    {
+      desired_state_.stiffness[i] = std::numeric_limits<Scalar>::quiet_NaN();
+      desired_state_.damping[i]   = std::numeric_limits<Scalar>::quiet_NaN();
+    }
+    else
+    {
+      desired_state_.stiffness[i] = desired_joint_state_.stiffness[0];
+      desired_state_.damping[i]   = desired_joint_state_.damping[0];
+    }
 
     state_joint_error_.position[0] = angles::shortest_angular_distance(current_state_.position[i],desired_joint_state_.position[0]);
     state_joint_error_.velocity[0] = desired_joint_state_.velocity[0] - current_state_.velocity[i];
@@ -395,15 +613,34 @@ update(const ros::Time& time, const ros::Duration& period)
     state_error_.velocity[i] = desired_joint_state_.velocity[0] - current_state_.velocity[i];
     state_error_.acceleration[i] = 0.0;
 
+    if (time_warping_enabled_ && time_data.uptime.toSec() < segment_it->endTime())
+    {
+      const Scalar position_tolerance = segment_it->getTolerances().state_tolerance.position;
+      if (position_tolerance > 0.0)
+      {
+        max_error_ratio = std::max(max_error_ratio, std::abs(state_joint_error_.position[0]) / position_tolerance);
+      }
+    }
+
     //Check tolerances
     const RealtimeGoalHandlePtr rt_segment_goal = segment_it->getGoalHandle();
     if (rt_segment_goal && rt_segment_goal == rt_active_goal_)
     {
+      // Restart tracking statistics when a new goal becomes active
+      if (rt_segment_goal != tracking_goal_)
+      {
+        tracking_statistics_.reset(time_data.uptime.toSec());
+        tracking_goal_ = rt_segment_goal;
+      }
+
       // Check tolerances
       if (time_data.uptime.toSec() < segment_it->endTime())
       {
         // Currently executing a segment: check path tolerances
         const SegmentTolerancesPerJoint<Scalar>& joint_tolerances = segment_it->getTolerances();
+        tracking_statistics_.addSample(i, time_data.uptime.toSec(),
+                                       state_joint_error_.position[0], state_joint_error_.velocity[0],
+                                       &joint_tolerances.state_tolerance);
         if (!checkStateTolerancePerJoint(state_joint_error_, joint_tolerances.state_tolerance))
         {
           if (verbose_)
@@ -411,11 +648,19 @@ update(const ros::Time& time, const ros::Duration& period)
             ROS_ERROR_STREAM_NAMED(name_,"Path tolerances failed for joint: " << joint_names_[i]);
             checkStateTolerancePerJoint(state_joint_error_, joint_tolerances.state_tolerance, true);
           }
-          rt_segment_goal->preallocated_result_->error_code =
-          control_msgs::FollowJointTrajectoryResult::PATH_TOLERANCE_VIOLATED;
-          rt_segment_goal->setAborted(rt_segment_goal->preallocated_result_);
-          rt_active_goal_.reset();
-          successful_joint_traj_.reset();
+          path_tolerance_violated = true;
+
+          // With time warping, the goal is only aborted if the violation persists
+          if (!time_warping_enabled_)
+          {
+            rt_segment_goal->preallocated_result_->error_code =
+            control_msgs::FollowJointTrajectoryResult::PATH_TOLERANCE_VIOLATED;
+            finishTrackingStatistics(rt_segment_goal->preallocated_result_->error_code);
+            rt_segment_goal->setAborted(rt_segment_goal->preallocated_result_);
+            rt_active_goal_.reset();
+            successful_joint_traj_.reset();
+            notifyGoalStatus();
+          }
         }
       }
       else if (segment_it == --curr_traj[i].end())
@@ -430,8 +675,13 @@ update(const ros::Time& time, const ros::Duration& period)
         const SegmentTolerancesPerJoint<Scalar>& tolerances = segment_it->getTolerances();
         const bool inside_goal_tolerances = checkStateTolerancePerJoint(state_joint_error_, tolerances.goal_state_tolerance);
 
+        tracking_statistics_.addSample(i, uptime.toSec(),
+                                       state_joint_error_.position[0], state_joint_error_.velocity[0]);
         if (inside_goal_tolerances)
         {
+          tracking_statistics_.setSettled(i, uptime.toSec() - segment_it->endTime(),
+                                          state_joint_error_.position[0], state_joint_error_.velocity[0],
+                                          tolerances.goal_state_tolerance);
           successful_joint_traj_[i] = 1;
         }
         else if (uptime.toSec() < segment_it->endTime() + tolerances.goal_time_tolerance)
@@ -448,28 +698,64 @@ update(const ros::Time& time, const ros::Duration& period)
           }
 
           rt_segment_goal->preallocated_result_->error_code = control_msgs::FollowJointTrajectoryResult::GOAL_TOLERANCE_VIOLATED;
+          finishTrackingStatistics(rt_segment_goal->preallocated_result_->error_code);
           rt_segment_goal->setAborted(rt_segment_goal->preallocated_result_);
           rt_active_goal_.reset();
           successful_joint_traj_.reset();
+          notifyGoalStatus();
         }
       }
     }
   }
 
+  // Time warping: slow down the trajectory clock for the next cycle, and abort the active goal if it has been
+  // violating its path tolerances for too long
+  if (time_warping_enabled_ && time_warping_.update(max_error_ratio, path_tolerance_violated, period.toSec()))
+  {
+    RealtimeGoalHandlePtr violating_goal(rt_active_goal_);
+    if (violating_goal)
+    {
+      if (verbose_) {ROS_ERROR_STREAM_NAMED(name_, "Path tolerances violated for too long, aborting goal.");}
+      violating_goal->preallocated_result_->error_code =
+      control_msgs::FollowJointTrajectoryResult::PATH_TOLERANCE_VIOLATED;
+      finishTrackingStatistics(violating_goal->preallocated_result_->error_code);
+      violating_goal->setAborted(violating_goal->preallocated_result_);
+      rt_active_goal_.reset();
+      successful_joint_traj_.reset();
+      notifyGoalStatus();
+    }
+  }
+
   //If there is an active goal and all segments finished successfully then set goal as succeeded
   RealtimeGoalHandlePtr current_active_goal(rt_active_goal_);
   if (current_active_goal && successful_joint_traj_.count() == joints_.size())
   {
     current_active_goal->preallocated_result_->error_code = control_msgs::FollowJointTrajectoryResult::SUCCESSFUL;
+    finishTrackingStatistics(current_active_goal->preallocated_result_->error_code);
     current_active_goal->setSucceeded(current_active_goal->preallocated_result_);
     current_active_goal.reset(); // do not publish feedback
     rt_active_goal_.reset();
     successful_joint_traj_.reset();
+    notifyGoalStatus();
   }
 
   // Hardware interface adapter: Generate and send commands
-  hw_iface_adapter_.updateCommand(time_data.uptime, time_data.period,
-                                  desired_state_, state_error_);
+  if (!export_only_)
+  {
+    hw_iface_adapter_.updateCommand(time_data.uptime, time_data.period,
+                                    desired_state_, state_error_);
+    internal::updateSegments(hw_iface_adapter_, time_data.time, time_data.uptime, curr_traj,
+                             StreamsTrajectorySegments<HwIfaceAdapter>());
+  }
+
+  // Chained downstream controllers read the desired state in this same cycle
+  for (unsigned int i = 0; i < chained_outputs_.size(); ++i)
+  {
+    chained_outputs_[i]->position = desired_state_.position[i];
+    chained_outputs_[i]->velocity = desired_state_.velocity[i];
+    chained_outputs_[i]->effort   = desired_state_.effort[i];
+    chained_outputs_[i]->valid    = true;
+  }
 
   // Set action feedback
   if (current_active_goal)
@@ -478,6 +764,7 @@ update(const ros::Time& time, const ros::Duration& period)
     current_active_goal->preallocated_feedback_->desired.positions     = desired_state_.position;
     current_active_goal->preallocated_feedback_->desired.velocities    = desired_state_.velocity;
     current_active_goal->preallocated_feedback_->desired.accelerations = desired_state_.acceleration;
+    current_active_goal->preallocated_feedback_->desired.effort        = desired_state_.effort;
     current_active_goal->preallocated_feedback_->actual.positions      = current_state_.position;
     current_active_goal->preallocated_feedback_->actual.velocities     = current_state_.velocity;
     current_active_goal->preallocated_feedback_->error.positions       = state_error_.position;
@@ -485,13 +772,16 @@ update(const ros::Time& time, const ros::Duration& period)
     current_active_goal->setFeedback( current_active_goal->preallocated_feedback_ );
   }
 
-  // Publish state
-  publishState(time_data.uptime);
+  // Publish state, at the configured rate of real time
+  publishState(time_data.uptime + ros::Duration(time_warping_.delay()));
 }
 
-template <class SegmentImpl, class HardwareInterface>
-bool JointTrajectoryController<SegmentImpl, HardwareInterface>::
-updateTrajectoryCommand(const JointTrajectoryConstPtr& msg, RealtimeGoalHandlePtr gh, std::string* error_string)
+template <class SegmentImpl, class HardwareInterface, class HardwareAdapter>
+bool JointTrajectoryController<SegmentImpl, HardwareInterface, HardwareAdapter>::
+updateTrajectoryCommand(const JointTrajectoryConstPtr&          msg,
+                        RealtimeGoalHandlePtr                   gh,
+                        std::string*                            error_string,
+                        const std::vector<JointImpedancePoint>* impedance_points)
 {
   typedef InitJointTrajectoryOptions<Trajectory> Options;
   Options options;
@@ -543,6 +833,11 @@ updateTrajectoryCommand(const JointTrajectoryConstPtr& msg, RealtimeGoalHandlePt
   options.rt_goal_handle            = gh;
   options.default_tolerances        = &default_tolerances_;
   options.allow_partial_joints_goal = allow_partial_joints_goal_;
+  options.worker_pool               = worker_pool_.get();
+  options.parallel_min_segments     = parallel_min_segments_;
+  options.bridge_max_acceleration   = has_bridge_limits_ ? &bridge_max_acceleration_ : 0;
+  options.bridge_max_jerk           = has_bridge_limits_ ? &bridge_max_jerk_ : 0;
+  options.impedance_points          = impedance_points;
 
   // Update currently executing trajectory
   try
@@ -552,6 +847,7 @@ updateTrajectoryCommand(const JointTrajectoryConstPtr& msg, RealtimeGoalHandlePt
     if (!traj_ptr->empty())
     {
       curr_trajectory_box_.set(traj_ptr);
+      if (allow_trajectory_resume_) {interrupted_trajectory_box_.set(InterruptedTrajectory());}
     }
     else
     {
@@ -575,8 +871,8 @@ updateTrajectoryCommand(const JointTrajectoryConstPtr& msg, RealtimeGoalHandlePt
   return true;
 }
 
-template <class SegmentImpl, class HardwareInterface>
-void JointTrajectoryController<SegmentImpl, HardwareInterface>::
+template <class SegmentImpl, class HardwareInterface, class HardwareAdapter>
+void JointTrajectoryController<SegmentImpl, HardwareInterface, HardwareAdapter>::
 goalCB(GoalHandle gh)
 {
   ROS_DEBUG_STREAM_NAMED(name_,"Received new action goal");
@@ -632,11 +928,13 @@ goalCB(GoalHandle gh)
     gh.setAccepted();
     rt_active_goal_ = rt_goal;
 
-    // Setup goal status checking timer
-    goal_handle_timer_ = controller_nh_.createTimer(action_monitor_period_,
-                                                    &RealtimeGoalHandle::runNonRealtime,
-                                                    rt_goal);
-    goal_handle_timer_.start();
+    // Hand the new goal over to the status notifier, which still forwards any pending status of the previous one
+    {
+      std::lock_guard<std::mutex> lock(goal_notifier_mutex_);
+      if (notifier_goal_) {replaced_goals_.push_back(notifier_goal_);}
+      notifier_goal_ = rt_goal;
+    }
+    notifyGoalStatus();
   }
   else
   {
@@ -648,8 +946,8 @@ goalCB(GoalHandle gh)
   }
 }
 
-template <class SegmentImpl, class HardwareInterface>
-void JointTrajectoryController<SegmentImpl, HardwareInterface>::
+template <class SegmentImpl, class HardwareInterface, class HardwareAdapter>
+void JointTrajectoryController<SegmentImpl, HardwareInterface, HardwareAdapter>::
 cancelCB(GoalHandle gh)
 {
   RealtimeGoalHandlePtr current_active_goal(rt_active_goal_);
@@ -672,8 +970,108 @@ cancelCB(GoalHandle gh)
   }
 }
 
-template <class SegmentImpl, class HardwareInterface>
-bool JointTrajectoryController<SegmentImpl, HardwareInterface>::
+template <class SegmentImpl, class HardwareInterface, class HardwareAdapter>
+inline void JointTrajectoryController<SegmentImpl, HardwareInterface, HardwareAdapter>::
+notifyGoalStatus()
+{
+  // Posted even if the notifier thread is busy, so that it runs again as soon as it waits
+  sem_post(&goal_notifier_sem_);
+}
+
+template <class SegmentImpl, class HardwareInterface, class HardwareAdapter>
+void JointTrajectoryController<SegmentImpl, HardwareInterface, HardwareAdapter>::
+goalNotifierLoop()
+{
+  const int64_t period_ns = action_monitor_period_.toNSec();
+  std::vector<RealtimeGoalHandlePtr> goals;
+
+  while (!goal_notifier_stopped_.load(std::memory_order_acquire))
+  {
+    // Wait for a wake-up, or for the next feedback. sem_timedwait only takes deadlines in CLOCK_REALTIME
+    timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    const int64_t deadline_ns = deadline.tv_nsec + period_ns;
+    deadline.tv_sec  += deadline_ns / 1000000000;
+    deadline.tv_nsec  = deadline_ns % 1000000000;
+    while (sem_timedwait(&goal_notifier_sem_, &deadline) != 0 && errno == EINTR) {}
+
+    // Wake-ups posted until now are all served by this iteration
+    while (sem_trywait(&goal_notifier_sem_) == 0) {}
+    if (goal_notifier_stopped_.load(std::memory_order_acquire)) {break;}
+
+    // Take the goals to notify, and call into actionlib only after releasing the lock
+    {
+      std::lock_guard<std::mutex> lock(goal_notifier_mutex_);
+      goals.swap(replaced_goals_);
+      if (notifier_goal_) {goals.push_back(notifier_goal_);}
+    }
+
+    // Forwards results requested by the realtime loop and the latest feedback to actionlib
+    publishTrackingStatistics();
+    for (const RealtimeGoalHandlePtr& goal : goals) {goal->runNonRealtime(ros::TimerEvent());}
+    goals.clear();
+  }
+}
+
+template <class SegmentImpl, class HardwareInterface, class HardwareAdapter>
+void JointTrajectoryController<SegmentImpl, HardwareInterface, HardwareAdapter>::
+finishTrackingStatistics(int error_code)
+{
+  if (!tracking_goal_ || tracking_statistics_pending_.load(std::memory_order_acquire)) {return;}
+
+  // Both statistics have the same size, so copying them does not allocate
+  finished_tracking_statistics_ = tracking_statistics_;
+  finished_tracking_goal_       = tracking_goal_;
+  finished_tracking_error_code_ = error_code;
+  tracking_statistics_pending_.store(true, std::memory_order_release);
+}
+
+template <class SegmentImpl, class HardwareInterface, class HardwareAdapter>
+void JointTrajectoryController<SegmentImpl, HardwareInterface, HardwareAdapter>::
+publishTrackingStatistics()
+{
+  if (!tracking_statistics_pending_.load(std::memory_order_acquire)) {return;}
+
+  const TrackingStatistics<Scalar>& stats = finished_tracking_statistics_;
+  const unsigned int n_joints = stats.size();
+
+  GoalTrackingStatistics msg;
+  msg.header.stamp = time_data_.readFromRT()->time;
+  msg.goal_id      = finished_tracking_goal_->gh_.getGoalID();
+  msg.error_code   = finished_tracking_error_code_;
+  msg.active_time  = ros::Duration(stats.endTime() - stats.startTime());
+  msg.joint_names  = joint_names_;
+  msg.rms_position_error.resize(n_joints);
+  msg.max_position_error.resize(n_joints);
+  msg.rms_velocity_error.resize(n_joints);
+  msg.max_velocity_error.resize(n_joints);
+  msg.min_path_position_margin.resize(n_joints);
+  msg.min_path_velocity_margin.resize(n_joints);
+  msg.settling_time.resize(n_joints);
+  msg.goal_position_margin.resize(n_joints);
+  msg.goal_velocity_margin.resize(n_joints);
+
+  for (unsigned int i = 0; i < n_joints; ++i)
+  {
+    const typename TrackingStatistics<Scalar>::JointStatistics& joint_stats = stats[i];
+    msg.rms_position_error[i]       = joint_stats.rmsPositionError();
+    msg.max_position_error[i]       = joint_stats.max_position_error;
+    msg.rms_velocity_error[i]       = joint_stats.rmsVelocityError();
+    msg.max_velocity_error[i]       = joint_stats.max_velocity_error;
+    msg.min_path_position_margin[i] = joint_stats.min_path_position_margin;
+    msg.min_path_velocity_margin[i] = joint_stats.min_path_velocity_margin;
+    msg.settling_time[i]            = joint_stats.settling_time;
+    msg.goal_position_margin[i]     = joint_stats.goal_position_margin;
+    msg.goal_velocity_margin[i]     = joint_stats.goal_velocity_margin;
+  }
+  tracking_statistics_pub_.publish(msg);
+
+  finished_tracking_goal_.reset();
+  tracking_statistics_pending_.store(false, std::memory_order_release);
+}
+
+template <class SegmentImpl, class HardwareInterface, class HardwareAdapter>
+bool JointTrajectoryController<SegmentImpl, HardwareInterface, HardwareAdapter>::
 queryStateService(control_msgs::QueryTrajectoryState::Request&  req,
                   control_msgs::QueryTrajectoryState::Response& resp)
 {
@@ -720,8 +1118,189 @@ queryStateService(control_msgs::QueryTrajectoryState::Request&  req,
   return true;
 }
 
-template <class SegmentImpl, class HardwareInterface>
-void JointTrajectoryController<SegmentImpl, HardwareInterface>::
+template <class SegmentImpl, class HardwareInterface, class HardwareAdapter>
+bool JointTrajectoryController<SegmentImpl, HardwareInterface, HardwareAdapter>::
+checkTrajectoryService(CheckTrajectory::Request&  req,
+                       CheckTrajectory::Response& resp)
+{
+  const unsigned int samples_per_segment = 16;
+  const unsigned int n_joints = joint_names_.size();
+
+  resp.accepted = false;
+  resp.name = joint_names_;
+
+  // Preconditions
+  if (!this->isRunning())
+  {
+    resp.error_string = "Can't check trajectory. Controller is not running.";
+    return true;
+  }
+
+  // Snapshot of the controller time and current trajectory, as seen by the next update
+  const TimeData time_data = *(time_data_.readFromRT());
+  const ros::Time next_update_time = time_data.time + time_data.period;
+  ros::Time next_update_uptime = time_data.uptime + time_data.period;
+
+  TrajectoryPtr curr_traj_ptr;
+  curr_trajectory_box_.get(curr_traj_ptr);
+
+  // An empty trajectory would make the controller hold its current position
+  Trajectory traj;
+  ros::Time start_uptime = next_update_uptime;
+  if (req.trajectory.points.empty())
+  {
+    traj = *curr_traj_ptr;
+  }
+  else
+  {
+    typedef InitJointTrajectoryOptions<Trajectory> Options;
+    Options options;
+    options.error_string              = &resp.error_string;
+    options.other_time_base           = &next_update_uptime;
+    options.current_trajectory        = curr_traj_ptr.get();
+    options.joint_names               = &joint_names_;
+    options.angle_wraparound          = &angle_wraparound_;
+    options.default_tolerances        = &default_tolerances_;
+    options.allow_partial_joints_goal = allow_partial_joints_goal_;
+    options.worker_pool               = worker_pool_.get();
+    options.parallel_min_segments     = parallel_min_segments_;
+    options.bridge_max_acceleration   = has_bridge_limits_ ? &bridge_max_acceleration_ : 0;
+    options.bridge_max_jerk           = has_bridge_limits_ ? &bridge_max_jerk_ : 0;
+
+    try
+    {
+      traj = initJointTrajectory<Trajectory>(req.trajectory, next_update_time, options);
+    }
+    catch(const std::exception& ex)
+    {
+      resp.error_string = ex.what();
+      return true;
+    }
+    catch(...)
+    {
+      resp.error_string = "Unexpected exception caught when initializing trajectory from ROS message data.";
+      return true;
+    }
+    if (traj.empty()) {return true;}
+
+    // Bridging starts when the new trajectory does, or at the next update if it starts in the past
+    const ros::Duration msg_start_offset = internal::startTime(req.trajectory, next_update_time) - next_update_time;
+    if (msg_start_offset > ros::Duration(0.0)) {start_uptime += msg_start_offset;}
+  }
+
+  // Start state, end time and peaks
+  resp.start_position.resize(n_joints);
+  resp.start_velocity.resize(n_joints);
+  resp.start_acceleration.resize(n_joints);
+  resp.max_velocity.assign(n_joints, 0.0);
+  resp.max_acceleration.assign(n_joints, 0.0);
+
+  typename Segment::Time end_uptime = next_update_uptime.toSec();
+  typename Segment::State state;
+  for (unsigned int i = 0; i < n_joints; ++i)
+  {
+    const TrajectoryPerJoint& joint_traj = traj[i];
+    if (joint_traj.end() == sample(joint_traj, start_uptime.toSec(), state))
+    {
+      resp.error_string = "Unexpected error: No trajectory defined at the start time. Please contact the package maintainer.";
+      return true;
+    }
+    resp.start_position[i]     = state.position[0];
+    resp.start_velocity[i]     = state.velocity[0];
+    resp.start_acceleration[i] = state.acceleration[0];
+
+    for (const Segment& segment : joint_traj)
+    {
+      const typename Segment::Time seg_start = std::max(segment.startTime(), next_update_uptime.toSec());
+      const typename Segment::Time seg_end   = segment.endTime();
+      if (seg_end < seg_start) {continue;}
+
+      for (unsigned int k = 0; k <= samples_per_segment; ++k)
+      {
+        segment.sample(seg_start + (seg_end - seg_start) * k / samples_per_segment, state);
+        resp.max_velocity[i]     = std::max<double>(resp.max_velocity[i],     std::abs(state.velocity[0]));
+        resp.max_acceleration[i] = std::max<double>(resp.max_acceleration[i], std::abs(state.acceleration[0]));
+      }
+    }
+    end_uptime = std::max(end_uptime, joint_traj.back().endTime());
+  }
+
+  resp.accepted   = true;
+  resp.start_time = time_data.time + (start_uptime - time_data.uptime);
+  resp.end_time   = time_data.time + ros::Duration(end_uptime - time_data.uptime.toSec());
+  return true;
+}
+
+template <class SegmentImpl, class HardwareInterface, class HardwareAdapter>
+bool JointTrajectoryController<SegmentImpl, HardwareInterface, HardwareAdapter>::
+resumeTrajectoryService(ResumeTrajectory::Request&  req,
+                        ResumeTrajectory::Response& resp)
+{
+  resp.success = false;
+
+  // Preconditions
+  if (!this->isRunning())
+  {
+    resp.error_string = "Can't resume trajectory. Controller is not running.";
+    return true;
+  }
+
+  InterruptedTrajectory interrupted;
+  interrupted_trajectory_box_.get(interrupted);
+  if (!interrupted.trajectory)
+  {
+    resp.error_string = "Can't resume trajectory. No trajectory was interrupted by the last controller stop.";
+    return true;
+  }
+
+  // Bridging starts at the next update, from the trajectory currently being followed
+  const TimeData time_data = *(time_data_.readFromRT());
+  const ros::Time next_update_uptime = time_data.uptime + time_data.period;
+
+  TrajectoryPtr curr_traj_ptr;
+  curr_trajectory_box_.get(curr_traj_ptr);
+
+  InitJointTrajectoryOptions<Trajectory> options;
+  options.error_string            = &resp.error_string;
+  options.angle_wraparound        = &angle_wraparound_;
+  options.bridge_max_acceleration = has_bridge_limits_ ? &bridge_max_acceleration_ : 0;
+  options.bridge_max_jerk         = has_bridge_limits_ ? &bridge_max_jerk_ : 0;
+
+  TrajectoryPtr traj_ptr(new Trajectory);
+  try
+  {
+    *traj_ptr = resumeJointTrajectory<Trajectory>(*interrupted.trajectory, interrupted.uptime, *curr_traj_ptr,
+                                                  next_update_uptime, req.bridge_duration, options);
+  }
+  catch(const std::exception& ex)
+  {
+    resp.error_string = ex.what();
+    return true;
+  }
+  if (traj_ptr->empty()) {return true;}
+
+  curr_trajectory_box_.set(traj_ptr);
+  interrupted_trajectory_box_.set(InterruptedTrajectory());
+  preemptActiveGoal();
+
+  // Report times in the controller time base
+  typename Segment::Time resume_uptime = next_update_uptime.toSec();
+  typename Segment::Time end_uptime    = next_update_uptime.toSec();
+  for (const TrajectoryPerJoint& joint_traj : *traj_ptr)
+  {
+    resume_uptime = std::max(resume_uptime, joint_traj.front().endTime());
+    end_uptime    = std::max(end_uptime,    joint_traj.back().endTime());
+  }
+
+  resp.success     = true;
+  resp.resume_time = time_data.time + ros::Duration(resume_uptime - time_data.uptime.toSec());
+  resp.end_time    = time_data.time + ros::Duration(end_uptime    - time_data.uptime.toSec());
+  ROS_DEBUG_STREAM_NAMED(name_, "Resuming trajectory interrupted at uptime " << interrupted.uptime.toSec() << "s.");
+  return true;
+}
+
+template <class SegmentImpl, class HardwareInterface, class HardwareAdapter>
+void JointTrajectoryController<SegmentImpl, HardwareInterface, HardwareAdapter>::
 publishState(const ros::Time& time)
 {
   // Check if it's time to publish
@@ -735,6 +1314,7 @@ publishState(const ros::Time& time)
       state_publisher_->msg_.desired.positions     = desired_state_.position;
       state_publisher_->msg_.desired.velocities    = desired_state_.velocity;
       state_publisher_->msg_.desired.accelerations = desired_state_.acceleration;
+      state_publisher_->msg_.desired.effort        = desired_state_.effort;
       state_publisher_->msg_.actual.positions      = current_state_.position;
       state_publisher_->msg_.actual.velocities     = current_state_.velocity;
       state_publisher_->msg_.error.positions       = state_error_.position;
@@ -745,8 +1325,8 @@ publishState(const ros::Time& time)
   }
 }
 
-template <class SegmentImpl, class HardwareInterface>
-void JointTrajectoryController<SegmentImpl, HardwareInterface>::
+template <class SegmentImpl, class HardwareInterface, class HardwareAdapter>
+void JointTrajectoryController<SegmentImpl, HardwareInterface, HardwareAdapter>::
 setHoldPosition(const ros::Time& time, RealtimeGoalHandlePtr gh)
 {
   assert(joint_names_.size() == hold_trajectory_ptr_->size());
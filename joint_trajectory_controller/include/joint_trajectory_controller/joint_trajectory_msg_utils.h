@@ -76,8 +76,8 @@ inline ros::Time startTime(const trajectory_msgs::JointTrajectory& msg,
 
 /**
  * \param point Trajectory point message.
- * \param joint_dim Expected dimension of the position, velocity and acceleration fields.
- * \return True if sizes of the position, velocity and acceleration fields are consistent. An empty field means that
+ * \param joint_dim Expected dimension of the position, velocity, acceleration and effort fields.
+ * \return True if sizes of the position, velocity, acceleration and effort fields are consistent. An empty field means that
  * it's unspecified, so in this particular case its dimension must not coincide with \p joint_dim.
  */
 inline bool isValid(const trajectory_msgs::JointTrajectoryPoint& point, const unsigned int joint_dim)
@@ -85,12 +85,13 @@ inline bool isValid(const trajectory_msgs::JointTrajectoryPoint& point, const un
   if (!point.positions.empty()     && point.positions.size()     != joint_dim) {return false;}
   if (!point.velocities.empty()    && point.velocities.size()    != joint_dim) {return false;}
   if (!point.accelerations.empty() && point.accelerations.size() != joint_dim) {return false;}
+  if (!point.effort.empty()        && point.effort.size()        != joint_dim) {return false;}
   return true;
 }
 
 /**
  * \param msg Trajectory message.
- * \return True if sizes of input message are consistent (joint names, position, velocity, acceleration).
+ * \return True if sizes of input message are consistent (joint names, position, velocity, acceleration, effort).
  */
 inline bool isValid(const trajectory_msgs::JointTrajectory& msg)
 {
@@ -105,7 +106,7 @@ inline bool isValid(const trajectory_msgs::JointTrajectory& msg)
     if(!isValid(*it, joint_dim))
     {
       ROS_ERROR_STREAM("Invalid trajectory point at index: " << index <<
-                       ". Size mismatch in joint names, position, velocity or acceleration data.");
+                       ". Size mismatch in joint names, position, velocity, acceleration or effort data.");
       return false;
     }
   }
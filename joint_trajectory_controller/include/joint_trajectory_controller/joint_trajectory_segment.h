@@ -31,6 +31,7 @@
 #define JOINT_TRAJECTORY_CONTROLLER_JOINT_TRAJECTORY_SEGMENT_H
 
 // C++ standard
+#include <algorithm>
 #include <cmath>
 #include <stdexcept>
 #include <string>
@@ -39,6 +40,9 @@
 // angles
 #include <angles/angles.h>
 
+// Boost
+#include <boost/container/small_vector.hpp>
+
 // ROS messages
 #include <control_msgs/FollowJointTrajectoryAction.h>
 #include <trajectory_msgs/JointTrajectoryPoint.h>
@@ -65,6 +69,13 @@ namespace joint_trajectory_controller
  * std::vector<Scalar> velocity;
  * std::vector<Scalar> acceleration;
  * \endcode
+ *
+ * Trajectory point efforts, when present, are carried along as a feedforward term. They are linearly interpolated
+ * between the segment boundaries and held constant outside them. A boundary state without effort data contributes a
+ * zero effort.
+ *
+ * Joint stiffness and damping, used by impedance controllers, are optionally carried along in the same way. Unlike
+ * efforts, they are either specified at both segment boundaries or not at all.
  */
 template <class Segment>
 class JointTrajectorySegment : public Segment
@@ -80,7 +91,7 @@ public:
   {
     typedef typename Segment::State::Scalar Scalar;
     State() : Segment::State() {}
-    State(unsigned int size) : Segment::State(size) {}
+    State(unsigned int size) : Segment::State(size), effort(size, 0.0) {}
 
     /**
      * \param point Trajectory point.
@@ -106,7 +117,7 @@ public:
       // Preconditions
       if (!isValid(point, joint_dim))
       {
-        throw(invalid_argument("Size mismatch in trajectory point position, velocity or acceleration data."));
+        throw(invalid_argument("Size mismatch in trajectory point position, velocity, acceleration or effort data."));
       }
       if (!position_offset.empty() && joint_dim != position_offset.size())
       {
@@ -118,6 +129,7 @@ public:
       if (!point.positions.empty())     {this->position.resize(joint_dim);}
       if (!point.velocities.empty())    {this->velocity.resize(joint_dim);}
       if (!point.accelerations.empty()) {this->acceleration.resize(joint_dim);}
+      if (!point.effort.empty())        {this->effort.resize(joint_dim);}
 
       for (unsigned int i = 0; i < joint_dim; ++i)
       {
@@ -127,10 +139,50 @@ public:
         if (!point.positions.empty())     {this->position[i]     = point.positions[i] + offset;}
         if (!point.velocities.empty())    {this->velocity[i]     = point.velocities[i];}
         if (!point.accelerations.empty()) {this->acceleration[i] = point.accelerations[i];}
+        if (!point.effort.empty())        {this->effort[i]       = point.effort[i];}
       }
     }
+
+    /**
+     * \brief Initialize a one-dimensional state from a single joint of a multi-joint trajectory point.
+     *
+     * Unlike building a single-joint point and passing it to the other initializer, this reads the \p index column of
+     * \p point directly and reuses the storage of this state, so repeated calls do not allocate.
+     *
+     * \param point Trajectory point. Its data sizes are assumed to have been validated with \ref isValid.
+     * \param index Index of the joint in \p point.
+     * \param position_offset Position offset to apply to the joint position.
+     */
+    void init(const trajectory_msgs::JointTrajectoryPoint& point,
+              const unsigned int                           index,
+              const Scalar&                                position_offset)
+    {
+      const auto assign = [index](const std::vector<double>& src, std::vector<Scalar>& dst, const Scalar& offset)
+      {
+        if (src.empty()) {dst.clear(); return;}
+        dst.resize(1);
+        dst[0] = src[index] + offset;
+      };
+      assign(point.positions,     this->position,     position_offset);
+      assign(point.velocities,    this->velocity,     0.0);
+      assign(point.accelerations, this->acceleration, 0.0);
+      assign(point.effort,        this->effort,       0.0);
+    }
+
+    /** Feedforward effort. Empty if unspecified. */
+    std::vector<Scalar> effort;
+
+    /** Joint stiffness and damping. Empty if unspecified. */
+    std::vector<Scalar> stiffness;
+    std::vector<Scalar> damping;
   };
 
+  /** \brief Creates an empty segment. */
+  JointTrajectorySegment()
+    : rt_goal_handle_(),
+      tolerances_()
+  {}
+
   /**
    * \brief Construct segment from start and end states (boundary conditions).
    *
@@ -146,7 +198,7 @@ public:
     : rt_goal_handle_(),
       tolerances_()
   {
-    Segment::init(start_time, start_state, end_time, end_state);
+    init(start_time, start_state, end_time, end_state);
   }
 
   /**
@@ -191,6 +243,137 @@ public:
     }
   }
 
+  /**
+   * \brief Initialize segment from start and end states (boundary conditions).
+   *
+   * Same as \p Segment::init, but additionally stores the boundary efforts, stiffnesses and dampings of
+   * \p start_state and \p end_state.
+   */
+  void init(const Time&  start_time,
+            const State& start_state,
+            const Time&  end_time,
+            const State& end_state)
+  {
+    Segment::init(start_time, start_state, end_time, end_state);
+    setEffort(start_state.effort, end_state.effort);
+    setImpedance(start_state.stiffness, start_state.damping, end_state.stiffness, end_state.damping);
+  }
+
+  /**
+   * \brief Set the efforts at the segment boundaries.
+   *
+   * An empty range means that the effort is unspecified at that boundary, and is taken as zero unless both are empty.
+   *
+   * \param start_effort Effort at the segment start time.
+   * \param end_effort Effort at the segment end time.
+   * \tparam Range Container of scalars.
+   *
+   * \throw std::invalid_argument If a non-empty range does not match the segment dimension.
+   */
+  template <class Range>
+  void setEffort(const Range& start_effort, const Range& end_effort)
+  {
+    const unsigned int dim = this->size();
+    start_effort_.clear();
+    end_effort_.clear();
+    if (start_effort.empty() && end_effort.empty()) {return;}
+
+    if ((!start_effort.empty() && start_effort.size() != dim) ||
+        (!end_effort.empty()   && end_effort.size()   != dim))
+    {
+      throw(std::invalid_argument("Effort data size does not match segment dimension."));
+    }
+    if (start_effort.empty()) {start_effort_.assign(dim, 0.0);}
+    else {start_effort_.assign(start_effort.begin(), start_effort.end());}
+    if (end_effort.empty()) {end_effort_.assign(dim, 0.0);}
+    else {end_effort_.assign(end_effort.begin(), end_effort.end());}
+  }
+
+  /**
+   * \brief Set the stiffness and damping at the segment boundaries.
+   *
+   * Either all ranges are empty, which leaves them unspecified, or all of them match the segment dimension.
+   *
+   * \param start_stiffness Stiffness at the segment start time.
+   * \param start_damping Damping at the segment start time.
+   * \param end_stiffness Stiffness at the segment end time.
+   * \param end_damping Damping at the segment end time.
+   * \tparam Range Container of scalars.
+   *
+   * \throw std::invalid_argument If only some ranges are empty, or a non-empty range does not match the segment
+   * dimension.
+   */
+  template <class Range>
+  void setImpedance(const Range& start_stiffness, const Range& start_damping,
+                    const Range& end_stiffness,   const Range& end_damping)
+  {
+    const unsigned int dim = this->size();
+    impedance_.clear();
+    if (start_stiffness.empty() && start_damping.empty() && end_stiffness.empty() && end_damping.empty()) {return;}
+
+    if (start_stiffness.size() != dim || start_damping.size() != dim ||
+        end_stiffness.size()   != dim || end_damping.size()   != dim)
+    {
+      throw(std::invalid_argument("Stiffness and damping data must be specified at both segment boundaries, and "
+                                  "match the segment dimension."));
+    }
+    impedance_.reserve(4 * dim);
+    impedance_.insert(impedance_.end(), start_stiffness.begin(), start_stiffness.end());
+    impedance_.insert(impedance_.end(), end_stiffness.begin(),   end_stiffness.end());
+    impedance_.insert(impedance_.end(), start_damping.begin(),   start_damping.end());
+    impedance_.insert(impedance_.end(), end_damping.begin(),     end_damping.end());
+  }
+
+  /**
+   * \brief Sample the segment at a specified time.
+   *
+   * Same as \p Segment::sample, but additionally fills the \p effort member of \p state, and its \p stiffness and
+   * \p damping members if the segment carries them (they are cleared otherwise).
+   */
+  void sample(const Time& time, State& state) const
+  {
+    Segment::sample(time, state);
+
+    const Time duration = this->endTime() - this->startTime();
+    Scalar alpha = 1.0;
+    if (time <= this->startTime())  {alpha = 0.0;}
+    else if (time < this->endTime() && duration > 0.0) {alpha = (time - this->startTime()) / duration;}
+
+    const unsigned int dim = this->size();
+    state.effort.resize(dim);
+    if (start_effort_.empty())
+    {
+      std::fill(state.effort.begin(), state.effort.end(), 0.0);
+    }
+    else
+    {
+      for (unsigned int i = 0; i < dim; ++i)
+      {
+        state.effort[i] = start_effort_[i] + alpha * (end_effort_[i] - start_effort_[i]);
+      }
+    }
+
+    if (impedance_.empty())
+    {
+      state.stiffness.clear();
+      state.damping.clear();
+      return;
+    }
+    state.stiffness.resize(dim);
+    state.damping.resize(dim);
+    for (unsigned int i = 0; i < dim; ++i)
+    {
+      state.stiffness[i] = impedance_[i]           + alpha * (impedance_[dim + i]     - impedance_[i]);
+      state.damping[i]   = impedance_[2 * dim + i] + alpha * (impedance_[3 * dim + i] - impedance_[2 * dim + i]);
+    }
+  }
+
+  /** \return True if the segment carries effort data. */
+  bool hasEffort() const {return !start_effort_.empty();}
+
+  /** \return True if the segment carries stiffness and damping data. */
+  bool hasImpedance() const {return !impedance_.empty();}
+
   /** \return Pointer to (realtime) goal handle associated to this segment. */
   RealtimeGoalHandlePtr getGoalHandle() const {return rt_goal_handle_;}
 
@@ -206,6 +389,11 @@ public:
 private:
   RealtimeGoalHandlePtr     rt_goal_handle_;
   SegmentTolerancesPerJoint<Scalar> tolerances_;
+  // Stored inline for one-dimensional segments, see QuinticSplineSegment
+  boost::container::small_vector<Scalar, 1> start_effort_;
+  boost::container::small_vector<Scalar, 1> end_effort_;
+  // Start and end stiffness, followed by start and end damping
+  boost::container::small_vector<Scalar, 4> impedance_;
 };
 
 /**
@@ -0,0 +1,691 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER_RIGID_BODY_CHAIN_H
+#define JOINT_TRAJECTORY_CONTROLLER_RIGID_BODY_CHAIN_H
+
+// C++ standard
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// ROS
+#include <ros/console.h>
+
+// URDF
+#include <urdf/model.h>
+
+namespace joint_trajectory_controller
+{
+
+namespace internal
+{
+
+struct Vector3
+{
+  double x, y, z;
+};
+
+inline Vector3 operator+(const Vector3& a, const Vector3& b) {return {a.x + b.x, a.y + b.y, a.z + b.z};}
+inline Vector3 operator-(const Vector3& a, const Vector3& b) {return {a.x - b.x, a.y - b.y, a.z - b.z};}
+inline Vector3 operator*(double k, const Vector3& a)         {return {k * a.x, k * a.y, k * a.z};}
+
+inline double dot(const Vector3& a, const Vector3& b) {return a.x * b.x + a.y * b.y + a.z * b.z;}
+
+inline Vector3 cross(const Vector3& a, const Vector3& b)
+{
+  return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+/** \brief Row-major 3x3 matrix. */
+struct Matrix3
+{
+  double m[9];
+
+  static Matrix3 identity() {return {{1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0}};}
+  static Matrix3 zero()     {return {{0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0}};}
+};
+
+inline Vector3 operator*(const Matrix3& a, const Vector3& v)
+{
+  return {a.m[0] * v.x + a.m[1] * v.y + a.m[2] * v.z,
+          a.m[3] * v.x + a.m[4] * v.y + a.m[5] * v.z,
+          a.m[6] * v.x + a.m[7] * v.y + a.m[8] * v.z};
+}
+
+/** \return \f$ a^T v \f$. */
+inline Vector3 transposeTimes(const Matrix3& a, const Vector3& v)
+{
+  return {a.m[0] * v.x + a.m[3] * v.y + a.m[6] * v.z,
+          a.m[1] * v.x + a.m[4] * v.y + a.m[7] * v.z,
+          a.m[2] * v.x + a.m[5] * v.y + a.m[8] * v.z};
+}
+
+inline Matrix3 operator*(const Matrix3& a, const Matrix3& b)
+{
+  Matrix3 out;
+  for (unsigned int r = 0; r < 3; ++r)
+  {
+    for (unsigned int c = 0; c < 3; ++c)
+    {
+      out.m[3 * r + c] = a.m[3 * r] * b.m[c] + a.m[3 * r + 1] * b.m[3 + c] + a.m[3 * r + 2] * b.m[6 + c];
+    }
+  }
+  return out;
+}
+
+inline Matrix3 operator+(const Matrix3& a, const Matrix3& b)
+{
+  Matrix3 out;
+  for (unsigned int k = 0; k < 9; ++k) {out.m[k] = a.m[k] + b.m[k];}
+  return out;
+}
+
+inline Matrix3 transpose(const Matrix3& a)
+{
+  return {{a.m[0], a.m[3], a.m[6], a.m[1], a.m[4], a.m[7], a.m[2], a.m[5], a.m[8]}};
+}
+
+/** \return Rotation of angle \f$ \theta \f$ (given by its cosine and sine) about the unit vector \p axis. */
+inline Matrix3 axisAngle(const Vector3& axis, double c, double s)
+{
+  const double t = 1.0 - c;
+  const Vector3& u = axis;
+  return {{t * u.x * u.x + c,       t * u.x * u.y - s * u.z, t * u.x * u.z + s * u.y,
+           t * u.x * u.y + s * u.z, t * u.y * u.y + c,       t * u.y * u.z - s * u.x,
+           t * u.x * u.z - s * u.y, t * u.y * u.z + s * u.x, t * u.z * u.z + c}};
+}
+
+/** \return Inertia of a point of mass \p mass located at \p p, about the origin (parallel axis theorem term). */
+inline Matrix3 parallelAxis(double mass, const Vector3& p)
+{
+  const double p2 = dot(p, p);
+  return {{mass * (p2 - p.x * p.x), -mass * p.x * p.y,         -mass * p.x * p.z,
+           -mass * p.y * p.x,        mass * (p2 - p.y * p.y),  -mass * p.y * p.z,
+           -mass * p.z * p.x,        -mass * p.z * p.y,         mass * (p2 - p.z * p.z)}};
+}
+
+/** \brief Rigid transform mapping child frame coordinates to parent frame coordinates. */
+struct Transform
+{
+  Matrix3 rotation;
+  Vector3 translation;
+
+  static Transform identity() {return {Matrix3::identity(), {0.0, 0.0, 0.0}};}
+
+  Vector3 operator*(const Vector3& p) const {return rotation * p + translation;}
+  Transform operator*(const Transform& t) const {return {rotation * t.rotation, rotation * t.translation + translation};}
+};
+
+/** \return Inverse of a rigid transform. */
+inline Transform inverse(const Transform& t)
+{
+  const Matrix3 rotation = transpose(t.rotation);
+  return {rotation, -1.0 * (rotation * t.translation)};
+}
+
+/**
+ * \return Rotation vector (axis times angle, with the angle in \f$ [0, \pi] \f$) of the rotation matrix \p r.
+ * The conversion goes through a unit quaternion, which is well conditioned for all angles.
+ */
+inline Vector3 rotationVector(const Matrix3& r)
+{
+  // Quaternion with non-negative scalar part, computed from its largest component
+  double w, x, y, z;
+  const double trace = r.m[0] + r.m[4] + r.m[8];
+  if (trace > 0.0)
+  {
+    const double s = 2.0 * std::sqrt(1.0 + trace);
+    w = 0.25 * s;
+    x = (r.m[7] - r.m[5]) / s;
+    y = (r.m[2] - r.m[6]) / s;
+    z = (r.m[3] - r.m[1]) / s;
+  }
+  else if (r.m[0] > r.m[4] && r.m[0] > r.m[8])
+  {
+    const double s = 2.0 * std::sqrt(1.0 + r.m[0] - r.m[4] - r.m[8]);
+    w = (r.m[7] - r.m[5]) / s;
+    x = 0.25 * s;
+    y = (r.m[1] + r.m[3]) / s;
+    z = (r.m[2] + r.m[6]) / s;
+  }
+  else if (r.m[4] > r.m[8])
+  {
+    const double s = 2.0 * std::sqrt(1.0 + r.m[4] - r.m[0] - r.m[8]);
+    w = (r.m[2] - r.m[6]) / s;
+    x = (r.m[1] + r.m[3]) / s;
+    y = 0.25 * s;
+    z = (r.m[5] + r.m[7]) / s;
+  }
+  else
+  {
+    const double s = 2.0 * std::sqrt(1.0 + r.m[8] - r.m[0] - r.m[4]);
+    w = (r.m[3] - r.m[1]) / s;
+    x = (r.m[2] + r.m[6]) / s;
+    y = (r.m[5] + r.m[7]) / s;
+    z = 0.25 * s;
+  }
+  if (w < 0.0) {w = -w; x = -x; y = -y; z = -z;}
+
+  const double sin_half = std::sqrt(x * x + y * y + z * z);
+  if (sin_half < 1e-12) {return {2.0 * x, 2.0 * y, 2.0 * z};} // Small angle limit
+  const double angle = 2.0 * std::atan2(sin_half, w);
+  return (angle / sin_half) * Vector3{x, y, z};
+}
+
+/** \return Rotation matrix of the rotation vector \p v (axis times angle). */
+inline Matrix3 rotationMatrix(const Vector3& v)
+{
+  const double angle = std::sqrt(dot(v, v));
+  if (angle < 1e-12) {return Matrix3::identity();}
+  return axisAngle((1.0 / angle) * v, std::cos(angle), std::sin(angle));
+}
+
+/** \return Rotation matrix of the unit quaternion \f$ (x, y, z, w) \f$. */
+inline Matrix3 quaternionMatrix(double x, double y, double z, double w)
+{
+  return {{1.0 - 2.0 * (y * y + z * z), 2.0 * (x * y - z * w),       2.0 * (x * z + y * w),
+           2.0 * (x * y + z * w),       1.0 - 2.0 * (x * x + z * z), 2.0 * (y * z - x * w),
+           2.0 * (x * z - y * w),       2.0 * (y * z + x * w),       1.0 - 2.0 * (x * x + y * y)}};
+}
+
+inline Vector3 toVector3(const urdf::Vector3& v) {return {v.x, v.y, v.z};}
+
+inline Transform toTransform(const urdf::Pose& pose)
+{
+  const urdf::Rotation& q = pose.rotation;
+  const Matrix3 rotation = {{1.0 - 2.0 * (q.y * q.y + q.z * q.z), 2.0 * (q.x * q.y - q.z * q.w),       2.0 * (q.x * q.z + q.y * q.w),
+                             2.0 * (q.x * q.y + q.z * q.w),       1.0 - 2.0 * (q.x * q.x + q.z * q.z), 2.0 * (q.y * q.z - q.x * q.w),
+                             2.0 * (q.x * q.z - q.y * q.w),       2.0 * (q.y * q.z + q.x * q.w),       1.0 - 2.0 * (q.x * q.x + q.y * q.y)}};
+  return {rotation, toVector3(pose.position)};
+}
+
+} // namespace
+
+/**
+ * \brief Dynamic model of a serial chain of revolute and prismatic joints, built from a URDF.
+ *
+ * The chain spans from the URDF root link to the child link of the deepest of the joints it is initialized with, and
+ * these joints must be exactly the movable joints along it. The inertia of links attached to the chain through fixed
+ * joints, or hanging off it in branches (evaluated at their zero position), is lumped into the body they are attached
+ * to.
+ *
+ * The chain tip, whose pose and Jacobian are computed by the kinematics methods, is the child link of the deepest joint
+ * unless moved to a link rigidly attached to it with \ref setTip.
+ *
+ * All computations after initialization are realtime-safe.
+ */
+class RigidBodyChain
+{
+public:
+  typedef internal::Vector3   Vector3;
+  typedef internal::Matrix3   Matrix3;
+  typedef internal::Transform Transform;
+
+  RigidBodyChain() : gravity_({0.0, 0.0, -9.81}) {}
+
+  /**
+   * \param urdf Robot model.
+   * \param joint_names Joints of the chain. They can be given in any order, which is the one used by all the methods
+   * taking or returning per-joint values.
+   * \return True if the joints form a serial chain of revolute, continuous or prismatic joints.
+   */
+  bool init(const urdf::Model& urdf, const std::vector<std::string>& joint_names);
+
+  /**
+   * \brief Move the chain tip to a link rigidly attached to the child link of the deepest joint.
+   * \return True if \p link_name is that link, or is connected to it through fixed joints only.
+   */
+  bool setTip(const urdf::Model& urdf, const std::string& link_name);
+
+  /** \brief Set the gravity vector, expressed in the root frame. Defaults to \f$ (0, 0, -9.81) \f$. */
+  void setGravity(const Vector3& gravity) {gravity_ = gravity;}
+
+  /** \return Number of joints in the chain. */
+  unsigned int size() const {return bodies_.size();}
+
+  /**
+   * \brief Compute the joint efforts that produce the given joint accelerations, using the recursive Newton-Euler
+   * algorithm. Efforts include gravity, Coriolis and centrifugal terms.
+   * \param effort Output efforts. Must have at least \ref size elements.
+   * \note This method is realtime-safe.
+   */
+  void inverseDynamics(const std::vector<double>& position,
+                       const std::vector<double>& velocity,
+                       const std::vector<double>& acceleration,
+                       std::vector<double>&       effort);
+
+  /**
+   * \brief Compute the pose of the chain tip w.r.t. the root.
+   * \note This method is realtime-safe.
+   */
+  Transform tipPose(const std::vector<double>& position) const;
+
+  /**
+   * \brief Compute the pose of the chain tip and its geometric Jacobian, expressed in the root frame.
+   * \param jacobian Output row-major \f$ 6 \times n \f$ matrix, with \f$ n \f$ the chain \ref size, mapping joint
+   * velocities to the linear (first three rows) and angular (last three rows) velocity of the tip. Columns follow the
+   * joint order given on initialization. Must have \f$ 6 n \f$ elements.
+   * \return Pose of the chain tip w.r.t. the root.
+   * \note This method is realtime-safe.
+   */
+  Transform jacobian(const std::vector<double>& position, std::vector<double>& jacobian) const;
+
+private:
+
+  struct Body
+  {
+    Transform    origin;    ///< Joint frame w.r.t. the previous body frame (or the root) at zero joint position.
+    Vector3      axis;      ///< Unit joint axis, in the joint frame.
+    bool         prismatic;
+    unsigned int index;     ///< Position of the joint in the user-specified joint order.
+    double       mass;
+    Vector3      com;       ///< Centre of mass, in the joint frame.
+    Matrix3      inertia;   ///< Rotational inertia about the centre of mass, in the joint frame.
+  };
+
+  /** \brief Per-body state of the current computation. */
+  struct BodyState
+  {
+    Transform pose;         ///< Body frame w.r.t. the previous body frame.
+    Vector3   omega;
+    Vector3   omega_dot;
+    Vector3   acceleration; ///< Linear acceleration of the frame origin, including gravity.
+    Vector3   force;
+    Vector3   torque;
+  };
+
+  std::vector<Body>      bodies_;
+  std::vector<BodyState> states_;
+  Vector3                gravity_;
+  std::string            tip_link_;   ///< Child link of the deepest joint.
+  Transform              tip_offset_; ///< Chain tip w.r.t. the frame of the deepest body.
+
+  /** \return Body frame w.r.t. the previous body frame (or the root) at joint position \p q. */
+  static Transform bodyPose(const Body& body, double q);
+
+  static void addInertia(Body& body, const Transform& link_pose, const urdf::Link& link);
+  static void addSubtreeInertia(const urdf::Model&       urdf,
+                                Body&                    body,
+                                const Transform&         link_pose,
+                                const urdf::Link&        link,
+                                const urdf::Joint* const excluded_joint);
+};
+
+inline bool RigidBodyChain::init(const urdf::Model& urdf, const std::vector<std::string>& joint_names)
+{
+  using namespace internal;
+
+  bodies_.clear();
+  states_.clear();
+  tip_link_.clear();
+  tip_offset_ = Transform::identity();
+
+  // Find the deepest of the chain joints
+  urdf::JointConstSharedPtr tip_joint;
+  unsigned int tip_depth = 0;
+  for (const auto& joint_name : joint_names)
+  {
+    urdf::JointConstSharedPtr joint = urdf.getJoint(joint_name);
+    if (!joint)
+    {
+      ROS_ERROR_STREAM("Could not find joint '" << joint_name << "' in URDF model.");
+      return false;
+    }
+    if (joint->type != urdf::Joint::REVOLUTE && joint->type != urdf::Joint::CONTINUOUS &&
+        joint->type != urdf::Joint::PRISMATIC)
+    {
+      ROS_ERROR_STREAM("Joint '" << joint_name << "' is not revolute, continuous or prismatic.");
+      return false;
+    }
+
+    unsigned int depth = 0;
+    for (urdf::LinkConstSharedPtr link = urdf.getLink(joint->child_link_name); link && link->parent_joint;
+         link = urdf.getLink(link->parent_joint->parent_link_name))
+    {
+      ++depth;
+    }
+    if (depth > tip_depth)
+    {
+      tip_depth = depth;
+      tip_joint = joint;
+    }
+  }
+  if (!tip_joint)
+  {
+    ROS_ERROR_STREAM("Cannot build a chain without joints.");
+    return false;
+  }
+
+  // Joints from the root to the tip
+  std::vector<urdf::JointConstSharedPtr> path(tip_depth);
+  urdf::LinkConstSharedPtr tip_link = urdf.getLink(tip_joint->child_link_name);
+  urdf::LinkConstSharedPtr link = tip_link;
+  for (unsigned int i = tip_depth; i > 0; --i)
+  {
+    path[i - 1] = link->parent_joint;
+    link = urdf.getLink(link->parent_joint->parent_link_name);
+  }
+
+  // Bodies, one per movable joint of the path
+  Transform pending = Transform::identity(); // Accumulated fixed transforms since the last body
+  for (unsigned int i = 0; i < path.size(); ++i)
+  {
+    const urdf::Joint& joint = *path[i];
+    urdf::LinkConstSharedPtr child = urdf.getLink(joint.child_link_name);
+
+    if (joint.type == urdf::Joint::FIXED)
+    {
+      pending = pending * toTransform(joint.parent_to_joint_origin_transform);
+    }
+    else
+    {
+      const std::vector<std::string>::const_iterator name_it = std::find(joint_names.begin(), joint_names.end(),
+                                                                         joint.name);
+      if (name_it == joint_names.end())
+      {
+        ROS_ERROR_STREAM("Joint '" << joint.name << "' lies between the URDF root and joint '" << tip_joint->name <<
+                         "', but is not part of the chain.");
+        return false;
+      }
+      if (joint.type != urdf::Joint::REVOLUTE && joint.type != urdf::Joint::CONTINUOUS &&
+          joint.type != urdf::Joint::PRISMATIC)
+      {
+        ROS_ERROR_STREAM("Joint '" << joint.name << "' is not revolute, continuous or prismatic.");
+        return false;
+      }
+
+      Body body;
+      body.origin    = pending * toTransform(joint.parent_to_joint_origin_transform);
+      body.prismatic = joint.type == urdf::Joint::PRISMATIC;
+      body.index     = std::distance(joint_names.begin(), name_it);
+      body.mass      = 0.0;
+      body.com       = {0.0, 0.0, 0.0};
+      body.inertia   = Matrix3::zero();
+
+      const Vector3 axis = toVector3(joint.axis);
+      const double axis_norm = std::sqrt(dot(axis, axis));
+      if (axis_norm == 0.0)
+      {
+        ROS_ERROR_STREAM("Joint '" << joint.name << "' has a zero axis.");
+        return false;
+      }
+      body.axis = (1.0 / axis_norm) * axis;
+
+      bodies_.push_back(body);
+      pending = Transform::identity();
+    }
+
+    // Link inertia, plus that of any branches stemming from it
+    if (!bodies_.empty())
+    {
+      const urdf::Joint* next_joint = i + 1 < path.size() ? path[i + 1].get() : nullptr;
+      addSubtreeInertia(urdf, bodies_.back(), pending, *child, next_joint);
+    }
+  }
+
+  if (bodies_.size() != joint_names.size())
+  {
+    ROS_ERROR_STREAM("Joints do not form a serial chain ending at joint '" << tip_joint->name << "'.");
+    bodies_.clear();
+    return false;
+  }
+
+  // Inertia was accumulated about the body frame origin: move it to the centre of mass
+  for (auto& body : bodies_)
+  {
+    if (body.mass > 0.0)
+    {
+      body.com = (1.0 / body.mass) * body.com;
+      body.inertia = body.inertia + parallelAxis(-body.mass, body.com);
+    }
+  }
+
+  states_.resize(bodies_.size());
+  tip_link_ = tip_link->name;
+  return true;
+}
+
+inline bool RigidBodyChain::setTip(const urdf::Model& urdf, const std::string& link_name)
+{
+  using namespace internal;
+
+  // Fixed transforms from the link up to the child link of the deepest joint
+  Transform offset = Transform::identity();
+  urdf::LinkConstSharedPtr link = urdf.getLink(link_name);
+  while (link && link->name != tip_link_)
+  {
+    if (!link->parent_joint || link->parent_joint->type != urdf::Joint::FIXED)
+    {
+      ROS_ERROR_STREAM("Link '" << link_name << "' is not rigidly attached to the chain tip '" << tip_link_ << "'.");
+      return false;
+    }
+    offset = toTransform(link->parent_joint->parent_to_joint_origin_transform) * offset;
+    link = urdf.getLink(link->parent_joint->parent_link_name);
+  }
+  if (!link || tip_link_.empty())
+  {
+    ROS_ERROR_STREAM("Could not find link '" << link_name << "' in URDF model, or the chain is not initialized.");
+    return false;
+  }
+
+  tip_offset_ = offset;
+  return true;
+}
+
+inline RigidBodyChain::Transform RigidBodyChain::bodyPose(const Body& body, double q)
+{
+  using namespace internal;
+
+  if (body.prismatic)
+  {
+    return {body.origin.rotation, body.origin.translation + body.origin.rotation * (q * body.axis)};
+  }
+  return {body.origin.rotation * axisAngle(body.axis, std::cos(q), std::sin(q)), body.origin.translation};
+}
+
+inline RigidBodyChain::Transform RigidBodyChain::tipPose(const std::vector<double>& position) const
+{
+  assert(position.size() >= bodies_.size());
+
+  Transform pose = Transform::identity();
+  for (const Body& body : bodies_) {pose = pose * bodyPose(body, position[body.index]);}
+  return pose * tip_offset_;
+}
+
+inline RigidBodyChain::Transform RigidBodyChain::jacobian(const std::vector<double>& position,
+                                                          std::vector<double>&       jacobian) const
+{
+  using namespace internal;
+
+  const unsigned int n_bodies = bodies_.size();
+  assert(position.size() >= n_bodies);
+  assert(jacobian.size() >= 6 * n_bodies);
+
+  // Joint axes and origins in the root frame are stored in the columns while the tip position is not yet known
+  Transform pose = Transform::identity();
+  for (const Body& body : bodies_)
+  {
+    pose = pose * bodyPose(body, position[body.index]);
+    const Vector3 axis = pose.rotation * body.axis;
+    const Vector3& origin = pose.translation;
+    const unsigned int c = body.index;
+    jacobian[c]                = origin.x;
+    jacobian[n_bodies + c]     = origin.y;
+    jacobian[2 * n_bodies + c] = origin.z;
+    jacobian[3 * n_bodies + c] = axis.x;
+    jacobian[4 * n_bodies + c] = axis.y;
+    jacobian[5 * n_bodies + c] = axis.z;
+  }
+  pose = pose * tip_offset_;
+
+  // Revolute joints move the tip about their axis, prismatic joints translate it along their axis
+  for (const Body& body : bodies_)
+  {
+    const unsigned int c = body.index;
+    const Vector3 axis   = {jacobian[3 * n_bodies + c], jacobian[4 * n_bodies + c], jacobian[5 * n_bodies + c]};
+    const Vector3 origin = {jacobian[c], jacobian[n_bodies + c], jacobian[2 * n_bodies + c]};
+    const Vector3 linear = body.prismatic ? axis : cross(axis, pose.translation - origin);
+    jacobian[c]                = linear.x;
+    jacobian[n_bodies + c]     = linear.y;
+    jacobian[2 * n_bodies + c] = linear.z;
+    if (body.prismatic)
+    {
+      jacobian[3 * n_bodies + c] = 0.0;
+      jacobian[4 * n_bodies + c] = 0.0;
+      jacobian[5 * n_bodies + c] = 0.0;
+    }
+  }
+  return pose;
+}
+
+inline void RigidBodyChain::addInertia(Body& body, const Transform& link_pose, const urdf::Link& link)
+{
+  using namespace internal;
+
+  if (!link.inertial) {return;}
+  const urdf::Inertial& inertial = *link.inertial;
+
+  // Inertia in the link inertial frame, and centre of mass and orientation of that frame in the body frame
+  const Matrix3 inertia = {{inertial.ixx, inertial.ixy, inertial.ixz,
+                            inertial.ixy, inertial.iyy, inertial.iyz,
+                            inertial.ixz, inertial.iyz, inertial.izz}};
+  const Transform inertial_pose = link_pose * toTransform(inertial.origin);
+  const Vector3& com = inertial_pose.translation;
+  const Matrix3& rotation = inertial_pose.rotation;
+
+  // Mass, first moment of mass and inertia about the body frame origin are accumulated
+  body.mass += inertial.mass;
+  body.com = body.com + inertial.mass * com;
+  body.inertia = body.inertia + rotation * inertia * transpose(rotation) + parallelAxis(inertial.mass, com);
+}
+
+inline void RigidBodyChain::addSubtreeInertia(const urdf::Model&       urdf,
+                                              Body&                    body,
+                                              const Transform&         link_pose,
+                                              const urdf::Link&        link,
+                                              const urdf::Joint* const excluded_joint)
+{
+  addInertia(body, link_pose, link);
+  for (const auto& joint : link.child_joints)
+  {
+    urdf::LinkConstSharedPtr child = urdf.getLink(joint->child_link_name);
+    if (joint.get() == excluded_joint || !child) {continue;}
+    addSubtreeInertia(urdf,
+                      body,
+                      link_pose * internal::toTransform(joint->parent_to_joint_origin_transform),
+                      *child,
+                      nullptr);
+  }
+}
+
+inline void RigidBodyChain::inverseDynamics(const std::vector<double>& position,
+                                            const std::vector<double>& velocity,
+                                            const std::vector<double>& acceleration,
+                                            std::vector<double>&       effort)
+{
+  using namespace internal;
+
+  const unsigned int n_bodies = bodies_.size();
+  assert(position.size() >= n_bodies && velocity.size() >= n_bodies && acceleration.size() >= n_bodies);
+  assert(effort.size() >= n_bodies);
+
+  // Forward pass: body velocities and accelerations, expressed in body frames. Gravity is accounted for by
+  // accelerating the root upwards
+  Vector3 parent_omega        = {0.0, 0.0, 0.0};
+  Vector3 parent_omega_dot    = {0.0, 0.0, 0.0};
+  Vector3 parent_acceleration = -1.0 * gravity_;
+  for (unsigned int i = 0; i < n_bodies; ++i)
+  {
+    const Body& body = bodies_[i];
+    BodyState& state = states_[i];
+
+    const double qd  = velocity[body.index];
+    const double qdd = acceleration[body.index];
+
+    state.pose = bodyPose(body, position[body.index]);
+
+    const Vector3& p = state.pose.translation;
+    const Matrix3& r = state.pose.rotation;
+    const Vector3 omega_in = transposeTimes(r, parent_omega);
+    state.acceleration = transposeTimes(r, parent_acceleration + cross(parent_omega_dot, p) +
+                                           cross(parent_omega, cross(parent_omega, p)));
+    if (body.prismatic)
+    {
+      state.omega        = omega_in;
+      state.omega_dot    = transposeTimes(r, parent_omega_dot);
+      state.acceleration = state.acceleration + qdd * body.axis + cross(2.0 * state.omega, qd * body.axis);
+    }
+    else
+    {
+      state.omega     = omega_in + qd * body.axis;
+      state.omega_dot = transposeTimes(r, parent_omega_dot) + qdd * body.axis + cross(omega_in, qd * body.axis);
+    }
+
+    // Net force and torque (about the centre of mass) acting on the body
+    const Vector3 com_acceleration = state.acceleration + cross(state.omega_dot, body.com) +
+                                     cross(state.omega, cross(state.omega, body.com));
+    state.force  = body.mass * com_acceleration;
+    state.torque = body.inertia * state.omega_dot + cross(state.omega, body.inertia * state.omega);
+
+    parent_omega        = state.omega;
+    parent_omega_dot    = state.omega_dot;
+    parent_acceleration = state.acceleration;
+  }
+
+  // Backward pass: forces and torques transmitted through each joint, about the joint frame origin
+  for (unsigned int i = n_bodies; i > 0; --i)
+  {
+    const Body& body = bodies_[i - 1];
+    BodyState& state = states_[i - 1];
+
+    state.torque = state.torque + cross(body.com, state.force);
+    if (i < n_bodies)
+    {
+      const BodyState& child = states_[i];
+      const Vector3 child_force = child.pose.rotation * child.force;
+      state.force  = state.force + child_force;
+      state.torque = state.torque + child.pose.rotation * child.torque + cross(child.pose.translation, child_force);
+    }
+
+    effort[body.index] = dot(body.prismatic ? state.force : state.torque, body.axis);
+  }
+}
+
+} // namespace
+
+#endif // header guard
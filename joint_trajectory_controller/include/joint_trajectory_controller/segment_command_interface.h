@@ -0,0 +1,162 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER_SEGMENT_COMMAND_INTERFACE_H
+#define JOINT_TRAJECTORY_CONTROLLER_SEGMENT_COMMAND_INTERFACE_H
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <hardware_interface/internal/hardware_resource_manager.h>
+#include <hardware_interface/joint_state_interface.h>
+
+namespace joint_trajectory_controller
+{
+
+/**
+ * \brief One-dimensional polynomial trajectory segment, to be interpolated by a drive.
+ */
+struct SegmentCommand
+{
+  SegmentCommand() : start_time(0.0), duration(0.0) {coefficients.fill(0.0);}
+
+  double start_time;                  ///< ROS time at which the segment starts, in seconds.
+  double duration;                    ///< Segment duration. The end position is held afterwards.
+  std::array<double, 6> coefficients; ///< Position polynomial, in increasing powers of the time since \p start_time.
+};
+
+/**
+ * \brief Bounded queue of the upcoming trajectory segments of a joint.
+ *
+ * Queues are owned by the robot hardware abstraction, which sets their capacity. The controller pushes segments ahead
+ * of time, and the hardware abstraction pops them as it forwards them to the drive. As with other joint handles, both
+ * sides are meant to access the queue from the control thread, so it is not synchronized.
+ *
+ * When the trajectory is replaced, the controller clears the queue, which increments its \ref generation. Segments of
+ * an older generation already forwarded to the drive must then be discarded, as the queue starts over with the segment
+ * active at the time of the replacement.
+ */
+class SegmentQueue
+{
+public:
+  explicit SegmentQueue(std::size_t capacity = 8) : segments_(capacity), head_(0), size_(0), generation_(0) {}
+
+  std::size_t capacity()   const {return segments_.size();}
+  std::size_t size()       const {return size_;}
+  bool        empty()      const {return size_ == 0;}
+  bool        full()       const {return size_ == segments_.size();}
+  unsigned    generation() const {return generation_;}
+
+  /** \return False if the queue is full, in which case \p segment is not queued. */
+  bool push(const SegmentCommand& segment)
+  {
+    if (full()) {return false;}
+    segments_[(head_ + size_) % segments_.size()] = segment;
+    ++size_;
+    return true;
+  }
+
+  /** \pre The queue is not empty. */
+  const SegmentCommand& front() const
+  {
+    assert(!empty());
+    return segments_[head_];
+  }
+
+  /** \pre The queue is not empty. */
+  void pop()
+  {
+    assert(!empty());
+    head_ = (head_ + 1) % segments_.size();
+    --size_;
+  }
+
+  /** \brief Drop all queued segments and start a new generation. */
+  void clear()
+  {
+    head_ = 0;
+    size_ = 0;
+    ++generation_;
+  }
+
+private:
+  std::vector<SegmentCommand> segments_;
+  std::size_t                 head_;
+  std::size_t                 size_;
+  unsigned                    generation_;
+};
+
+/**
+ * \brief Handle to read the state of a joint and stream trajectory segments to it.
+ */
+class SegmentJointHandle : public hardware_interface::JointStateHandle
+{
+public:
+  SegmentJointHandle() : queue_(0) {}
+
+  /**
+   * \param js Joint state handle.
+   * \param queue Segment queue of the joint.
+   */
+  SegmentJointHandle(const hardware_interface::JointStateHandle& js, SegmentQueue* queue)
+    : hardware_interface::JointStateHandle(js), queue_(queue)
+  {
+    if (!queue_)
+    {
+      throw hardware_interface::HardwareInterfaceException("Cannot create handle '" + js.getName() +
+                                                           "'. Segment queue pointer is null.");
+    }
+  }
+
+  SegmentQueue* getQueue() const {assert(queue_); return queue_;}
+
+private:
+  SegmentQueue* queue_;
+};
+
+/**
+ * \brief Hardware interface to stream trajectory segments to joints whose drives interpolate them.
+ *
+ * This is a \ref HardwareResourceManager for exclusive access to segment streaming joints.
+ */
+class SegmentJointInterface
+  : public hardware_interface::HardwareResourceManager<SegmentJointHandle, hardware_interface::ClaimResources>
+{};
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,145 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER_TIME_WARPING_H
+#define JOINT_TRAJECTORY_CONTROLLER_TIME_WARPING_H
+
+#include <algorithm>
+
+namespace joint_trajectory_controller
+{
+
+/**
+ * \brief Slows down the trajectory clock while joints lag behind their desired path.
+ *
+ * The trajectory clock advances \ref scale seconds per second of real time. The scale is 1 while the tracking error
+ * stays below \p slowdown_error_ratio times the path tolerance, decreases linearly to \p min_scale as the error grows
+ * up to the tolerance, and never goes below it. The clock slows down immediately, but recovers at most at
+ * \p recovery_rate per second, so that the desired velocity does not jump back when the error shrinks.
+ *
+ * Path tolerance violations are tolerated for up to \p max_violation_duration seconds of real time. Errors are only
+ * measured relative to a positive path tolerance, so joints without one never slow the clock down.
+ *
+ * All methods except \ref init are realtime-safe.
+ */
+template <class Scalar>
+class TimeWarping
+{
+public:
+  struct Parameters
+  {
+    Parameters()
+      : min_scale(0.1),
+        slowdown_error_ratio(0.5),
+        recovery_rate(1.0),
+        max_violation_duration(1.0)
+    {}
+
+    Scalar min_scale;              ///< Smallest clock scale, in (0, 1].
+    Scalar slowdown_error_ratio;   ///< Fraction of the path tolerance at which slowing down starts, in [0, 1).
+    Scalar recovery_rate;          ///< Largest clock scale increase per second. Positive.
+    Scalar max_violation_duration; ///< Longest path tolerance violation tolerated, in seconds. Non-negative.
+  };
+
+  TimeWarping() {reset();}
+
+  /** \return True if \p parameters are valid, in which case they are used from now on. */
+  bool init(const Parameters& parameters)
+  {
+    if (!(parameters.min_scale > 0.0 && parameters.min_scale <= 1.0) ||
+        !(parameters.slowdown_error_ratio >= 0.0 && parameters.slowdown_error_ratio < 1.0) ||
+        !(parameters.recovery_rate > 0.0) ||
+        !(parameters.max_violation_duration >= 0.0))
+    {
+      return false;
+    }
+    parameters_ = parameters;
+    reset();
+    return true;
+  }
+
+  /** \brief Run at real-time speed, forgetting past tolerance violations and the accumulated delay. */
+  void reset()
+  {
+    scale_              = static_cast<Scalar>(1.0);
+    delay_              = static_cast<Scalar>(0.0);
+    violation_duration_ = static_cast<Scalar>(0.0);
+  }
+
+  /**
+   * \brief Advance the clock by a control cycle.
+   * \return How much the trajectory clock advances during a cycle of duration \p period.
+   */
+  Scalar advance(const Scalar& period)
+  {
+    delay_ += (static_cast<Scalar>(1.0) - scale_) * period;
+    return scale_ * period;
+  }
+
+  /**
+   * \brief Update the clock scale from the tracking error of the last control cycle.
+   * \param error_ratio Largest ratio between the absolute position error of a joint and its path tolerance.
+   * \param tolerance_violated Whether any path tolerance was violated.
+   * \param period Duration of the last control cycle.
+   * \return True if the path tolerances have been violated for longer than \p max_violation_duration.
+   */
+  bool update(const Scalar& error_ratio, bool tolerance_violated, const Scalar& period)
+  {
+    // Target scale, linear in the error ratio between the slowdown ratio and the tolerance
+    const Scalar slowdown_range = static_cast<Scalar>(1.0) - parameters_.slowdown_error_ratio;
+    const Scalar slowdown = (error_ratio - parameters_.slowdown_error_ratio) / slowdown_range;
+    const Scalar target = std::max(parameters_.min_scale,
+                                   static_cast<Scalar>(1.0) -
+                                   std::max(static_cast<Scalar>(0.0), slowdown) * (1.0 - parameters_.min_scale));
+
+    scale_ = target < scale_ ? target : std::min(target, scale_ + parameters_.recovery_rate * period);
+
+    if (tolerance_violated) {violation_duration_ += period;}
+    else                    {violation_duration_ = static_cast<Scalar>(0.0);}
+    return violation_duration_ > parameters_.max_violation_duration;
+  }
+
+  Scalar scale() const {return scale_;} ///< Trajectory clock seconds per real-time second.
+  Scalar delay() const {return delay_;} ///< How far the trajectory clock lags behind real time.
+
+private:
+  Parameters parameters_;
+  Scalar     scale_;
+  Scalar     delay_;
+  Scalar     violation_duration_;
+};
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,197 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER_TRACKING_STATISTICS_H
+#define JOINT_TRAJECTORY_CONTROLLER_TRACKING_STATISTICS_H
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include <joint_trajectory_controller/tolerances.h>
+
+namespace joint_trajectory_controller
+{
+
+/**
+ * \brief Tracking error statistics of a trajectory goal, accumulated one control cycle at a time.
+ *
+ * Storage is allocated by \ref resize, all other methods are realtime-safe and run in constant time per joint.
+ *
+ * Tolerance margins are the distance between a tolerance and the absolute error it bounds, so they become negative
+ * when the tolerance is violated. They are NaN for tolerances that are not set, and while no sample has been taken.
+ */
+template <class Scalar>
+class TrackingStatistics
+{
+public:
+  struct JointStatistics
+  {
+    JointStatistics() {reset();}
+
+    void reset()
+    {
+      const Scalar nan = std::numeric_limits<Scalar>::quiet_NaN();
+      samples                   = 0;
+      sum_sq_position_error     = static_cast<Scalar>(0.0);
+      sum_sq_velocity_error     = static_cast<Scalar>(0.0);
+      max_position_error        = static_cast<Scalar>(0.0);
+      max_velocity_error        = static_cast<Scalar>(0.0);
+      min_path_position_margin  = nan;
+      min_path_velocity_margin  = nan;
+      goal_position_margin      = nan;
+      goal_velocity_margin      = nan;
+      settling_time             = nan;
+      settled                   = false;
+    }
+
+    Scalar rmsPositionError() const {return rms(sum_sq_position_error);}
+    Scalar rmsVelocityError() const {return rms(sum_sq_velocity_error);}
+
+    std::size_t samples;               ///< Number of control cycles accumulated.
+    Scalar      sum_sq_position_error;
+    Scalar      sum_sq_velocity_error;
+    Scalar      max_position_error;    ///< Largest absolute position error.
+    Scalar      max_velocity_error;    ///< Largest absolute velocity error.
+    Scalar      min_path_position_margin;
+    Scalar      min_path_velocity_margin;
+    Scalar      goal_position_margin;  ///< Goal position tolerance margin when the joint settled.
+    Scalar      goal_velocity_margin;  ///< Goal velocity tolerance margin when the joint settled.
+    Scalar      settling_time;         ///< Time from the end of the joint trajectory until it met its goal tolerances.
+    bool        settled;
+
+  private:
+    Scalar rms(const Scalar& sum_sq) const
+    {
+      return samples ? std::sqrt(sum_sq / samples) : static_cast<Scalar>(0.0);
+    }
+  };
+
+  TrackingStatistics() : start_time_(0.0), end_time_(0.0) {}
+
+  /** \brief Allocate storage for \p n_joints joints and reset them. \note Not realtime-safe. */
+  void resize(std::size_t n_joints)
+  {
+    joints_.resize(n_joints);
+    reset(static_cast<Scalar>(0.0));
+  }
+
+  /** \brief Discard all samples, and start accumulating for a goal that becomes active at \p start_time. */
+  void reset(const Scalar& start_time)
+  {
+    for (std::size_t i = 0; i < joints_.size(); ++i) {joints_[i].reset();}
+    start_time_ = start_time;
+    end_time_   = start_time;
+  }
+
+  /**
+   * \brief Accumulate the tracking error of a joint at \p time.
+   * \param path_tolerance Tolerances applying to \p joint at \p time, or null if it is no longer executing its path.
+   */
+  void addSample(std::size_t                    joint,
+                 const Scalar&                  time,
+                 const Scalar&                  position_error,
+                 const Scalar&                  velocity_error,
+                 const StateTolerances<Scalar>* path_tolerance = nullptr)
+  {
+    using std::abs;
+    JointStatistics& stats = joints_[joint];
+    const Scalar abs_position_error = abs(position_error);
+    const Scalar abs_velocity_error = abs(velocity_error);
+
+    ++stats.samples;
+    stats.sum_sq_position_error += position_error * position_error;
+    stats.sum_sq_velocity_error += velocity_error * velocity_error;
+    if (abs_position_error > stats.max_position_error) {stats.max_position_error = abs_position_error;}
+    if (abs_velocity_error > stats.max_velocity_error) {stats.max_velocity_error = abs_velocity_error;}
+
+    if (path_tolerance)
+    {
+      updateMinMargin(path_tolerance->position, abs_position_error, stats.min_path_position_margin);
+      updateMinMargin(path_tolerance->velocity, abs_velocity_error, stats.min_path_velocity_margin);
+    }
+
+    if (time > end_time_) {end_time_ = time;}
+  }
+
+  /**
+   * \brief Record that a joint met its goal tolerances.
+   *
+   * Only the first call after a \ref reset has an effect.
+   * \param settling_time Time elapsed since the end of the joint trajectory.
+   */
+  void setSettled(std::size_t                    joint,
+                  const Scalar&                  settling_time,
+                  const Scalar&                  position_error,
+                  const Scalar&                  velocity_error,
+                  const StateTolerances<Scalar>& goal_tolerance)
+  {
+    using std::abs;
+    JointStatistics& stats = joints_[joint];
+    if (stats.settled) {return;}
+
+    stats.settled       = true;
+    stats.settling_time = settling_time;
+    stats.goal_position_margin = margin(goal_tolerance.position, abs(position_error));
+    stats.goal_velocity_margin = margin(goal_tolerance.velocity, abs(velocity_error));
+  }
+
+  std::size_t size() const {return joints_.size();}
+  const JointStatistics& operator[](std::size_t joint) const {return joints_[joint];}
+
+  Scalar startTime() const {return start_time_;} ///< Time at which the goal became active.
+  Scalar endTime()   const {return end_time_;}   ///< Time of the last sample.
+
+private:
+  std::vector<JointStatistics> joints_;
+  Scalar start_time_;
+  Scalar end_time_;
+
+  static Scalar margin(const Scalar& tolerance, const Scalar& abs_error)
+  {
+    return tolerance > 0.0 ? tolerance - abs_error : std::numeric_limits<Scalar>::quiet_NaN();
+  }
+
+  static void updateMinMargin(const Scalar& tolerance, const Scalar& abs_error, Scalar& min_margin)
+  {
+    if (!(tolerance > 0.0)) {return;}
+    const Scalar new_margin = tolerance - abs_error;
+    if (std::isnan(min_margin) || new_margin < min_margin) {min_margin = new_margin;}
+  }
+};
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,191 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER_WORKER_POOL_H
+#define JOINT_TRAJECTORY_CONTROLLER_WORKER_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <ros/console.h>
+
+namespace joint_trajectory_controller
+{
+
+/**
+ * \brief Fixed-size pool of worker threads running batches of independent tasks.
+ *
+ * Workers run with the default, non-realtime scheduling policy, regardless of the policy of the thread creating the
+ * pool. A warning is logged if a worker fails to switch to it. They are meant for expensive non-realtime work, such as building long trajectories, and must never be used
+ * from the realtime loop.
+ */
+class WorkerPool
+{
+public:
+  /** \param n_threads Number of worker threads. With no threads, tasks run on the calling thread. */
+  explicit WorkerPool(unsigned int n_threads)
+    : task_(nullptr),
+      errors_(nullptr),
+      n_tasks_(0),
+      next_task_(0),
+      pending_tasks_(0),
+      stopped_(false)
+  {
+    for (unsigned int i = 0; i < n_threads; ++i)
+    {
+      threads_.emplace_back(&WorkerPool::workerLoop, this);
+    }
+  }
+
+  ~WorkerPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+    }
+    work_cond_.notify_all();
+    for (std::thread& thread : threads_) {thread.join();}
+  }
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  /** \return Number of worker threads. */
+  unsigned int size() const {return threads_.size();}
+
+  /**
+   * \brief Run \p task for every index in <tt>[0, n_tasks)</tt> and wait for all of them to finish.
+   *
+   * Tasks may run in any order and concurrently, so they must only write to data owned by their index. Batches
+   * submitted from different threads are serialized.
+   *
+   * \throw If one or more tasks throw, the exception of the task with the lowest index is rethrown once all tasks
+   * are done, so that the outcome does not depend on scheduling.
+   */
+  void run(std::size_t n_tasks, const std::function<void(std::size_t)>& task)
+  {
+    if (n_tasks == 0) {return;}
+
+    std::lock_guard<std::mutex> run_lock(run_mutex_);
+    std::vector<std::exception_ptr> errors(n_tasks);
+    if (threads_.empty())
+    {
+      for (std::size_t index = 0; index < n_tasks; ++index)
+      {
+        try {task(index);}
+        catch (...) {errors[index] = std::current_exception();}
+      }
+    }
+    else
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      task_          = &task;
+      errors_        = &errors;
+      n_tasks_       = n_tasks;
+      next_task_     = 0;
+      pending_tasks_ = n_tasks;
+      work_cond_.notify_all();
+      done_cond_.wait(lock, [this] {return pending_tasks_ == 0;});
+      task_   = nullptr;
+      errors_ = nullptr;
+    }
+
+    for (const std::exception_ptr& error : errors)
+    {
+      if (error) {std::rethrow_exception(error);}
+    }
+  }
+
+private:
+  std::vector<std::thread>                 threads_;
+  std::mutex                               run_mutex_;
+  std::mutex                               mutex_;
+  std::condition_variable                  work_cond_;
+  std::condition_variable                  done_cond_;
+  const std::function<void(std::size_t)>*  task_;
+  std::vector<std::exception_ptr>*         errors_;
+  std::size_t                              n_tasks_;
+  std::size_t                              next_task_;
+  std::size_t                              pending_tasks_;
+  bool                                     stopped_;
+
+  void workerLoop()
+  {
+    // Do not inherit a realtime policy from the creating thread. If that fails, the worker keeps running with it, and
+    // may compete with the realtime loop
+    sched_param param;
+    param.sched_priority = 0;
+    const int error = pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+    if (error != 0)
+    {
+      ROS_WARN_STREAM("Failed to set the default scheduling policy of a worker thread: " << std::strerror(error) <<
+                      ". It keeps the policy of the thread that created it.");
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+      work_cond_.wait(lock, [this] {return stopped_ || next_task_ < n_tasks_;});
+      if (stopped_) {return;}
+
+      const std::size_t index = next_task_++;
+      const std::function<void(std::size_t)>& task = *task_;
+      std::vector<std::exception_ptr>& errors = *errors_;
+
+      lock.unlock();
+      try {task(index);}
+      catch (...) {errors[index] = std::current_exception();}
+      lock.lock();
+
+      if (--pending_tasks_ == 0)
+      {
+        n_tasks_ = 0;
+        done_cond_.notify_all();
+      }
+    }
+  }
+};
+
+} // namespace
+
+#endif // header guard
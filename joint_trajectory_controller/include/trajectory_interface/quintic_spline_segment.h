@@ -32,8 +32,10 @@
 #define TRAJECTORY_INTERFACE_QUINTIC_SPLINE_SEGMENT_H
 
 #include <array>
+#include <cstddef>
 #include <iterator>
 #include <stdexcept>
+#include <boost/container/small_vector.hpp>
 #include <trajectory_interface/pos_vel_acc_state.h>
 
 namespace trajectory_interface
@@ -52,6 +54,22 @@ public:
   typedef Scalar                 Time;
   typedef PosVelAccState<Scalar> State;
 
+  /** Coefficients of a one-dimensional quintic polynomial, in increasing order of the power of time. */
+  typedef std::array<Scalar, 6> SplineCoefficients;
+
+  /**
+   * \brief Powers of a segment duration used when computing spline coefficients.
+   *
+   * They depend only on the segment duration, so they can be computed once and shared by all the dimensions (or
+   * joints) spanning the same pair of knots. Reciprocals are zero for a zero duration, which makes the coefficient
+   * formulas degrade gracefully to a constant (or constant-acceleration) segment.
+   */
+  struct DurationPowers
+  {
+    Scalar power[3];   ///< T^0, T^1, T^2
+    Scalar inverse[6]; ///< T^0, T^-1, ..., T^-5
+  };
+
   /**
    * \brief Creates an empty segment.
    *
@@ -120,7 +138,7 @@ public:
     state.acceleration.resize(coefs_.size());
 
     // Sample each dimension
-    typedef typename std::vector<SplineCoefficients>::const_iterator ConstIterator;
+    typedef typename CoefficientsVector::const_iterator ConstIterator;
     for(ConstIterator coefs_it = coefs_.begin(); coefs_it != coefs_.end(); ++coefs_it)
     {
       const typename std::vector<Scalar>::size_type id = std::distance(coefs_.begin(), coefs_it);
@@ -139,14 +157,62 @@ public:
   /** \return Segment size (dimension). */
   unsigned int size() const {return coefs_.size();}
 
+  /**
+   * \return Spline coefficients of dimension \p dim, in increasing order of the power of the time elapsed since
+   * \ref startTime.
+   */
+  const SplineCoefficients& coefficients(unsigned int dim = 0) const {return coefs_[dim];}
+
+  /**
+   * \brief Initialize a one-dimensional segment from precomputed coefficients.
+   *
+   * \param start_time Segment start time.
+   * \param end_time Segment end time.
+   * \param coefficients Spline coefficients, see \ref computeCoefficients.
+   *
+   * \throw std::invalid_argument If the \p end_time is earlier than \p start_time.
+   */
+  void init(const Time& start_time, const Time& end_time, const SplineCoefficients& coefficients);
+
+  /** \return Powers of \p duration used to compute spline coefficients. */
+  static DurationPowers durationPowers(const Time& duration);
+
+  /**
+   * \brief Compute the coefficients of the one-dimensional segments joining consecutive knots, all at once.
+   *
+   * Segment \c k joins knots \c k and \c k+1. The interpolation order is chosen once for the whole batch, following
+   * the same rules as \ref init: linear if \p velocities is null, cubic if \p accelerations is null, quintic
+   * otherwise. The inputs are laid out as contiguous arrays and the loops are branch-free, so that the compiler can
+   * vectorize them.
+   *
+   * \param n_segments Number of segments.
+   * \param powers Duration powers of each segment. Size \p n_segments.
+   * \param positions Knot positions. Size <tt>n_segments + 1</tt>.
+   * \param velocities Knot velocities. Size <tt>n_segments + 1</tt>, or null.
+   * \param accelerations Knot accelerations. Size <tt>n_segments + 1</tt>, or null.
+   * \param[out] coefficients Segment coefficients. Size \p n_segments.
+   */
+  static void computeCoefficients(std::size_t           n_segments,
+                                  const DurationPowers* powers,
+                                  const Scalar*         positions,
+                                  const Scalar*         velocities,
+                                  const Scalar*         accelerations,
+                                  SplineCoefficients*   coefficients);
+
 private:
-  typedef std::array<Scalar, 6> SplineCoefficients;
+
+  /**
+   * Coefficients of one-dimensional segments, the only kind the joint trajectory controller builds, are stored inline.
+   * A trajectory is then a contiguous array of segments allocated in one chunk, which also improves locality when
+   * sampling it.
+   */
+  typedef boost::container::small_vector<SplineCoefficients, 1> CoefficientsVector;
 
   /** Coefficients represent a quintic polynomial like so:
    *
    * <tt> coefs_[0] + coefs_[1]*x + coefs_[2]*x^2 + coefs_[3]*x^3 + coefs_[4]*x^4 + coefs_[5]*x^5 </tt>
    */
-  std::vector<SplineCoefficients> coefs_;
+  CoefficientsVector coefs_;
   Time duration_;
   Time start_time_;
 
@@ -156,17 +222,17 @@ private:
 
   static void computeCoefficients(const Scalar& start_pos,
                                   const Scalar& end_pos,
-                                  const Scalar& time,
+                                  const DurationPowers& T,
                                   SplineCoefficients& coefficients);
 
   static void computeCoefficients(const Scalar& start_pos, const Scalar& start_vel,
                                   const Scalar& end_pos,   const Scalar& end_vel,
-                                  const Scalar& time,
+                                  const DurationPowers& T,
                                   SplineCoefficients& coefficients);
 
   static void computeCoefficients(const Scalar& start_pos, const Scalar& start_vel, const Scalar& start_acc,
                                   const Scalar& end_pos,   const Scalar& end_vel,   const Scalar& end_acc,
-                                  const Scalar& time,
+                                  const DurationPowers& T,
                                   SplineCoefficients& coefficients);
 
   static void sample(const SplineCoefficients& coefficients, const Scalar& time,
@@ -221,10 +287,11 @@ void QuinticSplineSegment<ScalarType>::init(const Time&  start_time,
   start_time_ = start_time;
   duration_   = end_time - start_time;
 
-  // Spline coefficients
+  // Spline coefficients. Duration powers are shared by all dimensions
   coefs_.resize(dim);
+  const DurationPowers powers = durationPowers(duration_);
 
-  typedef typename std::vector<SplineCoefficients>::iterator Iterator;
+  typedef typename CoefficientsVector::iterator Iterator;
   if (!has_velocity)
   {
     // Linear interpolation
@@ -234,7 +301,7 @@ void QuinticSplineSegment<ScalarType>::init(const Time&  start_time,
 
       computeCoefficients(start_state.position[id],
                           end_state.position[id],
-                          duration_,
+                          powers,
                           *coefs_it);
     }
   }
@@ -247,7 +314,7 @@ void QuinticSplineSegment<ScalarType>::init(const Time&  start_time,
 
       computeCoefficients(start_state.position[id], start_state.velocity[id],
                           end_state.position[id],   end_state.velocity[id],
-                          duration_,
+                          powers,
                           *coefs_it);
     }
   }
@@ -260,7 +327,7 @@ void QuinticSplineSegment<ScalarType>::init(const Time&  start_time,
 
       computeCoefficients(start_state.position[id], start_state.velocity[id], start_state.acceleration[id],
                           end_state.position[id],   end_state.velocity[id],   end_state.acceleration[id],
-                          duration_,
+                          powers,
                           *coefs_it);
     }
   }
@@ -277,14 +344,43 @@ inline void QuinticSplineSegment<ScalarType>::generatePowers(int n, const Scalar
 }
 
 template<class ScalarType>
-void QuinticSplineSegment<ScalarType>::
+void QuinticSplineSegment<ScalarType>::init(const Time&               start_time,
+                                            const Time&               end_time,
+                                            const SplineCoefficients& coefficients)
+{
+  if (end_time < start_time)
+  {
+    throw(std::invalid_argument("Quintic spline segment can't be constructed: end_time < start_time."));
+  }
+  start_time_ = start_time;
+  duration_   = end_time - start_time;
+  if (coefs_.size() != 1) {coefs_.resize(1);}
+  coefs_.front() = coefficients;
+}
+
+template<class ScalarType>
+inline typename QuinticSplineSegment<ScalarType>::DurationPowers
+QuinticSplineSegment<ScalarType>::durationPowers(const Time& duration)
+{
+  DurationPowers T;
+  T.power[0] = 1.0;
+  T.power[1] = duration;
+  T.power[2] = duration * duration;
+
+  const Scalar inv = (duration == 0.0) ? 0.0 : 1.0 / duration;
+  generatePowers(5, inv, T.inverse);
+  return T;
+}
+
+template<class ScalarType>
+inline void QuinticSplineSegment<ScalarType>::
 computeCoefficients(const Scalar& start_pos,
                     const Scalar& end_pos,
-                    const Scalar& time,
+                    const DurationPowers& T,
                     SplineCoefficients& coefficients)
 {
   coefficients[0] = start_pos;
-  coefficients[1] = (time == 0.0) ? 0.0 : (end_pos - start_pos) / time;
+  coefficients[1] = (end_pos - start_pos) * T.inverse[1];
   coefficients[2] = 0.0;
   coefficients[3] = 0.0;
   coefficients[4] = 0.0;
@@ -292,63 +388,71 @@ computeCoefficients(const Scalar& start_pos,
 }
 
 template<class ScalarType>
-void QuinticSplineSegment<ScalarType>::
+inline void QuinticSplineSegment<ScalarType>::
 computeCoefficients(const Scalar& start_pos, const Scalar& start_vel,
                     const Scalar& end_pos,   const Scalar& end_vel,
-                    const Scalar& time,
+                    const DurationPowers& T,
                     SplineCoefficients& coefficients)
 {
-  if (time == 0.0)
-  {
-    coefficients[0] = start_pos;
-    coefficients[1] = start_vel;
-    coefficients[2] = 0.0;
-    coefficients[3] = 0.0;
-  }
-  else
-  {
-    Scalar T[4];
-    generatePowers(3, time, T);
-
-    coefficients[0] = start_pos;
-    coefficients[1] = start_vel;
-    coefficients[2] = (-3.0*start_pos + 3.0*end_pos - 2.0*start_vel*T[1] - end_vel*T[1]) / T[2];
-    coefficients[3] = (2.0*start_pos - 2.0*end_pos + start_vel*T[1] + end_vel*T[1]) / T[3];
-  }
+  coefficients[0] = start_pos;
+  coefficients[1] = start_vel;
+  coefficients[2] = (-3.0*start_pos + 3.0*end_pos - 2.0*start_vel*T.power[1] - end_vel*T.power[1]) * T.inverse[2];
+  coefficients[3] = (2.0*start_pos - 2.0*end_pos + start_vel*T.power[1] + end_vel*T.power[1]) * T.inverse[3];
   coefficients[4] = 0.0;
   coefficients[5] = 0.0;
 }
 
 template<class ScalarType>
-void QuinticSplineSegment<ScalarType>::
+inline void QuinticSplineSegment<ScalarType>::
 computeCoefficients(const Scalar& start_pos, const Scalar& start_vel, const Scalar& start_acc,
                     const Scalar& end_pos,   const Scalar& end_vel,   const Scalar& end_acc,
-                    const Scalar& time,
+                    const DurationPowers& T,
                     SplineCoefficients& coefficients)
 {
-  if (time == 0.0)
+  coefficients[0] = start_pos;
+  coefficients[1] = start_vel;
+  coefficients[2] = 0.5*start_acc;
+  coefficients[3] = (-20.0*start_pos + 20.0*end_pos - 3.0*start_acc*T.power[2] + end_acc*T.power[2] -
+                     12.0*start_vel*T.power[1] - 8.0*end_vel*T.power[1]) * 0.5 * T.inverse[3];
+  coefficients[4] = (30.0*start_pos - 30.0*end_pos + 3.0*start_acc*T.power[2] - 2.0*end_acc*T.power[2] +
+                     16.0*start_vel*T.power[1] + 14.0*end_vel*T.power[1]) * 0.5 * T.inverse[4];
+  coefficients[5] = (-12.0*start_pos + 12.0*end_pos - start_acc*T.power[2] + end_acc*T.power[2] -
+                     6.0*start_vel*T.power[1] - 6.0*end_vel*T.power[1]) * 0.5 * T.inverse[5];
+}
+
+template<class ScalarType>
+void QuinticSplineSegment<ScalarType>::
+computeCoefficients(std::size_t           n_segments,
+                    const DurationPowers* powers,
+                    const Scalar*         positions,
+                    const Scalar*         velocities,
+                    const Scalar*         accelerations,
+                    SplineCoefficients*   coefficients)
+{
+  if (!velocities)
   {
-    coefficients[0] = start_pos;
-    coefficients[1] = start_vel;
-    coefficients[2] = 0.5*start_acc;
-    coefficients[3] = 0.0;
-    coefficients[4] = 0.0;
-    coefficients[5] = 0.0;
+    for (std::size_t k = 0; k < n_segments; ++k)
+    {
+      computeCoefficients(positions[k], positions[k + 1], powers[k], coefficients[k]);
+    }
+  }
+  else if (!accelerations)
+  {
+    for (std::size_t k = 0; k < n_segments; ++k)
+    {
+      computeCoefficients(positions[k],     velocities[k],
+                          positions[k + 1], velocities[k + 1],
+                          powers[k], coefficients[k]);
+    }
   }
   else
   {
-    Scalar T[6];
-    generatePowers(5, time, T);
-
-    coefficients[0] = start_pos;
-    coefficients[1] = start_vel;
-    coefficients[2] = 0.5*start_acc;
-    coefficients[3] = (-20.0*start_pos + 20.0*end_pos - 3.0*start_acc*T[2] + end_acc*T[2] -
-                       12.0*start_vel*T[1] - 8.0*end_vel*T[1]) / (2.0*T[3]);
-    coefficients[4] = (30.0*start_pos - 30.0*end_pos + 3.0*start_acc*T[2] - 2.0*end_acc*T[2] +
-                       16.0*start_vel*T[1] + 14.0*end_vel*T[1]) / (2.0*T[4]);
-    coefficients[5] = (-12.0*start_pos + 12.0*end_pos - start_acc*T[2] + end_acc*T[2] -
-                       6.0*start_vel*T[1] - 6.0*end_vel*T[1]) / (2.0*T[5]);
+    for (std::size_t k = 0; k < n_segments; ++k)
+    {
+      computeCoefficients(positions[k],     velocities[k],     accelerations[k],
+                          positions[k + 1], velocities[k + 1], accelerations[k + 1],
+                          powers[k], coefficients[k]);
+    }
   }
 }
 
@@ -64,6 +64,18 @@ namespace effort_controllers
   typedef joint_trajectory_controller::JointTrajectoryController<trajectory_interface::QuinticSplineSegment<double>,
                                                                  hardware_interface::EffortJointInterface>
           JointTrajectoryController;
+
+  /**
+   * \brief Joint trajectory controller that represents trajectory segments as <b>quintic splines</b> and sends
+   * commands to an \b effort interface, computed by a joint impedance law with stiffness and damping interpolated
+   * along the trajectory.
+   */
+  typedef joint_trajectory_controller::JointTrajectorySegment<trajectory_interface::QuinticSplineSegment<double> >
+          QuinticSplineJointSegment;
+  typedef joint_trajectory_controller::JointTrajectoryController<trajectory_interface::QuinticSplineSegment<double>,
+                                                                 hardware_interface::EffortJointInterface,
+                                                                 JointImpedanceHardwareInterfaceAdapter<QuinticSplineJointSegment::State> >
+          JointImpedanceTrajectoryController;
 }
 
 namespace pos_vel_controllers
@@ -88,8 +100,21 @@ namespace pos_vel_acc_controllers
           JointTrajectoryController;
 }
 
+namespace segment_streaming_controllers
+{
+  /**
+   * \brief Joint trajectory controller that represents trajectory segments as <b>quintic splines</b> and streams
+   * them ahead of time to a \b segment interface, for drives that interpolate them onboard.
+   */
+  typedef joint_trajectory_controller::JointTrajectoryController<trajectory_interface::QuinticSplineSegment<double>,
+                                                                 joint_trajectory_controller::SegmentJointInterface>
+          JointTrajectoryController;
+}
+
 PLUGINLIB_EXPORT_CLASS(position_controllers::JointTrajectoryController, controller_interface::ControllerBase)
 PLUGINLIB_EXPORT_CLASS(velocity_controllers::JointTrajectoryController, controller_interface::ControllerBase)
 PLUGINLIB_EXPORT_CLASS(effort_controllers::JointTrajectoryController,   controller_interface::ControllerBase)
+PLUGINLIB_EXPORT_CLASS(effort_controllers::JointImpedanceTrajectoryController, controller_interface::ControllerBase)
 PLUGINLIB_EXPORT_CLASS(pos_vel_controllers::JointTrajectoryController,   controller_interface::ControllerBase)
 PLUGINLIB_EXPORT_CLASS(pos_vel_acc_controllers::JointTrajectoryController,   controller_interface::ControllerBase)
+PLUGINLIB_EXPORT_CLASS(segment_streaming_controllers::JointTrajectoryController, controller_interface::ControllerBase)
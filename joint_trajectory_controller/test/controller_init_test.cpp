@@ -0,0 +1,152 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+#include <hardware_interface/joint_command_interface.h>
+#include <hardware_interface/joint_state_interface.h>
+#include <trajectory_interface/quintic_spline_segment.h>
+#include <joint_trajectory_controller/joint_trajectory_controller.h>
+#include <joint_trajectory_controller/segment_command_interface.h>
+
+typedef trajectory_interface::QuinticSplineSegment<double> SegmentImpl;
+typedef joint_trajectory_controller::JointTrajectorySegment<SegmentImpl>::State State;
+typedef joint_trajectory_controller::JointTrajectoryController<SegmentImpl, hardware_interface::EffortJointInterface,
+        JointImpedanceHardwareInterfaceAdapter<State> > JointImpedanceTrajectoryController;
+typedef joint_trajectory_controller::JointTrajectoryController<SegmentImpl, hardware_interface::EffortJointInterface>
+        EffortJointTrajectoryController;
+typedef HardwareInterfaceAdapter<hardware_interface::EffortJointInterface, State> EffortHardwareInterfaceAdapter;
+typedef HardwareInterfaceAdapter<joint_trajectory_controller::SegmentJointInterface, State>
+        SegmentHardwareInterfaceAdapter;
+
+/**
+ * \brief Effort-controlled hardware with the joints of the RRbot model.
+ */
+class EffortRobot
+{
+public:
+  EffortRobot()
+  {
+    const char* names[] = {"joint1", "joint2"};
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+      pos_[i] = vel_[i] = eff_[i] = cmd_[i] = 0.0;
+      hardware_interface::JointStateHandle state_handle(names[i], &pos_[i], &vel_[i], &eff_[i]);
+      effort_iface.registerHandle(hardware_interface::JointHandle(state_handle, &cmd_[i]));
+    }
+  }
+
+  std::vector<hardware_interface::JointHandle> getHandles()
+  {
+    std::vector<hardware_interface::JointHandle> handles;
+    for (const std::string& name : effort_iface.getNames()) {handles.push_back(effort_iface.getHandle(name));}
+    return handles;
+  }
+
+  hardware_interface::EffortJointInterface effort_iface;
+
+private:
+  double pos_[2];
+  double vel_[2];
+  double eff_[2];
+  double cmd_[2];
+};
+
+TEST(ControllerInitTest, ImpedanceDefaults)
+{
+  EffortRobot robot;
+  ros::NodeHandle root_nh;
+  ros::NodeHandle controller_nh("impedance_controller");
+
+  JointImpedanceTrajectoryController controller;
+  EXPECT_TRUE(controller.init(&robot.effort_iface, root_nh, controller_nh));
+}
+
+TEST(ControllerInitTest, ImpedanceMissingStiffness)
+{
+  EffortRobot robot;
+  ros::NodeHandle root_nh;
+  ros::NodeHandle controller_nh("impedance_missing_stiffness_controller");
+
+  JointImpedanceTrajectoryController controller;
+  EXPECT_FALSE(controller.init(&robot.effort_iface, root_nh, controller_nh));
+}
+
+TEST(ControllerInitTest, InvalidFriction)
+{
+  EffortRobot robot;
+  ros::NodeHandle root_nh;
+  ros::NodeHandle controller_nh("invalid_friction_controller");
+
+  EffortJointTrajectoryController controller;
+  EXPECT_FALSE(controller.init(&robot.effort_iface, root_nh, controller_nh));
+}
+
+TEST(ControllerInitTest, AdapterWorkspaceAfterFailedInit)
+{
+  EffortRobot robot;
+  std::vector<hardware_interface::JointHandle> joints = robot.getHandles();
+  ros::NodeHandle controller_nh("invalid_friction_controller");
+
+  EffortHardwareInterfaceAdapter adapter;
+  ASSERT_FALSE(adapter.init(joints, controller_nh));
+
+  // The adapter is not expected to be used after a failed initialization, but must not access unsized workspace
+  State desired_state(joints.size());
+  State state_error(joints.size());
+  adapter.starting(ros::Time(0.0));
+  adapter.updateCommand(ros::Time(0.0), ros::Duration(0.01), desired_state, state_error);
+}
+
+TEST(ControllerInitTest, SegmentAdapterWorkspaceAfterFailedInit)
+{
+  double pos = 0.0, vel = 0.0, eff = 0.0;
+  hardware_interface::JointStateHandle state_handle("joint1", &pos, &vel, &eff);
+  joint_trajectory_controller::SegmentQueue queue;
+  std::vector<joint_trajectory_controller::SegmentJointHandle> joints;
+  joints.push_back(joint_trajectory_controller::SegmentJointHandle(state_handle, &queue));
+  ros::NodeHandle controller_nh("invalid_lookahead_controller");
+
+  SegmentHardwareInterfaceAdapter adapter;
+  ASSERT_FALSE(adapter.init(joints, controller_nh));
+  adapter.starting(ros::Time(0.0));
+  adapter.stopping(ros::Time(0.0));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "controller_init_test");
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,141 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <joint_trajectory_controller/friction_model.h>
+
+typedef joint_trajectory_controller::FrictionModel<double> FrictionModel;
+
+// Floating-point value comparison threshold
+const double EPS = 1e-9;
+
+TEST(FrictionModelTest, InvalidParameters)
+{
+  FrictionModel model;
+  std::vector<FrictionModel::Parameters> params(1);
+  EXPECT_TRUE(model.init(params));
+  EXPECT_EQ(1u, model.size());
+
+  params[0].coulomb = -1.0;
+  EXPECT_FALSE(model.init(params));
+
+  params[0].coulomb         = 2.0;
+  params[0].static_friction = 1.0;
+  EXPECT_FALSE(model.init(params)); // Breakaway friction lower than Coulomb friction
+
+  params[0].static_friction = 2.0;
+  params[0].viscous         = -0.1;
+  EXPECT_FALSE(model.init(params));
+
+  params[0].viscous           = 0.1;
+  params[0].stribeck_velocity = 0.0;
+  EXPECT_FALSE(model.init(params));
+
+  params[0].stribeck_velocity  = 0.1;
+  params[0].smoothing_velocity = 0.0;
+  EXPECT_FALSE(model.init(params));
+
+  params[0].smoothing_velocity = 0.01;
+  EXPECT_TRUE(model.init(params));
+}
+
+TEST(FrictionModelTest, CoulombAndViscous)
+{
+  std::vector<FrictionModel::Parameters> params(2);
+  params[0].coulomb         = 3.0;
+  params[0].static_friction = 3.0;
+  params[0].viscous         = 0.5;
+  params[1].viscous         = 2.0;
+
+  FrictionModel model;
+  ASSERT_TRUE(model.init(params));
+
+  // Far from zero velocity, the smoothed sign is saturated
+  const double velocity[] = {2.0, -1.5};
+  double friction[2];
+  model.compute(velocity, friction);
+  EXPECT_NEAR(3.0 + 0.5 * 2.0, friction[0], EPS);
+  EXPECT_NEAR(2.0 * -1.5,      friction[1], EPS);
+
+  // Friction is odd in the velocity, and continuous through zero
+  const double reversed[] = {-2.0, 1.5};
+  model.compute(reversed, friction);
+  EXPECT_NEAR(-(3.0 + 0.5 * 2.0), friction[0], EPS);
+  EXPECT_NEAR(3.0,                friction[1], EPS);
+
+  const double zero[] = {0.0, 0.0};
+  model.compute(zero, friction);
+  EXPECT_NEAR(0.0, friction[0], EPS);
+  EXPECT_NEAR(0.0, friction[1], EPS);
+
+  const double tiny[] = {1e-6, -1e-6};
+  model.compute(tiny, friction);
+  EXPECT_LT(std::abs(friction[0]), 0.01);
+  EXPECT_LT(std::abs(friction[1]), 0.01);
+}
+
+TEST(FrictionModelTest, StribeckTransition)
+{
+  std::vector<FrictionModel::Parameters> params(1);
+  params[0].coulomb            = 1.0;
+  params[0].static_friction    = 1.5;
+  params[0].stribeck_velocity  = 0.05;
+  params[0].smoothing_velocity = 1e-4;
+
+  FrictionModel model;
+  ASSERT_TRUE(model.init(params));
+
+  // Breakaway friction right after the sign transition, decaying to Coulomb friction with speed
+  double velocity = 1e-3;
+  double friction = 0.0;
+  model.compute(&velocity, &friction);
+  EXPECT_NEAR(1.5, friction, 1e-3);
+
+  velocity = 0.05;
+  model.compute(&velocity, &friction);
+  EXPECT_NEAR(1.0 + 0.5 * std::exp(-1.0), friction, EPS);
+
+  velocity = 0.5;
+  model.compute(&velocity, &friction);
+  EXPECT_NEAR(1.0, friction, 1e-6);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
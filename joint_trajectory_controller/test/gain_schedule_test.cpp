@@ -0,0 +1,206 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <joint_trajectory_controller/gain_schedule.h>
+
+typedef joint_trajectory_controller::GainSchedule<double> GainSchedule;
+
+// Floating-point value comparison threshold
+const double EPS = 1e-9;
+
+namespace
+{
+
+GainSchedule::Gains makeGains(double p, double i, double d, double i_clamp)
+{
+  GainSchedule::Gains gains;
+  gains.p       = p;
+  gains.i       = i;
+  gains.d       = d;
+  gains.i_max   = i_clamp;
+  gains.i_min   = -i_clamp;
+  return gains;
+}
+
+} // namespace
+
+TEST(GainScheduleTest, InvalidSchedules)
+{
+  GainSchedule schedule;
+  EXPECT_TRUE(schedule.empty());
+
+  std::vector<double> keys;
+  std::vector<GainSchedule::Gains> gains;
+  EXPECT_FALSE(schedule.init(keys, gains));
+
+  keys.push_back(0.0);
+  keys.push_back(1.0);
+  gains.push_back(makeGains(1.0, 0.0, 0.0, 0.0));
+  EXPECT_FALSE(schedule.init(keys, gains)); // Size mismatch
+
+  gains.push_back(makeGains(2.0, 0.0, 0.0, -1.0));
+  EXPECT_FALSE(schedule.init(keys, gains)); // Integral clamp bounds not ordered
+
+  gains.back() = makeGains(2.0, 0.0, 0.0, 1.0);
+  keys.back() = 0.0;
+  EXPECT_FALSE(schedule.init(keys, gains)); // Keys not increasing
+
+  keys.back() = 1.0;
+  EXPECT_TRUE(schedule.init(keys, gains));
+  EXPECT_FALSE(schedule.empty());
+}
+
+TEST(GainScheduleTest, Interpolation)
+{
+  std::vector<double> keys;
+  std::vector<GainSchedule::Gains> gains;
+  keys.push_back(0.0);
+  gains.push_back(makeGains(400.0, 20.0, 10.0, 2.0));
+  keys.push_back(0.5);
+  gains.push_back(makeGains(200.0, 10.0, 6.0,  1.0));
+  keys.push_back(1.5);
+  gains.push_back(makeGains(100.0, 0.0,  2.0,  0.0));
+
+  GainSchedule schedule;
+  ASSERT_TRUE(schedule.init(keys, gains));
+
+  GainSchedule::Gains out;
+  schedule.interpolate(0.25, out);
+  EXPECT_NEAR(300.0, out.p,       EPS);
+  EXPECT_NEAR(15.0,  out.i,       EPS);
+  EXPECT_NEAR(8.0,   out.d,       EPS);
+  EXPECT_NEAR(1.5,   out.i_max,   EPS);
+  EXPECT_NEAR(-1.5,  out.i_min,   EPS);
+
+  // Lookups in either direction from the previous interval
+  schedule.interpolate(1.0, out);
+  EXPECT_NEAR(150.0, out.p, EPS);
+  schedule.interpolate(0.5, out);
+  EXPECT_NEAR(200.0, out.p, EPS);
+  schedule.interpolate(0.1, out);
+  EXPECT_NEAR(360.0, out.p, EPS);
+
+  // Gains are held beyond the breakpoints
+  schedule.interpolate(-1.0, out);
+  EXPECT_NEAR(400.0, out.p, EPS);
+  schedule.interpolate(10.0, out);
+  EXPECT_NEAR(100.0, out.p, EPS);
+  schedule.interpolate(std::numeric_limits<double>::quiet_NaN(), out);
+  EXPECT_NEAR(400.0, out.p, EPS);
+}
+
+TEST(GainScheduleTest, ConstantGainsBehaveAsPid)
+{
+  GainSchedule schedule;
+  ASSERT_TRUE(schedule.init(std::vector<double>(1, 0.0),
+                            std::vector<GainSchedule::Gains>(1, makeGains(10.0, 2.0, 0.5, 100.0))));
+
+  const double dt = 0.01;
+  double integral = 0.0;
+  for (int k = 0; k < 10; ++k)
+  {
+    const double error     = 0.1 * k;
+    const double error_dot = -0.2;
+    integral += dt * error;
+    EXPECT_NEAR(10.0 * error + 2.0 * integral + 0.5 * error_dot,
+                schedule.computeCommand(0.3, error, error_dot, dt), EPS);
+  }
+
+  // Invalid inputs produce no command and leave the integral untouched
+  EXPECT_EQ(0.0, schedule.computeCommand(0.3, 1.0, 0.0, 0.0));
+  EXPECT_EQ(0.0, schedule.computeCommand(0.3, std::numeric_limits<double>::quiet_NaN(), 0.0, dt));
+  EXPECT_NEAR(2.0 * integral, schedule.computeCommand(0.3, 0.0, 0.0, dt), EPS);
+
+  schedule.reset();
+  EXPECT_NEAR(0.0, schedule.computeCommand(0.3, 0.0, 0.0, dt), EPS);
+}
+
+TEST(GainScheduleTest, IntegralTermIsBumpless)
+{
+  std::vector<double> keys;
+  std::vector<GainSchedule::Gains> gains;
+  keys.push_back(0.0);
+  gains.push_back(makeGains(0.0, 100.0, 0.0, 10.0));
+  keys.push_back(1.0);
+  gains.push_back(makeGains(0.0, 1.0,   0.0, 10.0));
+
+  GainSchedule schedule;
+  ASSERT_TRUE(schedule.init(keys, gains));
+
+  const double dt = 0.01;
+  double command = 0.0;
+  for (int k = 0; k < 10; ++k) {command = schedule.computeCommand(0.0, 0.1, 0.0, dt);}
+  EXPECT_NEAR(1.0, command, EPS);
+
+  // Switching to a much lower integral gain keeps the accumulated integral term
+  EXPECT_NEAR(1.0 + 0.001, schedule.computeCommand(1.0, 0.1, 0.0, dt), EPS);
+
+  // The integral term is clamped
+  for (int k = 0; k < 1000; ++k) {command = schedule.computeCommand(0.0, 1.0, 0.0, dt);}
+  EXPECT_NEAR(10.0, command, EPS);
+}
+
+TEST(GainScheduleTest, IntegralClamping)
+{
+  GainSchedule::Gains gains = makeGains(0.0, 1.0, 0.0, 0.0);
+  gains.i_max = 1.0;
+  gains.i_min = -0.5;
+  const std::vector<double> keys(1, 0.0);
+
+  // Asymmetric bounds
+  GainSchedule schedule;
+  ASSERT_TRUE(schedule.init(keys, std::vector<GainSchedule::Gains>(1, gains)));
+  EXPECT_NEAR(1.0, schedule.computeCommand(0.0, 2.0, 0.0, 1.0), EPS);
+  EXPECT_NEAR(-0.5, schedule.computeCommand(0.0, -4.0, 0.0, 1.0), EPS);
+
+  // With anti-windup the integral leaves its bound as soon as the error changes sign
+  EXPECT_NEAR(-0.5 + 0.25, schedule.computeCommand(0.0, 0.25, 0.0, 1.0), EPS);
+
+  // Without it, the integral keeps accumulating past its bound, and takes as long to unwind
+  ASSERT_TRUE(schedule.init(keys, std::vector<GainSchedule::Gains>(1, gains), false));
+  EXPECT_NEAR(1.0, schedule.computeCommand(0.0, 3.0, 0.0, 1.0), EPS);
+  EXPECT_NEAR(1.0, schedule.computeCommand(0.0, -1.0, 0.0, 1.0), EPS);
+  EXPECT_NEAR(0.5, schedule.computeCommand(0.0, -1.5, 0.0, 1.0), EPS);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,167 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/// \file Measures the cost of converting a long, high-DOF trajectory message into controller segments.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <actionlib/server/action_server.h>
+#include <trajectory_interface/quintic_spline_segment.h>
+#include <joint_trajectory_controller/init_joint_trajectory.h>
+
+using namespace joint_trajectory_controller;
+
+namespace
+{
+
+typedef JointTrajectorySegment<trajectory_interface::QuinticSplineSegment<double> > Segment;
+typedef std::vector<Segment> TrajectoryPerJoint;
+typedef std::vector<TrajectoryPerJoint> Trajectory;
+
+const unsigned int N_POINTS = 100000;
+const unsigned int N_JOINTS = 14;
+const unsigned int RUNS     = 5;
+
+// Keeps the optimizer from discarding the constructed trajectories
+volatile double sink;
+
+trajectory_msgs::JointTrajectory makeTrajectory()
+{
+  trajectory_msgs::JointTrajectory msg;
+  msg.header.stamp = ros::Time(1.0);
+  for (unsigned int k = 0; k < N_JOINTS; ++k) {msg.joint_names.push_back("joint" + std::to_string(k));}
+
+  msg.points.resize(N_POINTS);
+  for (unsigned int i = 0; i < N_POINTS; ++i)
+  {
+    trajectory_msgs::JointTrajectoryPoint& point = msg.points[i];
+    point.positions.resize(N_JOINTS);
+    point.velocities.resize(N_JOINTS);
+    point.accelerations.resize(N_JOINTS);
+    for (unsigned int k = 0; k < N_JOINTS; ++k)
+    {
+      point.positions[k]     =  std::sin(1e-3 * i + k);
+      point.velocities[k]    =  std::cos(1e-3 * i + k);
+      point.accelerations[k] = -std::sin(1e-3 * i + k);
+    }
+    point.time_from_start = ros::Duration(1e-3 * (i + 1));
+  }
+  return msg;
+}
+
+/// Conversion through single-joint temporary points, as done before segments were built from the message columns
+Trajectory perPointConversion(const trajectory_msgs::JointTrajectory& msg)
+{
+  Trajectory traj(N_JOINTS);
+  const std::vector<double> position_offset(1, 0.0);
+  for (unsigned int k = 0; k < N_JOINTS; ++k)
+  {
+    for (unsigned int i = 0; i + 1 < msg.points.size(); ++i)
+    {
+      const trajectory_msgs::JointTrajectoryPoint& p = msg.points[i];
+      const trajectory_msgs::JointTrajectoryPoint& q = msg.points[i + 1];
+      trajectory_msgs::JointTrajectoryPoint p_joint, q_joint;
+      p_joint.positions.resize(1, p.positions[k]);
+      p_joint.velocities.resize(1, p.velocities[k]);
+      p_joint.accelerations.resize(1, p.accelerations[k]);
+      p_joint.time_from_start = p.time_from_start;
+      q_joint.positions.resize(1, q.positions[k]);
+      q_joint.velocities.resize(1, q.velocities[k]);
+      q_joint.accelerations.resize(1, q.accelerations[k]);
+      q_joint.time_from_start = q.time_from_start;
+      traj[k].push_back(Segment(msg.header.stamp, p_joint, q_joint, position_offset));
+    }
+  }
+  return traj;
+}
+
+Trajectory columnConversion(const trajectory_msgs::JointTrajectory& msg)
+{
+  return initJointTrajectory<Trajectory>(msg, msg.header.stamp);
+}
+
+/// Column conversion with joints distributed among one worker per hardware thread
+Trajectory parallelConversion(const trajectory_msgs::JointTrajectory& msg)
+{
+  static WorkerPool worker_pool(std::max(std::thread::hardware_concurrency(), 1u));
+
+  InitJointTrajectoryOptions<Trajectory> options;
+  options.worker_pool           = &worker_pool;
+  options.parallel_min_segments = 0;
+  return initJointTrajectory<Trajectory>(msg, msg.header.stamp, options);
+}
+
+template <class Conversion>
+void benchmark(const std::string& name, const trajectory_msgs::JointTrajectory& msg, Conversion conversion)
+{
+  double best = 0.0;
+  for (unsigned int run = 0; run < RUNS; ++run)
+  {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    {
+      const Trajectory traj = conversion(msg);
+      sink = traj.back().back().endTime();
+    }
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    const double elapsed = std::chrono::duration<double, std::milli>(end - start).count();
+    if (run == 0 || elapsed < best) {best = elapsed;}
+  }
+
+  const double n_segments = static_cast<double>(N_JOINTS) * (N_POINTS - 1);
+  std::cout << std::setw(12) << name
+            << std::setw(12) << std::fixed << std::setprecision(1) << best
+            << std::setw(16) << std::fixed << std::setprecision(1) << 1e6 * best / n_segments << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  const trajectory_msgs::JointTrajectory msg = makeTrajectory();
+
+  std::cout << N_POINTS << " points, " << N_JOINTS << " joints, best of " << RUNS << " runs" << std::endl;
+  std::cout << std::setw(12) << "conversion" << std::setw(12) << "ms" << std::setw(16) << "ns/segment" << std::endl;
+  benchmark("per-point", msg, perPointConversion);
+  benchmark("column", msg, columnConversion);
+  benchmark("parallel", msg, parallelConversion);
+  return 0;
+}
@@ -27,7 +27,10 @@
 
 /// \author Adolfo Rodriguez Tsouroukdissian
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -367,6 +370,31 @@ TEST_F(InitTrajectoryTest, InitValues)
   }
 }
 
+TEST_F(InitTrajectoryTest, InitValuesMixedSpecification)
+{
+  // Middle point specifies positions only: Both segments use linear interpolation
+  trajectory_msg.points[1].velocities.clear();
+  trajectory_msg.points[1].accelerations.clear();
+  const ros::Time msg_start_time = trajectory_msg.header.stamp;
+  const vector<JointTrajectoryPoint>& msg_points = trajectory_msg.points;
+
+  Trajectory trajectory = initJointTrajectory<Trajectory>(trajectory_msg, msg_start_time);
+  ASSERT_EQ(points.size() - 1, trajectory[0].size());
+
+  for (unsigned int i = 0; i < trajectory[0].size(); ++i)
+  {
+    const Segment& segment = trajectory[0][i];
+    const double start_pos = msg_points[i].positions[0];
+    const double end_pos   = msg_points[i + 1].positions[0];
+
+    typename Segment::State state;
+    segment.sample(0.5 * (segment.startTime() + segment.endTime()), state);
+    EXPECT_NEAR(0.5 * (start_pos + end_pos), state.position[0], EPS);
+    EXPECT_NEAR((end_pos - start_pos) / (segment.endTime() - segment.startTime()), state.velocity[0], EPS);
+    EXPECT_NEAR(0.0, state.acceleration[0], EPS);
+  }
+}
+
 TEST_F(InitTrajectoryTest, InitValuesCombine)
 {
   // Before first point: Return 4 segments: Last of current + bridge + full message
@@ -858,6 +886,312 @@ TEST_F(InitTrajectoryTest, OtherTimeBase)
   }
 }
 
+TEST_F(InitTrajectoryTest, BridgingLimits)
+{
+  const ros::Time msg_start_time = trajectory_msg.header.stamp;
+  const ros::Time time = msg_start_time;
+  const typename Segment::Time bridge_start_time = msg_start_time.toSec();
+  const typename Segment::Time bridge_end_time   = (msg_start_time + points[0].time_from_start).toSec();
+
+  InitJointTrajectoryOptions<Trajectory> options;
+  options.current_trajectory = &curr_traj;
+
+  // Loose limits: Same result as without limits
+  vector<double> max_acceleration(1, 1000.0);
+  vector<double> max_jerk(1, 10000.0);
+  options.bridge_max_acceleration = &max_acceleration;
+  options.bridge_max_jerk         = &max_jerk;
+  {
+    Trajectory trajectory = initJointTrajectory<Trajectory>(trajectory_msg, time, options);
+    ASSERT_EQ(points.size() + 1, trajectory[0].size());
+    EXPECT_EQ(bridge_start_time, trajectory[0][1].startTime());
+    EXPECT_EQ(bridge_end_time,   trajectory[0][1].endTime());
+  }
+
+  // Tight limits: Longer bridge, with the same start time, and the same delay applied to all new segments
+  max_acceleration[0] = 2.0;
+  max_jerk[0]         = 8.0;
+  Trajectory trajectory = initJointTrajectory<Trajectory>(trajectory_msg, time, options);
+  ASSERT_EQ(points.size() + 1, trajectory[0].size());
+
+  const Segment& bridge = trajectory[0][1];
+  EXPECT_EQ(bridge_start_time, bridge.startTime());
+  EXPECT_LT(bridge_end_time, bridge.endTime());
+
+  const double delay = bridge.endTime() - bridge_end_time;
+  for (unsigned int traj_it = 2, msg_it = 0; traj_it < trajectory[0].size(); ++traj_it, ++msg_it)
+  {
+    EXPECT_NEAR((msg_start_time + points[msg_it].time_from_start).toSec()     + delay,
+                trajectory[0][traj_it].startTime(), EPS);
+    EXPECT_NEAR((msg_start_time + points[msg_it + 1].time_from_start).toSec() + delay,
+                trajectory[0][traj_it].endTime(),   EPS);
+  }
+
+  // Bridge still reaches the first point
+  typename Segment::State state;
+  bridge.sample(bridge.endTime(), state);
+  EXPECT_NEAR(points[0].positions[0], state.position[0], EPS);
+
+  // Limits are satisfied, up to the resolution of the peak estimation
+  typename Segment::State start_state;
+  bridge.sample(bridge.startTime(), start_state);
+  const double acceleration_limit = std::max(max_acceleration[0], std::abs(start_state.acceleration[0]));
+  const unsigned int n_samples = 1000;
+  const double dt = (bridge.endTime() - bridge.startTime()) / n_samples;
+  double prev_acceleration = start_state.acceleration[0];
+  for (unsigned int k = 1; k <= n_samples; ++k)
+  {
+    bridge.sample(bridge.startTime() + k * dt, state);
+    EXPECT_GE(1.05 * acceleration_limit, std::abs(state.acceleration[0]));
+    EXPECT_GE(1.05 * max_jerk[0], std::abs(state.acceleration[0] - prev_acceleration) / dt);
+    prev_acceleration = state.acceleration[0];
+  }
+
+  // Invalid limit vector sizes
+  max_jerk.resize(2, 8.0);
+  EXPECT_TRUE(initJointTrajectory<Trajectory>(trajectory_msg, time, options).empty());
+}
+
+TEST_F(InitTrajectoryTest, ResumeTrajectory)
+{
+  const ros::Time msg_start_time = trajectory_msg.header.stamp;
+  const Trajectory interrupted = initJointTrajectory<Trajectory>(trajectory_msg, msg_start_time);
+  ASSERT_EQ(points.size() - 1, interrupted[0].size());
+
+  // Trajectory holding a position different from the one at which the interrupted trajectory was left
+  typename Segment::State hold_state;
+  hold_state.position.push_back(-1.0);
+  hold_state.velocity.push_back(0.0);
+  hold_state.acceleration.push_back(0.0);
+  const Trajectory current(1, TrajectoryPerJoint(1, Segment(0.0, hold_state, 0.0, hold_state)));
+
+  const ros::Time interrupt_time(3.0);
+  const ros::Time time(10.0);
+  const ros::Duration bridge_duration(2.0);
+  std::string error_string;
+  InitJointTrajectoryOptions<Trajectory> options;
+  options.error_string = &error_string;
+
+  const Trajectory trajectory = resumeJointTrajectory(interrupted, interrupt_time, current, time, bridge_duration,
+                                                      options);
+  ASSERT_EQ(1, trajectory.size());
+  ASSERT_EQ(2, trajectory[0].size());
+  EXPECT_TRUE(error_string.empty());
+
+  // Bridge goes from the current state to the interrupted one
+  const Segment& bridge = trajectory[0][0];
+  EXPECT_EQ(time.toSec(), bridge.startTime());
+  EXPECT_EQ((time + bridge_duration).toSec(), bridge.endTime());
+
+  typename Segment::State state, ref_state;
+  bridge.sample(bridge.startTime(), state);
+  EXPECT_NEAR(hold_state.position[0], state.position[0], EPS);
+  EXPECT_NEAR(hold_state.velocity[0], state.velocity[0], EPS);
+
+  // Remaining part of the interrupted trajectory is replayed after the bridge
+  const double time_offset = bridge.endTime() - interrupt_time.toSec();
+  for (double t = interrupt_time.toSec(); t <= interrupted[0].back().endTime(); t += 0.25)
+  {
+    sample(interrupted[0], t, ref_state);
+    sample(trajectory[0], t + time_offset, state);
+    EXPECT_NEAR(ref_state.position[0],     state.position[0],     EPS);
+    EXPECT_NEAR(ref_state.velocity[0],     state.velocity[0],     EPS);
+    EXPECT_NEAR(ref_state.acceleration[0], state.acceleration[0], EPS);
+  }
+  EXPECT_NEAR(interrupted[0].back().endTime() + time_offset, trajectory[0].back().endTime(), EPS);
+
+  // Bridging limits lengthen the bridge, and allow leaving its duration unspecified
+  vector<double> max_acceleration(1, 2.0);
+  vector<double> max_jerk(1, 8.0);
+  options.bridge_max_acceleration = &max_acceleration;
+  options.bridge_max_jerk         = &max_jerk;
+  {
+    const Trajectory limited = resumeJointTrajectory(interrupted, interrupt_time, current, time, bridge_duration,
+                                                     options);
+    ASSERT_EQ(2, limited[0].size());
+    EXPECT_LT(bridge.endTime(), limited[0][0].endTime());
+
+    const Trajectory unspecified = resumeJointTrajectory(interrupted, interrupt_time, current, time, ros::Duration(),
+                                                         options);
+    ASSERT_EQ(2, unspecified[0].size());
+    EXPECT_LT(time.toSec(), unspecified[0][0].endTime());
+  }
+  options.bridge_max_acceleration = 0;
+  options.bridge_max_jerk         = 0;
+
+  // Unspecified bridge duration without limits
+  EXPECT_TRUE(resumeJointTrajectory(interrupted, interrupt_time, current, time, ros::Duration(), options).empty());
+  EXPECT_FALSE(error_string.empty());
+
+  // Nothing left to resume
+  error_string.clear();
+  const ros::Time finished_time(interrupted[0].back().endTime() + 1.0);
+  EXPECT_TRUE(resumeJointTrajectory(interrupted, finished_time, current, time, bridge_duration, options).empty());
+  EXPECT_FALSE(error_string.empty());
+}
+
+TEST_F(InitTrajectoryTest, ImpedancePoints)
+{
+  const ros::Time msg_start_time = trajectory_msg.header.stamp;
+  const ros::Time time = msg_start_time;
+
+  vector<JointImpedancePoint> impedance(points.size());
+  for (unsigned int i = 0; i < impedance.size(); ++i)
+  {
+    impedance[i].stiffness.resize(1, 100.0 * (i + 1));
+    impedance[i].damping.resize(1, 10.0 * (i + 1));
+  }
+
+  InitJointTrajectoryOptions<Trajectory> options;
+  options.current_trajectory = &curr_traj;
+  options.impedance_points   = &impedance;
+
+  Trajectory trajectory = initJointTrajectory<Trajectory>(trajectory_msg, time, options);
+  ASSERT_EQ(points.size() + 1, trajectory[0].size());
+
+  // Bridge holds the impedance of the first point, as the current trajectory has none
+  typename Segment::State state;
+  const Segment& bridge = trajectory[0][1];
+  ASSERT_TRUE(bridge.hasImpedance());
+  bridge.sample(bridge.startTime(), state);
+  EXPECT_NEAR(impedance[0].stiffness[0], state.stiffness[0], EPS);
+  EXPECT_NEAR(impedance[0].damping[0],   state.damping[0],   EPS);
+
+  // New segments interpolate the impedance of their points
+  for (unsigned int traj_it = 2, msg_it = 0; traj_it < trajectory[0].size(); ++traj_it, ++msg_it)
+  {
+    const Segment& segment = trajectory[0][traj_it];
+    segment.sample(segment.startTime(), state);
+    EXPECT_NEAR(impedance[msg_it].stiffness[0], state.stiffness[0], EPS);
+    EXPECT_NEAR(impedance[msg_it].damping[0],   state.damping[0],   EPS);
+    segment.sample(segment.endTime(), state);
+    EXPECT_NEAR(impedance[msg_it + 1].stiffness[0], state.stiffness[0], EPS);
+    EXPECT_NEAR(impedance[msg_it + 1].damping[0],   state.damping[0],   EPS);
+  }
+
+  // Bridging from a trajectory with impedance starts from its impedance
+  {
+    options.current_trajectory = &trajectory;
+    Trajectory next_traj = initJointTrajectory<Trajectory>(trajectory_msg, ros::Time(1.75), options);
+    options.current_trajectory = &curr_traj;
+    ASSERT_FALSE(next_traj.empty());
+    const Segment& next_bridge = *findSegment(next_traj[0], 1.75);
+    trajectory[0][2].sample(1.75, state);
+    const double curr_stiffness = state.stiffness[0];
+    next_bridge.sample(1.75, state);
+    EXPECT_NEAR(curr_stiffness, state.stiffness[0], EPS);
+  }
+
+  // Without impedance data, new segments carry none
+  options.impedance_points = 0;
+  trajectory = initJointTrajectory<Trajectory>(trajectory_msg, time, options);
+  for (unsigned int i = 1; i < trajectory[0].size(); ++i) {EXPECT_FALSE(trajectory[0][i].hasImpedance());}
+
+  // Negative or non-finite impedance
+  options.impedance_points = &impedance;
+  impedance[1].stiffness[0] = -100.0;
+  EXPECT_TRUE(initJointTrajectory<Trajectory>(trajectory_msg, time, options).empty());
+  impedance[1].stiffness[0] = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_TRUE(initJointTrajectory<Trajectory>(trajectory_msg, time, options).empty());
+  impedance[1].stiffness[0] = 100.0;
+  impedance[1].damping[0]   = -10.0;
+  EXPECT_TRUE(initJointTrajectory<Trajectory>(trajectory_msg, time, options).empty());
+  impedance[1].damping[0]   = std::numeric_limits<double>::infinity();
+  EXPECT_TRUE(initJointTrajectory<Trajectory>(trajectory_msg, time, options).empty());
+  impedance[1].damping[0]   = 10.0;
+  EXPECT_FALSE(initJointTrajectory<Trajectory>(trajectory_msg, time, options).empty());
+
+  // Missing impedance data
+  impedance.pop_back();
+  EXPECT_TRUE(initJointTrajectory<Trajectory>(trajectory_msg, time, options).empty());
+}
+
+TEST(WorkerPoolTest, RunTasks)
+{
+  WorkerPool pool(3);
+  EXPECT_EQ(3, pool.size());
+
+  // Every task runs exactly once
+  vector<int> counts(100, 0);
+  pool.run(counts.size(), [&counts](std::size_t i) {++counts[i];});
+  for (unsigned int i = 0; i < counts.size(); ++i) {EXPECT_EQ(1, counts[i]);}
+
+  // Exception of the lowest failing index is rethrown
+  try
+  {
+    pool.run(50, [](std::size_t i) {if (i % 10 == 7) {throw std::runtime_error(std::to_string(i));}});
+    FAIL() << "Expected exception";
+  }
+  catch (const std::runtime_error& ex) {EXPECT_EQ(string("7"), ex.what());}
+
+  // Pool is still usable after a failure, also without worker threads
+  WorkerPool empty_pool(0);
+  for (WorkerPool* p : {&pool, &empty_pool})
+  {
+    std::fill(counts.begin(), counts.end(), 0);
+    p->run(counts.size(), [&counts](std::size_t i) {counts[i] += 2;});
+    for (unsigned int i = 0; i < counts.size(); ++i) {EXPECT_EQ(2, counts[i]);}
+  }
+}
+
+TEST(InitTrajectoryParallelTest, SameAsSequential)
+{
+  // Message with many joints, in a different order than the expected joints
+  const unsigned int n_joints = 8;
+  const unsigned int n_points = 50;
+  trajectory_msgs::JointTrajectory msg;
+  vector<string> joint_names;
+  for (unsigned int k = 0; k < n_joints; ++k)
+  {
+    msg.joint_names.push_back("joint" + std::to_string(n_joints - 1 - k));
+    joint_names.push_back("joint" + std::to_string(k));
+  }
+  for (unsigned int i = 0; i < n_points; ++i)
+  {
+    JointTrajectoryPoint point;
+    for (unsigned int k = 0; k < n_joints; ++k)
+    {
+      point.positions.push_back(std::sin(0.1 * i + k));
+      point.velocities.push_back(std::cos(0.1 * i + k));
+    }
+    point.time_from_start = ros::Duration(0.1 * (i + 1));
+    msg.points.push_back(point);
+  }
+
+  InitJointTrajectoryOptions<Trajectory> options;
+  options.joint_names = &joint_names;
+  const Trajectory sequential = initJointTrajectory<Trajectory>(msg, ros::Time(0.0), options);
+
+  WorkerPool pool(3);
+  options.worker_pool = &pool;
+  options.parallel_min_segments = 0;
+  const Trajectory parallel = initJointTrajectory<Trajectory>(msg, ros::Time(0.0), options);
+
+  ASSERT_EQ(n_joints, sequential.size());
+  ASSERT_EQ(n_joints, parallel.size());
+  for (unsigned int k = 0; k < n_joints; ++k)
+  {
+    ASSERT_EQ(n_points - 1, parallel[k].size());
+    ASSERT_EQ(sequential[k].size(), parallel[k].size());
+    for (unsigned int i = 0; i < parallel[k].size(); ++i)
+    {
+      EXPECT_EQ(sequential[k][i].startTime(), parallel[k][i].startTime());
+      EXPECT_EQ(sequential[k][i].endTime(),   parallel[k][i].endTime());
+
+      typename Segment::State seq_state, par_state;
+      const double t = 0.5 * (parallel[k][i].startTime() + parallel[k][i].endTime());
+      sequential[k][i].sample(t, seq_state);
+      parallel[k][i].sample(t, par_state);
+      EXPECT_EQ(seq_state.position[0], par_state.position[0]);
+      EXPECT_EQ(seq_state.velocity[0], par_state.velocity[0]);
+    }
+  }
+
+  // Invalid input throws the same way
+  msg.points.back().positions.push_back(0.0);
+  EXPECT_THROW(initJointTrajectory<Trajectory>(msg, ros::Time(0.0), options), std::invalid_argument);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
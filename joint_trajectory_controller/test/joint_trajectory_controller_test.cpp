@@ -43,6 +43,8 @@
 #include <control_msgs/FollowJointTrajectoryAction.h>
 #include <control_msgs/JointTrajectoryControllerState.h>
 #include <control_msgs/QueryTrajectoryState.h>
+#include <joint_trajectory_controller/CheckTrajectory.h>
+#include <joint_trajectory_controller/GoalTrackingStatistics.h>
 
 #include <controller_manager_msgs/LoadController.h>
 #include <controller_manager_msgs/UnloadController.h>
@@ -120,9 +122,18 @@ public:
                                                                            &JointTrajectoryControllerTest::stateCB,
                                                                            this);
 
+    // Tracking statistics subscriber
+    tracking_statistics_sub = nh.subscribe("tracking_statistics",
+                                           1,
+                                           &JointTrajectoryControllerTest::trackingStatisticsCB,
+                                           this);
+
     // Query state service client
     query_state_service = nh.serviceClient<control_msgs::QueryTrajectoryState>("query_state");
 
+    // Check trajectory service client
+    check_trajectory_service = nh.serviceClient<joint_trajectory_controller::CheckTrajectory>("check_trajectory");
+
     // Controller management services
     load_controller_service = nh.serviceClient<controller_manager_msgs::LoadController>("/controller_manager/load_controller");
     unload_controller_service = nh.serviceClient<controller_manager_msgs::UnloadController>("/controller_manager/unload_controller");
@@ -139,6 +150,7 @@ public:
   ~JointTrajectoryControllerTest()
   {
     state_sub.shutdown(); // This is important, to make sure that the callback is not woken up later in the destructor
+    tracking_statistics_sub.shutdown();
   }
 
 protected:
@@ -146,6 +158,7 @@ protected:
   typedef std::shared_ptr<ActionClient> ActionClientPtr;
   typedef control_msgs::FollowJointTrajectoryGoal ActionGoal;
   typedef control_msgs::JointTrajectoryControllerStateConstPtr StateConstPtr;
+  typedef joint_trajectory_controller::GoalTrackingStatisticsConstPtr TrackingStatisticsConstPtr;
 
   std::mutex mutex;
   ros::NodeHandle nh;
@@ -167,7 +180,9 @@ protected:
   ros::Publisher     upper_bound_pub;
   ros::Publisher     traj_pub;
   ros::Subscriber    state_sub;
+  ros::Subscriber    tracking_statistics_sub;
   ros::ServiceClient query_state_service;
+  ros::ServiceClient check_trajectory_service;
   ros::ServiceClient load_controller_service;
   ros::ServiceClient unload_controller_service;
   ros::ServiceClient switch_controller_service;
@@ -181,6 +196,8 @@ protected:
 
   double stop_trajectory_duration;
 
+  TrackingStatisticsConstPtr tracking_statistics;
+
   void stateCB(const StateConstPtr& state)
   {
     std::lock_guard<std::mutex> lock(mutex);
@@ -194,6 +211,18 @@ protected:
                    [](double a, double b){return std::max(a, b);});
   }
 
+  void trackingStatisticsCB(const TrackingStatisticsConstPtr& stats)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    tracking_statistics = stats;
+  }
+
+  TrackingStatisticsConstPtr getTrackingStatistics()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tracking_statistics;
+  }
+
   StateConstPtr getState()
   {
     std::lock_guard<std::mutex> lock(mutex);
@@ -338,6 +367,49 @@ TEST_F(JointTrajectoryControllerTest, queryStateServiceConsistency)
   EXPECT_EQ(n_joints, srv.response.acceleration.size());
 }
 
+TEST_F(JointTrajectoryControllerTest, checkTrajectoryService)
+{
+  ASSERT_TRUE(initState());
+  check_trajectory_service.waitForExistence(ros::Duration(2.0));
+  ASSERT_TRUE(check_trajectory_service.isValid());
+
+  // Valid trajectory: accepted, but not executed
+  joint_trajectory_controller::CheckTrajectory srv;
+  srv.request.trajectory = traj;
+  srv.request.trajectory.header.stamp = ros::Time(0); // Start immediately
+  const ros::Time call_time = ros::Time::now();
+  ASSERT_TRUE(check_trajectory_service.call(srv));
+
+  EXPECT_TRUE(srv.response.accepted);
+  EXPECT_NEAR((call_time + traj.points.back().time_from_start).toSec(), srv.response.end_time.toSec(), 0.1);
+  ASSERT_EQ(n_joints, srv.response.name.size());
+  ASSERT_EQ(n_joints, srv.response.start_position.size());
+  ASSERT_EQ(n_joints, srv.response.max_velocity.size());
+  ASSERT_EQ(n_joints, srv.response.max_acceleration.size());
+
+  StateConstPtr state = getState();
+  for (unsigned int i = 0; i < n_joints; ++i)
+  {
+    EXPECT_EQ(joint_names[i], srv.response.name[i]);
+    EXPECT_NEAR(state->desired.positions[i], srv.response.start_position[i], EPS);
+    EXPECT_LT(0.0, srv.response.max_velocity[i]);
+    EXPECT_LT(0.0, srv.response.max_acceleration[i]);
+  }
+
+  ros::Duration(0.5).sleep();
+  state = getState();
+  for (unsigned int i = 0; i < n_joints; ++i)
+  {
+    EXPECT_NEAR(0.0, state->desired.velocities[i], EPS);
+  }
+
+  // Trajectory with unknown joints: rejected
+  srv.request.trajectory.joint_names[0] = "bad_joint";
+  ASSERT_TRUE(check_trajectory_service.call(srv));
+  EXPECT_FALSE(srv.response.accepted);
+  EXPECT_FALSE(srv.response.error_string.empty());
+}
+
 // Invalid messages ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 TEST_F(JointTrajectoryControllerTest, invalidMessages)
@@ -682,6 +754,37 @@ TEST_F(JointTrajectoryControllerTest, actionReplacesActionTraj)
   }
 }
 
+TEST_F(JointTrajectoryControllerTest, actionGoalsBackToBackWhileFinishing)
+{
+  ASSERT_TRUE(initState());
+  ASSERT_TRUE(action_client->waitForServer(long_timeout));
+  ASSERT_TRUE(action_client2->waitForServer(long_timeout));
+
+  // Go to home configuration, we need known initial conditions
+  traj_home_goal.trajectory.header.stamp = ros::Time(0); // Start immediately
+  action_client->sendGoal(traj_home_goal);
+  ASSERT_TRUE(waitForState(action_client, SimpleClientGoalState::SUCCEEDED, long_timeout));
+
+  // Short goals, so that new goals are accepted around the time the previous one finishes and its result is forwarded
+  ActionGoal short_goal = traj_home_goal;
+  short_goal.trajectory.points.back().time_from_start = ros::Duration(0.1);
+  for (unsigned int i = 0; i < 20; ++i)
+  {
+    short_goal.trajectory.header.stamp = ros::Time(0); // Start immediately
+    action_client->sendGoal(short_goal);
+    ASSERT_TRUE(waitForState(action_client, SimpleClientGoalState::ACTIVE, short_timeout));
+    ros::Duration(0.01 * i).sleep(); // Sweep the goal end
+
+    action_client2->sendGoal(short_goal);
+    action_client2->sendGoal(short_goal);
+
+    // Both clients get a result, none of the callbacks is stuck
+    ASSERT_TRUE(action_client->waitForResult(long_timeout));
+    ASSERT_TRUE(action_client2->waitForResult(long_timeout));
+    EXPECT_TRUE(action_client2->getState() == SimpleClientGoalState::SUCCEEDED);
+  }
+}
+
 TEST_F(JointTrajectoryControllerTest, actionReplacesTopicTraj)
 {
   ASSERT_TRUE(initState());
@@ -1297,6 +1400,49 @@ TEST_F(JointTrajectoryControllerTest, goalToleranceViolation)
   }
 }
 
+TEST_F(JointTrajectoryControllerTest, trackingStatistics)
+{
+  ASSERT_TRUE(initState());
+  ASSERT_TRUE(action_client->waitForServer(long_timeout));
+
+  // Go to home configuration, we need known initial conditions
+  traj_home_goal.trajectory.header.stamp = ros::Time(0); // Start immediately
+  action_client->sendGoal(traj_home_goal);
+  ASSERT_TRUE(waitForState(action_client, SimpleClientGoalState::SUCCEEDED, long_timeout));
+  ros::Duration(0.5).sleep();
+  const TrackingStatisticsConstPtr home_stats = getTrackingStatistics();
+
+  // Send trajectory
+  traj_goal.trajectory.header.stamp = ros::Time(0); // Start immediately
+  action_client->sendGoal(traj_goal);
+  ASSERT_TRUE(waitForState(action_client, SimpleClientGoalState::SUCCEEDED, long_timeout));
+  EXPECT_TRUE(action_client->getResult()->error_string.empty()); // Statistics are only published on their topic
+
+  // Wait for the statistics of the trajectory goal
+  const ros::Time start_time = ros::Time::now();
+  TrackingStatisticsConstPtr stats = getTrackingStatistics();
+  while ((!stats || stats == home_stats) && (ros::Time::now() - start_time) < short_timeout)
+  {
+    ros::Duration(0.01).sleep();
+    stats = getTrackingStatistics();
+  }
+  ASSERT_TRUE(stats && stats != home_stats);
+
+  EXPECT_EQ(control_msgs::FollowJointTrajectoryResult::SUCCESSFUL, stats->error_code);
+  EXPECT_NEAR(traj.points.back().time_from_start.toSec(), stats->active_time.toSec(), 0.1);
+  ASSERT_EQ(n_joints, stats->joint_names.size());
+  ASSERT_EQ(n_joints, stats->max_position_error.size());
+  ASSERT_EQ(n_joints, stats->settling_time.size());
+  for (unsigned int i = 0; i < n_joints; ++i)
+  {
+    EXPECT_EQ(joint_names[i], stats->joint_names[i]);
+    EXPECT_LE(stats->rms_position_error[i], stats->max_position_error[i]);
+    EXPECT_LT(0.0, stats->min_path_position_margin[i]); // Path tolerances were met
+    EXPECT_FALSE(std::isnan(stats->settling_time[i]));
+    EXPECT_LE(0.0, stats->settling_time[i]);
+  }
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
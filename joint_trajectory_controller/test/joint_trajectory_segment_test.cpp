@@ -384,6 +384,102 @@ TEST_F(JointTrajectorySegmentTest, MappingTest)
   }
 }
 
+TEST_F(JointTrajectorySegmentTest, EffortInterpolation)
+{
+  // No effort data: zero effort
+  {
+    Segment segment(traj_start_time, p_start, p_end);
+    typename Segment::State state;
+    segment.sample(segment.startTime(), state);
+    ASSERT_EQ(1, state.effort.size());
+    EXPECT_EQ(0.0, state.effort[0]);
+  }
+
+  // Effort in both points: linear interpolation, held constant outside the segment
+  {
+    JointTrajectoryPoint p_start_eff = p_start;
+    JointTrajectoryPoint p_end_eff   = p_end;
+    p_start_eff.effort.resize(1, 1.0);
+    p_end_eff.effort.resize(1, 3.0);
+    Segment segment(traj_start_time, p_start_eff, p_end_eff);
+
+    typename Segment::State state;
+    segment.sample(segment.startTime(), state);
+    EXPECT_NEAR(1.0, state.effort[0], EPS);
+    segment.sample((segment.startTime() + segment.endTime()) / 2.0, state);
+    EXPECT_NEAR(2.0, state.effort[0], EPS);
+    segment.sample(segment.endTime(), state);
+    EXPECT_NEAR(3.0, state.effort[0], EPS);
+    segment.sample(segment.startTime() - 1.0, state);
+    EXPECT_NEAR(1.0, state.effort[0], EPS);
+    segment.sample(segment.endTime() + 1.0, state);
+    EXPECT_NEAR(3.0, state.effort[0], EPS);
+  }
+
+  // Effort in end point only: ramp from zero
+  {
+    JointTrajectoryPoint p_end_eff = p_end;
+    p_end_eff.effort.resize(1, 4.0);
+    Segment segment(traj_start_time, p_start, p_end_eff);
+
+    typename Segment::State state;
+    segment.sample(segment.startTime(), state);
+    EXPECT_NEAR(0.0, state.effort[0], EPS);
+    segment.sample(segment.endTime(), state);
+    EXPECT_NEAR(4.0, state.effort[0], EPS);
+  }
+
+  // Effort size mismatch
+  {
+    JointTrajectoryPoint p_start_bad = p_start;
+    p_start_bad.effort.resize(2, 0.0);
+    EXPECT_THROW(Segment(traj_start_time, p_start_bad, p_end), std::invalid_argument);
+  }
+}
+
+TEST_F(JointTrajectorySegmentTest, ImpedanceInterpolation)
+{
+  Segment segment(traj_start_time, p_start, p_end);
+  typename Segment::State state;
+
+  // No impedance data
+  EXPECT_FALSE(segment.hasImpedance());
+  segment.sample(segment.startTime(), state);
+  EXPECT_TRUE(state.stiffness.empty());
+  EXPECT_TRUE(state.damping.empty());
+
+  // Linear interpolation, held constant outside the segment
+  const std::vector<double> start_stiffness(1, 100.0), end_stiffness(1, 300.0);
+  const std::vector<double> start_damping(1, 10.0),    end_damping(1, 20.0);
+  segment.setImpedance(start_stiffness, start_damping, end_stiffness, end_damping);
+  EXPECT_TRUE(segment.hasImpedance());
+
+  segment.sample(segment.startTime(), state);
+  ASSERT_EQ(1, state.stiffness.size());
+  ASSERT_EQ(1, state.damping.size());
+  EXPECT_NEAR(100.0, state.stiffness[0], EPS);
+  EXPECT_NEAR(10.0,  state.damping[0],   EPS);
+  segment.sample((segment.startTime() + segment.endTime()) / 2.0, state);
+  EXPECT_NEAR(200.0, state.stiffness[0], EPS);
+  EXPECT_NEAR(15.0,  state.damping[0],   EPS);
+  segment.sample(segment.endTime() + 1.0, state);
+  EXPECT_NEAR(300.0, state.stiffness[0], EPS);
+  EXPECT_NEAR(20.0,  state.damping[0],   EPS);
+
+  // Sampled states carry the impedance, so segments built from them do too
+  typename Segment::State start_state, end_state;
+  segment.sample(segment.startTime(), start_state);
+  segment.sample(segment.endTime(),   end_state);
+  const Segment copy(segment.startTime(), start_state, segment.endTime(), end_state);
+  EXPECT_TRUE(copy.hasImpedance());
+
+  // Data must be specified at both boundaries
+  const std::vector<double> empty;
+  EXPECT_THROW(segment.setImpedance(start_stiffness, start_damping, empty, empty), std::invalid_argument);
+  EXPECT_THROW(segment.setImpedance(start_stiffness, start_damping, std::vector<double>(2, 0.0), end_damping),
+               std::invalid_argument);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,186 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/// \file Measures the cost of computing quintic spline coefficients, one segment at a time and in batches.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <trajectory_interface/quintic_spline_segment.h>
+
+namespace
+{
+
+typedef trajectory_interface::QuinticSplineSegment<double>     Segment;
+typedef std::vector<std::vector<Segment> >                     SegmentStorage;     // Per joint
+typedef std::vector<std::vector<Segment::SplineCoefficients> > CoefficientStorage; // Per joint
+
+const unsigned int N_KNOTS  = 1000;
+const unsigned int N_JOINTS = 14;
+const unsigned int RUNS     = 200;
+
+// Keeps the optimizer from discarding the computed coefficients
+volatile double sink;
+
+struct Knots
+{
+  std::vector<double> times;
+  std::vector<std::vector<double> > positions;     // Per joint
+  std::vector<std::vector<double> > velocities;    // Per joint
+  std::vector<std::vector<double> > accelerations; // Per joint
+};
+
+Knots makeKnots()
+{
+  Knots knots;
+  knots.times.resize(N_KNOTS);
+  knots.positions.assign(N_JOINTS, std::vector<double>(N_KNOTS));
+  knots.velocities.assign(N_JOINTS, std::vector<double>(N_KNOTS));
+  knots.accelerations.assign(N_JOINTS, std::vector<double>(N_KNOTS));
+  for (unsigned int i = 0; i < N_KNOTS; ++i)
+  {
+    knots.times[i] = 1e-2 * i + 1e-3 * std::sin(i); // Non-uniform spacing
+    for (unsigned int k = 0; k < N_JOINTS; ++k)
+    {
+      knots.positions[k][i]     =  std::sin(1e-2 * i + k);
+      knots.velocities[k][i]    =  std::cos(1e-2 * i + k);
+      knots.accelerations[k][i] = -std::sin(1e-2 * i + k);
+    }
+  }
+  return knots;
+}
+
+/// One segment at a time, from its boundary states
+void perSegment(const Knots& knots, SegmentStorage& segments)
+{
+  Segment::State start_state(1), end_state(1);
+  for (unsigned int k = 0; k < N_JOINTS; ++k)
+  {
+    for (unsigned int i = 0; i + 1 < N_KNOTS; ++i)
+    {
+      start_state.position[0]     = knots.positions[k][i];
+      start_state.velocity[0]     = knots.velocities[k][i];
+      start_state.acceleration[0] = knots.accelerations[k][i];
+      end_state.position[0]       = knots.positions[k][i + 1];
+      end_state.velocity[0]       = knots.velocities[k][i + 1];
+      end_state.acceleration[0]   = knots.accelerations[k][i + 1];
+      segments[k][i].init(knots.times[i], start_state, knots.times[i + 1], end_state);
+    }
+  }
+}
+
+/// Coefficients of all segments of a joint at once, sharing the duration powers across joints
+void batchedCoefficients(const Knots& knots, CoefficientStorage& coefficients)
+{
+  std::vector<Segment::DurationPowers> powers(N_KNOTS - 1);
+  for (unsigned int i = 0; i + 1 < N_KNOTS; ++i)
+  {
+    powers[i] = Segment::durationPowers(knots.times[i + 1] - knots.times[i]);
+  }
+
+  for (unsigned int k = 0; k < N_JOINTS; ++k)
+  {
+    Segment::computeCoefficients(N_KNOTS - 1, powers.data(), knots.positions[k].data(), knots.velocities[k].data(),
+                                 knots.accelerations[k].data(), coefficients[k].data());
+  }
+}
+
+/// Batched coefficients, then segments initialized from them. Batches are small enough to stay in cache
+void batched(const Knots& knots, SegmentStorage& segments)
+{
+  const unsigned int BATCH = 64;
+
+  std::vector<Segment::DurationPowers> powers(N_KNOTS - 1);
+  for (unsigned int i = 0; i + 1 < N_KNOTS; ++i)
+  {
+    powers[i] = Segment::durationPowers(knots.times[i + 1] - knots.times[i]);
+  }
+
+  Segment::SplineCoefficients coefficients[BATCH];
+  for (unsigned int k = 0; k < N_JOINTS; ++k)
+  {
+    for (unsigned int first = 0; first + 1 < N_KNOTS; first += BATCH)
+    {
+      const unsigned int n = std::min(BATCH, N_KNOTS - 1 - first);
+      Segment::computeCoefficients(n, &powers[first], &knots.positions[k][first], &knots.velocities[k][first],
+                                   &knots.accelerations[k][first], coefficients);
+      for (unsigned int i = 0; i < n; ++i)
+      {
+        segments[k][first + i].init(knots.times[first + i], knots.times[first + i + 1], coefficients[i]);
+      }
+    }
+  }
+}
+
+double lastValue(const SegmentStorage& storage)     {return storage.back().back().endTime();}
+double lastValue(const CoefficientStorage& storage) {return storage.back().back()[5];}
+
+template <class Storage, class Builder>
+void benchmark(const std::string& name, const Knots& knots, Storage storage, Builder builder)
+{
+  builder(knots, storage); // Warm up
+
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (unsigned int run = 0; run < RUNS; ++run)
+  {
+    builder(knots, storage);
+  }
+  const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  sink = lastValue(storage);
+
+  const double ns_per_knot = std::chrono::duration<double, std::nano>(end - start).count() / (RUNS * (N_KNOTS - 1));
+  std::cout << std::setw(14) << name
+            << std::setw(16) << std::fixed << std::setprecision(1) << ns_per_knot
+            << std::setw(16) << std::fixed << std::setprecision(1) << ns_per_knot / N_JOINTS << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  const Knots knots = makeKnots();
+
+  std::cout << N_KNOTS << " knots, " << N_JOINTS << " joints, quintic interpolation" << std::endl;
+  std::cout << std::setw(14) << "builder" << std::setw(16) << "ns/knot" << std::setw(16) << "ns/segment" << std::endl;
+  benchmark("per-segment", knots, SegmentStorage(N_JOINTS, std::vector<Segment>(N_KNOTS - 1)), perSegment);
+  benchmark("batched", knots, SegmentStorage(N_JOINTS, std::vector<Segment>(N_KNOTS - 1)), batched);
+  benchmark("coefficients", knots,
+            CoefficientStorage(N_JOINTS, std::vector<Segment::SplineCoefficients>(N_KNOTS - 1)), batchedCoefficients);
+  return 0;
+}
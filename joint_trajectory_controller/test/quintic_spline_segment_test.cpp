@@ -29,6 +29,7 @@
 
 #include <cmath>
 #include <stdexcept>
+#include <vector>
 #include <gtest/gtest.h>
 #include <ros/console.h>
 #include <trajectory_interface/quintic_spline_segment.h>
@@ -551,6 +552,60 @@ TEST(QuinticSplineSegmentTest, MultiDofTest)
   }
 }
 
+TEST(QuinticSplineSegmentTest, BatchedCoefficients)
+{
+  // Knots, including a zero-duration segment
+  const std::vector<double> times = {0.0, 0.5, 0.5, 2.0};
+  const std::vector<double> pos   = {1.0, 2.0, 0.5, -1.0};
+  const std::vector<double> vel   = {0.0, 1.0, -2.0, 0.5};
+  const std::vector<double> acc   = {0.5, -1.0, 3.0, 0.0};
+  const unsigned int n_segments = times.size() - 1;
+
+  std::vector<Segment::DurationPowers> powers;
+  for (unsigned int k = 0; k < n_segments; ++k) {powers.push_back(Segment::durationPowers(times[k + 1] - times[k]));}
+
+  // Linear, cubic and quintic interpolation
+  for (unsigned int order = 0; order < 3; ++order)
+  {
+    const double* vel_ptr = order > 0 ? vel.data() : 0;
+    const double* acc_ptr = order > 1 ? acc.data() : 0;
+    std::vector<Segment::SplineCoefficients> coefficients(n_segments);
+    Segment::computeCoefficients(n_segments, powers.data(), pos.data(), vel_ptr, acc_ptr, coefficients.data());
+
+    for (unsigned int k = 0; k < n_segments; ++k)
+    {
+      State start_state, end_state;
+      start_state.position.push_back(pos[k]);
+      end_state.position.push_back(pos[k + 1]);
+      if (vel_ptr) {start_state.velocity.push_back(vel[k]);     end_state.velocity.push_back(vel[k + 1]);}
+      if (acc_ptr) {start_state.acceleration.push_back(acc[k]); end_state.acceleration.push_back(acc[k + 1]);}
+
+      const Segment ref_segment(times[k], start_state, times[k + 1], end_state);
+      Segment segment;
+      segment.init(times[k], times[k + 1], coefficients[k]);
+      EXPECT_EQ(ref_segment.startTime(), segment.startTime());
+      EXPECT_EQ(ref_segment.endTime(),   segment.endTime());
+      EXPECT_EQ(1, segment.size());
+
+      for (double t = times[k]; t <= times[k + 1]; t += 0.1)
+      {
+        State ref_state, state;
+        ref_segment.sample(t, ref_state);
+        segment.sample(t, state);
+        EXPECT_NEAR(ref_state.position[0],     state.position[0],     EPS);
+        EXPECT_NEAR(ref_state.velocity[0],     state.velocity[0],     EPS);
+        EXPECT_NEAR(ref_state.acceleration[0], state.acceleration[0], EPS);
+      }
+    }
+  }
+
+  // Invalid segment times
+  {
+    Segment segment;
+    EXPECT_THROW(segment.init(1.0, 0.0, Segment::SplineCoefficients()), std::invalid_argument);
+  }
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
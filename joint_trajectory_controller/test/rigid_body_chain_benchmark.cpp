@@ -0,0 +1,125 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/// \file Measures the per-cycle cost of RigidBodyChain::inverseDynamics on serial arms of increasing size.
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <joint_trajectory_controller/rigid_body_chain.h>
+
+namespace
+{
+
+const unsigned int CYCLES = 100000;
+
+// Keeps the optimizer from discarding the computed efforts
+volatile double sink;
+
+/// Arm whose consecutive joint axes are perpendicular, as in most industrial and collaborative arms
+std::string armUrdf(unsigned int n_joints)
+{
+  std::stringstream ss;
+  ss << "<robot name=\"arm\"><link name=\"link0\"/>";
+  for (unsigned int k = 1; k <= n_joints; ++k)
+  {
+    ss << "<link name=\"link" << k << "\"><inertial><origin xyz=\"0.01 0.02 0.1\" rpy=\"0 0 0\"/>"
+       << "<mass value=\"" << 4.0 - 0.4 * k << "\"/>"
+       << "<inertia ixx=\"0.05\" ixy=\"0.001\" ixz=\"0.002\" iyy=\"0.04\" iyz=\"0.003\" izz=\"0.02\"/>"
+       << "</inertial></link>";
+    ss << "<joint name=\"joint" << k << "\" type=\"revolute\"><parent link=\"link" << k - 1 << "\"/>"
+       << "<child link=\"link" << k << "\"/><origin xyz=\"0 0 0.2\" rpy=\"" << (k % 2 ? 1.5708 : -1.5708) << " 0 0\"/>"
+       << "<axis xyz=\"0 0 1\"/><limit lower=\"-3\" upper=\"3\" effort=\"100\" velocity=\"10\"/></joint>";
+  }
+  ss << "</robot>";
+  return ss.str();
+}
+
+void benchmark(unsigned int n_joints)
+{
+  urdf::Model urdf;
+  std::vector<std::string> joint_names;
+  for (unsigned int k = 1; k <= n_joints; ++k) {joint_names.push_back("joint" + std::to_string(k));}
+
+  joint_trajectory_controller::RigidBodyChain chain;
+  if (!urdf.initString(armUrdf(n_joints)) || !chain.init(urdf, joint_names))
+  {
+    std::cerr << "Failed to build a " << n_joints << "-joint chain." << std::endl;
+    return;
+  }
+
+  // Desired states are precomputed so that only the inverse dynamics are measured
+  std::vector<std::vector<double> > positions(64, std::vector<double>(n_joints));
+  std::vector<std::vector<double> > velocities(64, std::vector<double>(n_joints));
+  std::vector<std::vector<double> > accelerations(64, std::vector<double>(n_joints));
+  for (unsigned int cycle = 0; cycle < positions.size(); ++cycle)
+  {
+    for (unsigned int k = 0; k < n_joints; ++k)
+    {
+      positions[cycle][k]     = std::sin(1e-2 * cycle + k);
+      velocities[cycle][k]    = std::cos(1e-2 * cycle + k);
+      accelerations[cycle][k] = -std::sin(1e-2 * cycle + k);
+    }
+  }
+  std::vector<double> efforts(n_joints);
+
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (unsigned int cycle = 0; cycle < CYCLES; ++cycle)
+  {
+    const unsigned int sample = cycle % positions.size();
+    chain.inverseDynamics(positions[sample], velocities[sample], accelerations[sample], efforts);
+    sink = efforts[0];
+  }
+  const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+  std::cout << std::setw(8)  << n_joints
+            << std::setw(16) << std::fixed << std::setprecision(1)
+            << std::chrono::duration<double, std::nano>(end - start).count() / CYCLES << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  std::cout << std::setw(8) << "joints" << std::setw(16) << "ns/cycle" << std::endl;
+
+  const unsigned int n_joints[] = {6, 7};
+  for (unsigned int n : n_joints) {benchmark(n);}
+  return 0;
+}
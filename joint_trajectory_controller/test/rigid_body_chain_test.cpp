@@ -0,0 +1,374 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <joint_trajectory_controller/rigid_body_chain.h>
+
+using joint_trajectory_controller::RigidBodyChain;
+using std::string;
+using std::vector;
+
+// Floating-point value comparison threshold
+const double EPS = 1e-9;
+
+// Two-link planar arm moving in the xy plane, with gravity along -y
+const double m1 = 2.0, l1 = 0.5, lc1 = 0.2, i1 = 0.03;
+const double m2 = 1.5, lc2 = 0.3, i2 = 0.02;
+const double g = 9.81;
+
+string link(const string& name, double mass, double com_x, double izz)
+{
+  std::stringstream ss;
+  ss << "<link name=\"" << name << "\"><inertial><origin xyz=\"" << com_x << " 0 0\" rpy=\"0 0 0\"/>"
+     << "<mass value=\"" << mass << "\"/>"
+     << "<inertia ixx=\"0.01\" ixy=\"0\" ixz=\"0\" iyy=\"0.01\" iyz=\"0\" izz=\"" << izz << "\"/></inertial></link>";
+  return ss.str();
+}
+
+string joint(const string& name, const string& type, const string& parent, const string& child, double x,
+             const string& axis = "0 0 1", const string& rpy = "0 0 0")
+{
+  std::stringstream ss;
+  ss << "<joint name=\"" << name << "\" type=\"" << type << "\"><parent link=\"" << parent << "\"/>"
+     << "<child link=\"" << child << "\"/><origin xyz=\"" << x << " 0 0\" rpy=\"" << rpy << "\"/>"
+     << "<axis xyz=\"" << axis << "\"/><limit lower=\"-3\" upper=\"3\" effort=\"100\" velocity=\"10\"/></joint>";
+  return ss.str();
+}
+
+string twoLinkArm()
+{
+  return "<robot name=\"arm\"><link name=\"base\"/>" +
+         link("link1", m1, lc1, i1) + link("link2", m2, lc2, i2) +
+         joint("joint1", "revolute", "base", "link1", 0.0) +
+         joint("joint2", "continuous", "link1", "link2", l1) +
+         "</robot>";
+}
+
+vector<double> twoLinkArmEffort(const vector<double>& q, const vector<double>& qd, const vector<double>& qdd)
+{
+  const double c2 = std::cos(q[1]);
+  const double h = -m2 * l1 * lc2 * std::sin(q[1]);
+
+  const double m11 = m1 * lc1 * lc1 + i1 + m2 * (l1 * l1 + lc2 * lc2 + 2.0 * l1 * lc2 * c2) + i2;
+  const double m12 = m2 * (lc2 * lc2 + l1 * lc2 * c2) + i2;
+  const double m22 = m2 * lc2 * lc2 + i2;
+
+  const double g1 = (m1 * lc1 + m2 * l1) * g * std::cos(q[0]) + m2 * lc2 * g * std::cos(q[0] + q[1]);
+  const double g2 = m2 * lc2 * g * std::cos(q[0] + q[1]);
+
+  vector<double> effort(2);
+  effort[0] = m11 * qdd[0] + m12 * qdd[1] + h * qd[1] * qd[1] + 2.0 * h * qd[0] * qd[1] + g1;
+  effort[1] = m12 * qdd[0] + m22 * qdd[1] - h * qd[0] * qd[0] + g2;
+  return effort;
+}
+
+class RigidBodyChainTest : public ::testing::Test
+{
+public:
+  RigidBodyChainTest()
+  {
+    joint_names = {"joint1", "joint2"};
+
+    const vector<double> q_values   = {0.0, 0.4, -1.2, 2.5};
+    const vector<double> qd_values  = {0.0, -0.7, 1.3};
+    const vector<double> qdd_values = {0.0, 2.0, -0.5};
+    for (double q : q_values)
+    {
+      for (double qd : qd_values)
+      {
+        for (double qdd : qdd_values)
+        {
+          positions.push_back({q, 0.5 * q - 0.3});
+          velocities.push_back({qd, -0.8 * qd + 0.2});
+          accelerations.push_back({qdd, 1.5 * qdd - 0.4});
+        }
+      }
+    }
+  }
+
+protected:
+  vector<string> joint_names;
+  vector<vector<double> > positions;
+  vector<vector<double> > velocities;
+  vector<vector<double> > accelerations;
+
+  void expectSameEfforts(RigidBodyChain& chain, RigidBodyChain& ref_chain)
+  {
+    vector<double> effort(2), ref_effort(2);
+    for (unsigned int k = 0; k < positions.size(); ++k)
+    {
+      chain.inverseDynamics(positions[k], velocities[k], accelerations[k], effort);
+      ref_chain.inverseDynamics(positions[k], velocities[k], accelerations[k], ref_effort);
+      EXPECT_NEAR(ref_effort[0], effort[0], EPS);
+      EXPECT_NEAR(ref_effort[1], effort[1], EPS);
+    }
+  }
+};
+
+TEST_F(RigidBodyChainTest, TwoLinkArm)
+{
+  urdf::Model urdf;
+  ASSERT_TRUE(urdf.initString(twoLinkArm()));
+
+  RigidBodyChain chain;
+  ASSERT_TRUE(chain.init(urdf, joint_names));
+  EXPECT_EQ(2, chain.size());
+  chain.setGravity({0.0, -g, 0.0});
+
+  vector<double> effort(2);
+  for (unsigned int k = 0; k < positions.size(); ++k)
+  {
+    chain.inverseDynamics(positions[k], velocities[k], accelerations[k], effort);
+    const vector<double> ref_effort = twoLinkArmEffort(positions[k], velocities[k], accelerations[k]);
+    EXPECT_NEAR(ref_effort[0], effort[0], EPS);
+    EXPECT_NEAR(ref_effort[1], effort[1], EPS);
+  }
+}
+
+TEST_F(RigidBodyChainTest, JointOrder)
+{
+  urdf::Model urdf;
+  ASSERT_TRUE(urdf.initString(twoLinkArm()));
+
+  RigidBodyChain chain;
+  ASSERT_TRUE(chain.init(urdf, {"joint2", "joint1"}));
+  chain.setGravity({0.0, -g, 0.0});
+
+  vector<double> effort(2);
+  for (unsigned int k = 0; k < positions.size(); ++k)
+  {
+    const vector<double> q   = {positions[k][1], positions[k][0]};
+    const vector<double> qd  = {velocities[k][1], velocities[k][0]};
+    const vector<double> qdd = {accelerations[k][1], accelerations[k][0]};
+    chain.inverseDynamics(q, qd, qdd, effort);
+    const vector<double> ref_effort = twoLinkArmEffort(positions[k], velocities[k], accelerations[k]);
+    EXPECT_NEAR(ref_effort[1], effort[0], EPS);
+    EXPECT_NEAR(ref_effort[0], effort[1], EPS);
+  }
+}
+
+TEST_F(RigidBodyChainTest, FixedLinksAreLumped)
+{
+  // Same arm, with the base rotated about the z axis by a fixed joint, and the second link split into two halves
+  // connected by a fixed joint. A branch hanging off the first link is also massless
+  const string urdf_str =
+    "<robot name=\"arm\"><link name=\"world\"/><link name=\"base\"/><link name=\"branch\"/>" +
+    link("link1", m1, lc1, i1) + link("link2", 0.5 * m2, lc2, 0.5 * i2) + link("link2b", 0.5 * m2, 0.0, 0.5 * i2) +
+    joint("world_joint", "fixed", "world", "base", 0.0, "0 0 1", "0 0 1.1") +
+    joint("joint1", "revolute", "base", "link1", 0.0) +
+    joint("branch_joint", "revolute", "link1", "branch", 0.1) +
+    joint("joint2", "continuous", "link1", "link2", l1) +
+    joint("link2_joint", "fixed", "link2", "link2b", lc2) +
+    "</robot>";
+
+  urdf::Model ref_urdf, urdf;
+  ASSERT_TRUE(ref_urdf.initString(twoLinkArm()));
+  ASSERT_TRUE(urdf.initString(urdf_str));
+
+  RigidBodyChain ref_chain, chain;
+  ASSERT_TRUE(ref_chain.init(ref_urdf, joint_names));
+  ASSERT_TRUE(chain.init(urdf, joint_names));
+
+  // Gravity in the world frame, which is rotated w.r.t. the base: only its direction changes
+  ref_chain.setGravity({0.0, -g, 0.0});
+  chain.setGravity({g * std::sin(1.1), -g * std::cos(1.1), 0.0});
+
+  expectSameEfforts(chain, ref_chain);
+}
+
+TEST_F(RigidBodyChainTest, PrismaticJoint)
+{
+  // Vertical prismatic joint carrying the two-link arm
+  const double m0 = 3.0;
+  const string urdf_str =
+    "<robot name=\"arm\"><link name=\"world\"/>" + link("base", m0, 0.0, 0.01) +
+    link("link1", m1, lc1, i1) + link("link2", m2, lc2, i2) +
+    joint("lift", "prismatic", "world", "base", 0.0, "0 1 0") +
+    joint("joint1", "revolute", "base", "link1", 0.0) +
+    joint("joint2", "continuous", "link1", "link2", l1) +
+    "</robot>";
+
+  urdf::Model urdf;
+  ASSERT_TRUE(urdf.initString(urdf_str));
+
+  RigidBodyChain chain;
+  ASSERT_TRUE(chain.init(urdf, {"joint1", "joint2", "lift"}));
+  chain.setGravity({0.0, -g, 0.0});
+
+  // Static lift: the arm sees the usual gravity and the lift carries the whole weight
+  const vector<double> q   = {0.3, -0.6, 0.25};
+  const vector<double> qd  = {0.0, 0.0, 0.4};
+  const vector<double> qdd = {0.0, 0.0, 0.0};
+  vector<double> effort(3);
+  chain.inverseDynamics(q, qd, qdd, effort);
+
+  const vector<double> ref_effort = twoLinkArmEffort({q[0], q[1]}, {0.0, 0.0}, {0.0, 0.0});
+  EXPECT_NEAR(ref_effort[0], effort[0], EPS);
+  EXPECT_NEAR(ref_effort[1], effort[1], EPS);
+  EXPECT_NEAR((m0 + m1 + m2) * g, effort[2], EPS);
+
+  // Accelerating the lift upwards is equivalent to a stronger gravity
+  const vector<double> lift_qdd = {0.0, 0.0, 2.0};
+  chain.inverseDynamics(q, qd, lift_qdd, effort);
+  EXPECT_NEAR((m0 + m1 + m2) * (g + 2.0), effort[2], EPS);
+  EXPECT_NEAR(ref_effort[0] * (g + 2.0) / g, effort[0], EPS);
+}
+
+TEST_F(RigidBodyChainTest, Kinematics)
+{
+  // Two-link arm with a tool frame rigidly attached to its second link
+  const double lt = 0.25;
+  const string urdf_str =
+    "<robot name=\"arm\"><link name=\"base\"/><link name=\"tool\"/>" +
+    link("link1", m1, lc1, i1) + link("link2", m2, lc2, i2) +
+    joint("joint1", "revolute", "base", "link1", 0.0) +
+    joint("joint2", "continuous", "link1", "link2", l1) +
+    joint("tool_joint", "fixed", "link2", "tool", lt) +
+    "</robot>";
+
+  urdf::Model urdf;
+  ASSERT_TRUE(urdf.initString(urdf_str));
+
+  RigidBodyChain chain;
+  ASSERT_TRUE(chain.init(urdf, joint_names));
+  EXPECT_FALSE(chain.setTip(urdf, "link1"));
+  EXPECT_FALSE(chain.setTip(urdf, "bad_link"));
+  ASSERT_TRUE(chain.setTip(urdf, "tool"));
+
+  vector<double> jacobian(12);
+  for (const auto& q : positions)
+  {
+    const double q12 = q[0] + q[1];
+    const double x = l1 * std::cos(q[0]) + lt * std::cos(q12);
+    const double y = l1 * std::sin(q[0]) + lt * std::sin(q12);
+
+    const RigidBodyChain::Transform pose = chain.tipPose(q);
+    EXPECT_NEAR(x, pose.translation.x, EPS);
+    EXPECT_NEAR(y, pose.translation.y, EPS);
+    EXPECT_NEAR(0.0, pose.translation.z, EPS);
+    EXPECT_NEAR(std::cos(q12), pose.rotation.m[0], EPS);
+    EXPECT_NEAR(std::sin(q12), pose.rotation.m[3], EPS);
+
+    // Planar arm: only the xy linear and the z angular rows are populated
+    const RigidBodyChain::Transform jacobian_pose = chain.jacobian(q, jacobian);
+    EXPECT_NEAR(x, jacobian_pose.translation.x, EPS);
+    const vector<double> ref_jacobian = {-y, -lt * std::sin(q12),
+                                          x,  lt * std::cos(q12),
+                                          0.0, 0.0,
+                                          0.0, 0.0,
+                                          0.0, 0.0,
+                                          1.0, 1.0};
+    for (unsigned int i = 0; i < ref_jacobian.size(); ++i) {EXPECT_NEAR(ref_jacobian[i], jacobian[i], EPS);}
+  }
+}
+
+TEST_F(RigidBodyChainTest, PrismaticJacobian)
+{
+  const string urdf_str =
+    "<robot name=\"arm\"><link name=\"world\"/><link name=\"base\"/>" +
+    link("link1", m1, lc1, i1) + link("link2", m2, lc2, i2) +
+    joint("lift", "prismatic", "world", "base", 0.0, "0 1 0") +
+    joint("joint1", "revolute", "base", "link1", 0.0) +
+    joint("joint2", "continuous", "link1", "link2", l1) +
+    "</robot>";
+
+  urdf::Model urdf;
+  ASSERT_TRUE(urdf.initString(urdf_str));
+
+  RigidBodyChain chain;
+  ASSERT_TRUE(chain.init(urdf, {"lift", "joint1", "joint2"}));
+
+  // Finite-difference check of the linear rows, and the lift translates the tip without rotating it
+  const vector<double> q = {0.2, 0.7, -1.1};
+  vector<double> jacobian(18);
+  chain.jacobian(q, jacobian);
+  const double h = 1e-6;
+  for (unsigned int j = 0; j < q.size(); ++j)
+  {
+    vector<double> q_plus = q, q_minus = q;
+    q_plus[j]  += h;
+    q_minus[j] -= h;
+    const RigidBodyChain::Vector3 d = (1.0 / (2.0 * h)) * (chain.tipPose(q_plus).translation -
+                                                           chain.tipPose(q_minus).translation);
+    EXPECT_NEAR(d.x, jacobian[j],     1e-6);
+    EXPECT_NEAR(d.y, jacobian[3 + j], 1e-6);
+    EXPECT_NEAR(d.z, jacobian[6 + j], 1e-6);
+  }
+  EXPECT_NEAR(1.0, jacobian[3],  EPS);
+  EXPECT_NEAR(0.0, jacobian[15], EPS);
+}
+
+TEST_F(RigidBodyChainTest, RotationVector)
+{
+  using namespace joint_trajectory_controller::internal;
+
+  const vector<Vector3> rotations = {{0.0, 0.0, 0.0}, {1e-7, -2e-7, 0.0}, {0.3, -0.2, 0.9},
+                                     {0.0, 3.1, 0.0}, {-1.8, 1.2, 1.9},   {0.0, 0.0, -3.0}};
+  for (const Vector3& v : rotations)
+  {
+    const Vector3 r = rotationVector(rotationMatrix(v));
+    EXPECT_NEAR(v.x, r.x, EPS);
+    EXPECT_NEAR(v.y, r.y, EPS);
+    EXPECT_NEAR(v.z, r.z, EPS);
+
+    const Transform t = {rotationMatrix(v), {0.1, -0.4, 2.0}};
+    const Transform identity = t * inverse(t);
+    for (unsigned int i = 0; i < 9; ++i) {EXPECT_NEAR(Matrix3::identity().m[i], identity.rotation.m[i], EPS);}
+    EXPECT_NEAR(0.0, identity.translation.z, EPS);
+  }
+}
+
+TEST_F(RigidBodyChainTest, InvalidChains)
+{
+  urdf::Model urdf;
+  ASSERT_TRUE(urdf.initString(twoLinkArm()));
+
+  RigidBodyChain chain;
+  EXPECT_FALSE(chain.init(urdf, vector<string>()));
+  EXPECT_FALSE(chain.init(urdf, {"joint1", "bad_joint"}));
+  EXPECT_FALSE(chain.init(urdf, {"joint2"}));                     // joint1 lies in between
+  EXPECT_EQ(0, chain.size());
+  EXPECT_TRUE(chain.init(urdf, {"joint1"}));                      // joint2 and link2 are a branch of link1
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,111 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <string>
+
+#include <gtest/gtest.h>
+#include <joint_trajectory_controller/segment_command_interface.h>
+
+using namespace joint_trajectory_controller;
+
+SegmentCommand makeSegment(double start_time)
+{
+  SegmentCommand segment;
+  segment.start_time = start_time;
+  segment.duration   = 1.0;
+  return segment;
+}
+
+TEST(SegmentQueueTest, FirstInFirstOut)
+{
+  SegmentQueue queue(3);
+  EXPECT_EQ(3u, queue.capacity());
+  EXPECT_TRUE(queue.empty());
+
+  EXPECT_TRUE(queue.push(makeSegment(0.0)));
+  EXPECT_TRUE(queue.push(makeSegment(1.0)));
+  EXPECT_TRUE(queue.push(makeSegment(2.0)));
+  EXPECT_TRUE(queue.full());
+  EXPECT_FALSE(queue.push(makeSegment(3.0)));
+  EXPECT_EQ(3u, queue.size());
+
+  // Wrap around the end of the storage
+  EXPECT_EQ(0.0, queue.front().start_time);
+  queue.pop();
+  EXPECT_TRUE(queue.push(makeSegment(3.0)));
+  for (unsigned int i = 1; i < 4; ++i)
+  {
+    ASSERT_FALSE(queue.empty());
+    EXPECT_EQ(static_cast<double>(i), queue.front().start_time);
+    queue.pop();
+  }
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(SegmentQueueTest, ClearStartsNewGeneration)
+{
+  SegmentQueue queue(2);
+  const unsigned generation = queue.generation();
+  queue.push(makeSegment(0.0));
+  queue.push(makeSegment(1.0));
+
+  queue.clear();
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(generation + 1, queue.generation());
+
+  EXPECT_TRUE(queue.push(makeSegment(2.0)));
+  EXPECT_EQ(2.0, queue.front().start_time);
+}
+
+TEST(SegmentJointInterfaceTest, HandleAccess)
+{
+  double pos = 1.0, vel = 2.0, eff = 3.0;
+  hardware_interface::JointStateHandle state_handle("joint", &pos, &vel, &eff);
+  EXPECT_THROW(SegmentJointHandle(state_handle, 0), hardware_interface::HardwareInterfaceException);
+
+  SegmentQueue queue;
+  SegmentJointInterface iface;
+  iface.registerHandle(SegmentJointHandle(state_handle, &queue));
+
+  SegmentJointHandle handle = iface.getHandle("joint");
+  EXPECT_EQ(1.0, handle.getPosition());
+  EXPECT_EQ(&queue, handle.getQueue());
+  EXPECT_THROW(iface.getHandle("other_joint"), hardware_interface::HardwareInterfaceException);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
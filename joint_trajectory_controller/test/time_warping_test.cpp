@@ -0,0 +1,146 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <joint_trajectory_controller/time_warping.h>
+
+typedef joint_trajectory_controller::TimeWarping<double> TimeWarping;
+
+// Floating-point value comparison threshold
+const double EPS = 1e-9;
+
+// Control period
+const double PERIOD = 0.01;
+
+TEST(TimeWarpingTest, InvalidParameters)
+{
+  TimeWarping::Parameters params;
+  TimeWarping warping;
+  EXPECT_TRUE(warping.init(params));
+
+  params.min_scale = 0.0;
+  EXPECT_FALSE(warping.init(params));
+  params.min_scale = 1.5;
+  EXPECT_FALSE(warping.init(params));
+
+  params = TimeWarping::Parameters();
+  params.slowdown_error_ratio = 1.0;
+  EXPECT_FALSE(warping.init(params));
+
+  params = TimeWarping::Parameters();
+  params.recovery_rate = 0.0;
+  EXPECT_FALSE(warping.init(params));
+
+  params = TimeWarping::Parameters();
+  params.max_violation_duration = -1.0;
+  EXPECT_FALSE(warping.init(params));
+}
+
+TEST(TimeWarpingTest, ScaleFollowsError)
+{
+  TimeWarping::Parameters params;
+  params.min_scale            = 0.2;
+  params.slowdown_error_ratio = 0.5;
+  params.recovery_rate        = 1.0;
+
+  TimeWarping warping;
+  ASSERT_TRUE(warping.init(params));
+  EXPECT_EQ(1.0, warping.scale());
+
+  // Small errors do not slow down the clock
+  warping.update(0.4, false, PERIOD);
+  EXPECT_EQ(1.0, warping.scale());
+
+  // Slowing down is immediate, and linear in the error
+  warping.update(0.75, false, PERIOD);
+  EXPECT_NEAR(0.6, warping.scale(), EPS);
+  warping.update(1.0, false, PERIOD);
+  EXPECT_NEAR(0.2, warping.scale(), EPS);
+  warping.update(3.0, true, PERIOD);
+  EXPECT_NEAR(0.2, warping.scale(), EPS);
+
+  // Recovery is rate-limited
+  warping.update(0.0, false, PERIOD);
+  EXPECT_NEAR(0.2 + params.recovery_rate * PERIOD, warping.scale(), EPS);
+  for (unsigned int i = 0; i < 100; ++i) {warping.update(0.0, false, PERIOD);}
+  EXPECT_EQ(1.0, warping.scale());
+}
+
+TEST(TimeWarpingTest, ClockAdvance)
+{
+  TimeWarping::Parameters params;
+  params.min_scale = 0.5;
+  TimeWarping warping;
+  ASSERT_TRUE(warping.init(params));
+
+  EXPECT_NEAR(PERIOD, warping.advance(PERIOD), EPS);
+  EXPECT_EQ(0.0, warping.delay());
+
+  warping.update(1.0, false, PERIOD);
+  EXPECT_NEAR(0.5 * PERIOD, warping.advance(PERIOD), EPS);
+  EXPECT_NEAR(0.5 * PERIOD, warping.delay(), EPS);
+
+  warping.reset();
+  EXPECT_EQ(1.0, warping.scale());
+  EXPECT_EQ(0.0, warping.delay());
+}
+
+TEST(TimeWarpingTest, PersistentViolation)
+{
+  TimeWarping::Parameters params;
+  params.max_violation_duration = 0.1;
+  TimeWarping warping;
+  ASSERT_TRUE(warping.init(params));
+
+  // Short violations are tolerated
+  for (unsigned int i = 0; i < 5; ++i) {EXPECT_FALSE(warping.update(2.0, true, PERIOD));}
+  EXPECT_FALSE(warping.update(0.5, false, PERIOD));
+
+  // Violations lasting longer than the limit are not
+  bool abort = false;
+  unsigned int cycles = 0;
+  while (!abort && cycles < 100)
+  {
+    abort = warping.update(2.0, true, PERIOD);
+    ++cycles;
+  }
+  EXPECT_TRUE(abort);
+  EXPECT_EQ(11u, cycles);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,141 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+#include <joint_trajectory_controller/tracking_statistics.h>
+
+using joint_trajectory_controller::StateTolerances;
+
+typedef joint_trajectory_controller::TrackingStatistics<double> TrackingStatistics;
+
+// Floating-point value comparison threshold
+const double EPS = 1e-9;
+
+TEST(TrackingStatisticsTest, EmptyStatistics)
+{
+  TrackingStatistics stats;
+  stats.resize(2);
+  ASSERT_EQ(2u, stats.size());
+
+  for (unsigned int i = 0; i < stats.size(); ++i)
+  {
+    EXPECT_EQ(0u, stats[i].samples);
+    EXPECT_EQ(0.0, stats[i].rmsPositionError());
+    EXPECT_EQ(0.0, stats[i].max_position_error);
+    EXPECT_TRUE(std::isnan(stats[i].min_path_position_margin));
+    EXPECT_TRUE(std::isnan(stats[i].settling_time));
+    EXPECT_FALSE(stats[i].settled);
+  }
+}
+
+TEST(TrackingStatisticsTest, ErrorsAndMargins)
+{
+  TrackingStatistics stats;
+  stats.resize(2);
+  stats.reset(10.0);
+
+  // Only the position tolerance of joint 0 is set
+  const StateTolerances<double> tolerance(0.5, 0.0);
+  const double position_errors[] = {0.1, -0.3, 0.2, -0.2};
+  for (unsigned int k = 0; k < 4; ++k)
+  {
+    stats.addSample(0, 10.0 + 0.1 * k, position_errors[k], 2.0 * position_errors[k], &tolerance);
+    stats.addSample(1, 10.0 + 0.1 * k, 0.0, 0.0);
+  }
+
+  EXPECT_EQ(4u, stats[0].samples);
+  EXPECT_NEAR(std::sqrt((0.01 + 0.09 + 0.04 + 0.04) / 4.0), stats[0].rmsPositionError(), EPS);
+  EXPECT_NEAR(2.0 * stats[0].rmsPositionError(), stats[0].rmsVelocityError(), EPS);
+  EXPECT_NEAR(0.3, stats[0].max_position_error, EPS);
+  EXPECT_NEAR(0.6, stats[0].max_velocity_error, EPS);
+  EXPECT_NEAR(0.2, stats[0].min_path_position_margin, EPS);
+  EXPECT_TRUE(std::isnan(stats[0].min_path_velocity_margin)); // Tolerance not set
+
+  EXPECT_EQ(0.0, stats[1].max_position_error);
+  EXPECT_TRUE(std::isnan(stats[1].min_path_position_margin)); // No path samples
+
+  EXPECT_NEAR(10.0, stats.startTime(), EPS);
+  EXPECT_NEAR(10.3, stats.endTime(),   EPS);
+
+  // Violated tolerances have negative margins
+  stats.addSample(0, 10.4, 0.7, 0.0, &tolerance);
+  EXPECT_NEAR(-0.2, stats[0].min_path_position_margin, EPS);
+}
+
+TEST(TrackingStatisticsTest, Settling)
+{
+  TrackingStatistics stats;
+  stats.resize(1);
+  stats.reset(0.0);
+
+  const StateTolerances<double> goal_tolerance(0.1, 0.2);
+  stats.setSettled(0, 0.05, 0.04, -0.05, goal_tolerance);
+  EXPECT_TRUE(stats[0].settled);
+  EXPECT_NEAR(0.05, stats[0].settling_time,        EPS);
+  EXPECT_NEAR(0.06, stats[0].goal_position_margin, EPS);
+  EXPECT_NEAR(0.15, stats[0].goal_velocity_margin, EPS);
+
+  // Only the first time a joint settles is recorded
+  stats.setSettled(0, 0.08, 0.0, 0.0, goal_tolerance);
+  EXPECT_NEAR(0.05, stats[0].settling_time, EPS);
+
+  // Statistics are cleared for the next goal
+  stats.reset(1.0);
+  EXPECT_FALSE(stats[0].settled);
+  EXPECT_TRUE(std::isnan(stats[0].settling_time));
+  EXPECT_NEAR(1.0, stats.startTime(), EPS);
+}
+
+TEST(TrackingStatisticsTest, CopyPreservesStatistics)
+{
+  TrackingStatistics stats;
+  stats.resize(3);
+  stats.reset(0.0);
+  stats.addSample(2, 0.5, -0.25, 0.0);
+
+  TrackingStatistics finished;
+  finished.resize(3);
+  finished = stats;
+  EXPECT_EQ(1u, finished[2].samples);
+  EXPECT_NEAR(0.25, finished[2].max_position_error, EPS);
+  EXPECT_NEAR(0.5, finished.endTime(), EPS);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
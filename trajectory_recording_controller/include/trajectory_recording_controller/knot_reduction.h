@@ -0,0 +1,142 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef TRAJECTORY_RECORDING_CONTROLLER_KNOT_REDUCTION_H
+#define TRAJECTORY_RECORDING_CONTROLLER_KNOT_REDUCTION_H
+
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace trajectory_recording_controller
+{
+
+namespace internal
+{
+
+/**
+ * \brief Cubic Hermite interpolation between \p (t0, p0, v0) and \p (t1, p1, v1), evaluated at \p t.
+ */
+inline double hermite(double t0, double p0, double v0, double t1, double p1, double v1, double t)
+{
+  const double h  = t1 - t0;
+  const double s  = (t - t0) / h;
+  const double s2 = s * s;
+  const double s3 = s2 * s;
+  return (2.0 * s3 - 3.0 * s2 + 1.0) * p0 + (s3 - 2.0 * s2 + s) * h * v0 +
+         (-2.0 * s3 + 3.0 * s2)      * p1 + (s3 - s2)             * h * v1;
+}
+
+} // namespace
+
+/**
+ * \brief Select the samples of a recording to keep as knots of a trajectory.
+ *
+ * Knots keep the recorded positions and velocities, and are interpolated with cubic Hermite polynomials, which is how
+ * \p joint_trajectory_controller samples points that specify positions and velocities. As in the Ramer-Douglas-Peucker
+ * algorithm, the sample deviating the most from the interpolation of the current knots is added as a knot, until no
+ * dropped sample deviates more than \p tolerances. Typical complexity is \f$ O(n \log n) \f$ in the number of samples.
+ *
+ * \param times Sample times, strictly increasing.
+ * \param positions Sample positions, stored row-major with one row of \p tolerances.size() joints per sample.
+ * \param velocities Sample velocities, with the same layout as \p positions.
+ * \param tolerances Maximum position deviation of each joint. Must be positive.
+ *
+ * \return Increasing indices of the samples to keep. The first and last samples are always kept.
+ */
+inline std::vector<std::size_t> reduceKnots(const std::vector<double>& times,
+                                            const std::vector<double>& positions,
+                                            const std::vector<double>& velocities,
+                                            const std::vector<double>& tolerances)
+{
+  std::vector<std::size_t> knots;
+  const std::size_t n_samples = times.size();
+  const std::size_t n_joints  = tolerances.size();
+  if (n_samples == 0) {return knots;}
+
+  std::vector<bool> is_knot(n_samples, false);
+  is_knot.front() = true;
+  is_knot.back()  = true;
+
+  // Intervals between consecutive knots that still have to be checked
+  std::vector<std::pair<std::size_t, std::size_t> > intervals;
+  if (n_samples > 2) {intervals.push_back(std::make_pair(std::size_t(0), n_samples - 1));}
+
+  while (!intervals.empty())
+  {
+    const std::size_t first = intervals.back().first;
+    const std::size_t last  = intervals.back().second;
+    intervals.pop_back();
+
+    const double* p0 = &positions[first * n_joints];
+    const double* v0 = &velocities[first * n_joints];
+    const double* p1 = &positions[last * n_joints];
+    const double* v1 = &velocities[last * n_joints];
+
+    // Deviations are relative to the tolerance of each joint, so that knots are only added above one
+    double      max_deviation = 1.0;
+    std::size_t worst         = first;
+    for (std::size_t i = first + 1; i < last; ++i)
+    {
+      const double* p = &positions[i * n_joints];
+      for (std::size_t j = 0; j < n_joints; ++j)
+      {
+        const double expected  = internal::hermite(times[first], p0[j], v0[j], times[last], p1[j], v1[j], times[i]);
+        const double deviation = std::abs(p[j] - expected) / tolerances[j];
+        if (deviation > max_deviation)
+        {
+          max_deviation = deviation;
+          worst         = i;
+        }
+      }
+    }
+
+    if (worst == first) {continue;} // All samples within tolerance
+
+    is_knot[worst] = true;
+    if (worst - first > 1) {intervals.push_back(std::make_pair(first, worst));}
+    if (last - worst > 1)  {intervals.push_back(std::make_pair(worst, last));}
+  }
+
+  for (std::size_t i = 0; i < n_samples; ++i)
+  {
+    if (is_knot[i]) {knots.push_back(i);}
+  }
+  return knots;
+}
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,151 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef TRAJECTORY_RECORDING_CONTROLLER_TRAJECTORY_RECORDING_CONTROLLER_H
+#define TRAJECTORY_RECORDING_CONTROLLER_TRAJECTORY_RECORDING_CONTROLLER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/lockfree/spsc_queue.hpp>
+
+#include <controller_interface/controller.h>
+#include <hardware_interface/joint_state_interface.h>
+#include <ros/node_handle.h>
+#include <std_srvs/Trigger.h>
+#include <trajectory_msgs/JointTrajectory.h>
+
+namespace trajectory_recording_controller
+{
+
+/**
+ * \brief Controller recording joint motions as trajectories, e.g. while a robot is moved by hand.
+ *
+ * While recording, the positions and velocities of the joints are sampled every control cycle into a preallocated
+ * lock-free queue, which a non-realtime thread drains into the recording. When recording stops, samples are reduced to
+ * the knots needed to reproduce the recording within a position tolerance (see \ref reduceKnots), and published as a
+ * trajectory that \p joint_trajectory_controller can replay as is.
+ *
+ * The controller only reads joint states, so it runs alongside the controller holding the robot while teaching, such
+ * as a gravity compensation or admittance controller.
+ *
+ * \section ROS interface
+ *
+ * \param type Must be "trajectory_recording_controller/TrajectoryRecordingController".
+ * \param joints Names of the joints to record.
+ * \param tolerance Maximum position deviation of the recorded trajectory from the samples. Defaults to 0.001.
+ * \param <joint_name>/tolerance Overrides \p tolerance for a joint, e.g. for prismatic joints.
+ * \param buffer_size Number of samples the realtime queue holds. Defaults to 1000.
+ * \param drain_rate Rate at which the queue is drained into the recording, in Hz. Defaults to 50. Samples are dropped
+ * if more than \p buffer_size are taken in a drain period.
+ * \param max_duration Maximum duration of a recording, in seconds. Defaults to 600.
+ *
+ * Provides services:
+ * - \b start_recording (std_srvs::Trigger) : Discard the previous recording and start a new one.
+ * - \b stop_recording (std_srvs::Trigger) : Stop recording, and publish the recorded trajectory.
+ *
+ * Publishes:
+ * - \b recorded_trajectory (trajectory_msgs::JointTrajectory) : Last recorded trajectory, latched. Its first point has
+ *   zero \p time_from_start and its header stamp is zero, so that it starts executing on reception.
+ */
+class TrajectoryRecordingController : public controller_interface::Controller<hardware_interface::JointStateInterface>
+{
+public:
+  TrajectoryRecordingController();
+
+  /** \brief Stops the recording thread. */
+  ~TrajectoryRecordingController();
+
+  bool init(hardware_interface::JointStateInterface* hw, ros::NodeHandle& root_nh, ros::NodeHandle& controller_nh);
+  void update(const ros::Time& time, const ros::Duration& period);
+
+private:
+  /** \brief Samples are queued as blocks of one time, \p n_joints positions and \p n_joints velocities. */
+  typedef boost::lockfree::spsc_queue<double> Queue;
+
+  std::vector<hardware_interface::JointStateHandle> joints_;
+  std::vector<std::string> joint_names_;
+  std::vector<double>      tolerances_;
+  std::string              name_;
+
+  std::unique_ptr<Queue>    queue_;
+  std::vector<double>       rt_sample_;       ///< Preallocated sample block. Realtime loop only.
+  std::atomic<bool>         recording_;
+  std::atomic<unsigned int> dropped_samples_;
+
+  /**
+   * \name Recording
+   * Only accessed with \ref mutex_ locked, which serializes the recording thread and the service callbacks, the
+   * consumers of \ref queue_.
+   *\{*/
+  std::mutex          mutex_;
+  std::vector<double> sample_;                ///< Preallocated sample block.
+  std::vector<double> times_;
+  std::vector<double> positions_;             ///< Row-major, one row per sample.
+  std::vector<double> velocities_;            ///< Row-major, one row per sample.
+  double              max_duration_;
+  bool                duration_exceeded_;
+  bool                keep_running_;
+  /*\}*/
+
+  std::chrono::duration<double> drain_period_;
+  std::thread                   recording_thread_;
+  std::condition_variable       stop_cond_;
+
+  ros::ServiceServer start_recording_service_;
+  ros::ServiceServer stop_recording_service_;
+  ros::Publisher     trajectory_pub_;
+
+  bool startRecordingService(std_srvs::Trigger::Request& req, std_srvs::Trigger::Response& resp);
+  bool stopRecordingService(std_srvs::Trigger::Request& req, std_srvs::Trigger::Response& resp);
+
+  void recordingLoop();
+  void stopRecordingThread();
+
+  /** \brief Move queued samples to the recording. \ref mutex_ must be locked. */
+  void drainQueue();
+
+  /** \brief Build a trajectory from the recorded samples. \ref mutex_ must be locked. */
+  trajectory_msgs::JointTrajectory buildTrajectory() const;
+};
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,290 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <algorithm>
+#include <sstream>
+
+#include <pluginlib/class_list_macros.hpp>
+
+#include <trajectory_recording_controller/knot_reduction.h>
+#include <trajectory_recording_controller/trajectory_recording_controller.h>
+
+namespace trajectory_recording_controller
+{
+
+TrajectoryRecordingController::TrajectoryRecordingController()
+  : recording_(false),
+    dropped_samples_(0),
+    max_duration_(600.0),
+    duration_exceeded_(false),
+    keep_running_(false)
+{}
+
+TrajectoryRecordingController::~TrajectoryRecordingController()
+{
+  stopRecordingThread();
+}
+
+bool TrajectoryRecordingController::init(hardware_interface::JointStateInterface* hw,
+                                         ros::NodeHandle&                         /*root_nh*/,
+                                         ros::NodeHandle&                         controller_nh)
+{
+  stopRecordingThread();
+
+  // Controller name
+  const std::string complete_ns = controller_nh.getNamespace();
+  name_ = complete_ns.substr(complete_ns.find_last_of("/") + 1);
+
+  // Joints and their tolerances
+  if (!controller_nh.getParam("joints", joint_names_) || joint_names_.empty())
+  {
+    ROS_ERROR_STREAM_NAMED(name_, "Could not find a non-empty 'joints' parameter (namespace: " <<
+                           controller_nh.getNamespace() << ").");
+    return false;
+  }
+
+  double tolerance = 1e-3;
+  controller_nh.param("tolerance", tolerance, tolerance);
+  joints_.clear();
+  tolerances_.clear();
+  for (const auto& joint_name : joint_names_)
+  {
+    try {joints_.push_back(hw->getHandle(joint_name));}
+    catch (const hardware_interface::HardwareInterfaceException&)
+    {
+      ROS_ERROR_STREAM_NAMED(name_, "Could not find joint '" << joint_name << "'.");
+      return false;
+    }
+
+    ros::NodeHandle joint_nh(controller_nh, joint_name);
+    tolerances_.push_back(tolerance);
+    joint_nh.param("tolerance", tolerances_.back(), tolerances_.back());
+    if (tolerances_.back() <= 0.0)
+    {
+      ROS_ERROR_STREAM_NAMED(name_, "Tolerance of joint '" << joint_name << "' must be positive.");
+      return false;
+    }
+  }
+
+  // Realtime queue
+  int buffer_size = 1000;
+  double drain_rate = 50.0;
+  controller_nh.param("buffer_size",  buffer_size,   buffer_size);
+  controller_nh.param("drain_rate",   drain_rate,    drain_rate);
+  controller_nh.param("max_duration", max_duration_, max_duration_);
+  if (buffer_size <= 0 || drain_rate <= 0.0 || max_duration_ <= 0.0)
+  {
+    ROS_ERROR_STREAM_NAMED(name_, "The 'buffer_size', 'drain_rate' and 'max_duration' parameters must be positive.");
+    return false;
+  }
+
+  const std::size_t sample_size = 1 + 2 * joints_.size();
+  queue_.reset(new Queue(buffer_size * sample_size));
+  rt_sample_.assign(sample_size, 0.0);
+  sample_.assign(sample_size, 0.0);
+  recording_ = false;
+  dropped_samples_ = 0;
+  drain_period_ = std::chrono::duration<double>(1.0 / drain_rate);
+
+  // ROS API
+  trajectory_pub_ = controller_nh.advertise<trajectory_msgs::JointTrajectory>("recorded_trajectory", 1, true);
+  start_recording_service_ = controller_nh.advertiseService("start_recording",
+                                                            &TrajectoryRecordingController::startRecordingService,
+                                                            this);
+  stop_recording_service_ = controller_nh.advertiseService("stop_recording",
+                                                           &TrajectoryRecordingController::stopRecordingService,
+                                                           this);
+
+  keep_running_ = true;
+  recording_thread_ = std::thread(&TrajectoryRecordingController::recordingLoop, this);
+  return true;
+}
+
+void TrajectoryRecordingController::update(const ros::Time& time, const ros::Duration& /*period*/)
+{
+  if (!recording_) {return;}
+
+  const std::size_t n_joints = joints_.size();
+  rt_sample_[0] = time.toSec();
+  for (std::size_t i = 0; i < n_joints; ++i)
+  {
+    rt_sample_[1 + i]            = joints_[i].getPosition();
+    rt_sample_[1 + n_joints + i] = joints_[i].getVelocity();
+  }
+
+  // Samples are pushed whole, so that the recording thread never sees partial samples
+  if (queue_->write_available() < rt_sample_.size())
+  {
+    ++dropped_samples_;
+    return;
+  }
+  queue_->push(rt_sample_.data(), rt_sample_.size());
+}
+
+bool TrajectoryRecordingController::startRecordingService(std_srvs::Trigger::Request&  /*req*/,
+                                                          std_srvs::Trigger::Response& resp)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  recording_ = false;
+
+  // Discard leftovers of the previous recording
+  queue_->consume_all([](double) {});
+  times_.clear();
+  positions_.clear();
+  velocities_.clear();
+  duration_exceeded_ = false;
+  dropped_samples_ = 0;
+
+  recording_ = true;
+  resp.success = true;
+  resp.message = "Recording started.";
+  ROS_DEBUG_STREAM_NAMED(name_, resp.message);
+  return true;
+}
+
+bool TrajectoryRecordingController::stopRecordingService(std_srvs::Trigger::Request&  /*req*/,
+                                                         std_srvs::Trigger::Response& resp)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!recording_)
+  {
+    resp.success = false;
+    resp.message = "Not recording.";
+    return true;
+  }
+
+  // A sample being pushed right now may be missed, which only shortens the recording by one cycle
+  recording_ = false;
+  drainQueue();
+
+  if (times_.size() < 2)
+  {
+    resp.success = false;
+    resp.message = "Recorded less than two samples. Is the controller running?";
+    return true;
+  }
+
+  const trajectory_msgs::JointTrajectory trajectory = buildTrajectory();
+  trajectory_pub_.publish(trajectory);
+
+  std::ostringstream message;
+  message << "Recorded " << times_.size() << " samples over " << times_.back() - times_.front() <<
+             "s, reduced to " << trajectory.points.size() << " trajectory points.";
+  if (duration_exceeded_) {message << " Recording was cut at the maximum duration of " << max_duration_ << "s.";}
+  resp.success = true;
+  resp.message = message.str();
+  ROS_INFO_STREAM_NAMED(name_, resp.message);
+  return true;
+}
+
+void TrajectoryRecordingController::recordingLoop()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (keep_running_)
+  {
+    stop_cond_.wait_for(lock, drain_period_, [this] {return !keep_running_;});
+    drainQueue();
+  }
+}
+
+void TrajectoryRecordingController::stopRecordingThread()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    keep_running_ = false;
+  }
+  stop_cond_.notify_all();
+  if (recording_thread_.joinable()) {recording_thread_.join();}
+}
+
+void TrajectoryRecordingController::drainQueue()
+{
+  if (!queue_) {return;}
+
+  const std::size_t n_joints = joints_.size();
+  while (queue_->read_available() >= sample_.size())
+  {
+    queue_->pop(sample_.data(), sample_.size());
+
+    // Skip samples not moving forward in time, e.g. after a simulation reset, and beyond the maximum duration
+    const double time = sample_[0];
+    if (!times_.empty() && time <= times_.back()) {continue;}
+    if (!times_.empty() && time - times_.front() > max_duration_)
+    {
+      duration_exceeded_ = true;
+      continue;
+    }
+
+    times_.push_back(time);
+    positions_.insert(positions_.end(),   sample_.begin() + 1,            sample_.begin() + 1 + n_joints);
+    velocities_.insert(velocities_.end(), sample_.begin() + 1 + n_joints, sample_.end());
+  }
+
+  const unsigned int dropped_samples = dropped_samples_.exchange(0);
+  if (dropped_samples > 0)
+  {
+    ROS_WARN_STREAM_NAMED(name_, "Dropped " << dropped_samples << " recording samples. Consider increasing the " <<
+                          "buffer size or the drain rate.");
+  }
+}
+
+trajectory_msgs::JointTrajectory TrajectoryRecordingController::buildTrajectory() const
+{
+  const std::size_t n_joints = joints_.size();
+
+  // Teaching starts and ends at rest, which spares replay from ending with the measurement noise of the velocity
+  std::vector<double> velocities = velocities_;
+  std::fill(velocities.begin(), velocities.begin() + n_joints, 0.0);
+  std::fill(velocities.end() - n_joints, velocities.end(), 0.0);
+
+  const std::vector<std::size_t> knots = reduceKnots(times_, positions_, velocities, tolerances_);
+
+  trajectory_msgs::JointTrajectory trajectory;
+  trajectory.joint_names = joint_names_;
+  trajectory.points.resize(knots.size());
+  for (std::size_t k = 0; k < knots.size(); ++k)
+  {
+    const std::size_t row = knots[k] * n_joints;
+    trajectory_msgs::JointTrajectoryPoint& point = trajectory.points[k];
+    point.positions.assign(positions_.begin() + row, positions_.begin() + row + n_joints);
+    point.velocities.assign(velocities.begin() + row, velocities.begin() + row + n_joints);
+    point.time_from_start = ros::Duration(times_[knots[k]] - times_.front());
+  }
+  return trajectory;
+}
+
+} // namespace
+
+PLUGINLIB_EXPORT_CLASS(trajectory_recording_controller::TrajectoryRecordingController,
+                       controller_interface::ControllerBase)
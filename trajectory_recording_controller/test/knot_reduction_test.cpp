@@ -0,0 +1,181 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2019, Rapyuta Robotics Co., Ltd.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <trajectory_recording_controller/knot_reduction.h>
+
+using trajectory_recording_controller::reduceKnots;
+
+namespace
+{
+
+struct Recording
+{
+  std::vector<double> times;
+  std::vector<double> positions;
+  std::vector<double> velocities;
+};
+
+// Two joints: a sine and a slower cosine, sampled at 1kHz
+Recording sineRecording(double duration)
+{
+  Recording recording;
+  const double dt = 1e-3;
+  for (double t = 0.0; t <= duration; t += dt)
+  {
+    recording.times.push_back(t);
+    recording.positions.push_back(std::sin(2.0 * t));
+    recording.positions.push_back(0.5 * std::cos(t));
+    recording.velocities.push_back(2.0 * std::cos(2.0 * t));
+    recording.velocities.push_back(-0.5 * std::sin(t));
+  }
+  return recording;
+}
+
+// Largest deviation of the recorded samples from the interpolation of the knots, for each joint
+std::vector<double> maxDeviation(const Recording& recording, const std::vector<std::size_t>& knots,
+                                 std::size_t n_joints)
+{
+  using trajectory_recording_controller::internal::hermite;
+
+  std::vector<double> max_deviation(n_joints, 0.0);
+  for (std::size_t k = 0; k + 1 < knots.size(); ++k)
+  {
+    const std::size_t a = knots[k];
+    const std::size_t b = knots[k + 1];
+    for (std::size_t i = a; i <= b; ++i)
+    {
+      for (std::size_t j = 0; j < n_joints; ++j)
+      {
+        const double expected = hermite(recording.times[a], recording.positions[a * n_joints + j],
+                                        recording.velocities[a * n_joints + j],
+                                        recording.times[b], recording.positions[b * n_joints + j],
+                                        recording.velocities[b * n_joints + j],
+                                        recording.times[i]);
+        max_deviation[j] = std::max(max_deviation[j], std::abs(recording.positions[i * n_joints + j] - expected));
+      }
+    }
+  }
+  return max_deviation;
+}
+
+} // namespace
+
+TEST(KnotReductionTest, CubicMotionNeedsNoInnerKnots)
+{
+  // Cubic Hermite interpolation reproduces cubic polynomials exactly
+  Recording recording;
+  for (int i = 0; i <= 1000; ++i)
+  {
+    const double t = 1e-3 * i;
+    recording.times.push_back(t);
+    recording.positions.push_back(1.0 + 2.0 * t - 3.0 * t * t + t * t * t);
+    recording.velocities.push_back(2.0 - 6.0 * t + 3.0 * t * t);
+  }
+
+  const std::vector<std::size_t> knots = reduceKnots(recording.times, recording.positions, recording.velocities,
+                                                     std::vector<double>(1, 1e-6));
+  ASSERT_EQ(2u, knots.size());
+  EXPECT_EQ(0u, knots.front());
+  EXPECT_EQ(recording.times.size() - 1, knots.back());
+}
+
+TEST(KnotReductionTest, DeviationIsBounded)
+{
+  const Recording recording = sineRecording(5.0);
+  const std::vector<double> tolerances(2, 1e-3);
+
+  const std::vector<std::size_t> knots = reduceKnots(recording.times, recording.positions, recording.velocities,
+                                                     tolerances);
+  ASSERT_GE(knots.size(), 2u);
+  EXPECT_EQ(0u, knots.front());
+  EXPECT_EQ(recording.times.size() - 1, knots.back());
+  for (std::size_t k = 0; k + 1 < knots.size(); ++k) {EXPECT_LT(knots[k], knots[k + 1]);}
+
+  const std::vector<double> max_deviation = maxDeviation(recording, knots, 2);
+  EXPECT_LE(max_deviation[0], tolerances[0]);
+  EXPECT_LE(max_deviation[1], tolerances[1]);
+
+  // Smooth motions are described by a small fraction of the samples
+  EXPECT_LT(knots.size(), recording.times.size() / 50);
+}
+
+TEST(KnotReductionTest, TighterToleranceKeepsMoreKnots)
+{
+  const Recording recording = sineRecording(5.0);
+
+  const std::vector<std::size_t> loose = reduceKnots(recording.times, recording.positions, recording.velocities,
+                                                     std::vector<double>(2, 1e-2));
+  const std::vector<std::size_t> tight = reduceKnots(recording.times, recording.positions, recording.velocities,
+                                                     std::vector<double>(2, 1e-5));
+  EXPECT_LT(loose.size(), tight.size());
+
+  // Tolerances are per joint
+  std::vector<double> tolerances(2, 1e-2);
+  tolerances[1] = 1e-6;
+  const std::vector<std::size_t> mixed = reduceKnots(recording.times, recording.positions, recording.velocities,
+                                                     tolerances);
+  const std::vector<double> max_deviation = maxDeviation(recording, mixed, 2);
+  EXPECT_LE(max_deviation[0], tolerances[0]);
+  EXPECT_LE(max_deviation[1], tolerances[1]);
+  EXPECT_LT(loose.size(), mixed.size());
+}
+
+TEST(KnotReductionTest, ShortRecordings)
+{
+  const std::vector<double> tolerances(1, 1e-3);
+  const std::vector<double> none;
+  EXPECT_TRUE(reduceKnots(none, none, none, tolerances).empty());
+
+  const std::vector<double> times(1, 0.0), values(1, 1.0);
+  EXPECT_EQ(std::vector<std::size_t>(1, 0), reduceKnots(times, values, values, tolerances));
+
+  std::vector<double> two_times, two_values;
+  two_times.push_back(0.0);
+  two_times.push_back(1.0);
+  two_values.push_back(0.0);
+  two_values.push_back(1.0);
+  EXPECT_EQ(2u, reduceKnots(two_times, two_values, two_values, tolerances).size());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -63,17 +63,18 @@
 
    - @b state (control_msgs::JointControllerState) :
      Current state of the controller, including pid error and gains.
+     Publish rate and sample batching are set by the @b state_publish_rate and
+     @b state_batch_size parameters. See: batch_pid::PidStatePublisher
 
 */
 
-#include <control_msgs/JointControllerState.h>
+#include <batch_pid/pid_state_publisher.h>
 #include <control_msgs/JointControllerState.h>
 #include <control_toolbox/pid.h>
 #include <controller_interface/controller.h>
 #include <hardware_interface/joint_command_interface.h>
 #include <memory>
 #include <realtime_tools/realtime_buffer.h>
-#include <realtime_tools/realtime_publisher.h>
 #include <ros/node_handle.h>
 #include <std_msgs/Float64.h>
 #include <urdf/model.h>
@@ -113,6 +114,25 @@ public:
    */
   bool init(hardware_interface::VelocityJointInterface *robot, ros::NodeHandle &n);
 
+  /**
+   * \brief Initialize the controller to be hosted by a joint_controller_group::JointControllerGroup.
+   *
+   * Same as \ref init, except that no command subscriber is started, and state samples are only published by calls
+   * to \ref publishState, so that the hosting controller can serve all its joints with a single topic and thread.
+   *
+   * \param default_joint_name Joint controlled if the \p joint parameter is not set.
+   * \param default_state_publish_rate State publish rate if the \p state_publish_rate parameter is not set. Ignored
+   * if not positive.
+   */
+  bool initHosted(hardware_interface::VelocityJointInterface *robot, ros::NodeHandle &n,
+                  const std::string &default_joint_name, double default_state_publish_rate);
+
+  /**
+   * \brief Publish the state samples recorded since the last call. Only needed by hosted controllers.
+   *        This method is \e not realtime-safe.
+   */
+  void publishState();
+
   /*!
    * \brief Give set position of the joint for next update: revolute (angle) and prismatic (position)
    *
@@ -178,12 +198,9 @@ public:
   Commands command_struct_; // pre-allocated memory that is re-used to set the realtime buffer
 
 private:
-  int loop_count_;
   control_toolbox::Pid pid_controller_;       /**< Internal PID controller. */
 
-  std::unique_ptr<
-    realtime_tools::RealtimePublisher<
-      control_msgs::JointControllerState> > controller_state_publisher_ ;
+  batch_pid::PidStatePublisher controller_state_publisher_;
 
   ros::Subscriber sub_command_;
 
@@ -192,6 +209,9 @@ private:
    */
   void setCommandCB(const std_msgs::Float64ConstPtr& msg);
 
+  bool initImpl(hardware_interface::VelocityJointInterface *robot, ros::NodeHandle &n, bool hosted,
+                const std::string &default_joint_name, double default_state_publish_rate);
+
   /**
    * \brief Check that the command is within the hard limits of the joint. Checks for joint
    *        type first. Sets command to limit if out of bounds.
@@ -0,0 +1,154 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  Copyright (c) 2012, hiDOF, Inc.
+ *  Copyright (c) 2013, PAL Robotics, S.L.
+ *  Copyright (c) 2014, Fraunhofer IPA
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <velocity_controllers/joint_group_position_controller.h>
+#include <pluginlib/class_list_macros.hpp>
+
+namespace velocity_controllers
+{
+
+  JointGroupPositionController::JointGroupPositionController() {}
+  JointGroupPositionController::~JointGroupPositionController() {sub_command_.shutdown();}
+
+  bool JointGroupPositionController::init(hardware_interface::VelocityJointInterface* hw, ros::NodeHandle &n)
+  {
+    // List of controlled joints
+    std::string param_name = "joints";
+    if(!n.getParam(param_name, joint_names_))
+    {
+      ROS_ERROR_STREAM("Failed to getParam '" << param_name << "' (namespace: " << n.getNamespace() << ").");
+      return false;
+    }
+    n_joints_ = joint_names_.size();
+
+    if(n_joints_ == 0){
+      ROS_ERROR_STREAM("List of joint names is empty.");
+      return false;
+    }
+
+    // Get URDF
+    urdf::Model urdf;
+    if (!urdf.initParam("robot_description"))
+    {
+      ROS_ERROR("Failed to parse urdf file");
+      return false;
+    }
+
+    for(unsigned int i=0; i<n_joints_; i++)
+    {
+      try
+      {
+        joints_.push_back(hw->getHandle(joint_names_[i]));
+      }
+      catch (const hardware_interface::HardwareInterfaceException& e)
+      {
+        ROS_ERROR_STREAM("Exception thrown: " << e.what());
+        return false;
+      }
+    }
+
+    // Cache joint types and limits, so that the control loop doesn't need to access the URDF model
+    if (!position_error_.init(urdf, joint_names_))
+    {
+      return false;
+    }
+
+    // Load PID Controller using gains set on parameter server
+    if (!pid_controller_.init(n, joint_names_))
+    {
+      ROS_ERROR_STREAM("Failed to load PID parameters (namespace: " << n.getNamespace() << ").");
+      return false;
+    }
+
+    // Preallocate workspace used by the control loop
+    current_positions_.resize(n_joints_, 0.0);
+    position_errors_.resize(n_joints_, 0.0);
+    commanded_velocities_.resize(n_joints_, 0.0);
+
+    commands_buffer_.writeFromNonRT(std::vector<double>(n_joints_, 0.0));
+
+    sub_command_ = n.subscribe<std_msgs::Float64MultiArray>("command", 1, &JointGroupPositionController::commandCB, this);
+    return true;
+  }
+
+  void JointGroupPositionController::update(const ros::Time& time, const ros::Duration& period)
+  {
+    const std::vector<double> & commands = *commands_buffer_.readFromRT();
+
+    for(unsigned int i=0; i<n_joints_; i++)
+    {
+      current_positions_[i] = joints_[i].getPosition();
+    }
+
+    // Make sure joints are within limits if applicable, and compute the position error
+    position_error_.compute(commands.data(), current_positions_.data(), position_errors_.data());
+
+    // Set the PID errors and compute the PID commands of all joints at once with nonuniform
+    // time step size.
+    pid_controller_.computeCommand(position_errors_.data(), period.toSec(), commanded_velocities_.data());
+
+    for(unsigned int i=0; i<n_joints_; i++)
+    {
+      joints_[i].setCommand(commanded_velocities_[i]);
+    }
+  }
+
+  void JointGroupPositionController::starting(const ros::Time& time)
+  {
+    // Hold the current positions until a command is received
+    for(unsigned int i=0; i<n_joints_; i++)
+    {
+      current_positions_[i] = joints_[i].getPosition();
+    }
+    commands_buffer_.initRT(current_positions_);
+
+    pid_controller_.reset();
+  }
+
+  void JointGroupPositionController::commandCB(const std_msgs::Float64MultiArrayConstPtr& msg)
+  {
+    if(msg->data.size()!=n_joints_)
+    { 
+      ROS_ERROR_STREAM("Dimension of command (" << msg->data.size() << ") does not match number of joints (" << n_joints_ << ")! Not executing!");
+      return; 
+    }
+    commands_buffer_.writeFromNonRT(msg->data);
+  }
+
+} // namespace
+
+PLUGINLIB_EXPORT_CLASS( velocity_controllers::JointGroupPositionController, controller_interface::ControllerBase)